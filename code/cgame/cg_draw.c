@@ -2637,6 +2637,9 @@ void CG_DrawActive( stereoFrame_t stereoView ) {
 	// clear around the rendered view if sized down
 	CG_TileClear();
 
+	// swap in the newest head pose
+	CG_LateLatchView( stereoView );
+
 	// offset vieworg appropriately if we're doing stereo separation
 	VectorCopy( cg.refdef.vieworg, baseOrg );
 	if ( separation != 0 ) {
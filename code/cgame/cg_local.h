@@ -507,6 +507,27 @@ typedef struct {
 	int			predictedErrorTime;
 	vec3_t		predictedError;
 
+	// moves saved by the last prediction, see CG_ResumePrediction
+	qboolean	predictCacheValid;
+	playerState_t	predictBase;		// snapshot state the saved moves were run from
+	int			predictBaseTime;		// cg.physicsTime of predictBase
+	int			predictTracemask;
+	int			predictNoFootsteps;
+	int			predictFirstMove;		// -1 when nothing is saved
+	int			predictLastMove;
+	int			predictLastCmd;			// newest command number looked at
+	playerState_t	predictStates[CMD_BACKUP];	// indexed by command number, before mover adjustment
+	qboolean	predictTouched[CMD_BACKUP];		// the move touched a trigger or item
+
+	int			predictStatTime;		// cg_predictStats counters
+	int			predictStatFrames;
+	int			predictStatMoves;
+	int			predictStatMax;
+	int			predictStatResumed;
+	int			predictStatSnapshots;	// frames resumed on a new snapshot
+	int			predictStatChecked;		// cg_predictStats 2 replays
+	int			predictStatWrong;
+
 	int			eventSequence;
 	int			predictableEvents[MAX_PREDICTED_EVENTS];
 
@@ -531,6 +552,9 @@ typedef struct {
 	// view rendering
 	refdef_t	refdef;
 	vec3_t		refdefViewAngles;		// will be converted to refdef.viewaxis
+	vec3_t		hmdAngles;				// head angles included in refdefViewAngles
+	trackedPose_t	latchedPose;		// taken by CG_LateLatchView for both eyes
+	qboolean	latchedPoseValid;
 
 	// zoom key
 	qboolean	zoomed;
@@ -1124,6 +1148,9 @@ extern	vmCvar_t		cg_debugEvents;
 extern	vmCvar_t		cg_railTrailTime;
 extern	vmCvar_t		cg_errorDecay;
 extern	vmCvar_t		cg_nopredict;
+extern	vmCvar_t		cg_optimizePrediction;
+extern	vmCvar_t		cg_predictStats;
+extern	vmCvar_t		cg_lateLatch;
 extern	vmCvar_t		cg_noPlayerAnims;
 extern	vmCvar_t		cg_showmiss;
 extern	vmCvar_t		cg_footsteps;
@@ -1240,6 +1267,7 @@ void CG_ZoomUp_f( void );
 void CG_AddBufferedSound( sfxHandle_t sfx);
 
 void CG_DrawActiveFrame( int serverTime, stereoFrame_t stereoView, qboolean demoPlayback );
+void CG_LateLatchView( stereoFrame_t stereoView );
 
 
 //
@@ -1635,6 +1663,9 @@ int			trap_GetCurrentCmdNumber( void );
 
 qboolean	trap_GetUserCmd( int cmdNumber, usercmd_t *ucmd );
 
+// the newest head tracking pose, which can be newer than any usercmd
+qboolean	trap_GetTrackedPose( trackedPose_t *pose );
+
 // used for the weapon select and zoom
 void		trap_SetUserCmdValue( int stateValue, float sensitivityScale );
 
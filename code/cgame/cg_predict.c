@@ -280,23 +280,23 @@ static void CG_InterpolatePlayerState( qboolean grabAngles ) {
 CG_TouchItem
 ===================
 */
-static void CG_TouchItem( centity_t *cent ) {
+static qboolean CG_TouchItem( centity_t *cent ) {
 	gitem_t		*item;
 
 	if ( !cg_predictItems.integer ) {
-		return;
+		return qfalse;
 	}
 	if ( !BG_PlayerTouchesItem( &cg.predictedPlayerState, &cent->currentState, cg.time ) ) {
-		return;
+		return qfalse;
 	}
 
 	// never pick an item up twice in a prediction
 	if ( cent->miscTime == cg.time ) {
-		return;
+		return qtrue;
 	}
 
 	if ( !BG_CanItemBeGrabbed( cgs.gametype, &cent->currentState, &cg.predictedPlayerState ) ) {
-		return;		// can't hold it
+		return qtrue;		// can't hold it
 	}
 
 	item = &bg_itemlist[ cent->currentState.modelindex ];
@@ -306,7 +306,7 @@ static void CG_TouchItem( centity_t *cent ) {
 #ifdef MISSIONPACK
 	if( cgs.gametype == GT_1FCTF ) {
 		if( item->giTag != PW_NEUTRALFLAG ) {
-			return;
+			return qtrue;
 		}
 	}
 	if( cgs.gametype == GT_CTF || cgs.gametype == GT_HARVESTER ) {
@@ -315,10 +315,10 @@ static void CG_TouchItem( centity_t *cent ) {
 #endif
 		if (cg.predictedPlayerState.persistant[PERS_TEAM] == TEAM_RED &&
 			item->giTag == PW_REDFLAG)
-			return;
+			return qtrue;
 		if (cg.predictedPlayerState.persistant[PERS_TEAM] == TEAM_BLUE &&
 			item->giTag == PW_BLUEFLAG)
-			return;
+			return qtrue;
 	}
 
 	// grab it
@@ -337,6 +337,7 @@ static void CG_TouchItem( centity_t *cent ) {
 			cg.predictedPlayerState.ammo[ item->giTag ] = 1;
 		}
 	}
+	return qtrue;
 }
 
 
@@ -344,34 +345,38 @@ static void CG_TouchItem( centity_t *cent ) {
 =========================
 CG_TouchTriggerPrediction
 
-Predict push triggers and items
+Predict push triggers and items, returns qtrue if any were touched
 =========================
 */
-static void CG_TouchTriggerPrediction( void ) {
+static qboolean CG_TouchTriggerPrediction( void ) {
 	int			i;
 	trace_t		trace;
 	entityState_t	*ent;
 	clipHandle_t cmodel;
 	centity_t	*cent;
 	qboolean	spectator;
+	qboolean	touched;
 
 	// dead clients don't activate triggers
 	if ( cg.predictedPlayerState.stats[STAT_HEALTH] <= 0 ) {
-		return;
+		return qfalse;
 	}
 
 	spectator = ( cg.predictedPlayerState.pm_type == PM_SPECTATOR );
 
 	if ( cg.predictedPlayerState.pm_type != PM_NORMAL && !spectator ) {
-		return;
+		return qfalse;
 	}
 
+	touched = qfalse;
 	for ( i = 0 ; i < cg_numTriggerEntities ; i++ ) {
 		cent = cg_triggerEntities[ i ];
 		ent = &cent->currentState;
 
 		if ( ent->eType == ET_ITEM && !spectator ) {
-			CG_TouchItem( cent );
+			if ( CG_TouchItem( cent ) ) {
+				touched = qtrue;
+			}
 			continue;
 		}
 
@@ -391,6 +396,7 @@ static void CG_TouchTriggerPrediction( void ) {
 			continue;
 		}
 
+		touched = qtrue;
 		if ( ent->eType == ET_TELEPORT_TRIGGER ) {
 			cg.hyperspace = qtrue;
 		} else if ( ent->eType == ET_PUSH_TRIGGER ) {
@@ -403,9 +409,257 @@ static void CG_TouchTriggerPrediction( void ) {
 		cg.predictedPlayerState.jumppad_frame = 0;
 		cg.predictedPlayerState.jumppad_ent = 0;
 	}
+
+	return touched;
+}
+
+
+
+/*
+=================
+CG_CheckPredictionError
+
+Called when the prediction reaches the commandTime of last frame's
+predicted state, so the two positions can be compared
+=================
+*/
+static void CG_CheckPredictionError( playerState_t *oldPlayerState ) {
+	vec3_t	delta;
+	float	len;
+
+	if ( cg.thisFrameTeleport ) {
+		// a teleport will not cause an error decay
+		VectorClear( cg.predictedError );
+		if ( cg_showmiss.integer ) {
+			CG_Printf( "PredictionTeleport\n" );
+		}
+		cg.thisFrameTeleport = qfalse;
+	} else {
+		vec3_t	adjusted;
+		CG_AdjustPositionForMover( cg.predictedPlayerState.origin, 
+			cg.predictedPlayerState.groundEntityNum, cg.physicsTime, cg.oldTime, adjusted );
+
+		if ( cg_showmiss.integer ) {
+			if (!VectorCompare( oldPlayerState->origin, adjusted )) {
+				CG_Printf("prediction error\n");
+			}
+		}
+		VectorSubtract( oldPlayerState->origin, adjusted, delta );
+		len = VectorLength( delta );
+		if ( len > 0.1 ) {
+			if ( cg_showmiss.integer ) {
+				CG_Printf("Prediction miss: %f\n", len);
+			}
+			if ( cg_errorDecay.integer ) {
+				int		t;
+				float	f;
+
+				t = cg.time - cg.predictedErrorTime;
+				f = ( cg_errorDecay.value - t ) / cg_errorDecay.value;
+				if ( f < 0 ) {
+					f = 0;
+				}
+				if ( f > 0 && cg_showmiss.integer ) {
+					CG_Printf("Double prediction decay: %f\n", f);
+				}
+				VectorScale( cg.predictedError, f, cg.predictedError );
+			} else {
+				VectorClear( cg.predictedError );
+			}
+			VectorAdd( delta, cg.predictedError, cg.predictedError );
+			cg.predictedErrorTime = cg.oldTime;
+		}
+	}
+}
+
+/*
+=================
+CG_SamePredictedState
+
+Compares two states bit for bit, ignoring the fields that aren't in
+the snapshot's playerState.  Pmove counts pmove_framecount up on every
+call and the server never sends it, so a cached state can't match a
+snapshot on those.
+=================
+*/
+static qboolean CG_SamePredictedState( const playerState_t *cached, const playerState_t *ps ) {
+	playerState_t	a;
+	const int		*p1, *p2;
+	int				i;
+
+	a = *cached;
+	a.ping = ps->ping;
+	a.pmove_framecount = ps->pmove_framecount;
+	a.jumppad_frame = ps->jumppad_frame;
+	a.entityEventSequence = ps->entityEventSequence;
+	a.lastHand = ps->lastHand;
+	a.module = ps->module;
+
+	p1 = (const int *)&a;
+	p2 = (const int *)ps;
+	for ( i = 0 ; i < sizeof( playerState_t ) / sizeof( int ) ; i++ ) {
+		if ( p1[i] != p2[i] ) {
+			return qfalse;
+		}
+	}
+	return qtrue;
+}
+
+/*
+=================
+CG_ResumePrediction
+
+If the moves cached by the last prediction still follow from the
+state in cg.predictedPlayerState, leaves the newest cached state there
+and returns the first command that still has to be run.  Otherwise
+empties the cache and returns firstCmd.
+=================
+*/
+static int CG_ResumePrediction( int firstCmd, int current ) {
+	playerState_t	*ps;
+	int				cmdNum, match;
+
+	if ( !cg_optimizePrediction.integer || cg_pmove.pmove_fixed || !cg.predictCacheValid
+		|| cg.predictTracemask != cg_pmove.tracemask || cg.predictNoFootsteps != cg_pmove.noFootsteps
+		|| cg.predictLastCmd < firstCmd || cg.predictLastCmd > current
+		|| ( cg.predictFirstMove != -1 && cg.predictFirstMove < firstCmd ) ) {
+		goto reset;
+	}
+
+	if ( cg.predictBaseTime == cg.physicsTime
+		&& CG_SamePredictedState( &cg.predictBase, &cg.predictedPlayerState ) ) {
+		// same snapshot as last frame, every cached move still holds
+		if ( cg.predictFirstMove == -1 ) {
+			return cg.predictLastCmd + 1;
+		}
+		match = cg.predictFirstMove - 1;
+	} else {
+		// a new snapshot, look for the cached move that got there
+		if ( cg.predictFirstMove == -1 ) {
+			goto reset;
+		}
+		for ( match = cg.predictFirstMove ; match <= cg.predictLastMove ; match++ ) {
+			if ( cg.predictStates[match & CMD_MASK].commandTime == cg.predictedPlayerState.commandTime ) {
+				break;
+			}
+		}
+		if ( match > cg.predictLastMove
+			|| !CG_SamePredictedState( &cg.predictStates[match & CMD_MASK], &cg.predictedPlayerState ) ) {
+			goto reset;
+		}
+		if ( cg_predictStats.integer ) {
+			cg.predictStatSnapshots++;
+		}
+	}
+
+	// touching triggers and items has side effects outside the
+	// playerState, so those moves always get run again
+	for ( cmdNum = match + 1 ; cmdNum <= cg.predictLastMove ; cmdNum++ ) {
+		if ( cg.predictTouched[cmdNum & CMD_MASK] ) {
+			goto reset;
+		}
+	}
+
+	cg.predictBase = cg.predictedPlayerState;
+	cg.predictBaseTime = cg.physicsTime;
+
+	if ( match >= cg.predictLastMove ) {
+		cg.predictFirstMove = cg.predictLastMove = -1;
+		return cg.predictLastCmd + 1;
+	}
+
+	cg.predictFirstMove = match + 1;
+	for ( cmdNum = cg.predictFirstMove ; cmdNum <= cg.predictLastMove ; cmdNum++ ) {
+		ps = &cg.predictStates[cmdNum & CMD_MASK];
+		ps->ping = cg.predictBase.ping;
+	}
+	cg.predictedPlayerState = cg.predictStates[cg.predictLastMove & CMD_MASK];
+	return cg.predictLastCmd + 1;
+
+reset:
+	cg.predictCacheValid = qtrue;
+	cg.predictBase = cg.predictedPlayerState;
+	cg.predictBaseTime = cg.physicsTime;
+	cg.predictTracemask = cg_pmove.tracemask;
+	cg.predictNoFootsteps = cg_pmove.noFootsteps;
+	cg.predictFirstMove = cg.predictLastMove = -1;
+	return firstCmd;
 }
 
+/*
+=================
+CG_PredictionStats
+
+Prints pmoves per frame once a second for cg_predictStats
+=================
+*/
+static void CG_PredictionStats( int moves, qboolean resumed ) {
+	if ( !cg_predictStats.integer ) {
+		return;
+	}
+
+	cg.predictStatFrames++;
+	cg.predictStatMoves += moves;
+	if ( moves > cg.predictStatMax ) {
+		cg.predictStatMax = moves;
+	}
+	if ( resumed ) {
+		cg.predictStatResumed++;
+	}
+
+	if ( cg.time - cg.predictStatTime < 1000 && cg.time >= cg.predictStatTime ) {
+		return;
+	}
+	CG_Printf( "prediction: %.1f pmoves/frame, max %i, %i%% resumed, %i across snapshots\n",
+		(float)cg.predictStatMoves / cg.predictStatFrames, cg.predictStatMax,
+		cg.predictStatResumed * 100 / cg.predictStatFrames, cg.predictStatSnapshots );
+	if ( cg_predictStats.integer > 1 ) {
+		CG_Printf( "prediction: %i resumed frames checked, %i wrong\n",
+			cg.predictStatChecked, cg.predictStatWrong );
+	}
+	cg.predictStatTime = cg.time;
+	cg.predictStatFrames = 0;
+	cg.predictStatMoves = 0;
+	cg.predictStatMax = 0;
+	cg.predictStatResumed = 0;
+	cg.predictStatSnapshots = 0;
+	cg.predictStatChecked = 0;
+	cg.predictStatWrong = 0;
+}
+
+/*
+=================
+CG_CheckResumedPrediction
+
+For cg_predictStats 2, runs every command again from the snapshot state
+and compares the result with the one the resumed prediction came up with
+=================
+*/
+static void CG_CheckResumedPrediction( const playerState_t *snapState, int current, int latestTime ) {
+	playerState_t	ps;
+	pmove_t			pm;
+	int				cmdNum;
+
+	ps = *snapState;
+	pm = cg_pmove;
+	pm.ps = &ps;
 
+	for ( cmdNum = current - CMD_BACKUP + 1 ; cmdNum <= current ; cmdNum++ ) {
+		trap_GetUserCmd( cmdNum, &pm.cmd );
+		if ( pm.cmd.serverTime <= ps.commandTime || pm.cmd.serverTime > latestTime ) {
+			continue;
+		}
+		pm.gauntletHit = qfalse;
+		ps.module = 1;
+		Pmove( &pm );
+	}
+
+	cg.predictStatChecked++;
+	if ( !CG_SamePredictedState( &ps, &cg.predictedPlayerState ) ) {
+		cg.predictStatWrong++;
+		CG_Printf( "resumed prediction differs from a full replay at command %i\n", current );
+	}
+}
 
 /*
 =================
@@ -420,23 +674,26 @@ playerState_t.
 For normal gameplay, it will be the result of predicted usercmd_t on
 top of the most recent playerState_t received from the server.
 
-Each new snapshot will usually have one or more new usercmd over the last,
-but we simulate all unacknowledged commands each time, not just the new ones.
-This means that on an internet connection, quite a few pmoves may be issued
-each frame.
-
-OPTIMIZE: don't re-simulate unless the newly arrived snapshot playerState_t
-differs from the predicted one.  Would require saving all intermediate
-playerState_t during prediction.
+Each new snapshot will usually have one or more new usercmd over the last.
+The state after every predicted command is saved, so with cg_optimizePrediction
+only the commands issued since last frame are run, and a new snapshot that
+matches the saved state for its commandTime picks up from there.  Anything
+else, or a command that touched a trigger or item, re-simulates all
+unacknowledged commands, which on an internet connection can be quite a
+few pmoves.  Cached moves keep the collisions they were predicted with.
 
 We detect prediction errors and allow them to be decayed off over several frames
 to ease the jerk.
 =================
 */
 void CG_PredictPlayerState( void ) {
-	int			cmdNum, current;
+	int			cmdNum, current, firstCmd;
 	playerState_t	oldPlayerState;
 	qboolean	moved;
+	qboolean	touched;
+	int			numMoves;
+	qboolean	anyTouched;
+	playerState_t	snapState;
 	usercmd_t	oldestCmd;
 	usercmd_t	latestCmd;
 
@@ -453,12 +710,14 @@ void CG_PredictPlayerState( void ) {
 
 	// demo playback just copies the moves
 	if ( cg.demoPlayback || (cg.snap->ps.pm_flags & PMF_FOLLOW) ) {
+		cg.predictCacheValid = qfalse;
 		CG_InterpolatePlayerState( qfalse );
 		return;
 	}
 
 	// non-predicting local movement will grab the latest angles
 	if ( cg_nopredict.integer || cg_synchronousClients.integer ) {
+		cg.predictCacheValid = qfalse;
 		CG_InterpolatePlayerState( qtrue );
 		return;
 	}
@@ -494,6 +753,7 @@ void CG_PredictPlayerState( void ) {
 		if ( cg_showmiss.integer ) {
 			CG_Printf ("exceeded PACKET_BACKUP on commands\n");
 		}
+		cg.predictCacheValid = qfalse;
 		return;
 	}
 
@@ -522,9 +782,20 @@ void CG_PredictPlayerState( void ) {
 	cg_pmove.pmove_fixed = pmove_fixed.integer;// | cg_pmove_fixed.integer;
 	cg_pmove.pmove_msec = pmove_msec.integer;
 
+	// pick up after the moves that are still valid from last frame,
+	// pmove_fixed changes the state even for skipped commands, so
+	// it always runs them all
+	if ( cg_predictStats.integer > 1 ) {
+		snapState = cg.predictedPlayerState;
+	}
+	firstCmd = CG_ResumePrediction( current - CMD_BACKUP + 1, current );
+	moved = ( firstCmd != current - CMD_BACKUP + 1 && cg.predictLastMove != -1 );
+	cg_pmove.cmd = latestCmd;
+
 	// run cmds
-	moved = qfalse;
-	for ( cmdNum = current - CMD_BACKUP + 1 ; cmdNum <= current ; cmdNum++ ) {
+	numMoves = 0;
+	anyTouched = qfalse;
+	for ( cmdNum = firstCmd ; cmdNum <= current ; cmdNum++ ) {
 		// get the command
 		trap_GetUserCmd( cmdNum, &cg_pmove.cmd );
 
@@ -534,11 +805,18 @@ void CG_PredictPlayerState( void ) {
 
 		// don't do anything if the time is before the snapshot player time
 		if ( cg_pmove.cmd.serverTime <= cg.predictedPlayerState.commandTime ) {
+			// keep the saved moves contiguous
+			if ( cg.predictLastMove != -1 ) {
+				cg.predictStates[cmdNum & CMD_MASK] = cg.predictedPlayerState;
+				cg.predictTouched[cmdNum & CMD_MASK] = qfalse;
+				cg.predictLastMove = cmdNum;
+			}
 			continue;
 		}
 
 		// don't do anything if the command was from a previous map_restart
 		if ( cg_pmove.cmd.serverTime > latestCmd.serverTime ) {
+			cg.predictCacheValid = qfalse;
 			continue;
 		}
 
@@ -548,52 +826,7 @@ void CG_PredictPlayerState( void ) {
 		// to predict several commands to get to the point
 		// we want to compare
 		if ( cg.predictedPlayerState.commandTime == oldPlayerState.commandTime ) {
-			vec3_t	delta;
-			float	len;
-
-			if ( cg.thisFrameTeleport ) {
-				// a teleport will not cause an error decay
-				VectorClear( cg.predictedError );
-				if ( cg_showmiss.integer ) {
-					CG_Printf( "PredictionTeleport\n" );
-				}
-				cg.thisFrameTeleport = qfalse;
-			} else {
-				vec3_t	adjusted;
-				CG_AdjustPositionForMover( cg.predictedPlayerState.origin, 
-					cg.predictedPlayerState.groundEntityNum, cg.physicsTime, cg.oldTime, adjusted );
-
-				if ( cg_showmiss.integer ) {
-					if (!VectorCompare( oldPlayerState.origin, adjusted )) {
-						CG_Printf("prediction error\n");
-					}
-				}
-				VectorSubtract( oldPlayerState.origin, adjusted, delta );
-				len = VectorLength( delta );
-				if ( len > 0.1 ) {
-					if ( cg_showmiss.integer ) {
-						CG_Printf("Prediction miss: %f\n", len);
-					}
-					if ( cg_errorDecay.integer ) {
-						int		t;
-						float	f;
-
-						t = cg.time - cg.predictedErrorTime;
-						f = ( cg_errorDecay.value - t ) / cg_errorDecay.value;
-						if ( f < 0 ) {
-							f = 0;
-						}
-						if ( f > 0 && cg_showmiss.integer ) {
-							CG_Printf("Double prediction decay: %f\n", f);
-						}
-						VectorScale( cg.predictedError, f, cg.predictedError );
-					} else {
-						VectorClear( cg.predictedError );
-					}
-					VectorAdd( delta, cg.predictedError, cg.predictedError );
-					cg.predictedErrorTime = cg.oldTime;
-				}
-			}
+			CG_CheckPredictionError( &oldPlayerState );
 		}
 
 		// don't predict gauntlet firing, which is only supposed to happen
@@ -615,14 +848,35 @@ void CG_PredictPlayerState( void ) {
 		//Com_Printf(" %i, %i, %i, %i\n", cg_pmove.cmd.hangles[0], cg_pmove.cmd.hangles[1], cg_pmove.cmd.hangles[2], cg_pmove.cmd.hangles[3]);
 
 		moved = qtrue;
+		numMoves++;
 
 		// add push trigger movement effects
-		CG_TouchTriggerPrediction();
+		touched = CG_TouchTriggerPrediction();
+		if ( touched ) {
+			anyTouched = qtrue;
+		}
+
+		// save the state for the next frame, before the mover adjustment
+		cg.predictStates[cmdNum & CMD_MASK] = cg.predictedPlayerState;
+		cg.predictTouched[cmdNum & CMD_MASK] = touched;
+		if ( cg.predictFirstMove == -1 ) {
+			cg.predictFirstMove = cmdNum;
+		}
+		cg.predictLastMove = cmdNum;
 
 		// check for predictable events that changed from previous predictions
 		//CG_CheckChangedPredictableEvents(&cg.predictedPlayerState);
 	}
 
+	cg.predictLastCmd = current;
+	CG_PredictionStats( numMoves, firstCmd != current - CMD_BACKUP + 1 );
+
+	// a replay can't repeat what touching triggers did to the state
+	if ( cg_predictStats.integer > 1 && firstCmd != current - CMD_BACKUP + 1
+		&& !anyTouched && cg.predictCacheValid ) {
+		CG_CheckResumedPrediction( &snapState, current, latestCmd.serverTime );
+	}
+
 	if ( cg_showmiss.integer > 1 ) {
 		CG_Printf( "[%i : %i] ", cg_pmove.cmd.serverTime, cg.time );
 	}
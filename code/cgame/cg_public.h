@@ -53,6 +53,12 @@ typedef struct {
 	int				serverCommandSequence;	// snapshot becomes current
 } snapshot_t;
 
+// the newest head tracking pose, see trap_GetTrackedPose
+typedef struct {
+	int				time;			// Sys_Milliseconds when the tracker sampled it
+	vec3_t			angles;			// added to the view angles
+} trackedPose_t;
+
 enum {
   CGAME_EVENT_NONE,
   CGAME_EVENT_TEAMMENU,
@@ -166,6 +172,7 @@ typedef enum {
 	CG_R_INPVS,
 	// 1.32
 	CG_FS_SEEK,
+	CG_GETTRACKEDPOSE,
 
 /*
 	CG_LOADCAMERA,
@@ -346,6 +346,10 @@ qboolean	trap_GetUserCmd( int cmdNumber, usercmd_t *ucmd ) {
 	return syscall( CG_GETUSERCMD, cmdNumber, ucmd );
 }
 
+qboolean	trap_GetTrackedPose( trackedPose_t *pose ) {
+	return syscall( CG_GETTRACKEDPOSE, pose );
+}
+
 void		trap_SetUserCmdValue( int stateValue, float sensitivityScale ) {
 	syscall( CG_SETUSERCMDVALUE, stateValue, PASSFLOAT(sensitivityScale) );
 }
@@ -337,7 +337,8 @@ static void CG_OffsetFirstPersonView( void ) {
 	//need a two eyed vs one eyed shooting option
 	//need a two eyed vs one eyed shooting option
 	//need a two eyed vs one eyed shooting option
-	VectorAdd(cg.snap->ps.hmdAngles, cg.refdefViewAngles, angles);
+	VectorCopy( cg.predictedPlayerState.hmdAngles, cg.hmdAngles );
+	VectorAdd(cg.hmdAngles, cg.refdefViewAngles, angles);
 
 	//Com_Printf(" %f, %f, %f, %f\n",	cg.snap->ps.hmdAngles[0], cg.snap->ps.hmdAngles[1], cg.snap->ps.hmdAngles[2], cg.snap->ps.hmdAngles[3]);
 
@@ -705,6 +706,7 @@ static int CG_CalcViewValues( void ) {
 		}
 	}
 
+	VectorClear( cg.hmdAngles );
 	if ( cg.renderingThirdPerson ) {
 		// back away from character
 		CG_OffsetThirdPersonView();
@@ -802,6 +804,38 @@ void cg_drawBBox(vec3_t origin){
 
 //=========================================================================
 
+/*
+=================
+CG_LateLatchView
+
+Replaces the head angles the view was built with by the newest tracked
+pose, right before the scene is rendered.  Both eyes of a stereo frame
+use the pose the first eye took.  The view weapon and sound were placed
+with the command's pose and don't move.
+=================
+*/
+void CG_LateLatchView( stereoFrame_t stereoView ) {
+	int		i;
+
+	if ( stereoView != STEREO_RIGHT ) {
+		cg.latchedPoseValid = qfalse;
+		if ( !cg_lateLatch.integer || cg.renderingThirdPerson || cg.demoPlayback
+			|| ( cg.snap->ps.pm_flags & PMF_FOLLOW ) || cg.snap->ps.pm_type == PM_INTERMISSION ) {
+			return;
+		}
+		cg.latchedPoseValid = trap_GetTrackedPose( &cg.latchedPose );
+	}
+	if ( !cg.latchedPoseValid ) {
+		return;
+	}
+
+	for ( i = 0 ; i < 3 ; i++ ) {
+		cg.refdefViewAngles[i] += AngleSubtract( cg.latchedPose.angles[i], cg.hmdAngles[i] );
+	}
+	VectorCopy( cg.latchedPose.angles, cg.hmdAngles );
+	AnglesToAxis( cg.refdefViewAngles, cg.refdef.viewaxis );
+}
+
 /*
 =================
 CG_DrawActiveFrame
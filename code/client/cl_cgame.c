@@ -599,6 +599,8 @@ int CL_CgameSystemCalls( int *args ) {
 		return CL_GetCurrentCmdNumber();
 	case CG_GETUSERCMD:
 		return CL_GetUserCmd( args[1], VMA(2) );
+	case CG_GETTRACKEDPOSE:
+		return CL_LatchTrackedPose( VMA(1) );
 	case CG_SETUSERCMDVALUE:
 		CL_SetUserCmdValue( args[1], VMF(2) );
 		return 0;
@@ -1009,6 +1011,7 @@ void CL_SetCGameTime( void ) {
 	if ( cl_timedemo->integer ) {
 		if (!clc.timeDemoStart) {
 			clc.timeDemoStart = Sys_Milliseconds();
+			re.GetGLCounters( &clc.timeDemoGL );
 		}
 		clc.timeDemoFrames++;
 		cl.serverTime = clc.timeDemoBaseTime + clc.timeDemoFrames * 50;
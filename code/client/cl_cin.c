@@ -33,6 +33,9 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include "client.h"
 #include "snd_local.h"
+#if idsse2
+#include <emmintrin.h>
+#endif
 
 #define MAXSIZE				8
 #define MINSIZE				4
@@ -52,6 +55,8 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 #define MAX_VIDEO_HANDLES	16
 
+#define CIN_INPUT_SIZE		0x40000		// power of two, holds a few of the largest frames
+
 extern glconfig_t glConfig;
 extern	int		s_paintedtime;
 extern	int		s_rawend;
@@ -73,22 +78,27 @@ static	long				ROQ_UB_tab[256];
 static	long				ROQ_UG_tab[256];
 static	long				ROQ_VG_tab[256];
 static	long				ROQ_VR_tab[256];
-static	unsigned short		vq2[256*16*4];
-static	unsigned short		vq4[256*64*4];
-static	unsigned short		vq8[256*256*4];
 
 
+// decoder state, one per playing cinematic so several can run at once
 typedef struct {
 	byte				linbuf[DEFAULT_CIN_WIDTH*DEFAULT_CIN_HEIGHT*4*2];
 	byte				file[65536];
 	short				sqrTable[256];
 
+	unsigned short		vq2[256*16*4];
+	unsigned short		vq4[256*64*4];
+	unsigned short		vq8[256*256*4];
+
 	unsigned int		mcomp[256];
 	byte				*qStatus[2][32768];
 
 	long				oldXOff, oldYOff, oldysize, oldxsize;
 
-	int					currentHandle;
+	// file data read ahead on the main thread for the decode thread
+	byte				input[CIN_INPUT_SIZE];
+	int					inputHead, inputTail;	// free running
+	long				inputRead;				// bytes of the file read into input
 } cinematics_t;
 
 typedef struct {
@@ -129,17 +139,58 @@ typedef struct {
 	int					playonwalls;
 	byte*				buf;
 	long				drawX, drawY;
+
+	cinematics_t		*state;
+
+	// set for cinematics decoded on the background thread
+	qboolean			threaded;
+	qboolean			resetPending;	// looped, the file is reopened on the main thread
+	byte				*readyBuf;		// decoded frame waiting for its time
+	int					pins[2];		// halves of linbuf being uploaded
 } cin_cache;
 
-static cinematics_t		cin;
+static cinematics_t		*cin;
 static cin_cache		cinTable[MAX_VIDEO_HANDLES];
 static int				currentHandle = -1;
 static int				CL_handle = -1;
 
+// background decoding of silent cinematics
+static void				*cin_lock;
+static void				*cin_thread;
+static volatile qboolean	cin_threadQuit;
+static qboolean			cin_inThread;
+static qboolean			cin_benchmark;
+
 extern int				s_soundtime;		// sample PAIRS
 extern int   			s_paintedtime; 		// sample PAIRS
 
 
+static void CIN_Lock( void ) {
+	if ( cin_lock ) {
+		Sys_LockMutex( cin_lock );
+	}
+}
+
+static void CIN_Unlock( void ) {
+	if ( cin_lock ) {
+		Sys_UnlockMutex( cin_lock );
+	}
+}
+
+/*
+==================
+CIN_SetHandle
+
+The decoder works on the globals, point them at a handle
+==================
+*/
+static void CIN_SetHandle( int handle ) {
+	currentHandle = handle;
+	cin = cinTable[handle].state;
+}
+
+static void CIN_StopThread( void );
+
 void CIN_CloseAllVideos(void) {
 	int		i;
 
@@ -148,6 +199,20 @@ void CIN_CloseAllVideos(void) {
 			CIN_StopCinematic(i);
 		}
 	}
+
+	CIN_StopThread();
+
+	// the renderer may still upload from a stopped handle, so the
+	// decoder state is kept for reuse until now
+	for ( i = 0 ; i < MAX_VIDEO_HANDLES ; i++ ) {
+		if ( cinTable[i].state && cinTable[i].fileName[0] == 0 ) {
+			Z_Free( cinTable[i].state );
+			cinTable[i].state = NULL;
+			cinTable[i].buf = NULL;
+			cinTable[i].readyBuf = NULL;
+		}
+	}
+	cin = NULL;
 }
 
 
@@ -180,8 +245,8 @@ static void RllSetupTable()
 	int z;
 
 	for (z=0;z<128;z++) {
-		cin.sqrTable[z] = (short)(z*z);
-		cin.sqrTable[z+128] = (short)(-cin.sqrTable[z]);
+		cin->sqrTable[z] = (short)(z*z);
+		cin->sqrTable[z+128] = (short)(-cin->sqrTable[z]);
 	}
 }
 
@@ -211,7 +276,7 @@ long RllDecodeMonoToMono(unsigned char *from,short *to,unsigned int size,char si
 		prev = flag;
 
 	for (z=0;z<size;z++) {
-		prev = to[z] = (short)(prev + cin.sqrTable[from[z]]); 
+		prev = to[z] = (short)(prev + cin->sqrTable[from[z]]); 
 	}
 	return size;	//*sizeof(short));
 }
@@ -242,7 +307,7 @@ long RllDecodeMonoToStereo(unsigned char *from,short *to,unsigned int size,char
 		prev = flag;
 
 	for (z = 0; z < size; z++) {
-		prev = (short)(prev + cin.sqrTable[from[z]]);
+		prev = (short)(prev + cin->sqrTable[from[z]]);
 		to[z*2+0] = to[z*2+1] = (short)(prev);
 	}
 	
@@ -278,8 +343,8 @@ long RllDecodeStereoToStereo(unsigned char *from,short *to,unsigned int size,cha
 	}
 
 	for (z=0;z<size;z+=2) {
-                prevL = (short)(prevL + cin.sqrTable[*zz++]); 
-                prevR = (short)(prevR + cin.sqrTable[*zz++]);
+                prevL = (short)(prevL + cin->sqrTable[*zz++]); 
+                prevR = (short)(prevR + cin->sqrTable[*zz++]);
                 to[z+0] = (short)(prevL);
                 to[z+1] = (short)(prevR);
 	}
@@ -315,8 +380,8 @@ long RllDecodeStereoToMono(unsigned char *from,short *to,unsigned int size,char
 	}
 
 	for (z=0;z<size;z+=1) {
-		prevL= prevL + cin.sqrTable[from[z*2]];
-		prevR = prevR + cin.sqrTable[from[z*2+1]];
+		prevL= prevL + cin->sqrTable[from[z*2]];
+		prevR = prevR + cin->sqrTable[from[z*2+1]];
 		to[z] = (short)((prevL + prevR)/2);
 	}
 
@@ -331,6 +396,53 @@ long RllDecodeStereoToMono(unsigned char *from,short *to,unsigned int size,char
 *
 ******************************************************************************/
 
+#if idsse2
+// rows of 32 bit pixels are 16 or 32 bytes, a register or two each
+static void move8_32( byte *src, byte *dst, int spl )
+{
+	int		i;
+
+	for ( i = 0 ; i < 8 ; i++, src += spl, dst += spl ) {
+		_mm_storeu_si128( (__m128i *)dst, _mm_loadu_si128( (const __m128i *)src ) );
+		_mm_storeu_si128( (__m128i *)( dst + 16 ), _mm_loadu_si128( (const __m128i *)( src + 16 ) ) );
+	}
+}
+
+static void move4_32( byte *src, byte *dst, int spl  )
+{
+	int		i;
+
+	for ( i = 0 ; i < 4 ; i++, src += spl, dst += spl ) {
+		_mm_storeu_si128( (__m128i *)dst, _mm_loadu_si128( (const __m128i *)src ) );
+	}
+}
+
+static void blit8_32( byte *src, byte *dst, int spl  )
+{
+	int		i;
+
+	for ( i = 0 ; i < 8 ; i++, src += 32, dst += spl ) {
+		_mm_storeu_si128( (__m128i *)dst, _mm_loadu_si128( (const __m128i *)src ) );
+		_mm_storeu_si128( (__m128i *)( dst + 16 ), _mm_loadu_si128( (const __m128i *)( src + 16 ) ) );
+	}
+}
+
+static void blit4_32( byte *src, byte *dst, int spl  )
+{
+	_mm_storeu_si128( (__m128i *)dst, _mm_loadu_si128( (const __m128i *)src ) );
+	_mm_storeu_si128( (__m128i *)( dst + spl ), _mm_loadu_si128( (const __m128i *)( src + 16 ) ) );
+	_mm_storeu_si128( (__m128i *)( dst + spl*2 ), _mm_loadu_si128( (const __m128i *)( src + 32 ) ) );
+	_mm_storeu_si128( (__m128i *)( dst + spl*3 ), _mm_loadu_si128( (const __m128i *)( src + 48 ) ) );
+}
+
+static void blit2_32( byte *src, byte *dst, int spl  )
+{
+	_mm_storel_epi64( (__m128i *)dst, _mm_loadl_epi64( (const __m128i *)src ) );
+	_mm_storel_epi64( (__m128i *)( dst + spl ), _mm_loadl_epi64( (const __m128i *)( src + 8 ) ) );
+}
+
+#else
+
 static void move8_32( byte *src, byte *dst, int spl )
 {
 	double *dsrc, *ddst;
@@ -464,6 +576,8 @@ static void blit2_32( byte *src, byte *dst, int spl  )
 	ddst[dspl] = dsrc[1];
 }
 
+#endif
+
 /******************************************************************************
 *
 * Function:		
@@ -498,7 +612,7 @@ int		spl;
 		
 		switch (code) {
 			case	0x8000:													// vq code
-				blit8_32( (byte *)&vq8[(*data)*128], status[index], spl );
+				blit8_32( (byte *)&cin->vq8[(*data)*128], status[index], spl );
 				data++;
 				index += 5;
 				break;
@@ -517,21 +631,21 @@ int		spl;
 
 					switch (code) {											// code in top two bits of code
 						case	0x8000:										// 4x4 vq code
-							blit4_32( (byte *)&vq4[(*data)*32], status[index], spl );
+							blit4_32( (byte *)&cin->vq4[(*data)*32], status[index], spl );
 							data++;
 							break;
 						case	0xc000:										// 2x2 vq code
-							blit2_32( (byte *)&vq2[(*data)*8], status[index], spl );
+							blit2_32( (byte *)&cin->vq2[(*data)*8], status[index], spl );
 							data++;
-							blit2_32( (byte *)&vq2[(*data)*8], status[index]+8, spl );
+							blit2_32( (byte *)&cin->vq2[(*data)*8], status[index]+8, spl );
 							data++;
-							blit2_32( (byte *)&vq2[(*data)*8], status[index]+spl*2, spl );
+							blit2_32( (byte *)&cin->vq2[(*data)*8], status[index]+spl*2, spl );
 							data++;
-							blit2_32( (byte *)&vq2[(*data)*8], status[index]+spl*2+8, spl );
+							blit2_32( (byte *)&cin->vq2[(*data)*8], status[index]+spl*2+8, spl );
 							data++;
 							break;
 						case	0x4000:										// motion compensation
-							move4_32( status[index] + cin.mcomp[(*data)], status[index], spl );
+							move4_32( status[index] + cin->mcomp[(*data)], status[index], spl );
 							data++;
 							break;
 					}
@@ -539,7 +653,7 @@ int		spl;
 				}
 				break;
 			case	0x4000:													// motion compensation
-				move8_32( status[index] + cin.mcomp[(*data)], status[index], spl );
+				move8_32( status[index] + cin->mcomp[(*data)], status[index], spl );
 				data++;
 				index += 5;
 				break;
@@ -614,6 +728,24 @@ static void ROQ_GenYUVTables( void )
 	*d++ = *b;	\
 	a++; b++; }
 
+#if idsse2
+// one 4 pixel row of a 4x4 and two 8 pixel rows of an 8x8 per step
+#define VQ2TO4_32(a,b,c,d) { \
+	__m128i	pa, pb, da, db; \
+	pa = _mm_loadl_epi64( (const __m128i *)a ); \
+	pb = _mm_loadl_epi64( (const __m128i *)b ); \
+	da = _mm_unpacklo_epi32( pa, pa ); \
+	db = _mm_unpacklo_epi32( pb, pb ); \
+	_mm_storeu_si128( (__m128i *)c, _mm_unpacklo_epi64( pa, pb ) ); \
+	_mm_storeu_si128( (__m128i *)d, da ); \
+	_mm_storeu_si128( (__m128i *)(d+4), db ); \
+	_mm_storeu_si128( (__m128i *)(d+8), da ); \
+	_mm_storeu_si128( (__m128i *)(d+12), db ); \
+	a += 2; b += 2; c += 4; d += 16; }
+#else
+#define VQ2TO4_32	VQ2TO4
+#endif
+
 /******************************************************************************
 *
 * Function:		
@@ -677,6 +809,36 @@ static unsigned int yuv_to_rgb24( long y, long u, long v )
 }
 #endif
 
+#if idsse2 && !defined(MACOS_X)
+/******************************************************************************
+*
+* Function:		yuv4_to_rgb24
+*
+* Description:	yuv_to_rgb24 for the four pixels of a codebook entry, which
+*				share their chroma.  The saturating packs do the clamping,
+*				so the result is bit exact with the scalar version.
+*
+******************************************************************************/
+
+static void yuv4_to_rgb24( long y0, long y1, long y2, long y3, long u, long v, unsigned int *out )
+{
+	__m128i	yy, r, g, b, px;
+
+	yy = _mm_setr_epi32( ROQ_YY_tab[y0], ROQ_YY_tab[y1], ROQ_YY_tab[y2], ROQ_YY_tab[y3] );
+
+	r = _mm_srai_epi32( _mm_add_epi32( yy, _mm_set1_epi32( ROQ_VR_tab[v] ) ), 6 );
+	g = _mm_srai_epi32( _mm_add_epi32( yy, _mm_set1_epi32( ROQ_UG_tab[u] + ROQ_VG_tab[v] ) ), 6 );
+	b = _mm_srai_epi32( _mm_add_epi32( yy, _mm_set1_epi32( ROQ_UB_tab[u] ) ), 6 );
+
+	// r0-3 b0-3 g0-3 a0-3, then interleaved to r g b a per pixel
+	px = _mm_packus_epi16( _mm_packs_epi32( r, b ), _mm_packs_epi32( g, _mm_set1_epi32( 255 ) ) );
+	px = _mm_unpacklo_epi8( px, _mm_srli_si128( px, 8 ) );
+	px = _mm_unpacklo_epi16( px, _mm_srli_si128( px, 8 ) );
+
+	_mm_storeu_si128( (__m128i *)out, px );
+}
+#endif
+
 /******************************************************************************
 *
 * Function:		
@@ -703,7 +865,7 @@ static void decodeCodeBook( byte *input, unsigned short roq_flags )
 
 	four *= 2;
 
-	bptr = (unsigned short *)vq2;
+	bptr = (unsigned short *)cin->vq2;
 
 	if (!cinTable[currentHandle].half) {
 		if (!cinTable[currentHandle].smootheddouble) {
@@ -724,12 +886,12 @@ static void decodeCodeBook( byte *input, unsigned short roq_flags )
 					*bptr++ = yuv_to_rgb( y3, cr, cb );
 				}
 
-				cptr = (unsigned short *)vq4;
-				dptr = (unsigned short *)vq8;
+				cptr = (unsigned short *)cin->vq4;
+				dptr = (unsigned short *)cin->vq8;
 		
 				for(i=0;i<four;i++) {
-					aptr = (unsigned short *)vq2 + (*input++)*4;
-					bptr = (unsigned short *)vq2 + (*input++)*4;
+					aptr = (unsigned short *)cin->vq2 + (*input++)*4;
+					bptr = (unsigned short *)cin->vq2 + (*input++)*4;
 					for(j=0;j<2;j++)
 						VQ2TO4(aptr,bptr,cptr,dptr);
 				}
@@ -742,20 +904,25 @@ static void decodeCodeBook( byte *input, unsigned short roq_flags )
 					y3 = (long)*input++;
 					cr = (long)*input++;
 					cb = (long)*input++;
+#if idsse2 && !defined(MACOS_X)
+					yuv4_to_rgb24( y0, y1, y2, y3, cr, cb, ibptr );
+					ibptr += 4;
+#else
 					*ibptr++ = yuv_to_rgb24( y0, cr, cb );
 					*ibptr++ = yuv_to_rgb24( y1, cr, cb );
 					*ibptr++ = yuv_to_rgb24( y2, cr, cb );
 					*ibptr++ = yuv_to_rgb24( y3, cr, cb );
+#endif
 				}
 
-				icptr = (unsigned int *)vq4;
-				idptr = (unsigned int *)vq8;
+				icptr = (unsigned int *)cin->vq4;
+				idptr = (unsigned int *)cin->vq8;
 	
 				for(i=0;i<four;i++) {
-					iaptr = (unsigned int *)vq2 + (*input++)*4;
-					ibptr = (unsigned int *)vq2 + (*input++)*4;
+					iaptr = (unsigned int *)cin->vq2 + (*input++)*4;
+					ibptr = (unsigned int *)cin->vq2 + (*input++)*4;
 					for(j=0;j<2;j++) 
-						VQ2TO4(iaptr, ibptr, icptr, idptr);
+						VQ2TO4_32(iaptr, ibptr, icptr, idptr);
 				}
 			} else if (cinTable[currentHandle].samplesPerPixel==1) {
 				bbptr = (byte *)bptr;
@@ -766,12 +933,12 @@ static void decodeCodeBook( byte *input, unsigned short roq_flags )
 					*bbptr++ = cinTable[currentHandle].gray[*input]; input +=3;
 				}
 
-				bcptr = (byte *)vq4;
-				bdptr = (byte *)vq8;
+				bcptr = (byte *)cin->vq4;
+				bdptr = (byte *)cin->vq8;
 	
 				for(i=0;i<four;i++) {
-					baptr = (byte *)vq2 + (*input++)*4;
-					bbptr = (byte *)vq2 + (*input++)*4;
+					baptr = (byte *)cin->vq2 + (*input++)*4;
+					bbptr = (byte *)cin->vq2 + (*input++)*4;
 					for(j=0;j<2;j++) 
 						VQ2TO4(baptr,bbptr,bcptr,bdptr);
 				}
@@ -798,12 +965,12 @@ static void decodeCodeBook( byte *input, unsigned short roq_flags )
 					*bptr++ = yuv_to_rgb( y3, cr, cb );
 				}
 
-				cptr = (unsigned short *)vq4;
-				dptr = (unsigned short *)vq8;
+				cptr = (unsigned short *)cin->vq4;
+				dptr = (unsigned short *)cin->vq8;
 		
 				for(i=0;i<four;i++) {
-					aptr = (unsigned short *)vq2 + (*input++)*8;
-					bptr = (unsigned short *)vq2 + (*input++)*8;
+					aptr = (unsigned short *)cin->vq2 + (*input++)*8;
+					bptr = (unsigned short *)cin->vq2 + (*input++)*8;
 					for(j=0;j<2;j++) {
 						VQ2TO4(aptr,bptr,cptr,dptr);
 						VQ2TO4(aptr,bptr,cptr,dptr);
@@ -818,6 +985,11 @@ static void decodeCodeBook( byte *input, unsigned short roq_flags )
 					y3 = (long)*input++;
 					cr = (long)*input++;
 					cb = (long)*input++;
+#if idsse2 && !defined(MACOS_X)
+					yuv4_to_rgb24( y0, y1, ((y0*3)+y2)/4, ((y1*3)+y3)/4, cr, cb, ibptr );
+					yuv4_to_rgb24( (y0+(y2*3))/4, (y1+(y3*3))/4, y2, y3, cr, cb, ibptr + 4 );
+					ibptr += 8;
+#else
 					*ibptr++ = yuv_to_rgb24( y0, cr, cb );
 					*ibptr++ = yuv_to_rgb24( y1, cr, cb );
 					*ibptr++ = yuv_to_rgb24( ((y0*3)+y2)/4, cr, cb );
@@ -826,17 +998,18 @@ static void decodeCodeBook( byte *input, unsigned short roq_flags )
 					*ibptr++ = yuv_to_rgb24( (y1+(y3*3))/4, cr, cb );
 					*ibptr++ = yuv_to_rgb24( y2, cr, cb );
 					*ibptr++ = yuv_to_rgb24( y3, cr, cb );
+#endif
 				}
 
-				icptr = (unsigned int *)vq4;
-				idptr = (unsigned int *)vq8;
+				icptr = (unsigned int *)cin->vq4;
+				idptr = (unsigned int *)cin->vq8;
 	
 				for(i=0;i<four;i++) {
-					iaptr = (unsigned int *)vq2 + (*input++)*8;
-					ibptr = (unsigned int *)vq2 + (*input++)*8;
+					iaptr = (unsigned int *)cin->vq2 + (*input++)*8;
+					ibptr = (unsigned int *)cin->vq2 + (*input++)*8;
 					for(j=0;j<2;j++) {
-						VQ2TO4(iaptr, ibptr, icptr, idptr);
-						VQ2TO4(iaptr, ibptr, icptr, idptr);
+						VQ2TO4_32(iaptr, ibptr, icptr, idptr);
+						VQ2TO4_32(iaptr, ibptr, icptr, idptr);
 					}
 				}
 			} else if (cinTable[currentHandle].samplesPerPixel==1) {
@@ -856,12 +1029,12 @@ static void decodeCodeBook( byte *input, unsigned short roq_flags )
 					*bbptr++ = cinTable[currentHandle].gray[y3];
 				}
 
-				bcptr = (byte *)vq4;
-				bdptr = (byte *)vq8;
+				bcptr = (byte *)cin->vq4;
+				bdptr = (byte *)cin->vq8;
 	
 				for(i=0;i<four;i++) {
-					baptr = (byte *)vq2 + (*input++)*8;
-					bbptr = (byte *)vq2 + (*input++)*8;
+					baptr = (byte *)cin->vq2 + (*input++)*8;
+					bbptr = (byte *)cin->vq2 + (*input++)*8;
 					for(j=0;j<2;j++) {
 						VQ2TO4(baptr,bbptr,bcptr,bdptr);
 						VQ2TO4(baptr,bbptr,bcptr,bdptr);
@@ -883,12 +1056,12 @@ static void decodeCodeBook( byte *input, unsigned short roq_flags )
 				*bptr++ = yuv_to_rgb( y2, cr, cb );
 			}
 
-			cptr = (unsigned short *)vq4;
-			dptr = (unsigned short *)vq8;
+			cptr = (unsigned short *)cin->vq4;
+			dptr = (unsigned short *)cin->vq8;
 	
 			for(i=0;i<four;i++) {
-				aptr = (unsigned short *)vq2 + (*input++)*2;
-				bptr = (unsigned short *)vq2 + (*input++)*2;
+				aptr = (unsigned short *)cin->vq2 + (*input++)*2;
+				bptr = (unsigned short *)cin->vq2 + (*input++)*2;
 				for(j=0;j<2;j++) { 
 					VQ2TO2(aptr,bptr,cptr,dptr);
 				}
@@ -901,12 +1074,12 @@ static void decodeCodeBook( byte *input, unsigned short roq_flags )
 				*bbptr++ = cinTable[currentHandle].gray[*input]; input+=4;
 			}
 
-			bcptr = (byte *)vq4;
-			bdptr = (byte *)vq8;
+			bcptr = (byte *)cin->vq4;
+			bdptr = (byte *)cin->vq8;
 	
 			for(i=0;i<four;i++) {
-				baptr = (byte *)vq2 + (*input++)*2;
-				bbptr = (byte *)vq2 + (*input++)*2;
+				baptr = (byte *)cin->vq2 + (*input++)*2;
+				bbptr = (byte *)cin->vq2 + (*input++)*2;
 				for(j=0;j<2;j++) { 
 					VQ2TO2(baptr,bbptr,bcptr,bdptr);
 				}
@@ -922,12 +1095,12 @@ static void decodeCodeBook( byte *input, unsigned short roq_flags )
 				*ibptr++ = yuv_to_rgb24( y2, cr, cb );
 			}
 
-			icptr = (unsigned int *)vq4;
-			idptr = (unsigned int *)vq8;
+			icptr = (unsigned int *)cin->vq4;
+			idptr = (unsigned int *)cin->vq8;
 	
 			for(i=0;i<four;i++) {
-				iaptr = (unsigned int *)vq2 + (*input++)*2;
-				ibptr = (unsigned int *)vq2 + (*input++)*2;
+				iaptr = (unsigned int *)cin->vq2 + (*input++)*2;
+				ibptr = (unsigned int *)cin->vq2 + (*input++)*2;
 				for(j=0;j<2;j++) { 
 					VQ2TO2(iaptr,ibptr,icptr,idptr);
 				}
@@ -961,10 +1134,10 @@ static void recurseQuad( long startX, long startY, long quadSize, long xOff, lon
 
 	if ( (startX >= lowx) && (startX+quadSize) <= (bigx) && (startY+quadSize) <= (bigy) && (startY >= lowy) && quadSize <= MAXSIZE) {
 		useY = startY;
-		scroff = cin.linbuf + (useY+((cinTable[currentHandle].CIN_HEIGHT-bigy)>>1)+yOff)*(cinTable[currentHandle].samplesPerLine) + (((startX+xOff))*cinTable[currentHandle].samplesPerPixel);
+		scroff = cin->linbuf + (useY+((cinTable[currentHandle].CIN_HEIGHT-bigy)>>1)+yOff)*(cinTable[currentHandle].samplesPerLine) + (((startX+xOff))*cinTable[currentHandle].samplesPerPixel);
 
-		cin.qStatus[0][cinTable[currentHandle].onQuad  ] = scroff;
-		cin.qStatus[1][cinTable[currentHandle].onQuad++] = scroff+offset;
+		cin->qStatus[0][cinTable[currentHandle].onQuad  ] = scroff;
+		cin->qStatus[1][cinTable[currentHandle].onQuad++] = scroff+offset;
 	}
 
 	if ( quadSize != MINSIZE ) {
@@ -990,14 +1163,14 @@ static void setupQuad( long xOff, long yOff )
 	long numQuadCels, i,x,y;
 	byte *temp;
 
-	if (xOff == cin.oldXOff && yOff == cin.oldYOff && cinTable[currentHandle].ysize == cin.oldysize && cinTable[currentHandle].xsize == cin.oldxsize) {
+	if (xOff == cin->oldXOff && yOff == cin->oldYOff && cinTable[currentHandle].ysize == cin->oldysize && cinTable[currentHandle].xsize == cin->oldxsize) {
 		return;
 	}
 
-	cin.oldXOff = xOff;
-	cin.oldYOff = yOff;
-	cin.oldysize = cinTable[currentHandle].ysize;
-	cin.oldxsize = cinTable[currentHandle].xsize;
+	cin->oldXOff = xOff;
+	cin->oldYOff = yOff;
+	cin->oldysize = cinTable[currentHandle].ysize;
+	cin->oldxsize = cinTable[currentHandle].xsize;
 
 	numQuadCels  = (cinTable[currentHandle].CIN_WIDTH*cinTable[currentHandle].CIN_HEIGHT) / (16);
 	numQuadCels += numQuadCels/4 + numQuadCels/16;
@@ -1016,8 +1189,8 @@ static void setupQuad( long xOff, long yOff )
 	temp = NULL;
 
 	for(i=(numQuadCels-64);i<numQuadCels;i++) {
-		cin.qStatus[0][i] = temp;			  // eoq
-		cin.qStatus[1][i] = temp;			  // eoq
+		cin->qStatus[0][i] = temp;			  // eoq
+		cin->qStatus[1][i] = temp;			  // eoq
 	}
 }
 
@@ -1050,8 +1223,8 @@ static void readQuadInfo( byte *qData )
 	cinTable[currentHandle].VQ0 = cinTable[currentHandle].VQNormal;
 	cinTable[currentHandle].VQ1 = cinTable[currentHandle].VQBuffer;
 
-	cinTable[currentHandle].t[0] = (0 - (unsigned int)cin.linbuf)+(unsigned int)cin.linbuf+cinTable[currentHandle].screenDelta;
-	cinTable[currentHandle].t[1] = (0 - ((unsigned int)cin.linbuf + cinTable[currentHandle].screenDelta))+(unsigned int)cin.linbuf;
+	cinTable[currentHandle].t[0] = (0 - (unsigned int)cin->linbuf)+(unsigned int)cin->linbuf+cinTable[currentHandle].screenDelta;
+	cinTable[currentHandle].t[1] = (0 - ((unsigned int)cin->linbuf + cinTable[currentHandle].screenDelta))+(unsigned int)cin->linbuf;
 
         cinTable[currentHandle].drawX = cinTable[currentHandle].CIN_WIDTH;
         cinTable[currentHandle].drawY = cinTable[currentHandle].CIN_HEIGHT;
@@ -1093,7 +1266,7 @@ static void RoQPrepMcomp( long xoff, long yoff )
 		temp2 = (y+yoff-8)*i;
 		for(x=0;x<16;x++) {
 			temp = (x+xoff-8)*j;
-			cin.mcomp[(x*16)+y] = cinTable[currentHandle].normalBuffer0-(temp2+temp);
+			cin->mcomp[(x*16)+y] = cinTable[currentHandle].normalBuffer0-(temp2+temp);
 		}
 	}
 }
@@ -1108,12 +1281,18 @@ static void RoQPrepMcomp( long xoff, long yoff )
 
 static void initRoQ() 
 {
+	static qboolean	tablesBuilt;
+
 	if (currentHandle < 0) return;
 
 	cinTable[currentHandle].VQNormal = (void (*)(byte *, void *))blitVQQuad32fs;
 	cinTable[currentHandle].VQBuffer = (void (*)(byte *, void *))blitVQQuad32fs;
 	cinTable[currentHandle].samplesPerPixel = 4;
-	ROQ_GenYUVTables();
+	// the tables are shared, don't rewrite them under a decoding thread
+	if ( !tablesBuilt ) {
+		ROQ_GenYUVTables();
+		tablesBuilt = qtrue;
+	}
 	RllSetupTable();
 }
 
@@ -1140,16 +1319,112 @@ static byte* RoQFetchInterlaced( byte *source ) {
 	return cinTable[currentHandle].buf2;
 }
 */
+
+/*
+==================
+CIN_FillInput
+
+The decode thread can't use the file system, so the main thread reads
+ahead into the input buffer of a threaded cinematic for it
+==================
+*/
+static void CIN_FillInput( void ) {
+	int		space, size, start, read;
+
+	while ( 1 ) {
+		space = CIN_INPUT_SIZE - ( cin->inputHead - cin->inputTail );
+		size = cinTable[currentHandle].ROQSize - cin->inputRead;
+		start = cin->inputHead & ( CIN_INPUT_SIZE - 1 );
+		if ( size > space ) {
+			size = space;
+		}
+		if ( size > CIN_INPUT_SIZE - start ) {
+			size = CIN_INPUT_SIZE - start;
+		}
+		if ( size <= 0 ) {
+			return;
+		}
+
+		read = FS_Read( cin->input + start, size, cinTable[currentHandle].iFile );
+		if ( read <= 0 ) {
+			// short file, let the decoder run off the end
+			cin->inputRead = cinTable[currentHandle].ROQSize;
+			return;
+		}
+		cin->inputHead += read;
+		cin->inputRead += read;
+	}
+}
+
+/*
+==================
+CIN_InputReady
+
+True if a threaded cinematic has size bytes read ahead, or all there is
+==================
+*/
+static qboolean CIN_InputReady( int size ) {
+	return cin->inputHead - cin->inputTail >= size || cin->inputRead >= cinTable[currentHandle].ROQSize;
+}
+
+/*
+==================
+CIN_Read
+
+Threaded cinematics read what CIN_FillInput has read ahead, the others
+go through the streaming thread
+==================
+*/
+static void CIN_Read( void *buffer, int size ) {
+	byte	*out;
+	int		start, block;
+
+	if ( cinTable[currentHandle].threaded ) {
+		out = (byte *)buffer;
+		if ( size > cin->inputHead - cin->inputTail ) {
+			size = cin->inputHead - cin->inputTail;
+		}
+		while ( size > 0 ) {
+			start = cin->inputTail & ( CIN_INPUT_SIZE - 1 );
+			block = CIN_INPUT_SIZE - start;
+			if ( block > size ) {
+				block = size;
+			}
+			Com_Memcpy( out, cin->input + start, block );
+			cin->inputTail += block;
+			out += block;
+			size -= block;
+		}
+	} else {
+		Sys_StreamedRead( buffer, size, 1, cinTable[currentHandle].iFile );
+	}
+}
+
 static void RoQReset() {
 	
 	if (currentHandle < 0) return;
 
-	Sys_EndStreamedFile(cinTable[currentHandle].iFile);
+	if ( cin_inThread ) {
+		// the file system belongs to the main thread, CIN_RunCinematic reopens it
+		cinTable[currentHandle].resetPending = qtrue;
+		return;
+	}
+	cinTable[currentHandle].resetPending = qfalse;
+
+	if ( !cinTable[currentHandle].threaded ) {
+		Sys_EndStreamedFile(cinTable[currentHandle].iFile);
+	}
 	FS_FCloseFile( cinTable[currentHandle].iFile );
 	FS_FOpenFileRead (cinTable[currentHandle].fileName, &cinTable[currentHandle].iFile, qtrue);
-	// let the background thread start reading ahead
-	Sys_BeginStreamedFile( cinTable[currentHandle].iFile, 0x10000 );
-	Sys_StreamedRead (cin.file, 16, 1, cinTable[currentHandle].iFile);
+	if ( !cinTable[currentHandle].threaded ) {
+		// let the background thread start reading ahead
+		Sys_BeginStreamedFile( cinTable[currentHandle].iFile, 0x10000 );
+	} else {
+		cin->inputHead = cin->inputTail = 0;
+		cin->inputRead = 0;
+		CIN_FillInput();
+	}
+	CIN_Read( cin->file, 16 );
 	RoQ_init();
 	cinTable[currentHandle].status = FMV_LOOPED;
 }
@@ -1169,8 +1444,9 @@ static void RoQInterrupt(void)
         int		ssize;
         
 	if (currentHandle < 0) return;
+	if (cinTable[currentHandle].resetPending) return;
 
-	Sys_StreamedRead( cin.file, cinTable[currentHandle].RoQFrameSize+8, 1, cinTable[currentHandle].iFile );
+	CIN_Read( cin->file, cinTable[currentHandle].RoQFrameSize+8 );
 	if ( cinTable[currentHandle].RoQPlayed >= cinTable[currentHandle].ROQSize ) { 
 		if (cinTable[currentHandle].holdAtEnd==qfalse) {
 			if (cinTable[currentHandle].looping) {
@@ -1184,7 +1460,7 @@ static void RoQInterrupt(void)
 		return; 
 	}
 
-	framedata = cin.file;
+	framedata = cin->file;
 //
 // new frame is ready
 //
@@ -1195,16 +1471,16 @@ redump:
 			if ((cinTable[currentHandle].numQuads&1)) {
 				cinTable[currentHandle].normalBuffer0 = cinTable[currentHandle].t[1];
 				RoQPrepMcomp( cinTable[currentHandle].roqF0, cinTable[currentHandle].roqF1 );
-				cinTable[currentHandle].VQ1( (byte *)cin.qStatus[1], framedata);
-				cinTable[currentHandle].buf = 	cin.linbuf + cinTable[currentHandle].screenDelta;
+				cinTable[currentHandle].VQ1( (byte *)cin->qStatus[1], framedata);
+				cinTable[currentHandle].buf = 	cin->linbuf + cinTable[currentHandle].screenDelta;
 			} else {
 				cinTable[currentHandle].normalBuffer0 = cinTable[currentHandle].t[0];
 				RoQPrepMcomp( cinTable[currentHandle].roqF0, cinTable[currentHandle].roqF1 );
-				cinTable[currentHandle].VQ0( (byte *)cin.qStatus[0], framedata );
-				cinTable[currentHandle].buf = 	cin.linbuf;
+				cinTable[currentHandle].VQ0( (byte *)cin->qStatus[0], framedata );
+				cinTable[currentHandle].buf = 	cin->linbuf;
 			}
 			if (cinTable[currentHandle].numQuads == 0) {		// first frame
-				Com_Memcpy(cin.linbuf+cinTable[currentHandle].screenDelta, cin.linbuf, cinTable[currentHandle].samplesPerLine*cinTable[currentHandle].ysize);
+				Com_Memcpy(cin->linbuf+cinTable[currentHandle].screenDelta, cin->linbuf, cinTable[currentHandle].samplesPerLine*cinTable[currentHandle].ysize);
 			}
 			cinTable[currentHandle].numQuads++;
 			cinTable[currentHandle].dirty = qtrue;
@@ -1286,7 +1562,7 @@ redump:
 // one more frame hits the dust
 //
 //	assert(cinTable[currentHandle].RoQFrameSize <= 65536);
-//	r = Sys_StreamedRead( cin.file, cinTable[currentHandle].RoQFrameSize+8, 1, cinTable[currentHandle].iFile );
+//	r = Sys_StreamedRead( cin->file, cinTable[currentHandle].RoQFrameSize+8, 1, cinTable[currentHandle].iFile );
 	cinTable[currentHandle].RoQPlayed	+= cinTable[currentHandle].RoQFrameSize+8;
 }
 
@@ -1306,15 +1582,15 @@ static void RoQ_init( void )
 	cinTable[currentHandle].RoQPlayed = 24;
 
 /*	get frame rate */	
-	cinTable[currentHandle].roqFPS	 = cin.file[ 6] + cin.file[ 7]*256;
+	cinTable[currentHandle].roqFPS	 = cin->file[ 6] + cin->file[ 7]*256;
 	
 	if (!cinTable[currentHandle].roqFPS) cinTable[currentHandle].roqFPS = 30;
 
 	cinTable[currentHandle].numQuads = -1;
 
-	cinTable[currentHandle].roq_id		= cin.file[ 8] + cin.file[ 9]*256;
-	cinTable[currentHandle].RoQFrameSize	= cin.file[10] + cin.file[11]*256 + cin.file[12]*65536;
-	cinTable[currentHandle].roq_flags	= cin.file[14] + cin.file[15]*256;
+	cinTable[currentHandle].roq_id		= cin->file[ 8] + cin->file[ 9]*256;
+	cinTable[currentHandle].RoQFrameSize	= cin->file[10] + cin->file[11]*256 + cin->file[12]*65536;
+	cinTable[currentHandle].roq_flags	= cin->file[14] + cin->file[15]*256;
 
 	if (cinTable[currentHandle].RoQFrameSize > 65536 || !cinTable[currentHandle].RoQFrameSize) { 
 		return;
@@ -1344,7 +1620,9 @@ static void RoQShutdown( void ) {
 	cinTable[currentHandle].status = FMV_IDLE;
 
 	if (cinTable[currentHandle].iFile) {
-		Sys_EndStreamedFile( cinTable[currentHandle].iFile );
+		if (!cinTable[currentHandle].threaded) {
+			Sys_EndStreamedFile( cinTable[currentHandle].iFile );
+		}
 		FS_FCloseFile( cinTable[currentHandle].iFile );
 		cinTable[currentHandle].iFile = 0;
 	}
@@ -1366,15 +1644,157 @@ static void RoQShutdown( void ) {
 	currentHandle = -1;
 }
 
+/*
+==================
+CIN_DecodeAhead
+
+Shows the frame decoded ahead once its time has come, then decodes the
+next one into the half of linbuf that isn't on screen.  Called with the
+lock held, returns qtrue if there was work to do.
+==================
+*/
+static qboolean CIN_DecodeAhead( int handle ) {
+	cin_cache	*c = &cinTable[handle];
+	byte		*shown;
+	qboolean	dirty, pinned, decoded;
+	long		numQuads;
+	int			thisTime;
+
+	if (c->resetPending) {
+		return qfalse;
+	}
+	if (c->status == FMV_LOOPED) {
+		c->status = FMV_PLAY;
+	}
+	if (c->status != FMV_PLAY) {
+		return qfalse;
+	}
+
+	// shader cinematics stand still while nothing draws them
+	thisTime = CL_ScaledMilliseconds()*com_timescale->value;
+	if (thisTime - (int)c->lastTime > 100) {
+		return qfalse;
+	}
+
+	CIN_SetHandle( handle );
+
+	if (c->readyBuf) {
+		c->tfps = ((thisTime - c->startTime)*3)/100;
+		if (c->tfps < c->numQuads) {
+			return qfalse;
+		}
+		c->buf = c->readyBuf;
+		c->readyBuf = NULL;
+		c->dirty = qtrue;
+	}
+
+	// RoQInterrupt writes the buffers in place, so decode into the
+	// half that isn't shown and put the visible frame back afterwards
+	shown = c->buf;
+	dirty = c->dirty;
+	numQuads = c->numQuads;
+	decoded = qfalse;
+	while (c->numQuads == numQuads && c->status == FMV_PLAY && !c->resetPending) {
+		// the first frame fills both halves
+		if (c->numQuads <= 0) {
+			pinned = c->pins[0] || c->pins[1];
+		} else {
+			pinned = c->pins[c->numQuads & 1];
+		}
+		if (pinned) {
+			break;		// still being uploaded
+		}
+		if (!CIN_InputReady( c->RoQFrameSize + 8 )) {
+			break;		// the main thread hasn't read that far yet
+		}
+		RoQInterrupt();
+		decoded = qtrue;
+	}
+
+	// a restarted cinematic decodes its first frame into the visible
+	// half, that one is simply shown dirty
+	if (c->buf != shown) {
+		c->readyBuf = c->buf;
+		c->buf = shown;
+		c->dirty = dirty;
+	}
+
+	return decoded;
+}
+
+/*
+==================
+CIN_DecodeThread
+==================
+*/
+static void CIN_DecodeThread( void *arg ) {
+	int			i;
+	qboolean	busy;
+
+	while (!cin_threadQuit) {
+		busy = qfalse;
+		for ( i = 0 ; i < MAX_VIDEO_HANDLES ; i++ ) {
+			CIN_Lock();
+			if (cinTable[i].threaded && cinTable[i].state && cinTable[i].fileName[0]) {
+				cin_inThread = qtrue;
+				busy |= CIN_DecodeAhead( i );
+				cin_inThread = qfalse;
+			}
+			CIN_Unlock();
+		}
+		if (!busy) {
+			Sys_Sleep( 1 );
+		}
+	}
+}
+
+/*
+==================
+CIN_StartThread
+
+Returns qfalse if cinematics have to be decoded on the main thread
+==================
+*/
+static qboolean CIN_StartThread( void ) {
+	if (cin_thread) {
+		return qtrue;
+	}
+	if (!cin_lock) {
+		return qfalse;
+	}
+
+	cin_threadQuit = qfalse;
+	cin_thread = Sys_CreateThread( CIN_DecodeThread, NULL );
+	if (!cin_thread) {
+		Com_DPrintf( "CIN_StartThread: couldn't create the decode thread\n" );
+		return qfalse;
+	}
+	return qtrue;
+}
+
+static void CIN_StopThread( void ) {
+	if (cin_thread) {
+		cin_threadQuit = qtrue;
+		Sys_JoinThread( cin_thread );
+		cin_thread = NULL;
+	}
+	if (cin_lock) {
+		Sys_DestroyMutex( cin_lock );
+		cin_lock = NULL;
+	}
+}
+
 /*
 ==================
 SCR_StopCinematic
 ==================
 */
-e_status CIN_StopCinematic(int handle) {
+static e_status CIN_StopCinematic_(int handle) {
 	
-	if (handle < 0 || handle>= MAX_VIDEO_HANDLES || cinTable[handle].status == FMV_EOF) return FMV_EOF;
-	currentHandle = handle;
+	if (handle < 0 || handle>= MAX_VIDEO_HANDLES) return FMV_EOF;
+	// a threaded handle can sit at the end until the main thread closes it
+	if (cinTable[handle].status == FMV_EOF && !cinTable[handle].threaded) return FMV_EOF;
+	CIN_SetHandle( handle );
 
 	Com_DPrintf("trFMV::stop(), closing %s\n", cinTable[currentHandle].fileName);
 
@@ -1393,6 +1813,16 @@ e_status CIN_StopCinematic(int handle) {
 	return FMV_EOF;
 }
 
+e_status CIN_StopCinematic(int handle) {
+	e_status	status;
+
+	CIN_Lock();
+	status = CIN_StopCinematic_( handle );
+	CIN_Unlock();
+
+	return status;
+}
+
 /*
 ==================
 SCR_RunCinematic
@@ -1402,19 +1832,21 @@ Fetch and decompress the pending frame
 */
 
 
-e_status CIN_RunCinematic (int handle)
+static e_status CIN_RunCinematic_ (int handle)
 {
         // bk001204 - init
 	int	start = 0;
 	int     thisTime = 0;
 
-	if (handle < 0 || handle>= MAX_VIDEO_HANDLES || cinTable[handle].status == FMV_EOF) return FMV_EOF;
+	if (handle < 0 || handle>= MAX_VIDEO_HANDLES) return FMV_EOF;
 
-	if (cin.currentHandle != handle) {
-		currentHandle = handle;
-		cin.currentHandle = currentHandle;
-		cinTable[currentHandle].status = FMV_EOF;
-		RoQReset();
+	if (cinTable[handle].status == FMV_EOF) {
+		if (cinTable[handle].threaded && cinTable[handle].fileName[0]) {
+			// the decode thread ran off the end
+			CIN_SetHandle( handle );
+			RoQShutdown();
+		}
+		return cinTable[handle].status;
 	}
 
 	if (cinTable[handle].playonwalls < -1)
@@ -1422,7 +1854,23 @@ e_status CIN_RunCinematic (int handle)
 		return cinTable[handle].status;
 	}
 
-	currentHandle = handle;
+	CIN_SetHandle( handle );
+
+	if (cinTable[currentHandle].threaded) {
+		// the decode thread does the work, keep time and finish what it can't
+		thisTime = CL_ScaledMilliseconds()*com_timescale->value;
+		if (cinTable[currentHandle].shader && (abs(thisTime - cinTable[currentHandle].lastTime))>100) {
+			cinTable[currentHandle].startTime += thisTime - cinTable[currentHandle].lastTime;
+		}
+		cinTable[currentHandle].lastTime = thisTime;
+
+		if (cinTable[currentHandle].resetPending) {
+			RoQReset();
+		} else if (cinTable[currentHandle].iFile) {
+			CIN_FillInput();
+		}
+		return cinTable[handle].status;
+	}
 
 	if (cinTable[currentHandle].alterGameState) {
 		if ( cls.state != CA_CINEMATIC ) {
@@ -1469,7 +1917,18 @@ e_status CIN_RunCinematic (int handle)
 	  }
 	}
 
-	return cinTable[currentHandle].status;
+	return cinTable[handle].status;
+}
+
+e_status CIN_RunCinematic (int handle)
+{
+	e_status	status;
+
+	CIN_Lock();
+	status = CIN_RunCinematic_( handle );
+	CIN_Unlock();
+
+	return status;
 }
 
 /*
@@ -1478,7 +1937,7 @@ CL_PlayCinematic
 
 ==================
 */
-int CIN_PlayCinematic( const char *arg, int x, int y, int w, int h, int systemBits ) {
+static int CIN_PlayCinematic_( const char *arg, int x, int y, int w, int h, int systemBits ) {
 	unsigned short RoQID;
 	char	name[MAX_OSPATH];
 	int		i;
@@ -1489,7 +1948,7 @@ int CIN_PlayCinematic( const char *arg, int x, int y, int w, int h, int systemBi
 		Com_sprintf (name, sizeof(name), "%s", arg);
 	}
 
-	if (!(systemBits & CIN_system)) {
+	if (!(systemBits & CIN_system) && !cin_benchmark) {
 		for ( i = 0 ; i < MAX_VIDEO_HANDLES ; i++ ) {
 			if (!strcmp(cinTable[i].fileName, name) ) {
 				return i;
@@ -1499,10 +1958,12 @@ int CIN_PlayCinematic( const char *arg, int x, int y, int w, int h, int systemBi
 
 	Com_DPrintf("SCR_PlayCinematic( %s )\n", arg);
 
-	Com_Memset(&cin, 0, sizeof(cinematics_t) );
 	currentHandle = CIN_HandleForVideo();
 
-	cin.currentHandle = currentHandle;
+	cinTable[currentHandle].threaded = qfalse;
+	cinTable[currentHandle].resetPending = qfalse;
+	cinTable[currentHandle].readyBuf = NULL;
+	cinTable[currentHandle].pins[0] = cinTable[currentHandle].pins[1] = 0;
 
 	strcpy(cinTable[currentHandle].fileName, name);
 
@@ -1535,17 +1996,32 @@ int CIN_PlayCinematic( const char *arg, int x, int y, int w, int h, int systemBi
 		cinTable[currentHandle].playonwalls = cl_inGameVideo->integer;
 	}
 
+	if (!cinTable[currentHandle].state) {
+		cinTable[currentHandle].state = Z_Malloc( sizeof( cinematics_t ) );
+	}
+	cin = cinTable[currentHandle].state;
+	Com_Memset( cin, 0, sizeof( cinematics_t ) );
+
 	initRoQ();
 					
-	FS_Read (cin.file, 16, cinTable[currentHandle].iFile);
+	FS_Read (cin->file, 16, cinTable[currentHandle].iFile);
 
-	RoQID = (unsigned short)(cin.file[0]) + (unsigned short)(cin.file[1])*256;
+	RoQID = (unsigned short)(cin->file[0]) + (unsigned short)(cin->file[1])*256;
 	if (RoQID == 0x1084)
 	{
 		RoQ_init();
-//		FS_Read (cin.file, cinTable[currentHandle].RoQFrameSize+8, cinTable[currentHandle].iFile);
-		// let the background thread start reading ahead
-		Sys_BeginStreamedFile( cinTable[currentHandle].iFile, 0x10000 );
+//		FS_Read (cin->file, cinTable[currentHandle].RoQFrameSize+8, cinTable[currentHandle].iFile);
+		// video without sound can be decoded ahead on the decode thread,
+		// the rest has to stay in step with the raw sound samples
+		cinTable[currentHandle].threaded = cinTable[currentHandle].silent && !cinTable[currentHandle].alterGameState
+			&& cl_cinematicThread->integer && !cin_benchmark && CIN_StartThread();
+		if (!cinTable[currentHandle].threaded) {
+			// let the background thread start reading ahead
+			Sys_BeginStreamedFile( cinTable[currentHandle].iFile, 0x10000 );
+		} else {
+			cin->inputRead = 16;
+			CIN_FillInput();
+		}
 
 		cinTable[currentHandle].status = FMV_PLAY;
 		Com_DPrintf("trFMV::play(), playing %s\n", arg);
@@ -1566,6 +2042,20 @@ int CIN_PlayCinematic( const char *arg, int x, int y, int w, int h, int systemBi
 	return -1;
 }
 
+int CIN_PlayCinematic( const char *arg, int x, int y, int w, int h, int systemBits ) {
+	int		handle;
+
+	if ( !cin_lock ) {
+		cin_lock = Sys_CreateMutex();
+	}
+
+	CIN_Lock();
+	handle = CIN_PlayCinematic_( arg, x, y, w, h, systemBits );
+	CIN_Unlock();
+
+	return handle;
+}
+
 void CIN_SetExtents (int handle, int x, int y, int w, int h) {
 	if (handle < 0 || handle>= MAX_VIDEO_HANDLES || cinTable[handle].status == FMV_EOF) return;
 	cinTable[handle].xpos = x;
@@ -1586,24 +2076,16 @@ SCR_DrawCinematic
 
 ==================
 */
-void CIN_DrawCinematic (int handle) {
+static void CIN_DrawCinematic_ (int handle, byte *buf, qboolean dirty) {
 	float	x, y, w, h;
-	byte	*buf;
-
-	if (handle < 0 || handle>= MAX_VIDEO_HANDLES || cinTable[handle].status == FMV_EOF) return;
-
-	if (!cinTable[handle].buf) {
-		return;
-	}
 
 	x = cinTable[handle].xpos;
 	y = cinTable[handle].ypos;
 	w = cinTable[handle].width;
 	h = cinTable[handle].height;
-	buf = cinTable[handle].buf;
 	SCR_AdjustFrom640( &x, &y, &w, &h );
 
-	if (cinTable[handle].dirty && (cinTable[handle].CIN_WIDTH != cinTable[handle].drawX || cinTable[handle].CIN_HEIGHT != cinTable[handle].drawY)) {
+	if (dirty && (cinTable[handle].CIN_WIDTH != cinTable[handle].drawX || cinTable[handle].CIN_HEIGHT != cinTable[handle].drawY)) {
 		int ix, iy, *buf2, *buf3, xm, ym, ll;
                 
 		xm = cinTable[handle].CIN_WIDTH/256;
@@ -1653,13 +2135,63 @@ void CIN_DrawCinematic (int handle) {
                     }
                 }
 		re.DrawStretchRaw( x, y, w, h, 256, 256, (byte *)buf2, handle, qtrue);
-		cinTable[handle].dirty = qfalse;
 		Hunk_FreeTempMemory(buf2);
 		return;
 	}
 
-	re.DrawStretchRaw( x, y, w, h, cinTable[handle].drawX, cinTable[handle].drawY, buf, handle, cinTable[handle].dirty);
-	cinTable[handle].dirty = qfalse;
+	re.DrawStretchRaw( x, y, w, h, cinTable[handle].drawX, cinTable[handle].drawY, buf, handle, dirty);
+}
+
+/*
+==================
+CIN_PinFrame
+
+Keeps the decode thread from writing the half of linbuf that is being
+handed to the renderer, the lock itself can't be held across the GL
+calls because the smp back end runs cinematics too.  Takes the dirty
+flag along so a frame flipped in meanwhile isn't lost.
+==================
+*/
+static byte *CIN_PinFrame( int handle, int *half, qboolean *dirty ) {
+	byte	*buf;
+
+	CIN_Lock();
+	buf = cinTable[handle].buf;
+	*dirty = cinTable[handle].dirty;
+	*half = -1;
+	if (buf) {
+		cinTable[handle].dirty = qfalse;
+	}
+	if (buf && cinTable[handle].threaded) {
+		*half = ( buf != cinTable[handle].state->linbuf );
+		cinTable[handle].pins[*half]++;
+	}
+	CIN_Unlock();
+
+	return buf;
+}
+
+static void CIN_UnpinFrame( int handle, int half ) {
+	if (half < 0) {
+		return;
+	}
+	CIN_Lock();
+	cinTable[handle].pins[half]--;
+	CIN_Unlock();
+}
+
+void CIN_DrawCinematic (int handle) {
+	byte		*buf;
+	int			half;
+	qboolean	dirty;
+
+	if (handle < 0 || handle>= MAX_VIDEO_HANDLES || cinTable[handle].status == FMV_EOF) return;
+
+	buf = CIN_PinFrame( handle, &half, &dirty );
+	if (buf) {
+		CIN_DrawCinematic_( handle, buf, dirty );
+	}
+	CIN_UnpinFrame( handle, half );
 }
 
 void CL_PlayCinematic_f(void) {
@@ -1689,11 +2221,74 @@ void CL_PlayCinematic_f(void) {
 	if (CL_handle >= 0) {
 		do {
 			SCR_RunCinematic();
-		} while (cinTable[currentHandle].buf == NULL && cinTable[currentHandle].status == FMV_PLAY);		// wait for first frame (load codebook and sound)
+		} while (CL_handle >= 0 && cinTable[CL_handle].buf == NULL && cinTable[CL_handle].status == FMV_PLAY);		// wait for first frame (load codebook and sound)
 	}
 }
 
 
+/*
+==================
+CL_CinematicBench_f
+
+Decodes a RoQ start to finish as fast as it will go, without sound or
+drawing, and reports the rate
+==================
+*/
+void CL_CinematicBench_f( void ) {
+	cin_cache	*c;
+	int			handle, start, msec, frames;
+
+	if ( Cmd_Argc() != 2 ) {
+		Com_Printf( "usage: cinbench <file.roq>\n" );
+		return;
+	}
+
+	cin_benchmark = qtrue;
+	handle = CIN_PlayCinematic( Cmd_Argv( 1 ), 0, 0, 0, 0, CIN_silent );
+	cin_benchmark = qfalse;
+	if ( handle < 0 ) {
+		Com_Printf( "couldn't play %s\n", Cmd_Argv( 1 ) );
+		return;
+	}
+
+	CIN_Lock();
+	CIN_SetHandle( handle );
+	c = &cinTable[handle];
+
+	frames = 0;
+	start = Sys_Milliseconds();
+	while ( c->status == FMV_PLAY ) {
+		c->dirty = qfalse;
+		RoQInterrupt();
+		if ( c->dirty ) {
+			frames++;
+		}
+	}
+	msec = Sys_Milliseconds() - start;
+
+	if ( c->buf ) {
+		c->status = FMV_EOF;
+		RoQShutdown();
+	} else {
+		// RoQShutdown leaves handles that never got a frame alone
+		FS_FCloseFile( c->iFile );
+		c->iFile = 0;
+		c->fileName[0] = 0;
+		c->status = FMV_IDLE;
+	}
+	CIN_Unlock();
+
+	if ( !frames ) {
+		Com_Printf( "%s has no frames\n", Cmd_Argv( 1 ) );
+		return;
+	}
+	if ( msec < 1 ) {
+		msec = 1;
+	}
+	Com_Printf( "%i frames (%ix%i) in %i msec, %.1f fps, %.2f msec/frame\n", frames,
+		c->xsize, c->ysize, msec, frames * 1000.0f / msec, (float)msec / frames );
+}
+
 void SCR_DrawCinematic (void) {
 	if (CL_handle >= 0 && CL_handle < MAX_VIDEO_HANDLES) {
 		CIN_DrawCinematic(CL_handle);
@@ -1716,22 +2311,29 @@ void SCR_StopCinematic(void) {
 }
 
 void CIN_UploadCinematic(int handle) {
+	byte		*buf;
+	int			half;
+	qboolean	dirty;
+
 	if (handle >= 0 && handle < MAX_VIDEO_HANDLES) {
-		if (!cinTable[handle].buf) {
+		// the texture keeps the frame, later calls until the next one only bind it
+		buf = CIN_PinFrame( handle, &half, &dirty );
+		if (!buf) {
 			return;
 		}
-		if (cinTable[handle].playonwalls <= 0 && cinTable[handle].dirty) {
+		if (cinTable[handle].playonwalls <= 0 && dirty) {
 			if (cinTable[handle].playonwalls == 0) {
 				cinTable[handle].playonwalls = -1;
 			} else {
 				if (cinTable[handle].playonwalls == -1) {
 					cinTable[handle].playonwalls = -2;
 				} else {
-					cinTable[handle].dirty = qfalse;
+					dirty = qfalse;
 				}
 			}
 		}
-		re.UploadCinematic( 256, 256, 256, 256, cinTable[handle].buf, handle, cinTable[handle].dirty);
+		re.UploadCinematic( 256, 256, 256, 256, buf, handle, dirty);
+		CIN_UnpinFrame( handle, half );
 		if (cl_inGameVideo->integer == 0 && cinTable[handle].playonwalls == 1) {
 			cinTable[handle].playonwalls--;
 		}
@@ -430,21 +430,22 @@ void CL_KeyMove( usercmd_t *cmd ) {
 /*
 =================
 CL_HMDEvent
+
+Tracker poses that come through the event queue, in millionths of a degree
 =================
 */
 void CL_HMDEvent( int ax, int ay, int az, int aw, int time ) {
+	vec3_t	angles;
 
+	// a file replay stands in for the tracker while it runs
+	if ( CL_TrackReplaying() ) {
+		return;
+	}
 
-	//if ( cls.keyCatchers & KEYCATCH_UI ) {
-	//	//VM_Call( uivm, UI_MOUSE_EVENT, dx, dy );
-	//} else if (cls.keyCatchers & KEYCATCH_CGAME) {
-	//	//VM_Call (cgvm, CG_HMD_EVENT, dx, dy);
-	//} else {
-	//	cl.hmdX -= .5 * ax;
-	//	cl.hmdY += .5 * ay;
-	//	cl.hmdZ -= .5 * az;
-
-	//}
+	angles[PITCH] = ax * 0.000001f;
+	angles[YAW] = ay * 0.000001f;
+	angles[ROLL] = az * 0.000001f;
+	CL_TrackPose( angles, time );
 }
 
 /*
@@ -617,13 +618,8 @@ void CL_FinishMove( usercmd_t *cmd ) {
 	// can be determined without allowing cheating
 	cmd->serverTime = cl.serverTime;
 
-	//cmd->hangles[0] = cl.hmdX;
-	//cmd->hangles[1] = cl.hmdY;
-	//cmd->hangles[2] = cl.hmdZ;
-	//cmd->hangles[3] = cl.hmdW;
-
-	//Com_Printf("  %i, %i, %i, %i \n", cl.hmdX, cl.hmdY, cl.hmdZ, cl.hmdW);
-	//Com_Printf("  %i, %i, %i, %i \n", cmd->hangles[0], cmd->hangles[1], cmd->hangles[2], cmd->hangles[3]);
+	// the newest head pose, however long ago the last frame was
+	CL_TrackCommandPose( cmd );
 
 	for (i=0 ; i<3 ; i++) {
 		cmd->angles[i] = ANGLE2SHORT(cl.viewangles[i]);
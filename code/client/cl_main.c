@@ -65,6 +65,7 @@ cvar_t	*cl_motdString;
 cvar_t	*cl_allowDownload;
 cvar_t	*cl_conXOffset;
 cvar_t	*cl_inGameVideo;
+cvar_t	*cl_cinematicThread;
 
 cvar_t	*cl_serverStatusResendTime;
 cvar_t	*cl_trn;
@@ -396,12 +397,29 @@ CL_DemoCompleted
 void CL_DemoCompleted( void ) {
 	if (cl_timedemo && cl_timedemo->integer) {
 		int	time;
+		glCounters_t	gl;
 		
 		time = Sys_Milliseconds() - clc.timeDemoStart;
 		if ( time > 0 ) {
 			Com_Printf ("%i frames, %3.1f seconds: %3.1f fps\n", clc.timeDemoFrames,
 			time/1000.0, clc.timeDemoFrames*1000.0 / time);
 		}
+		if ( clc.timeDemoFrames > 0 ) {
+			Com_Printf ("%3.2f msec front end, %3.2f msec back end per frame\n",
+				(float)clc.timeDemoFrontEnd / clc.timeDemoFrames,
+				(float)clc.timeDemoBackEnd / clc.timeDemoFrames );
+
+			// only a recording GL driver counts these
+			re.GetGLCounters( &gl );
+			gl.frames -= clc.timeDemoGL.frames;
+			if ( gl.frames > 0 ) {
+				Com_Printf ("%i draw calls, %i state changes, %i vertices, %3.1f KB per frame\n",
+					( gl.drawCalls - clc.timeDemoGL.drawCalls ) / gl.frames,
+					( gl.stateChanges - clc.timeDemoGL.stateChanges ) / gl.frames,
+					( gl.vertices - clc.timeDemoGL.vertices ) / gl.frames,
+					( gl.bytes - clc.timeDemoGL.bytes ) / gl.frames / 1024.0 );
+			}
+		}
 	}
 
 	CL_Disconnect( qtrue );
@@ -2275,6 +2293,8 @@ void CL_Init( void ) {
 
 	CL_InitInput ();
 
+	CL_InitTracking ();
+
 	//
 	// register our variables
 	//
@@ -2320,6 +2340,7 @@ void CL_Init( void ) {
 #else
 	cl_inGameVideo = Cvar_Get ("r_inGameVideo", "1", CVAR_ARCHIVE);
 #endif
+	cl_cinematicThread = Cvar_Get ("cl_cinematicThread", "1", CVAR_ARCHIVE);
 
 	cl_serverStatusResendTime = Cvar_Get ("cl_serverStatusResendTime", "750", 0);
 
@@ -2379,6 +2400,7 @@ void CL_Init( void ) {
 	Cmd_AddCommand ("record", CL_Record_f);
 	Cmd_AddCommand ("demo", CL_PlayDemo_f);
 	Cmd_AddCommand ("cinematic", CL_PlayCinematic_f);
+	Cmd_AddCommand ("cinbench", CL_CinematicBench_f);
 	Cmd_AddCommand ("stoprecord", CL_StopRecord_f);
 	Cmd_AddCommand ("connect", CL_Connect_f);
 	Cmd_AddCommand ("reconnect", CL_Reconnect_f);
@@ -2433,6 +2455,8 @@ void CL_Shutdown( void ) {
 	
 	CL_ShutdownUI();
 
+	CL_ShutdownTracking();
+
 	Cmd_RemoveCommand ("cmd");
 	Cmd_RemoveCommand ("configstrings");
 	Cmd_RemoveCommand ("userinfo");
@@ -2442,6 +2466,7 @@ void CL_Shutdown( void ) {
 	Cmd_RemoveCommand ("record");
 	Cmd_RemoveCommand ("demo");
 	Cmd_RemoveCommand ("cinematic");
+	Cmd_RemoveCommand ("cinbench");
 	Cmd_RemoveCommand ("stoprecord");
 	Cmd_RemoveCommand ("connect");
 	Cmd_RemoveCommand ("localservers");
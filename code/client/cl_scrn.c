@@ -536,12 +536,18 @@ void SCR_UpdateScreen( void ) {
 		SCR_DrawScreenField( STEREO_CENTER );
 	}
 
-	if ( com_speeds->integer ) {
+	if ( com_speeds->integer || ( clc.demoplaying && cl_timedemo->integer ) ) {
 		re.EndFrame( &time_frontend, &time_backend );
+		if ( clc.demoplaying && clc.timeDemoStart ) {
+			clc.timeDemoFrontEnd += time_frontend;
+			clc.timeDemoBackEnd += time_backend;
+		}
 	} else {
 		re.EndFrame( NULL, NULL );
 	}
 
+	CL_TrackFrameDone();
+
 	recursive = 0;
 }
 
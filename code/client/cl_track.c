@@ -0,0 +1,465 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Foobar; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+// cl_track.c -- head tracking samples, kept apart from the frame rate
+
+#include "client.h"
+
+/*
+=============================================================================
+
+TRACKED POSES
+
+The tracking source pushes timestamped poses into a ring as fast as it
+samples them, from whatever thread it runs on.  There is one writer at
+a time, and readers only ever want the newest pose, so the ring needs
+no lock: the writer fills a slot and then publishes the new head, and a
+reader copies the newest slot and checks the writer didn't come back
+around to it in the meantime.
+
+The pose is read three times on its way to the screen: when a usercmd
+is built, when the cgame latches it just before rendering, and after
+the frame is submitted, which closes the motion-to-render measurement.
+
+=============================================================================
+*/
+
+#define	TRACK_SAMPLES		256		// must be a power of two
+#define	TRACK_MASK			( TRACK_SAMPLES - 1 )
+
+#define	TRACK_TRACE_FRAMES	600		// default tracktrace length
+
+typedef struct {
+	int			sampleTime;		// newest pose when the frame's last usercmd was built
+	int			cmdTime;		// when that usercmd was built
+	int			latchTime;		// when the cgame latched a pose, 0 if it didn't
+	int			latchSampleTime;
+	int			submitTime;		// when the frame went to the renderer
+} trackFrame_t;
+
+typedef struct {
+	trackedPose_t	samples[TRACK_SAMPLES];
+	volatile int	head;			// samples ever written, the newest is head - 1
+
+	// file replay stand-in for a tracker
+	void			*replayThread;
+	volatile qboolean	replayQuit;
+	trackedPose_t	*replay;		// times relative to the first sample
+	int				numReplay;
+
+	// this frame, filled in as the pose is used
+	trackFrame_t	frame;
+
+	// cl_trackStats, reset each second
+	int				statTime;
+	int				statHead;
+	int				statFrames;
+	int				statCmdTotal;
+	int				statRenderTotal;
+	int				statRenderMax;
+	int				statLatched;
+
+	// tracktrace
+	trackFrame_t	*trace;
+	int				traceFrames;
+	int				numTrace;
+} track_t;
+
+static track_t	track;
+
+cvar_t	*cl_trackStats;
+
+/*
+=================
+CL_TrackPose
+
+Adds a pose from the tracking source, time is Sys_Milliseconds when it
+was sampled.  Only one thread may add poses at a time.
+=================
+*/
+void CL_TrackPose( const vec3_t angles, int time ) {
+	trackedPose_t	*pose;
+	int				head;
+
+	head = track.head;
+	pose = &track.samples[head & TRACK_MASK];
+	pose->time = time;
+	VectorCopy( angles, pose->angles );
+
+	// the slot must be complete before readers can see it
+	Sys_MemoryBarrier();
+	track.head = head + 1;
+}
+
+/*
+=================
+CL_LatestTrackedPose
+
+Copies the newest pose, returns qfalse if there has never been one
+=================
+*/
+qboolean CL_LatestTrackedPose( trackedPose_t *pose ) {
+	int		head;
+
+	do {
+		head = track.head;
+		if ( !head ) {
+			return qfalse;
+		}
+		Sys_MemoryBarrier();
+		*pose = track.samples[(head - 1) & TRACK_MASK];
+		Sys_MemoryBarrier();
+
+		// retry if the writer reached the slot while it was copied
+	} while ( track.head - head >= TRACK_SAMPLES - 1 );
+
+	return qtrue;
+}
+
+/*
+=================
+CL_TrackCommandPose
+
+Puts the pose at command time into a new usercmd
+=================
+*/
+void CL_TrackCommandPose( usercmd_t *cmd ) {
+	trackedPose_t	pose;
+	int				i;
+
+	if ( !CL_LatestTrackedPose( &pose ) ) {
+		return;
+	}
+
+	for ( i = 0 ; i < 3 ; i++ ) {
+		cmd->hangles[i] = ANGLE2SHORT( pose.angles[i] );
+	}
+
+	track.frame.sampleTime = pose.time;
+	track.frame.cmdTime = Sys_Milliseconds();
+}
+
+/*
+=================
+CL_LatchTrackedPose
+
+The cgame takes the newest pose right before it renders the view
+=================
+*/
+qboolean CL_LatchTrackedPose( trackedPose_t *pose ) {
+	if ( !CL_LatestTrackedPose( pose ) ) {
+		return qfalse;
+	}
+
+	track.frame.latchTime = Sys_Milliseconds();
+	track.frame.latchSampleTime = pose->time;
+	return qtrue;
+}
+
+/*
+=================
+CL_TrackWriteTrace
+=================
+*/
+static void CL_TrackWriteTrace( void ) {
+	fileHandle_t	f;
+	trackFrame_t	*fr;
+	int				i;
+
+	f = FS_FOpenFileWrite( "tracktrace.csv" );
+	if ( !f ) {
+		Com_Printf( "couldn't write tracktrace.csv\n" );
+	} else {
+		FS_Printf( f, "frame,sample,cmd,latch,latchsample,submit,cmdlatency,renderlatency\n" );
+		for ( i = 0 ; i < track.numTrace ; i++ ) {
+			fr = &track.trace[i];
+			FS_Printf( f, "%i,%i,%i,%i,%i,%i,%i,%i\n", i, fr->sampleTime, fr->cmdTime,
+				fr->latchTime, fr->latchSampleTime, fr->submitTime,
+				fr->cmdTime - fr->sampleTime,
+				fr->submitTime - ( fr->latchTime ? fr->latchSampleTime : fr->sampleTime ) );
+		}
+		FS_FCloseFile( f );
+		Com_Printf( "wrote %i frames to tracktrace.csv\n", track.numTrace );
+	}
+
+	Z_Free( track.trace );
+	track.trace = NULL;
+	track.numTrace = track.traceFrames = 0;
+}
+
+/*
+=================
+CL_TrackFrameDone
+
+Called after the frame has been handed to the renderer.  With r_smp the
+back end may still be drawing it, so this is the time it was submitted,
+not when it reached the display.
+=================
+*/
+void CL_TrackFrameDone( void ) {
+	trackFrame_t	*fr;
+	int				now, latency;
+
+	fr = &track.frame;
+	if ( !track.head || !fr->cmdTime ) {
+		Com_Memset( fr, 0, sizeof( *fr ) );
+		return;
+	}
+
+	now = Sys_Milliseconds();
+	fr->submitTime = now;
+	if ( !track.statTime ) {
+		track.statTime = now;
+		track.statHead = track.head;
+	}
+
+	if ( track.trace ) {
+		track.trace[track.numTrace++] = *fr;
+		if ( track.numTrace == track.traceFrames ) {
+			CL_TrackWriteTrace();
+		}
+	}
+
+	if ( cl_trackStats->integer ) {
+		latency = now - ( fr->latchTime ? fr->latchSampleTime : fr->sampleTime );
+		track.statFrames++;
+		track.statCmdTotal += fr->cmdTime - fr->sampleTime;
+		track.statRenderTotal += latency;
+		if ( latency > track.statRenderMax ) {
+			track.statRenderMax = latency;
+		}
+		if ( fr->latchTime ) {
+			track.statLatched++;
+		}
+
+		if ( now - track.statTime >= 1000 ) {
+			Com_Printf( "track: %i poses/s, motion to cmd %.1f msec, motion to render %.1f msec (max %i), %i%% latched\n",
+				( track.head - track.statHead ) * 1000 / ( now - track.statTime ),
+				(float)track.statCmdTotal / track.statFrames,
+				(float)track.statRenderTotal / track.statFrames, track.statRenderMax,
+				track.statLatched * 100 / track.statFrames );
+			track.statTime = now;
+			track.statHead = track.head;
+			track.statFrames = 0;
+			track.statCmdTotal = 0;
+			track.statRenderTotal = 0;
+			track.statRenderMax = 0;
+			track.statLatched = 0;
+		}
+	}
+
+	// the command pose carries over to frames that build no usercmd
+	fr->latchTime = 0;
+	fr->latchSampleTime = 0;
+	fr->submitTime = 0;
+}
+
+/*
+=================
+CL_TrackReplayThread
+
+Plays the loaded poses back at their recorded spacing, over and over
+=================
+*/
+static void CL_TrackReplayThread( void *arg ) {
+	trackedPose_t	*pose;
+	int				start, loop, length, i;
+
+	// keep the loop point one average spacing after the last sample
+	length = track.replay[track.numReplay - 1].time;
+	if ( track.numReplay > 1 ) {
+		length += length / ( track.numReplay - 1 );
+	}
+	if ( length <= 0 ) {
+		length = 1;
+	}
+
+	start = Sys_Milliseconds();
+	for ( loop = 0 ; !track.replayQuit ; loop += length ) {
+		for ( i = 0 ; i < track.numReplay && !track.replayQuit ; i++ ) {
+			pose = &track.replay[i];
+			while ( Sys_Milliseconds() - start < loop + pose->time && !track.replayQuit ) {
+				Sys_Sleep( 1 );
+			}
+			CL_TrackPose( pose->angles, Sys_Milliseconds() );
+		}
+	}
+}
+
+/*
+=================
+CL_TrackReplaying
+=================
+*/
+qboolean CL_TrackReplaying( void ) {
+	return track.replayThread != NULL;
+}
+
+/*
+=================
+CL_StopTrackReplay
+=================
+*/
+static void CL_StopTrackReplay( void ) {
+	if ( !track.replayThread ) {
+		return;
+	}
+
+	track.replayQuit = qtrue;
+	Sys_JoinThread( track.replayThread );
+	track.replayThread = NULL;
+
+	Z_Free( track.replay );
+	track.replay = NULL;
+	track.numReplay = 0;
+}
+
+/*
+=================
+CL_TrackReplay_f
+
+trackreplay <file> plays a recorded head track as if a tracker were
+sampling it, one "<msec> <pitch> <yaw> <roll>" pose per line.
+trackreplay with no file stops it.
+=================
+*/
+static void CL_TrackReplay_f( void ) {
+	char	*buf, *text, *token;
+	int		len, count, first, i;
+
+	CL_StopTrackReplay();
+	if ( Cmd_Argc() < 2 ) {
+		return;
+	}
+
+	len = FS_ReadFile( Cmd_Argv( 1 ), (void **)&buf );
+	if ( len <= 0 ) {
+		Com_Printf( "couldn't load %s\n", Cmd_Argv( 1 ) );
+		return;
+	}
+
+	// every sample takes at least four tokens
+	track.replay = Z_Malloc( ( len / 8 + 1 ) * sizeof( *track.replay ) );
+
+	count = 0;
+	first = 0;
+	text = buf;
+	while ( 1 ) {
+		token = COM_Parse( &text );
+		if ( !token[0] ) {
+			break;
+		}
+		track.replay[count].time = atoi( token );
+		for ( i = 0 ; i < 3 ; i++ ) {
+			track.replay[count].angles[i] = atof( COM_Parse( &text ) );
+		}
+
+		if ( !count ) {
+			first = track.replay[0].time;
+		}
+		track.replay[count].time -= first;
+		if ( count && track.replay[count].time < track.replay[count-1].time ) {
+			Com_Printf( "%s: sample %i goes back in time\n", Cmd_Argv( 1 ), count );
+			break;
+		}
+		count++;
+	}
+	FS_FreeFile( buf );
+
+	if ( !count ) {
+		Com_Printf( "%s has no samples\n", Cmd_Argv( 1 ) );
+		Z_Free( track.replay );
+		track.replay = NULL;
+		return;
+	}
+	track.numReplay = count;
+
+	track.replayQuit = qfalse;
+	track.replayThread = Sys_CreateThread( CL_TrackReplayThread, NULL );
+	if ( !track.replayThread ) {
+		Com_Printf( "couldn't start the replay thread\n" );
+		Z_Free( track.replay );
+		track.replay = NULL;
+		track.numReplay = 0;
+		return;
+	}
+	Com_Printf( "replaying %i poses from %s\n", count, Cmd_Argv( 1 ) );
+}
+
+/*
+=================
+CL_TrackTrace_f
+
+tracktrace [frames] writes the pose timestamps of the next frames to
+tracktrace.csv
+=================
+*/
+static void CL_TrackTrace_f( void ) {
+	int		frames;
+
+	if ( track.trace ) {
+		Com_Printf( "already tracing\n" );
+		return;
+	}
+
+	frames = TRACK_TRACE_FRAMES;
+	if ( Cmd_Argc() > 1 ) {
+		frames = atoi( Cmd_Argv( 1 ) );
+	}
+	if ( frames <= 0 ) {
+		Com_Printf( "usage: tracktrace [frames]\n" );
+		return;
+	}
+
+	track.trace = Z_Malloc( frames * sizeof( *track.trace ) );
+	track.traceFrames = frames;
+	track.numTrace = 0;
+	Com_Printf( "tracing %i frames\n", frames );
+}
+
+/*
+=================
+CL_InitTracking
+=================
+*/
+void CL_InitTracking( void ) {
+	cl_trackStats = Cvar_Get( "cl_trackStats", "0", 0 );
+
+	Cmd_AddCommand( "trackreplay", CL_TrackReplay_f );
+	Cmd_AddCommand( "tracktrace", CL_TrackTrace_f );
+}
+
+/*
+=================
+CL_ShutdownTracking
+=================
+*/
+void CL_ShutdownTracking( void ) {
+	CL_StopTrackReplay();
+
+	if ( track.trace ) {
+		Z_Free( track.trace );
+		track.trace = NULL;
+	}
+
+	Cmd_RemoveCommand( "trackreplay" );
+	Cmd_RemoveCommand( "tracktrace" );
+}
@@ -206,6 +206,9 @@ typedef struct {
 	int			timeDemoFrames;		// counter of rendered frames
 	int			timeDemoStart;		// cls.realtime before first frame
 	int			timeDemoBaseTime;	// each frame will be at this time + frameNum * 50
+	int			timeDemoFrontEnd;	// renderer msec summed over the timedemo
+	int			timeDemoBackEnd;
+	glCounters_t	timeDemoGL;		// recording driver totals before the first frame
 
 	// big stuff at end of structure so most offsets are 15 bits or less
 	netchan_t	netchan;
@@ -352,6 +355,7 @@ extern	cvar_t	*cl_activeAction;
 extern	cvar_t	*cl_allowDownload;
 extern	cvar_t	*cl_conXOffset;
 extern	cvar_t	*cl_inGameVideo;
+extern	cvar_t	*cl_cinematicThread;
 
 //=================================================
 
@@ -481,6 +485,7 @@ void	SCR_DrawSmallChar( int x, int y, int ch );
 //
 
 void CL_PlayCinematic_f( void );
+void CL_CinematicBench_f( void );
 void SCR_DrawCinematic (void);
 void SCR_RunCinematic (void);
 void SCR_StopCinematic (void);
@@ -504,6 +509,20 @@ void CL_SetCGameTime( void );
 void CL_FirstSnapshot( void );
 void CL_ShaderStateChanged(void);
 
+//
+// cl_track.c
+//
+extern	cvar_t	*cl_trackStats;
+
+void CL_InitTracking( void );
+void CL_ShutdownTracking( void );
+void CL_TrackPose( const vec3_t angles, int time );
+qboolean CL_TrackReplaying( void );
+qboolean CL_LatestTrackedPose( trackedPose_t *pose );
+void CL_TrackCommandPose( usercmd_t *cmd );
+qboolean CL_LatchTrackedPose( trackedPose_t *pose );
+void CL_TrackFrameDone( void );
+
 //
 // cl_ui.c
 //
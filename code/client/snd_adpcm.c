@@ -328,3 +328,41 @@ void S_AdpcmEncodeSound( sfx_t *sfx, short *samples ) {
 		count -= n;
 	}
 }
+
+
+/*
+====================
+S_AdpcmCompressSound
+
+Re-encodes a resident 16 bit sound in place.  The pcm chunks go back to
+the pool before encoding, so this never needs more memory than it frees.
+====================
+*/
+void S_AdpcmCompressSound( sfx_t *sfx ) {
+	short			*samples;
+	sndBuffer		*chunk, *next;
+	int				offset;
+	int				n;
+
+	samples = Hunk_AllocateTempMemory( sfx->soundLength * sizeof(short) );
+
+	offset = 0;
+	for ( chunk = sfx->soundData ; chunk ; chunk = next ) {
+		n = sfx->soundLength - offset;
+		if( n > SND_CHUNK_SIZE ) {
+			n = SND_CHUNK_SIZE;
+		}
+		if( n > 0 ) {
+			Com_Memcpy( samples + offset, chunk->sndChunk, n * sizeof(short) );
+			offset += n;
+		}
+		next = chunk->next;
+		SND_free( chunk );
+	}
+
+	sfx->soundData = NULL;
+	sfx->soundCompressionMethod = 1;
+	S_AdpcmEncodeSound( sfx, samples );
+
+	Hunk_FreeTempMemory( samples );
+}
@@ -91,6 +91,8 @@ cvar_t		*s_mixPreStep;
 cvar_t		*s_musicVolume;
 cvar_t		*s_separation;
 cvar_t		*s_doppler;
+cvar_t		*s_mixerThread;
+cvar_t		*s_streamSize;
 
 static loopSound_t		loopSounds[MAX_GENTITIES];
 static	channel_t		*freelist = NULL;
@@ -98,6 +100,74 @@ static	channel_t		*freelist = NULL;
 int						s_rawend;
 portable_samplepair_t	s_rawsamples[MAX_RAW_SAMPLES];
 
+/*
+==============================================================
+
+mixer thread
+
+With s_mixerThread set, S_Update_ runs on its own thread so a long client
+frame can't starve the dma buffer.  The per-frame calls from cgame are
+turned into commands on a single producer, single consumer queue that the
+main thread publishes once per S_Update, so the mixer always sees a whole
+frame of loop sounds and spatialization at once.  Rarer calls that change
+shared state (registration, clearing, raw samples) take s_mixLock instead.
+
+==============================================================
+*/
+
+typedef enum {
+	SC_START_SOUND,
+	SC_STOP_LOOPING_SOUND,
+	SC_CLEAR_LOOPING_SOUNDS,
+	SC_ADD_LOOPING_SOUND,
+	SC_ADD_REAL_LOOPING_SOUND,
+	SC_UPDATE_ENTITY_POSITION,
+	SC_RESPATIALIZE
+} soundCommandType_t;
+
+typedef struct {
+	soundCommandType_t	type;
+	int					entityNum;
+	int					param;			// entchannel or killall
+	sfx_t				*sfx;
+	qboolean			hasOrigin;
+	vec3_t				origin;
+	vec3_t				velocity;
+	vec3_t				axis[3];
+	int					framecount;		// cls.framecount, for loop doppler
+	int					time;			// Com_Milliseconds, for channel ageing
+	int					queueTime;		// Sys_Milliseconds, for latency
+} soundCommand_t;
+
+#define	MAX_SOUND_COMMANDS	2048		// must be a power of two
+
+static soundCommand_t			s_commands[MAX_SOUND_COMMANDS];
+static unsigned int				s_commandWrite;		// main thread only
+static volatile unsigned int	s_commandHead;		// published by the main thread
+static volatile unsigned int	s_commandTail;		// consumed by the mixer thread
+
+static void				*s_mixThread;
+static void				*s_mixLock;
+static volatile qboolean	s_mixThreadQuit;
+
+// reported by s_info
+static int			s_underruns;
+static int			s_droppedSounds;
+static int			s_queueStalls;
+static int			s_mixEnd;
+static int			s_mixAheadMsec;
+static int			s_commandLatencyMax;
+static int			s_commandLatencyTotal;
+static int			s_commandCount;
+
+static void S_StartSound_( vec3_t origin, int entityNum, int entchannel, sfx_t *sfx, int time );
+static void S_StopLoopingSound_( int entityNum );
+static void S_ClearLoopingSounds_( qboolean killall );
+static void S_AddLoopingSound_( int entityNum, const vec3_t origin, const vec3_t velocity, sfx_t *sfx, int framecount );
+static void S_AddRealLoopingSound_( int entityNum, const vec3_t origin, const vec3_t velocity, sfx_t *sfx );
+static void S_Respatialize_( int entityNum, const vec3_t head, vec3_t axis[3], int time );
+static void S_ClearSoundBuffer_( void );
+
 
 // ====================================================================
 // User-setable variables
@@ -125,11 +195,205 @@ void S_SoundInfo_f(void) {
 			Com_Printf("No background file.\n" );
 		}
 
+		if ( s_mixThread ) {
+			Com_Printf("mixing on its own thread\n");
+		} else {
+			Com_Printf("mixing on the main thread\n");
+		}
+		Com_Printf("%5d msec mixed ahead\n", s_mixAheadMsec);
+		Com_Printf("%5d underruns\n", s_underruns);
+		Com_Printf("%5d dropped sounds\n", s_droppedSounds);
+		if ( s_mixThread ) {
+			Com_Printf("%5d commands, %i msec avg / %i msec max latency\n", s_commandCount,
+				s_commandCount ? s_commandLatencyTotal / s_commandCount : 0, s_commandLatencyMax);
+			Com_Printf("%5d queue stalls\n", s_queueStalls);
+		}
+
 	}
 	Com_Printf("----------------------\n" );
 }
 
 
+/*
+================
+S_Lock
+
+Keeps the mixer thread out while the main thread changes shared state
+================
+*/
+void S_Lock( void ) {
+	if ( s_mixThread ) {
+		Sys_LockMutex( s_mixLock );
+	}
+}
+
+void S_Unlock( void ) {
+	if ( s_mixThread ) {
+		Sys_UnlockMutex( s_mixLock );
+	}
+}
+
+/*
+================
+S_AllocCommand
+
+Returns the next free slot of the command queue, it won't be seen by the
+mixer until S_Update publishes the frame
+================
+*/
+static soundCommand_t *S_AllocCommand( soundCommandType_t type ) {
+	soundCommand_t	*cmd;
+
+	if ( s_commandWrite - s_commandTail >= MAX_SOUND_COMMANDS ) {
+		// a single frame filled the queue, hand over what we
+		// have and wait for the mixer to make room
+		s_queueStalls++;
+		Sys_MemoryBarrier();
+		s_commandHead = s_commandWrite;
+		while ( s_commandWrite - s_commandTail >= MAX_SOUND_COMMANDS ) {
+			Sys_Sleep( 1 );
+		}
+		Sys_MemoryBarrier();
+	}
+
+	cmd = &s_commands[ s_commandWrite & ( MAX_SOUND_COMMANDS - 1 ) ];
+	cmd->type = type;
+	cmd->queueTime = Sys_Milliseconds();
+	s_commandWrite++;
+
+	return cmd;
+}
+
+/*
+================
+S_RunCommands
+
+Executes queued commands up to head, called with s_mixLock held
+================
+*/
+static void S_RunCommands( unsigned int head ) {
+	soundCommand_t	*cmd;
+	int				now, latency;
+
+	Sys_MemoryBarrier();
+
+	now = Sys_Milliseconds();
+	while ( s_commandTail != head ) {
+		cmd = &s_commands[ s_commandTail & ( MAX_SOUND_COMMANDS - 1 ) ];
+
+		switch ( cmd->type ) {
+		case SC_START_SOUND:
+			S_StartSound_( cmd->hasOrigin ? cmd->origin : NULL, cmd->entityNum, cmd->param, cmd->sfx, cmd->time );
+			break;
+		case SC_STOP_LOOPING_SOUND:
+			S_StopLoopingSound_( cmd->entityNum );
+			break;
+		case SC_CLEAR_LOOPING_SOUNDS:
+			S_ClearLoopingSounds_( cmd->param );
+			break;
+		case SC_ADD_LOOPING_SOUND:
+			S_AddLoopingSound_( cmd->entityNum, cmd->origin, cmd->velocity, cmd->sfx, cmd->framecount );
+			break;
+		case SC_ADD_REAL_LOOPING_SOUND:
+			S_AddRealLoopingSound_( cmd->entityNum, cmd->origin, cmd->velocity, cmd->sfx );
+			break;
+		case SC_UPDATE_ENTITY_POSITION:
+			VectorCopy( cmd->origin, loopSounds[ cmd->entityNum ].origin );
+			break;
+		case SC_RESPATIALIZE:
+			S_Respatialize_( cmd->entityNum, cmd->origin, cmd->axis, cmd->time );
+			break;
+		}
+
+		latency = now - cmd->queueTime;
+		if ( latency > s_commandLatencyMax ) {
+			s_commandLatencyMax = latency;
+		}
+		s_commandLatencyTotal += latency;
+		s_commandCount++;
+
+		Sys_MemoryBarrier();
+		s_commandTail++;
+	}
+}
+
+/*
+================
+S_FlushCommands
+
+Runs everything queued so far, published or not, on the calling thread
+so a following clear happens in the same order it would without the
+mixer thread.  Called from the main thread with s_mixLock held.
+================
+*/
+static void S_FlushCommands( void ) {
+	if ( !s_mixThread ) {
+		return;
+	}
+	S_RunCommands( s_commandWrite );
+	s_commandHead = s_commandWrite;
+}
+
+/*
+================
+S_MixThread
+================
+*/
+static void S_MixThread( void *arg ) {
+	while ( !s_mixThreadQuit ) {
+		Sys_LockMutex( s_mixLock );
+		S_RunCommands( s_commandHead );
+		S_Update_();
+		Sys_UnlockMutex( s_mixLock );
+
+		Sys_Sleep( 5 );
+	}
+}
+
+/*
+================
+S_StartMixThread
+================
+*/
+static void S_StartMixThread( void ) {
+	if ( !s_mixerThread->integer ) {
+		return;
+	}
+
+	s_commandWrite = s_commandHead = s_commandTail = 0;
+	s_mixThreadQuit = qfalse;
+
+	s_mixLock = Sys_CreateMutex();
+	if ( s_mixLock ) {
+		s_mixThread = Sys_CreateThread( S_MixThread, NULL );
+	}
+	if ( !s_mixThread ) {
+		Com_Printf( "couldn't start the mixer thread, mixing on the main thread\n" );
+		if ( s_mixLock ) {
+			Sys_DestroyMutex( s_mixLock );
+			s_mixLock = NULL;
+		}
+	}
+}
+
+/*
+================
+S_StopMixThread
+================
+*/
+static void S_StopMixThread( void ) {
+	if ( !s_mixThread ) {
+		return;
+	}
+
+	s_mixThreadQuit = qtrue;
+	Sys_JoinThread( s_mixThread );
+	s_mixThread = NULL;
+
+	Sys_DestroyMutex( s_mixLock );
+	s_mixLock = NULL;
+}
+
 
 /*
 ================
@@ -152,6 +416,8 @@ void S_Init( void ) {
 	s_mixPreStep = Cvar_Get ("s_mixPreStep", "0.05", CVAR_ARCHIVE);
 	s_show = Cvar_Get ("s_show", "0", CVAR_CHEAT);
 	s_testsound = Cvar_Get ("s_testsound", "0", CVAR_CHEAT);
+	s_mixerThread = Cvar_Get ("s_mixerThread", "1", CVAR_ARCHIVE | CVAR_LATCH);
+	s_streamSize = Cvar_Get ("s_streamSize", "512", CVAR_ARCHIVE);
 
 	cv = Cvar_Get ("s_initsound", "1", 0);
 	if ( !cv->integer ) {
@@ -165,6 +431,7 @@ void S_Init( void ) {
 	Cmd_AddCommand("s_list", S_SoundList_f);
 	Cmd_AddCommand("s_info", S_SoundInfo_f);
 	Cmd_AddCommand("s_stop", S_StopAllSounds);
+	Cmd_AddCommand("s_mixbench", S_MixBench_f);
 
 	r = SNDDMA_Init();
 	Com_Printf("------------------------------------\n");
@@ -179,8 +446,12 @@ void S_Init( void ) {
 		s_soundtime = 0;
 		s_paintedtime = 0;
 
+		S_HRTF_Init( dma.speed );
+
 		S_StopAllSounds ();
 
+		S_StartMixThread();
+
 		S_SoundInfo_f();
 	}
 
@@ -193,14 +464,14 @@ void S_ChannelFree(channel_t *v) {
 	freelist = (channel_t*)v;
 }
 
-channel_t*	S_ChannelMalloc() {
+channel_t*	S_ChannelMalloc( int time ) {
 	channel_t *v;
 	if (freelist == NULL) {
 		return NULL;
 	}
 	v = freelist;
 	freelist = *(channel_t **)freelist;
-	v->allocTime = Com_Milliseconds();
+	v->allocTime = time;
 	return v;
 }
 
@@ -230,15 +501,20 @@ void S_Shutdown( void ) {
 		return;
 	}
 
+	S_StopMixThread();
+
+	S_CloseSoundStreams();
+
 	SNDDMA_Shutdown();
 
 	s_soundStarted = 0;
 
-    Cmd_RemoveCommand("play");
+	Cmd_RemoveCommand("play");
 	Cmd_RemoveCommand("music");
 	Cmd_RemoveCommand("stopsound");
 	Cmd_RemoveCommand("soundlist");
 	Cmd_RemoveCommand("soundinfo");
+	Cmd_RemoveCommand("s_mixbench");
 }
 
 
@@ -357,8 +633,10 @@ are no longer valid.
 ===================
 */
 void S_DisableSounds( void ) {
+	S_Lock();
 	S_StopAllSounds();
 	s_soundMuted = qtrue;
+	S_Unlock();
 }
 
 /*
@@ -371,11 +649,13 @@ void S_BeginRegistration( void ) {
 	s_soundMuted = qfalse;		// we can play again
 
 	if (s_numSfx == 0) {
+		S_Lock();
 		SND_setup();
 
 		s_numSfx = 0;
 		Com_Memset( s_knownSfx, 0, sizeof( s_knownSfx ) );
 		Com_Memset(sfxHash, 0, sizeof(sfx_t *)*LOOP_HASH);
+		S_Unlock();
 
 		S_RegisterSound("sound/feedback/hit.wav", qfalse);		// changed to a sound in baseq3
 	}
@@ -403,7 +683,7 @@ sfxHandle_t	S_RegisterSound( const char *name, qboolean compressed ) {
 	}
 
 	sfx = S_FindName( name );
-	if ( sfx->soundData ) {
+	if ( sfx->soundData || sfx->streamed ) {
 		if ( sfx->defaultSound ) {
 			Com_Printf( S_COLOR_YELLOW "WARNING: could not find %s - using default\n", sfx->soundName );
 			return 0;
@@ -425,12 +705,17 @@ sfxHandle_t	S_RegisterSound( const char *name, qboolean compressed ) {
 }
 
 void S_memoryLoad(sfx_t	*sfx) {
+	// loading may page out other sounds the mixer is reading
+	S_Lock();
+
 	// load the sound file
 	if ( !S_LoadSound ( sfx ) ) {
 //		Com_Printf( S_COLOR_YELLOW "WARNING: couldn't load sound: %s\n", sfx->soundName );
 		sfx->defaultSound = qtrue;
 	}
 	sfx->inMemory = qtrue;
+
+	S_Unlock();
 }
 
 //=============================================================================
@@ -439,10 +724,12 @@ void S_memoryLoad(sfx_t	*sfx) {
 =================
 S_SpatializeOrigin
 
-Used for spatializing s_channels
+Used for spatializing s_channels.  In binaural mode both volumes only
+carry the distance attenuation and the direction goes into hrtfIndex,
+otherwise hrtfIndex is -1.
 =================
 */
-void S_SpatializeOrigin (vec3_t origin, int master_vol, int *left_vol, int *right_vol)
+void S_SpatializeOrigin (vec3_t origin, int master_vol, int *left_vol, int *right_vol, int *hrtfIndex)
 {
     vec_t		dot;
     vec_t		dist;
@@ -465,11 +752,18 @@ void S_SpatializeOrigin (vec3_t origin, int master_vol, int *left_vol, int *righ
 
 	dot = -vec[1];
 
+	*hrtfIndex = -1;
 	if (dma.channels == 1)
 	{ // no attenuation = no spatialization
 		rscale = 1.0;
 		lscale = 1.0;
 	}
+	else if ( S_HRTF_Active() )
+	{ // the filters do the panning
+		*hrtfIndex = S_HRTF_Direction( vec );
+		rscale = 1.0;
+		lscale = 1.0;
+	}
 	else
 	{
 		rscale = 0.5 * (1.0 + dot);
@@ -500,6 +794,44 @@ void S_SpatializeOrigin (vec3_t origin, int master_vol, int *left_vol, int *righ
 // Start a sound effect
 // =======================================================================
 
+/*
+====================
+S_SoundStartAllowed
+
+False for a double start of the same sound on an entity, or when the
+entity already has too many copies of it playing
+====================
+*/
+static qboolean S_SoundStartAllowed( int entityNum, sfx_t *sfx, int time ) {
+	channel_t	*ch;
+	int			i;
+	int			inplay, allowed;
+
+	allowed = 4;
+	if (entityNum == listener_number) {
+		allowed = 8;
+	}
+
+	ch = s_channels;
+	inplay = 0;
+	for ( i = 0; i < MAX_CHANNELS ; i++, ch++ ) {		
+		if (ch->entnum == entityNum && ch->thesfx == sfx) {
+			if (time - ch->allocTime < 50) {
+//				if (Cvar_VariableValue( "cg_showmiss" )) {
+//					Com_Printf("double sound start\n");
+//				}
+				return qfalse;
+			}
+			inplay++;
+		}
+	}
+
+	if (inplay>allowed) {
+		return qfalse;
+	}
+	return qtrue;
+}
+
 /*
 ====================
 S_StartSound
@@ -510,10 +842,10 @@ Entchannel 0 will never override a playing sound
 ====================
 */
 void S_StartSound(vec3_t origin, int entityNum, int entchannel, sfxHandle_t sfxHandle ) {
-	channel_t	*ch;
-	sfx_t		*sfx;
-  int i, oldest, chosen, time;
-  int	inplay, allowed;
+	sfx_t			*sfx;
+	soundCommand_t	*cmd;
+	channel_t		*ch;
+	int				i, time;
 
 	if ( !s_soundStarted || s_soundMuted ) {
 		return;
@@ -529,8 +861,25 @@ void S_StartSound(vec3_t origin, int entityNum, int entchannel, sfxHandle_t sfxH
 	}
 
 	sfx = &s_knownSfx[ sfxHandle ];
+	time = Com_Milliseconds();
 
-	if (sfx->inMemory == qfalse) {
+	if ( sfx->streamed ) {
+		// only restart the window for a start that gets past the
+		// channel checks, and cut off the channels reading it first
+		S_Lock();
+		if ( !S_SoundStartAllowed( entityNum, sfx, time ) ) {
+			S_Unlock();
+			return;
+		}
+		for ( i = 0, ch = s_channels ; i < MAX_CHANNELS ; i++, ch++ ) {
+			if ( ch->thesfx == sfx ) {
+				S_ChannelFree( ch );
+			}
+		}
+		S_Unlock();
+
+		S_StartSoundStream( sfx );
+	} else if (sfx->inMemory == qfalse) {
 		S_memoryLoad(sfx);
 	}
 
@@ -538,37 +887,52 @@ void S_StartSound(vec3_t origin, int entityNum, int entchannel, sfxHandle_t sfxH
 		Com_Printf( "%i : %s\n", s_paintedtime, sfx->soundName );
 	}
 
-	time = Com_Milliseconds();
+	if ( s_mixThread ) {
+		cmd = S_AllocCommand( SC_START_SOUND );
+		cmd->hasOrigin = ( origin != NULL );
+		if ( origin ) {
+			VectorCopy( origin, cmd->origin );
+		}
+		cmd->entityNum = entityNum;
+		cmd->param = entchannel;
+		cmd->sfx = sfx;
+		cmd->time = time;
+		return;
+	}
+
+	S_StartSound_( origin, entityNum, entchannel, sfx, time );
+}
+
+/*
+====================
+S_StartSound_
+
+Picks a channel for a validated sound, runs on the mixer thread if there is one
+====================
+*/
+static void S_StartSound_( vec3_t origin, int entityNum, int entchannel, sfx_t *sfx, int time ) {
+	channel_t	*ch;
+	int			i, oldest, chosen;
 
 //	Com_Printf("playing %s\n", sfx->soundName);
 	// pick a channel to play on
 
-	allowed = 4;
-	if (entityNum == listener_number) {
-		allowed = 8;
+	if ( !S_SoundStartAllowed( entityNum, sfx, time ) ) {
+		return;
 	}
 
-	ch = s_channels;
-	inplay = 0;
-	for ( i = 0; i < MAX_CHANNELS ; i++, ch++ ) {		
-		if (ch[i].entnum == entityNum && ch[i].thesfx == sfx) {
-			if (time - ch[i].allocTime < 50) {
-//				if (Cvar_VariableValue( "cg_showmiss" )) {
-//					Com_Printf("double sound start\n");
-//				}
-				return;
+	// a streamed sound restarted from the top, nothing else can follow it
+	if ( sfx->streamed ) {
+		for ( i = 0, ch = s_channels ; i < MAX_CHANNELS ; i++, ch++ ) {
+			if ( ch->thesfx == sfx ) {
+				S_ChannelFree( ch );
 			}
-			inplay++;
 		}
 	}
 
-	if (inplay>allowed) {
-		return;
-	}
-
 	sfx->lastTimeUsed = time;
 
-	ch = S_ChannelMalloc();	// entityNum, entchannel);
+	ch = S_ChannelMalloc( time );	// entityNum, entchannel);
 	if (!ch) {
 		ch = s_channels;
 
@@ -598,7 +962,10 @@ void S_StartSound(vec3_t origin, int entityNum, int entchannel, sfxHandle_t sfxH
 					}
 				}
 				if (chosen == -1) {
-					Com_Printf("dropping sound\n");
+					s_droppedSounds++;
+					if ( !s_mixThread ) {
+						Com_Printf("dropping sound\n");
+					}
 					return;
 				}
 			}
@@ -622,6 +989,8 @@ void S_StartSound(vec3_t origin, int entityNum, int entchannel, sfxHandle_t sfxH
 	ch->leftvol = ch->master_vol;		// these will get calced at next spatialize
 	ch->rightvol = ch->master_vol;		// unless the game isn't running
 	ch->doppler = qfalse;
+	ch->hrtfIndex = -1;
+	ch->oldHrtfIndex = -1;
 }
 
 
@@ -653,19 +1022,31 @@ so sound doesn't stutter.
 ==================
 */
 void S_ClearSoundBuffer( void ) {
-	int		clear;
-		
 	if (!s_soundStarted)
 		return;
 
+	S_Lock();
+	S_FlushCommands();
+	S_ClearSoundBuffer_();
+	S_Unlock();
+}
+
+static void S_ClearSoundBuffer_( void ) {
+	int		clear;
+	int		i;
+
 	// stop looping sounds
 	Com_Memset(loopSounds, 0, MAX_GENTITIES*sizeof(loopSound_t));
+	for ( i = 0 ; i < MAX_GENTITIES ; i++ ) {
+		loopSounds[i].hrtfIndex = -1;
+	}
 	Com_Memset(loop_channels, 0, MAX_CHANNELS*sizeof(channel_t));
 	numLoopChannels = 0;
 
 	S_ChannelSetup();
 
 	s_rawend = 0;
+	s_mixEnd = 0;
 
 	if (dma.samplebits == 8)
 		clear = 0x80;
@@ -692,10 +1073,35 @@ void S_StopAllSounds(void) {
 		return;
 	}
 
+	S_Lock();
+
 	// stop the background music
 	S_StopBackgroundTrack();
 
 	S_ClearSoundBuffer ();
+
+	S_CloseSoundStreams();
+
+	S_Unlock();
+}
+
+/*
+==================
+S_MakeResident
+
+Loops wrap around the whole sample, so a sound used as one can't stream
+==================
+*/
+static void S_MakeResident( sfx_t *sfx ) {
+	if ( sfx->streamed ) {
+		S_CloseSoundStream( sfx );
+		sfx->noStream = qtrue;
+		sfx->inMemory = qfalse;
+	}
+
+	if (sfx->inMemory == qfalse) {
+		S_memoryLoad(sfx);
+	}
 }
 
 /*
@@ -707,6 +1113,14 @@ continuous looping sounds are added each frame
 */
 
 void S_StopLoopingSound(int entityNum) {
+	if ( s_mixThread ) {
+		S_AllocCommand( SC_STOP_LOOPING_SOUND )->entityNum = entityNum;
+		return;
+	}
+	S_StopLoopingSound_( entityNum );
+}
+
+static void S_StopLoopingSound_( int entityNum ) {
 	loopSounds[entityNum].active = qfalse;
 //	loopSounds[entityNum].sfx = 0;
 	loopSounds[entityNum].kill = qfalse;
@@ -719,11 +1133,19 @@ S_ClearLoopingSounds
 ==================
 */
 void S_ClearLoopingSounds( qboolean killall ) {
+	if ( s_mixThread ) {
+		S_AllocCommand( SC_CLEAR_LOOPING_SOUNDS )->param = killall;
+		return;
+	}
+	S_ClearLoopingSounds_( killall );
+}
+
+static void S_ClearLoopingSounds_( qboolean killall ) {
 	int i;
 	for ( i = 0 ; i < MAX_GENTITIES ; i++) {
 		if (killall || loopSounds[i].kill == qtrue || (loopSounds[i].sfx && loopSounds[i].sfx->soundLength == 0)) {
 			loopSounds[i].kill = qfalse;
-			S_StopLoopingSound(i);
+			S_StopLoopingSound_(i);
 		}
 	}
 	numLoopChannels = 0;
@@ -738,7 +1160,8 @@ Include velocity in case I get around to doing doppler...
 ==================
 */
 void S_AddLoopingSound( int entityNum, const vec3_t origin, const vec3_t velocity, sfxHandle_t sfxHandle ) {
-	sfx_t *sfx;
+	sfx_t			*sfx;
+	soundCommand_t	*cmd;
 
 	if ( !s_soundStarted || s_soundMuted ) {
 		return;
@@ -751,14 +1174,26 @@ void S_AddLoopingSound( int entityNum, const vec3_t origin, const vec3_t velocit
 
 	sfx = &s_knownSfx[ sfxHandle ];
 
-	if (sfx->inMemory == qfalse) {
-		S_memoryLoad(sfx);
-	}
+	S_MakeResident( sfx );
 
 	if ( !sfx->soundLength ) {
 		Com_Error( ERR_DROP, "%s has length 0", sfx->soundName );
 	}
 
+	if ( s_mixThread ) {
+		cmd = S_AllocCommand( SC_ADD_LOOPING_SOUND );
+		cmd->entityNum = entityNum;
+		VectorCopy( origin, cmd->origin );
+		VectorCopy( velocity, cmd->velocity );
+		cmd->sfx = sfx;
+		cmd->framecount = cls.framecount;
+		return;
+	}
+
+	S_AddLoopingSound_( entityNum, origin, velocity, sfx, cls.framecount );
+}
+
+static void S_AddLoopingSound_( int entityNum, const vec3_t origin, const vec3_t velocity, sfx_t *sfx, int framecount ) {
 	VectorCopy( origin, loopSounds[entityNum].origin );
 	VectorCopy( velocity, loopSounds[entityNum].velocity );
 	loopSounds[entityNum].active = qtrue;
@@ -776,7 +1211,7 @@ void S_AddLoopingSound( int entityNum, const vec3_t origin, const vec3_t velocit
 		lena = DistanceSquared(loopSounds[listener_number].origin, loopSounds[entityNum].origin);
 		VectorAdd(loopSounds[entityNum].origin, loopSounds[entityNum].velocity, out);
 		lenb = DistanceSquared(loopSounds[listener_number].origin, out);
-		if ((loopSounds[entityNum].framenum+1) != cls.framecount) {
+		if ((loopSounds[entityNum].framenum+1) != framecount) {
 			loopSounds[entityNum].oldDopplerScale = 1.0;
 		} else {
 			loopSounds[entityNum].oldDopplerScale = loopSounds[entityNum].dopplerScale;
@@ -787,7 +1222,7 @@ void S_AddLoopingSound( int entityNum, const vec3_t origin, const vec3_t velocit
 		}
 	}
 
-	loopSounds[entityNum].framenum = cls.framecount;
+	loopSounds[entityNum].framenum = framecount;
 }
 
 /*
@@ -799,7 +1234,8 @@ Include velocity in case I get around to doing doppler...
 ==================
 */
 void S_AddRealLoopingSound( int entityNum, const vec3_t origin, const vec3_t velocity, sfxHandle_t sfxHandle ) {
-	sfx_t *sfx;
+	sfx_t			*sfx;
+	soundCommand_t	*cmd;
 
 	if ( !s_soundStarted || s_soundMuted ) {
 		return;
@@ -812,13 +1248,25 @@ void S_AddRealLoopingSound( int entityNum, const vec3_t origin, const vec3_t vel
 
 	sfx = &s_knownSfx[ sfxHandle ];
 
-	if (sfx->inMemory == qfalse) {
-		S_memoryLoad(sfx);
-	}
+	S_MakeResident( sfx );
 
 	if ( !sfx->soundLength ) {
 		Com_Error( ERR_DROP, "%s has length 0", sfx->soundName );
 	}
+
+	if ( s_mixThread ) {
+		cmd = S_AllocCommand( SC_ADD_REAL_LOOPING_SOUND );
+		cmd->entityNum = entityNum;
+		VectorCopy( origin, cmd->origin );
+		VectorCopy( velocity, cmd->velocity );
+		cmd->sfx = sfx;
+		return;
+	}
+
+	S_AddRealLoopingSound_( entityNum, origin, velocity, sfx );
+}
+
+static void S_AddRealLoopingSound_( int entityNum, const vec3_t origin, const vec3_t velocity, sfx_t *sfx ) {
 	VectorCopy( origin, loopSounds[entityNum].origin );
 	VectorCopy( velocity, loopSounds[entityNum].velocity );
 	loopSounds[entityNum].sfx = sfx;
@@ -838,17 +1286,18 @@ All sounds are on the same cycle, so any duplicates can just
 sum up the channel multipliers.
 ==================
 */
-void S_AddLoopSounds (void) {
-	int			i, j, time;
+void S_AddLoopSounds( int time ) {
+	int			i, j;
 	int			left_total, right_total, left, right;
+	int			hrtfIndex;
+	qboolean	hrtf;
 	channel_t	*ch;
 	loopSound_t	*loop, *loop2;
 	static int	loopFrame;
 
 
 	numLoopChannels = 0;
-
-	time = Com_Milliseconds();
+	hrtf = S_HRTF_Active();
 
 	loopFrame++;
 	for ( i = 0 ; i < MAX_GENTITIES ; i++) {
@@ -858,14 +1307,15 @@ void S_AddLoopSounds (void) {
 		}
 
 		if (loop->kill) {
-			S_SpatializeOrigin( loop->origin, 127, &left_total, &right_total);			// 3d
+			S_SpatializeOrigin( loop->origin, 127, &left_total, &right_total, &hrtfIndex);			// 3d
 		} else {
-			S_SpatializeOrigin( loop->origin, 90,  &left_total, &right_total);			// sphere
+			S_SpatializeOrigin( loop->origin, 90,  &left_total, &right_total, &hrtfIndex);			// sphere
 		}
 
 		loop->sfx->lastTimeUsed = time;
 
-		for (j=(i+1); j< MAX_GENTITIES ; j++) {
+		// binaural sounds keep their own direction, so they can't be merged
+		for (j=(i+1); j< MAX_GENTITIES && !hrtf ; j++) {
 			loop2 = &loopSounds[j];
 			if ( !loop2->active || loop2->doppler || loop2->sfx != loop->sfx) {
 				continue;
@@ -873,9 +1323,9 @@ void S_AddLoopSounds (void) {
 			loop2->mergeFrame = loopFrame;
 
 			if (loop2->kill) {
-				S_SpatializeOrigin( loop2->origin, 127, &left, &right);				// 3d
+				S_SpatializeOrigin( loop2->origin, 127, &left, &right, &hrtfIndex);				// 3d
 			} else {
-				S_SpatializeOrigin( loop2->origin, 90,  &left, &right);				// sphere
+				S_SpatializeOrigin( loop2->origin, 90,  &left, &right, &hrtfIndex);				// sphere
 			}
 
 			loop2->sfx->lastTimeUsed = time;
@@ -903,6 +1353,9 @@ void S_AddLoopSounds (void) {
 		ch->doppler = loop->doppler;
 		ch->dopplerScale = loop->dopplerScale;
 		ch->oldDopplerScale = loop->oldDopplerScale;
+		ch->hrtfIndex = hrtfIndex;
+		ch->oldHrtfIndex = loop->hrtfIndex >= 0 ? loop->hrtfIndex : hrtfIndex;
+		loop->hrtfIndex = hrtfIndex;
 		numLoopChannels++;
 		if (numLoopChannels == MAX_CHANNELS) {
 			return;
@@ -959,6 +1412,8 @@ void S_RawSamples( int samples, int rate, int width, int s_channels, const byte
 		return;
 	}
 
+	S_Lock();
+
 	intVolume = 256 * volume;
 
 	if ( s_rawend < s_soundtime ) {
@@ -1039,6 +1494,8 @@ void S_RawSamples( int samples, int rate, int width, int s_channels, const byte
 		}
 	}
 
+	S_Unlock();
+
 	if ( s_rawend > s_soundtime + MAX_RAW_SAMPLES ) {
 		Com_DPrintf( "S_RawSamples: overflowed %i > %i\n", s_rawend, s_soundtime );
 	}
@@ -1057,6 +1514,14 @@ void S_UpdateEntityPosition( int entityNum, const vec3_t origin ) {
 	if ( entityNum < 0 || entityNum > MAX_GENTITIES ) {
 		Com_Error( ERR_DROP, "S_UpdateEntityPosition: bad entitynum %i", entityNum );
 	}
+	if ( s_mixThread ) {
+		soundCommand_t	*cmd;
+
+		cmd = S_AllocCommand( SC_UPDATE_ENTITY_POSITION );
+		cmd->entityNum = entityNum;
+		VectorCopy( origin, cmd->origin );
+		return;
+	}
 	VectorCopy( origin, loopSounds[entityNum].origin );
 }
 
@@ -1069,14 +1534,32 @@ Change the volumes of all the playing sounds for changes in their positions
 ============
 */
 void S_Respatialize( int entityNum, const vec3_t head, vec3_t axis[3], int inwater ) {
-	int			i;
-	channel_t	*ch;
-	vec3_t		origin;
+	soundCommand_t	*cmd;
 
 	if ( !s_soundStarted || s_soundMuted ) {
 		return;
 	}
 
+	if ( s_mixThread ) {
+		cmd = S_AllocCommand( SC_RESPATIALIZE );
+		cmd->entityNum = entityNum;
+		VectorCopy( head, cmd->origin );
+		VectorCopy( axis[0], cmd->axis[0] );
+		VectorCopy( axis[1], cmd->axis[1] );
+		VectorCopy( axis[2], cmd->axis[2] );
+		cmd->time = Com_Milliseconds();
+		return;
+	}
+
+	S_Respatialize_( entityNum, head, axis, Com_Milliseconds() );
+}
+
+static void S_Respatialize_( int entityNum, const vec3_t head, vec3_t axis[3], int time ) {
+	int			i;
+	int			hrtfIndex;
+	channel_t	*ch;
+	vec3_t		origin;
+
 	listener_number = entityNum;
 	VectorCopy(head, listener_origin);
 	VectorCopy(axis[0], listener_axis[0]);
@@ -1093,6 +1576,7 @@ void S_Respatialize( int entityNum, const vec3_t head, vec3_t axis[3], int inwat
 		if (ch->entnum == listener_number) {
 			ch->leftvol = ch->master_vol;
 			ch->rightvol = ch->master_vol;
+			ch->hrtfIndex = -1;
 		} else {
 			if (ch->fixed_origin) {
 				VectorCopy( ch->origin, origin );
@@ -1100,12 +1584,16 @@ void S_Respatialize( int entityNum, const vec3_t head, vec3_t axis[3], int inwat
 				VectorCopy( loopSounds[ ch->entnum ].origin, origin );
 			}
 
-			S_SpatializeOrigin (origin, ch->master_vol, &ch->leftvol, &ch->rightvol);
+			S_SpatializeOrigin (origin, ch->master_vol, &ch->leftvol, &ch->rightvol, &hrtfIndex);
+			if ( ch->hrtfIndex < 0 ) {
+				ch->oldHrtfIndex = hrtfIndex;	// nothing to fade from
+			}
+			ch->hrtfIndex = hrtfIndex;
 		}
 	}
 
 	// add loopsounds
-	S_AddLoopSounds ();
+	S_AddLoopSounds( time );
 }
 
 
@@ -1182,6 +1670,16 @@ void S_Update( void ) {
 	// add raw data from streamed samples
 	S_UpdateBackgroundTrack();
 
+	// keep the long sounds read ahead of the mixer
+	S_UpdateSoundStreams();
+
+	if ( s_mixThread ) {
+		// hand this frame's commands to the mixer
+		Sys_MemoryBarrier();
+		s_commandHead = s_commandWrite;
+		return;
+	}
+
 	// mix some sound
 	S_Update_();
 }
@@ -1206,7 +1704,12 @@ void S_GetSoundtime(void)
 		{	// time to chop things off to avoid 32 bit limits
 			buffers = 0;
 			s_paintedtime = fullsamples;
-			S_StopAllSounds ();
+			if ( s_mixThread ) {
+				// the background track belongs to the main thread
+				S_ClearSoundBuffer_ ();
+			} else {
+				S_StopAllSounds ();
+			}
 		}
 	}
 	oldsamplepos = samplepos;
@@ -1242,7 +1745,7 @@ void S_Update_(void) {
 		return;
 	}
 
-	thisTime = Com_Milliseconds();
+	thisTime = Sys_Milliseconds();
 
 	// Updates s_soundtime
 	S_GetSoundtime();
@@ -1252,6 +1755,11 @@ void S_Update_(void) {
 	}
 	ot = s_soundtime;
 
+	// the device has played past everything mixed last time
+	if ( s_mixEnd && s_soundtime > s_mixEnd ) {
+		s_underruns++;
+	}
+
 	// clear any sound effects that end before the current time,
 	// and start any new sounds
 	S_ScanChannelStarts();
@@ -1288,6 +1796,9 @@ void S_Update_(void) {
 
 	SNDDMA_Submit ();
 
+	s_mixEnd = endtime;
+	s_mixAheadMsec = ( endtime - s_soundtime ) * 1000 / dma.speed;
+
 	lastTime = thisTime;
 }
 
@@ -1341,7 +1852,7 @@ void S_SoundList_f( void ) {
 	sfx_t	*sfx;
 	int		size, total;
 	char	type[4][16];
-	char	mem[2][16];
+	char	mem[3][16];
 
 	strcpy(type[0], "16bit");
 	strcpy(type[1], "adpcm");
@@ -1349,13 +1860,15 @@ void S_SoundList_f( void ) {
 	strcpy(type[3], "mulaw");
 	strcpy(mem[0], "paged out");
 	strcpy(mem[1], "resident ");
+	strcpy(mem[2], "streamed ");
 	total = 0;
 	for (sfx=s_knownSfx, i=0 ; i<s_numSfx ; i++, sfx++) {
-		size = sfx->soundLength;
+		size = SND_ResidentSize( sfx );
 		total += size;
-		Com_Printf("%6i[%s] : %s[%s]\n", size, type[sfx->soundCompressionMethod], sfx->soundName, mem[sfx->inMemory] );
+		Com_Printf("%6i %7i[%s] : %s[%s]\n", sfx->soundLength, size, type[sfx->soundCompressionMethod], sfx->soundName, 
+			mem[sfx->streamed ? 2 : sfx->inMemory] );
 	}
-	Com_Printf ("Total resident: %i\n", total);
+	Com_Printf ("Total resident: %i bytes\n", total);
 	S_DisplayFreeMemory();
 }
 
@@ -1411,6 +1924,61 @@ int S_FindWavChunk( fileHandle_t f, char *chunk ) {
 	return len;
 }
 
+/*
+======================
+S_OpenWavStream
+
+Opens a wav file and leaves it positioned at the start of the samples,
+used for the music and for streamed sounds
+======================
+*/
+fileHandle_t S_OpenWavStream( const char *name, wavinfo_t *info ) {
+	fileHandle_t	f;
+	int		len;
+	char	dump[16];
+
+	Com_Memset( info, 0, sizeof( *info ) );
+
+	FS_FOpenFileRead( name, &f, qtrue );
+	if ( !f ) {
+		Com_Printf( S_COLOR_YELLOW "WARNING: couldn't open sound file %s\n", name );
+		return 0;
+	}
+
+	// skip the riff wav header
+
+	FS_Read(dump, 12, f);
+
+	if ( !S_FindWavChunk( f, "fmt " ) ) {
+		Com_Printf( "No fmt chunk in %s\n", name );
+		FS_FCloseFile( f );
+		return 0;
+	}
+
+	info->format = FGetLittleShort( f );
+	info->channels = FGetLittleShort( f );
+	info->rate = FGetLittleLong( f );
+	FGetLittleLong( f );
+	FGetLittleShort( f );
+	info->width = FGetLittleShort( f ) / 8;
+
+	if ( info->format != WAV_FORMAT_PCM ) {
+		FS_FCloseFile( f );
+		Com_Printf("Not a microsoft PCM format wav: %s\n", name);
+		return 0;
+	}
+
+	if ( ( len = S_FindWavChunk( f, "data" ) ) == 0 ) {
+		FS_FCloseFile( f );
+		Com_Printf("No data chunk in %s\n", name);
+		return 0;
+	}
+
+	info->samples = len / (info->width * info->channels);
+
+	return f;
+}
+
 /*
 ======================
 S_StopBackgroundTrack
@@ -1423,7 +1991,10 @@ void S_StopBackgroundTrack( void ) {
 	Sys_EndStreamedFile( s_backgroundFile );
 	FS_FCloseFile( s_backgroundFile );
 	s_backgroundFile = 0;
+
+	S_Lock();
 	s_rawend = 0;
+	S_Unlock();
 }
 
 /*
@@ -1432,8 +2003,6 @@ S_StartBackgroundTrack
 ======================
 */
 void S_StartBackgroundTrack( const char *intro, const char *loop ){
-	int		len;
-	char	dump[16];
 	char	name[MAX_QPATH];
 
 	if ( !intro ) {
@@ -1464,35 +2033,8 @@ void S_StartBackgroundTrack( const char *intro, const char *loop ){
 	//
 	// open up a wav file and get all the info
 	//
-	FS_FOpenFileRead( name, &s_backgroundFile, qtrue );
+	s_backgroundFile = S_OpenWavStream( name, &s_backgroundInfo );
 	if ( !s_backgroundFile ) {
-		Com_Printf( S_COLOR_YELLOW "WARNING: couldn't open music file %s\n", name );
-		return;
-	}
-
-	// skip the riff wav header
-
-	FS_Read(dump, 12, s_backgroundFile);
-
-	if ( !S_FindWavChunk( s_backgroundFile, "fmt " ) ) {
-		Com_Printf( "No fmt chunk in %s\n", name );
-		FS_FCloseFile( s_backgroundFile );
-		s_backgroundFile = 0;
-		return;
-	}
-
-	// save name for soundinfo
-	s_backgroundInfo.format = FGetLittleShort( s_backgroundFile );
-	s_backgroundInfo.channels = FGetLittleShort( s_backgroundFile );
-	s_backgroundInfo.rate = FGetLittleLong( s_backgroundFile );
-	FGetLittleLong(  s_backgroundFile );
-	FGetLittleShort(  s_backgroundFile );
-	s_backgroundInfo.width = FGetLittleShort( s_backgroundFile ) / 8;
-
-	if ( s_backgroundInfo.format != WAV_FORMAT_PCM ) {
-		FS_FCloseFile( s_backgroundFile );
-		s_backgroundFile = 0;
-		Com_Printf("Not a microsoft PCM format wav: %s\n", name);
 		return;
 	}
 
@@ -1500,15 +2042,6 @@ void S_StartBackgroundTrack( const char *intro, const char *loop ){
 		Com_Printf(S_COLOR_YELLOW "WARNING: music file %s is not 22k stereo\n", name );
 	}
 
-	if ( ( len = S_FindWavChunk( s_backgroundFile, "data" ) ) == 0 ) {
-		FS_FCloseFile( s_backgroundFile );
-		s_backgroundFile = 0;
-		Com_Printf("No data chunk in %s\n", name);
-		return;
-	}
-
-	s_backgroundInfo.samples = len / (s_backgroundInfo.width * s_backgroundInfo.channels);
-
 	s_backgroundSamples = s_backgroundInfo.samples;
 
 	//
@@ -1602,26 +2135,73 @@ void S_UpdateBackgroundTrack( void ) {
 /*
 ======================
 S_FreeOldestSound
+
+Makes room in the sound pool.  Sounds are ranked by when they were last
+used; the coldest one is recompressed to adpcm if that saves chunks, which
+the mixer decodes on the fly, and paged out if it is already compressed.
+Playing sounds count as just used and are only paged out, cutting off
+their channels, when nothing else is resident.  Streamed sounds manage
+their own window.
 ======================
 */
-
-void S_FreeOldestSound() {
-	int	i, oldest, used;
-	sfx_t	*sfx;
+qboolean S_FreeOldestSound( void ) {
+	int			i, oldest, now;
+	sfx_t		*sfx, *candidate;
+	channel_t	*ch;
 	sndBuffer	*buffer, *nbuffer;
 
-	oldest = Com_Milliseconds();
-	used = 0;
+	now = Com_Milliseconds();
+
+	for ( i = 0, ch = s_channels ; i < MAX_CHANNELS ; i++, ch++ ) {
+		if ( ch->thesfx ) {
+			ch->thesfx->lastTimeUsed = now;
+		}
+	}
+	for ( i = 0, ch = loop_channels ; i < numLoopChannels ; i++, ch++ ) {
+		if ( ch->thesfx ) {
+			ch->thesfx->lastTimeUsed = now;
+		}
+	}
 
+	candidate = NULL;
+	oldest = now;
 	for (i=1 ; i < s_numSfx ; i++) {
 		sfx = &s_knownSfx[i];
-		if (sfx->inMemory && sfx->lastTimeUsed<oldest) {
-			used = i;
+		if ( !sfx->inMemory || sfx->streamed || !sfx->soundData ) {
+			continue;
+		}
+		if ( sfx->lastTimeUsed < oldest || !candidate ) {
+			candidate = sfx;
 			oldest = sfx->lastTimeUsed;
 		}
 	}
 
-	sfx = &s_knownSfx[used];
+	sfx = candidate;
+	if ( !sfx ) {
+		return qfalse;
+	}
+
+	// an adpcm chunk holds four times the samples, so anything
+	// longer than a chunk gets smaller
+	if ( sfx->soundCompressionMethod == 0 && sfx->soundLength > SND_CHUNK_SIZE ) {
+		Com_DPrintf("S_FreeOldestSound: compressing sound %s\n", sfx->soundName);
+		S_AdpcmCompressSound( sfx );
+		return qtrue;
+	}
+
+	if ( sfx->lastTimeUsed == now ) {
+		// everything left is playing
+		for ( i = 0, ch = s_channels ; i < MAX_CHANNELS ; i++, ch++ ) {
+			if ( ch->thesfx == sfx ) {
+				S_ChannelFree( ch );
+			}
+		}
+		for ( i = 0, ch = loop_channels ; i < numLoopChannels ; i++, ch++ ) {
+			if ( ch->thesfx == sfx ) {
+				ch->thesfx = NULL;
+			}
+		}
+	}
 
 	Com_DPrintf("S_FreeOldestSound: freeing sound %s\n", sfx->soundName);
 
@@ -1633,4 +2213,5 @@ void S_FreeOldestSound() {
 	}
 	sfx->inMemory = qfalse;
 	sfx->soundData = NULL;
+	return qtrue;
 }
@@ -0,0 +1,203 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Foobar; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+
+/*****************************************************************************
+ * name:		snd_hrtf.c
+ *
+ * desc:		head related impulse responses for binaural spatialization
+ *
+ * The responses come from a structural model instead of measured data:
+ * a spherical head (Brown & Duda) gives the interaural delay and the
+ * frequency dependent head shadow for each ear, and a few pinna echoes
+ * with elevation dependent delays give the elevation and front / back
+ * cues that plain panning loses.
+ *
+ *****************************************************************************/
+
+#include "snd_local.h"
+
+#define	HEAD_RADIUS		0.0875f		// meters
+#define	SPEED_OF_SOUND	343.0f		// meters per second
+
+// pinna echoes, delays are in samples at 44.1khz
+#define	NUM_PINNA_ECHOES	5
+static const float	pinnaReflection[NUM_PINNA_ECHOES] = { 0.5f, -1.0f, 0.5f, -0.25f, 0.25f };
+static const float	pinnaScale[NUM_PINNA_ECHOES] = { 1, 5, 5, 5, 5 };
+static const float	pinnaOffset[NUM_PINNA_ECHOES] = { 2, 4, 7, 11, 13 };
+static const float	pinnaElevation[NUM_PINNA_ECHOES] = { 1, 0.5f, 0.5f, 0.5f, 0.5f };
+
+cvar_t		*s_hrtf;
+
+// filters are stored time reversed so the mixer can run a straight dot product
+hrir_t		s_hrirs[HRTF_DIRECTIONS];
+
+static int	s_hrirSpeed;
+
+/*
+=================
+S_HRTF_AddImpulse
+
+Adds a scaled impulse at a fractional sample delay
+=================
+*/
+static void S_HRTF_AddImpulse( float *ir, float delay, float scale ) {
+	int		i;
+	float	frac;
+
+	i = (int)floor( delay );
+	frac = delay - i;
+	if ( i >= 0 && i < HRTF_LENGTH ) {
+		ir[i] += scale * ( 1.0f - frac );
+	}
+	if ( i + 1 >= 0 && i + 1 < HRTF_LENGTH ) {
+		ir[i+1] += scale * frac;
+	}
+}
+
+/*
+=================
+S_HRTF_BuildEar
+
+theta is the angle between the source and the ear axis, azimuth and
+elevation are in the listener's frame, everything in radians
+=================
+*/
+static void S_HRTF_BuildEar( float *out, float theta, float azimuth, float elevation, int speed ) {
+	float	pinna[HRTF_LENGTH];
+	float	shadow[HRTF_LENGTH];
+	float	alpha, k, b0, b1, a1, norm;
+	float	delay, scale;
+	float	x1, y1;
+	int		i;
+
+	// pinna: direct sound plus elevation dependent echoes
+	Com_Memset( pinna, 0, sizeof( pinna ) );
+	pinna[0] = 1.0f;
+	scale = speed / 44100.0f;
+	for ( i = 0 ; i < NUM_PINNA_ECHOES ; i++ ) {
+		delay = pinnaScale[i] * cos( azimuth * 0.5f ) * sin( pinnaElevation[i] * ( M_PI * 0.5f - elevation ) ) + pinnaOffset[i];
+		S_HRTF_AddImpulse( pinna, fabs( delay ) * scale, pinnaReflection[i] * 0.5f );
+	}
+
+	// head shadow: one pole, one zero shelf with more treble toward the
+	// ear (alpha 2) and less behind the head (alpha 0.1 at 150 degrees),
+	// discretized with the bilinear transform
+	alpha = 1.05f + 0.95f * cos( theta * ( 180.0f / 150.0f ) );
+	k = 2.0f * speed * HEAD_RADIUS / ( 2.0f * SPEED_OF_SOUND );
+	norm = 1.0f / ( 1.0f + k );
+	b0 = ( 1.0f + alpha * k ) * norm;
+	b1 = ( 1.0f - alpha * k ) * norm;
+	a1 = ( 1.0f - k ) * norm;
+
+	x1 = y1 = 0;
+	for ( i = 0 ; i < HRTF_LENGTH ; i++ ) {
+		shadow[i] = b0 * pinna[i] + b1 * x1 - a1 * y1;
+		x1 = pinna[i];
+		y1 = shadow[i];
+	}
+
+	// interaural delay around a sphere (Woodworth)
+	if ( theta < M_PI * 0.5f ) {
+		delay = 1.0f - cos( theta );
+	} else {
+		delay = 1.0f + theta - M_PI * 0.5f;
+	}
+	delay *= HEAD_RADIUS / SPEED_OF_SOUND * speed;
+
+	Com_Memset( out, 0, HRTF_LENGTH * sizeof( float ) );
+	for ( i = 0 ; i < HRTF_LENGTH ; i++ ) {
+		if ( shadow[i] != 0 ) {
+			// time reversed for the mixer
+			S_HRTF_AddImpulse( out, HRTF_LENGTH - 1 - ( i + delay ), shadow[i] );
+		}
+	}
+}
+
+/*
+=================
+S_HRTF_Init
+
+Builds the filter set for the output rate, cheap enough to do at startup
+=================
+*/
+void S_HRTF_Init( int speed ) {
+	int		el, az;
+	float	elevation, azimuth;
+	vec3_t	dir;
+	hrir_t	*hrir;
+
+	s_hrtf = Cvar_Get( "s_hrtf", "0", CVAR_ARCHIVE );
+
+	if ( speed == s_hrirSpeed ) {
+		return;
+	}
+	s_hrirSpeed = speed;
+
+	hrir = s_hrirs;
+	for ( el = 0 ; el < HRTF_ELEVATIONS ; el++ ) {
+		elevation = ( -0.5f + (float)el / ( HRTF_ELEVATIONS - 1 ) ) * M_PI;
+		for ( az = 0 ; az < HRTF_AZIMUTHS ; az++, hrir++ ) {
+			azimuth = (float)az / HRTF_AZIMUTHS * 2 * M_PI;
+
+			// +y is to the listener's left
+			dir[0] = cos( elevation ) * cos( azimuth );
+			dir[1] = cos( elevation ) * sin( azimuth );
+			dir[2] = sin( elevation );
+
+			S_HRTF_BuildEar( hrir->left, acos( dir[1] ), azimuth, elevation, speed );
+			S_HRTF_BuildEar( hrir->right, acos( -dir[1] ), azimuth, elevation, speed );
+		}
+	}
+}
+
+/*
+=================
+S_HRTF_Active
+=================
+*/
+qboolean S_HRTF_Active( void ) {
+	return s_hrtf && s_hrtf->integer && s_hrirSpeed && dma.channels == 2;
+}
+
+/*
+=================
+S_HRTF_Direction
+
+Picks the nearest filter for a normalized direction in the listener's
+frame (forward, left, up)
+=================
+*/
+int S_HRTF_Direction( const vec3_t dir ) {
+	float	azimuth, elevation;
+	int		az, el;
+
+	azimuth = atan2( dir[1], dir[0] );
+	if ( azimuth < 0 ) {
+		azimuth += 2 * M_PI;
+	}
+	elevation = asin( dir[2] < -1.0f ? -1.0f : dir[2] > 1.0f ? 1.0f : dir[2] );
+
+	az = (int)( azimuth * HRTF_AZIMUTHS / ( 2 * M_PI ) + 0.5f ) % HRTF_AZIMUTHS;
+	el = (int)( ( elevation / M_PI + 0.5f ) * ( HRTF_ELEVATIONS - 1 ) + 0.5f );
+
+	return el * HRTF_AZIMUTHS + az;
+}
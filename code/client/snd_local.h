@@ -58,6 +58,10 @@ typedef struct sfx_s {
 	int 			soundLength;
 	char 			soundName[MAX_QPATH];
 	int				lastTimeUsed;
+	qboolean		streamed;				// too long to keep, read from disk while playing
+	qboolean		noStream;				// used as a loop, must stay resident
+	int				streamBase;				// first resident sample of a streamed sound
+	int				streamEnd;				// samples read so far of a streamed sound
 	struct sfx_s	*next;
 } sfx_t;
 
@@ -83,6 +87,7 @@ typedef struct loopSound_s {
 	float		dopplerScale;
 	float		oldDopplerScale;
 	int			framenum;
+	int			hrtfIndex;		// last binaural direction, -1 if none
 } loopSound_t;
 
 typedef struct
@@ -100,6 +105,8 @@ typedef struct
 	qboolean	fixed_origin;	// use origin instead of fetching entnum's origin
 	sfx_t		*thesfx;		// sfx structure
 	qboolean	doppler;
+	int			hrtfIndex;		// binaural direction, -1 for plain panning
+	int			oldHrtfIndex;	// direction at the last mix, crossfaded from
 } channel_t;
 
 
@@ -163,14 +170,28 @@ extern cvar_t	*s_mixahead;
 
 extern cvar_t	*s_testsound;
 extern cvar_t	*s_separation;
+extern cvar_t	*s_streamSize;
 
 qboolean S_LoadSound( sfx_t *sfx );
 
 void		SND_free(sndBuffer *v);
 sndBuffer*	SND_malloc();
 void		SND_setup();
+int			SND_ResidentSize( const sfx_t *sfx );
+
+// long sounds are streamed from disk a window at a time
+fileHandle_t S_OpenWavStream( const char *name, wavinfo_t *info );
+void		S_StartSoundStream( sfx_t *sfx );
+void		S_UpdateSoundStreams( void );
+void		S_CloseSoundStream( sfx_t *sfx );
+void		S_CloseSoundStreams( void );
 
 void S_PaintChannels(int endtime);
+void S_MixBench_f(void);
+
+// keeps the mixer thread out while shared sound state changes
+void S_Lock(void);
+void S_Unlock(void);
 
 void S_memoryLoad(sfx_t *sfx);
 portable_samplepair_t *S_GetRawSamplePointer();
@@ -182,13 +203,32 @@ void S_Spatialize(channel_t *ch);
 int  S_AdpcmMemoryNeeded( const wavinfo_t *info );
 void S_AdpcmEncodeSound( sfx_t *sfx, short *samples );
 void S_AdpcmGetSamples(sndBuffer *chunk, short *to);
+void S_AdpcmCompressSound( sfx_t *sfx );
+
+// binaural spatialization
+#define	HRTF_LENGTH			64		// taps per ear, a multiple of 4
+#define	HRTF_AZIMUTHS		36		// 10 degree steps
+#define	HRTF_ELEVATIONS		9		// 22.5 degree steps from straight down to straight up
+#define	HRTF_DIRECTIONS		(HRTF_AZIMUTHS*HRTF_ELEVATIONS)
+
+typedef struct {
+	float		left[HRTF_LENGTH];
+	float		right[HRTF_LENGTH];
+} hrir_t;
+
+extern	hrir_t	s_hrirs[HRTF_DIRECTIONS];
+extern	cvar_t	*s_hrtf;
+
+void		S_HRTF_Init( int speed );
+qboolean	S_HRTF_Active( void );
+int			S_HRTF_Direction( const vec3_t dir );
 
 // wavelet function
 
 #define SENTINEL_MULAW_ZERO_RUN 127
 #define SENTINEL_MULAW_FOUR_BIT_RUN 126
 
-void S_FreeOldestSound();
+qboolean S_FreeOldestSound();
 
 #define	NXStream byte
 
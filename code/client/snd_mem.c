@@ -45,6 +45,7 @@ static	sndBuffer	*buffer = NULL;
 static	sndBuffer	*freelist = NULL;
 static	int inUse = 0;
 static	int totalInUse = 0;
+static	int poolSize = 0;
 
 short *sfxScratchBuffer = NULL;
 sfx_t *sfxScratchPointer = NULL;
@@ -60,7 +61,9 @@ sndBuffer*	SND_malloc() {
 	sndBuffer *v;
 redo:
 	if (freelist == NULL) {
-		S_FreeOldestSound();
+		if ( !S_FreeOldestSound() ) {
+			Com_Error( ERR_FATAL, "SND_malloc: out of sound memory, raise com_soundMegs" );
+		}
 		goto redo;
 	}
 
@@ -88,6 +91,7 @@ void SND_setup() {
 	sfxScratchPointer = NULL;
 
 	inUse = scs*sizeof(sndBuffer);
+	poolSize = inUse;
 	p = buffer;;
 	q = p + scs;
 	while (--q > p)
@@ -99,6 +103,24 @@ void SND_setup() {
 	Com_Printf("Sound memory manager started\n");
 }
 
+/*
+================
+SND_ResidentSize
+
+Bytes of the pool a sound is holding
+================
+*/
+int SND_ResidentSize( const sfx_t *sfx ) {
+	sndBuffer	*chunk;
+	int			size;
+
+	size = 0;
+	for ( chunk = sfx->soundData ; chunk ; chunk = chunk->next ) {
+		size += sizeof( sndBuffer );
+	}
+	return size;
+}
+
 /*
 ===============================================================================
 
@@ -316,6 +338,293 @@ static int ResampleSfxRaw( short *sfx, int inrate, int inwidth, int samples, byt
 }
 
 
+/*
+===============================================================================
+
+sound streaming
+
+Sounds larger than s_streamSize kilobytes are not loaded at registration.
+When one starts playing its file is opened and read about a second ahead
+of the channel playing it, and the chunks the mixer is done with go back
+to the pool, so only a small window of the sound is ever resident.  All
+file reads happen on the main thread; the mixer only sees the samples
+between streamBase and streamEnd.
+
+===============================================================================
+*/
+
+#define	MAX_SOUND_STREAMS	8
+#define	STREAM_AHEAD_MSEC	1000	// how far ahead of the mixer to read
+#define	STREAM_START_MSEC	1000	// time a new stream has to pick up a channel
+
+typedef struct {
+	sfx_t			*sfx;
+	fileHandle_t	file;
+	wavinfo_t		info;
+	int				fileSamples;	// source samples not read yet
+	int				sampleFrac;		// resampling position in the next block, 8 bit fraction
+	sndBuffer		*tail;			// last resident chunk
+	int				startTime;
+} soundStream_t;
+
+static soundStream_t	s_streams[MAX_SOUND_STREAMS];
+
+/*
+================
+S_LoadSoundStream
+
+Only reads the header, the samples come in when the sound is played
+================
+*/
+static qboolean S_LoadSoundStream( sfx_t *sfx ) {
+	fileHandle_t	f;
+	wavinfo_t		info;
+
+	f = S_OpenWavStream( sfx->soundName, &info );
+	if ( !f ) {
+		return qfalse;
+	}
+	FS_FCloseFile( f );
+
+	if ( info.channels != 1 ) {
+		Com_Printf ("%s is a stereo wav file\n", sfx->soundName);
+		return qfalse;
+	}
+
+	sfx->lastTimeUsed = Com_Milliseconds()+1;
+	sfx->soundCompressionMethod = 0;
+	sfx->soundLength = info.samples / ( (float)info.rate / dma.speed );
+	sfx->soundData = NULL;
+	sfx->streamed = qtrue;
+	sfx->streamBase = 0;
+	sfx->streamEnd = 0;
+
+	return qtrue;
+}
+
+/*
+================
+S_ReadSoundStream
+
+Reads and resamples until the window reaches end or the file runs out
+================
+*/
+static void S_ReadSoundStream( soundStream_t *stream, int end ) {
+	sfx_t		*sfx;
+	byte		raw[8192];
+	int			fileSamples, fileBytes;
+	int			srcsample, sample, fracstep, part;
+	sndBuffer	*chunk;
+
+	sfx = stream->sfx;
+	fracstep = ( (float)stream->info.rate / dma.speed ) * 256;
+
+	if ( end > sfx->soundLength ) {
+		end = sfx->soundLength;
+	}
+
+	while ( sfx->streamEnd < end && stream->fileSamples > 0 ) {
+		fileSamples = sizeof( raw ) / stream->info.width;
+		if ( fileSamples > stream->fileSamples ) {
+			fileSamples = stream->fileSamples;
+		}
+		fileBytes = fileSamples * stream->info.width;
+
+		if ( FS_Read( raw, fileBytes, stream->file ) != fileBytes ) {
+			Com_Printf( "S_ReadSoundStream: read failure on %s\n", sfx->soundName );
+			stream->fileSamples = 0;
+			return;
+		}
+		stream->fileSamples -= fileSamples;
+
+		// the mixer may be reading the front of the window
+		S_Lock();
+		while ( ( srcsample = stream->sampleFrac >> 8 ) < fileSamples && sfx->streamEnd < sfx->soundLength ) {
+			if ( stream->info.width == 2 ) {
+				sample = LittleShort( ((short *)raw)[srcsample] );
+			} else {
+				sample = (int)( (unsigned char)(raw[srcsample]) - 128 ) << 8;
+			}
+
+			part = sfx->streamEnd & ( SND_CHUNK_SIZE - 1 );
+			if ( part == 0 ) {
+				chunk = SND_malloc();
+				if ( stream->tail ) {
+					stream->tail->next = chunk;
+				} else {
+					sfx->soundData = chunk;
+				}
+				stream->tail = chunk;
+			}
+			stream->tail->sndChunk[part] = sample;
+
+			sfx->streamEnd++;
+			stream->sampleFrac += fracstep;
+		}
+		S_Unlock();
+
+		stream->sampleFrac -= fileSamples << 8;
+	}
+}
+
+/*
+================
+S_CloseSoundStream
+
+Gives back the window of a streamed sound
+================
+*/
+void S_CloseSoundStream( sfx_t *sfx ) {
+	soundStream_t	*stream;
+	sndBuffer		*chunk, *next;
+	int				i;
+
+	for ( i = 0, stream = s_streams ; i < MAX_SOUND_STREAMS ; i++, stream++ ) {
+		if ( stream->sfx == sfx ) {
+			break;
+		}
+	}
+	if ( i == MAX_SOUND_STREAMS ) {
+		return;
+	}
+
+	S_Lock();
+	for ( chunk = sfx->soundData ; chunk ; chunk = next ) {
+		next = chunk->next;
+		SND_free( chunk );
+	}
+	sfx->soundData = NULL;
+	sfx->streamBase = 0;
+	sfx->streamEnd = 0;
+	S_Unlock();
+
+	FS_FCloseFile( stream->file );
+	Com_Memset( stream, 0, sizeof( *stream ) );
+}
+
+/*
+================
+S_CloseSoundStreams
+================
+*/
+void S_CloseSoundStreams( void ) {
+	int		i;
+
+	for ( i = 0 ; i < MAX_SOUND_STREAMS ; i++ ) {
+		if ( s_streams[i].sfx ) {
+			S_CloseSoundStream( s_streams[i].sfx );
+		}
+	}
+}
+
+/*
+================
+S_StartSoundStream
+
+Called before a streamed sound is started on a channel.  There is only
+one window per sound, so starting it again restarts it from the top and
+the channel that was playing it gets cut off.
+================
+*/
+void S_StartSoundStream( sfx_t *sfx ) {
+	soundStream_t	*stream, *oldest;
+	int				i;
+
+	S_CloseSoundStream( sfx );
+
+	stream = oldest = NULL;
+	for ( i = 0 ; i < MAX_SOUND_STREAMS ; i++ ) {
+		if ( !s_streams[i].sfx ) {
+			stream = &s_streams[i];
+			break;
+		}
+		if ( !oldest || s_streams[i].startTime < oldest->startTime ) {
+			oldest = &s_streams[i];
+		}
+	}
+	if ( !stream ) {
+		S_CloseSoundStream( oldest->sfx );
+		stream = oldest;
+	}
+
+	stream->file = S_OpenWavStream( sfx->soundName, &stream->info );
+	if ( !stream->file ) {
+		return;
+	}
+	stream->sfx = sfx;
+	stream->fileSamples = stream->info.samples;
+	stream->sampleFrac = 0;
+	stream->tail = NULL;
+	stream->startTime = Com_Milliseconds();
+
+	// have the start resident before the mixer gets the channel
+	S_ReadSoundStream( stream, dma.speed * STREAM_AHEAD_MSEC / 2000 );
+}
+
+/*
+================
+S_UpdateSoundStreams
+
+Slides every window along behind the channels playing it, called once
+a frame from the main thread
+================
+*/
+void S_UpdateSoundStreams( void ) {
+	soundStream_t	*stream;
+	sfx_t			*sfx;
+	channel_t		*ch;
+	sndBuffer		*chunk;
+	int				i, j, pos;
+	qboolean		playing;
+
+	for ( i = 0, stream = s_streams ; i < MAX_SOUND_STREAMS ; i++, stream++ ) {
+		sfx = stream->sfx;
+		if ( !sfx ) {
+			continue;
+		}
+
+		S_Lock();
+
+		// find the earliest sample still needed
+		pos = sfx->streamEnd;
+		playing = qfalse;
+		for ( j = 0, ch = s_channels ; j < MAX_CHANNELS ; j++, ch++ ) {
+			if ( ch->thesfx != sfx ) {
+				continue;
+			}
+			playing = qtrue;
+			if ( ch->startSample == START_SAMPLE_IMMEDIATE ) {
+				pos = sfx->streamBase;
+			} else if ( s_paintedtime - ch->startSample < pos ) {
+				pos = s_paintedtime - ch->startSample;
+			}
+		}
+
+		if ( !playing ) {
+			S_Unlock();
+			// finished, or never got a channel
+			if ( Com_Milliseconds() - stream->startTime > STREAM_START_MSEC ) {
+				S_CloseSoundStream( sfx );
+			}
+			continue;
+		}
+
+		// release what has been mixed, keeping a chunk of history
+		// for the binaural filters and never the tail
+		while ( pos - sfx->streamBase >= 2 * SND_CHUNK_SIZE && sfx->soundData->next ) {
+			chunk = sfx->soundData;
+			sfx->soundData = chunk->next;
+			SND_free( chunk );
+			sfx->streamBase += SND_CHUNK_SIZE;
+		}
+
+		S_Unlock();
+
+		S_ReadSoundStream( stream, pos + dma.speed * STREAM_AHEAD_MSEC / 1000 );
+	}
+}
+
+
 //=============================================================================
 
 /*
@@ -338,6 +647,14 @@ qboolean S_LoadSound( sfx_t *sfx )
 		return qfalse;
 	}
 
+	// long sounds only have a window resident while they play
+	if ( s_streamSize->integer > 0 && !sfx->noStream ) {
+		size = FS_ReadFile( sfx->soundName, NULL );
+		if ( size > s_streamSize->integer * 1024 ) {
+			return S_LoadSoundStream( sfx );
+		}
+	}
+
 	// load it in
 	size = FS_ReadFile( sfx->soundName, (void **)&data );
 	if ( !data ) {
@@ -362,6 +679,7 @@ qboolean S_LoadSound( sfx_t *sfx )
 	samples = Hunk_AllocateTempMemory(info.samples * sizeof(short) * 2);
 
 	sfx->lastTimeUsed = Com_Milliseconds()+1;
+	sfx->streamed = qfalse;
 
 	// each of these compression schemes works just fine
 	// but the 16bit quality is much nicer and with a local
@@ -400,5 +718,5 @@ qboolean S_LoadSound( sfx_t *sfx )
 }
 
 void S_DisplayFreeMemory() {
-	Com_Printf("%d bytes free sound buffer memory, %d total used\n", inUse, totalInUse);
+	Com_Printf("%d of %d bytes free sound buffer memory, %d total used\n", inUse, poolSize, totalInUse);
 }
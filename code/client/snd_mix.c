@@ -23,7 +23,24 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include "snd_local.h"
 
-static portable_samplepair_t paintbuffer[PAINTBUFFER_SIZE];
+#if idsse2
+#include <emmintrin.h>
+#if idavx2
+#include <immintrin.h>
+#endif
+
+// the SIMD mixer accumulates in float, kept in the same scale as the integer path
+typedef float	paintsample_t;
+#else
+typedef int		paintsample_t;
+#endif
+
+typedef struct {
+	paintsample_t	left;
+	paintsample_t	right;
+} paintsamplepair_t;
+
+static paintsamplepair_t paintbuffer[PAINTBUFFER_SIZE];
 static int snd_vol;
 
 // bk001119 - these not static, required by unix/snd_mixa.s
@@ -31,6 +48,70 @@ int*     snd_p;
 int      snd_linear_count;
 short*   snd_out;
 
+#if idsse2
+
+/*
+===================
+S_ClipStereo16
+
+Scales the float paint buffer back down and saturates it to 16 bit,
+eight samples per step
+===================
+*/
+static void S_ClipStereo16( short *out, const paintsample_t *in, int count ) {
+	__m128	scale = _mm_set1_ps( 1.0f / 256.0f );
+	__m128	high = _mm_set1_ps( 32767.0f );
+	__m128	low = _mm_set1_ps( -32768.0f );
+	__m128	a, b;
+	int		i, val;
+
+	for ( i = 0 ; i + 8 <= count ; i += 8 ) {
+		a = _mm_mul_ps( _mm_loadu_ps( in + i ), scale );
+		b = _mm_mul_ps( _mm_loadu_ps( in + i + 4 ), scale );
+		a = _mm_max_ps( _mm_min_ps( a, high ), low );
+		b = _mm_max_ps( _mm_min_ps( b, high ), low );
+		_mm_storeu_si128( (__m128i *)( out + i ), _mm_packs_epi32( _mm_cvttps_epi32( a ), _mm_cvttps_epi32( b ) ) );
+	}
+
+	for ( ; i < count ; i++ ) {
+		val = (int)in[i] >> 8;
+		if (val > 0x7fff)
+			out[i] = 0x7fff;
+		else if (val < -32768)
+			out[i] = -32768;
+		else
+			out[i] = val;
+	}
+}
+
+void S_TransferStereo16 (unsigned long *pbuf, int endtime)
+{
+	int				lpos;
+	int				ls_paintedtime;
+	int				count;
+	paintsample_t	*p;
+
+	p = (paintsample_t *) paintbuffer;
+	ls_paintedtime = s_paintedtime;
+
+	while (ls_paintedtime < endtime)
+	{
+	// handle recirculating buffer issues
+		lpos = ls_paintedtime & ((dma.samples>>1)-1);
+
+		count = (dma.samples>>1) - lpos;
+		if (ls_paintedtime + count > endtime)
+			count = endtime - ls_paintedtime;
+
+		S_ClipStereo16( (short *) pbuf + (lpos<<1), p, count<<1 );
+
+		p += count<<1;
+		ls_paintedtime += count;
+	}
+}
+
+#else
+
 #if !( (defined __linux__ || defined __FreeBSD__ ) && (defined __i386__) ) // rb010123
 #if	!id386
 
@@ -139,6 +220,15 @@ void S_TransferStereo16 (unsigned long *pbuf, int endtime)
 	}
 }
 
+static void S_ClipStereo16( short *out, paintsample_t *in, int count ) {
+	snd_p = in;
+	snd_out = out;
+	snd_linear_count = count;
+	S_WriteLinearBlastStereo16 ();
+}
+
+#endif
+
 /*
 ===================
 S_TransferPaintBuffer
@@ -150,7 +240,7 @@ void S_TransferPaintBuffer(int endtime)
 	int 	out_idx;
 	int 	count;
 	int 	out_mask;
-	int 	*p;
+	paintsample_t	*p;
 	int 	step;
 	int		val;
 	unsigned long *pbuf;
@@ -175,7 +265,7 @@ void S_TransferPaintBuffer(int endtime)
 	}
 	else
 	{	// general case
-		p = (int *) paintbuffer;
+		p = (paintsample_t *) paintbuffer;
 		count = (endtime - s_paintedtime) * dma.channels;
 		out_mask = dma.samples - 1; 
 		out_idx = s_paintedtime * dma.channels & out_mask;
@@ -186,7 +276,7 @@ void S_TransferPaintBuffer(int endtime)
 			short *out = (short *) pbuf;
 			while (count--)
 			{
-				val = *p >> 8;
+				val = (int)*p >> 8;
 				p+= step;
 				if (val > 0x7fff)
 					val = 0x7fff;
@@ -201,7 +291,7 @@ void S_TransferPaintBuffer(int endtime)
 			unsigned char *out = (unsigned char *) pbuf;
 			while (count--)
 			{
-				val = *p >> 8;
+				val = (int)*p >> 8;
 				p+= step;
 				if (val > 0x7fff)
 					val = 0x7fff;
@@ -223,11 +313,99 @@ CHANNEL MIXING
 ===============================================================================
 */
 
+#if idsse2
+
+// doppler resampled input for the float mixing kernel
+static float	s_resamplebuffer[PAINTBUFFER_SIZE];
+
+/*
+===================
+S_MixMono16
+
+Adds a run of mono 16 bit samples into the paint buffer, four (or eight
+with AVX2) samples per step.  The volumes already include the 1/256 scale.
+===================
+*/
+static void S_MixMono16( paintsamplepair_t *samp, const short *samples, int count, float leftvol, float rightvol ) {
+	float	*out;
+	__m128	vol, s, lo, hi;
+	__m128i	w;
+	int		i;
+
+	out = (float *)samp;
+	i = 0;
+
+#if idavx2
+	{
+		__m256	vol8, s8, lo8, hi8;
+
+		vol8 = _mm256_setr_ps( leftvol, rightvol, leftvol, rightvol, leftvol, rightvol, leftvol, rightvol );
+		for ( ; i + 8 <= count ; i += 8 ) {
+			s8 = _mm256_cvtepi32_ps( _mm256_cvtepi16_epi32( _mm_loadu_si128( (const __m128i *)( samples + i ) ) ) );
+			// duplicate every sample so it lines up with its left/right pair
+			lo8 = _mm256_unpacklo_ps( s8, s8 );
+			hi8 = _mm256_unpackhi_ps( s8, s8 );
+			s8 = _mm256_permute2f128_ps( lo8, hi8, 0x20 );
+			_mm256_storeu_ps( out + i*2, _mm256_add_ps( _mm256_loadu_ps( out + i*2 ), _mm256_mul_ps( s8, vol8 ) ) );
+			s8 = _mm256_permute2f128_ps( lo8, hi8, 0x31 );
+			_mm256_storeu_ps( out + i*2 + 8, _mm256_add_ps( _mm256_loadu_ps( out + i*2 + 8 ), _mm256_mul_ps( s8, vol8 ) ) );
+		}
+	}
+#endif
+
+	vol = _mm_setr_ps( leftvol, rightvol, leftvol, rightvol );
+	for ( ; i + 4 <= count ; i += 4 ) {
+		// sign extend four shorts to ints by unpacking each one into the high half
+		w = _mm_loadl_epi64( (const __m128i *)( samples + i ) );
+		s = _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpacklo_epi16( w, w ), 16 ) );
+		lo = _mm_unpacklo_ps( s, s );
+		hi = _mm_unpackhi_ps( s, s );
+		_mm_storeu_ps( out + i*2, _mm_add_ps( _mm_loadu_ps( out + i*2 ), _mm_mul_ps( lo, vol ) ) );
+		_mm_storeu_ps( out + i*2 + 4, _mm_add_ps( _mm_loadu_ps( out + i*2 + 4 ), _mm_mul_ps( hi, vol ) ) );
+	}
+
+	for ( ; i < count ; i++ ) {
+		samp[i].left += samples[i] * leftvol;
+		samp[i].right += samples[i] * rightvol;
+	}
+}
+
+/*
+===================
+S_MixMonoFloat
+
+Same as S_MixMono16 for samples that have already been resampled to float
+===================
+*/
+static void S_MixMonoFloat( paintsamplepair_t *samp, const float *samples, int count, float leftvol, float rightvol ) {
+	float	*out;
+	__m128	vol, s, lo, hi;
+	int		i;
+
+	out = (float *)samp;
+	vol = _mm_setr_ps( leftvol, rightvol, leftvol, rightvol );
+
+	for ( i = 0 ; i + 4 <= count ; i += 4 ) {
+		s = _mm_loadu_ps( samples + i );
+		lo = _mm_unpacklo_ps( s, s );
+		hi = _mm_unpackhi_ps( s, s );
+		_mm_storeu_ps( out + i*2, _mm_add_ps( _mm_loadu_ps( out + i*2 ), _mm_mul_ps( lo, vol ) ) );
+		_mm_storeu_ps( out + i*2 + 4, _mm_add_ps( _mm_loadu_ps( out + i*2 + 4 ), _mm_mul_ps( hi, vol ) ) );
+	}
+
+	for ( ; i < count ; i++ ) {
+		samp[i].left += samples[i] * leftvol;
+		samp[i].right += samples[i] * rightvol;
+	}
+}
+
+#endif
+
 static void S_PaintChannelFrom16( channel_t *ch, const sfx_t *sc, int count, int sampleOffset, int bufferOffset ) {
 	int						data, aoff, boff;
 	int						leftvol, rightvol;
 	int						i, j;
-	portable_samplepair_t	*samp;
+	paintsamplepair_t		*samp;
 	sndBuffer				*chunk;
 	short					*samples;
 	float					ooff, fdata, fdiv, fleftvol, frightvol;
@@ -256,7 +434,28 @@ static void S_PaintChannelFrom16( channel_t *ch, const sfx_t *sc, int count, int
 		leftvol = ch->leftvol*snd_vol;
 		rightvol = ch->rightvol*snd_vol;
 		samples = chunk->sndChunk;
-#if idppc_altivec
+#if idsse2
+		// mix whole runs up to the next chunk boundary at once
+		i = 0;
+		while ( i < count ) {
+			j = count - i;
+			if ( j > SND_CHUNK_SIZE - sampleOffset ) {
+				j = SND_CHUNK_SIZE - sampleOffset;
+			}
+			S_MixMono16( samp + i, samples + sampleOffset, j, leftvol * (1.0f/256), rightvol * (1.0f/256) );
+			i += j;
+			sampleOffset += j;
+
+			if (sampleOffset == SND_CHUNK_SIZE) {
+				chunk = chunk->next;
+				if (!chunk) {
+					chunk = sc->soundData;
+				}
+				samples = chunk->sndChunk;
+				sampleOffset = 0;
+			}
+		}
+#elif idppc_altivec
 		((short *)&volume_vec)[0] = leftvol;
 		((short *)&volume_vec)[1] = leftvol;
 		((short *)&volume_vec)[4] = leftvol;
@@ -383,10 +582,35 @@ static void S_PaintChannelFrom16( channel_t *ch, const sfx_t *sc, int count, int
 
 		ooff = sampleOffset;
 		samples = chunk->sndChunk;
-		
-
 
+#if idsse2
+		// box filter into a float run, then let the vector kernel apply the volumes
+		for ( i=0 ; i<count ; i++ ) {
 
+			aoff = ooff;
+			ooff = ooff + ch->dopplerScale;
+			boff = ooff;
+			fdata = 0;
+			for (j=aoff; j<boff; j++) {
+				if (j == SND_CHUNK_SIZE) {
+					chunk = chunk->next;
+					if (!chunk) {
+						chunk = sc->soundData;
+					}
+					samples = chunk->sndChunk;
+					ooff -= SND_CHUNK_SIZE;
+				}
+				fdata  += samples[j&(SND_CHUNK_SIZE-1)];
+			}
+			if ( boff > aoff ) {
+				s_resamplebuffer[i] = fdata / (boff-aoff);
+			} else {
+				// slowed down below one source sample per output sample
+				s_resamplebuffer[i] = samples[aoff&(SND_CHUNK_SIZE-1)];
+			}
+		}
+		S_MixMonoFloat( samp, s_resamplebuffer, count, fleftvol * (1.0f/256), frightvol * (1.0f/256) );
+#else
 		for ( i=0 ; i<count ; i++ ) {
 
 			aoff = ooff;
@@ -408,6 +632,7 @@ static void S_PaintChannelFrom16( channel_t *ch, const sfx_t *sc, int count, int
 			samp[i].left += (fdata * fleftvol)/fdiv;
 			samp[i].right += (fdata * frightvol)/fdiv;
 		}
+#endif
 	}
 }
 
@@ -415,7 +640,7 @@ void S_PaintChannelFromWavelet( channel_t *ch, sfx_t *sc, int count, int sampleO
 	int						data;
 	int						leftvol, rightvol;
 	int						i;
-	portable_samplepair_t	*samp;
+	paintsamplepair_t		*samp;
 	sndBuffer				*chunk;
 	short					*samples;
 
@@ -457,7 +682,7 @@ void S_PaintChannelFromADPCM( channel_t *ch, sfx_t *sc, int count, int sampleOff
 	int						data;
 	int						leftvol, rightvol;
 	int						i;
-	portable_samplepair_t	*samp;
+	paintsamplepair_t		*samp;
 	sndBuffer				*chunk;
 	short					*samples;
 
@@ -504,7 +729,7 @@ void S_PaintChannelFromMuLaw( channel_t *ch, sfx_t *sc, int count, int sampleOff
 	int						data;
 	int						leftvol, rightvol;
 	int						i;
-	portable_samplepair_t	*samp;
+	paintsamplepair_t		*samp;
 	sndBuffer				*chunk;
 	byte					*samples;
 	float					ooff;
@@ -554,6 +779,163 @@ void S_PaintChannelFromMuLaw( channel_t *ch, sfx_t *sc, int count, int sampleOff
 	}
 }
 
+/*
+===============================================================================
+
+BINAURAL MIXING
+
+===============================================================================
+*/
+
+static float	s_hrtfInput[PAINTBUFFER_SIZE + HRTF_LENGTH];
+
+/*
+===================
+S_GetSamples16
+
+Reads count 16 bit samples starting at offset as floats.  Loops wrap
+around, offsets before the start of a one shot sound read as silence.
+===================
+*/
+static void S_GetSamples16( const sfx_t *sc, int offset, int count, float *out, qboolean loop ) {
+	sndBuffer	*chunk;
+	int			pos, i, n;
+
+	if ( loop ) {
+		offset %= sc->soundLength;
+		if ( offset < 0 ) {
+			offset += sc->soundLength;
+		}
+	} else {
+		for ( ; count > 0 && offset < 0 ; count--, offset++ ) {
+			*out++ = 0;
+		}
+	}
+
+	pos = offset;
+	chunk = sc->soundData;
+	while ( chunk && offset >= SND_CHUNK_SIZE ) {
+		chunk = chunk->next;
+		offset -= SND_CHUNK_SIZE;
+	}
+
+	while ( count > 0 ) {
+		if ( !chunk ) {
+			for ( ; count > 0 ; count-- ) {
+				*out++ = 0;
+			}
+			return;
+		}
+
+		n = SND_CHUNK_SIZE - offset;
+		if ( loop && pos + n > sc->soundLength ) {
+			n = sc->soundLength - pos;
+		}
+		if ( n > count ) {
+			n = count;
+		}
+		for ( i = 0 ; i < n ; i++ ) {
+			out[i] = chunk->sndChunk[offset + i];
+		}
+		out += n;
+		count -= n;
+		offset += n;
+		pos += n;
+
+		if ( loop && pos == sc->soundLength ) {
+			chunk = sc->soundData;
+			offset = 0;
+			pos = 0;
+		} else if ( offset == SND_CHUNK_SIZE ) {
+			chunk = chunk->next;
+			offset = 0;
+		}
+	}
+}
+
+/*
+===================
+S_ConvolveHRIR
+
+Runs count samples, which must be preceded by HRTF_LENGTH-1 samples of
+history, through both ears of a filter and adds the result with a
+linearly ramped gain.  The filter taps are time reversed, so each output
+is a straight dot product over the input; the SSE path computes four
+outputs at once so no horizontal adds are needed.
+===================
+*/
+static void S_ConvolveHRIR( paintsamplepair_t *samp, const float *in, int count, const hrir_t *hrir, float gain, float gainStep ) {
+	float	left, right;
+	int		i, k;
+
+	i = 0;
+
+#if idsse2
+	{
+		__m128	l, r, x, g, gstep;
+		float	*out = (float *)samp;
+
+		g = _mm_setr_ps( gain, gain + gainStep, gain + 2*gainStep, gain + 3*gainStep );
+		gstep = _mm_set1_ps( 4*gainStep );
+		for ( ; i + 4 <= count ; i += 4 ) {
+			l = _mm_setzero_ps();
+			r = _mm_setzero_ps();
+			for ( k = 0 ; k < HRTF_LENGTH ; k++ ) {
+				x = _mm_loadu_ps( in + i + k );
+				l = _mm_add_ps( l, _mm_mul_ps( x, _mm_load1_ps( &hrir->left[k] ) ) );
+				r = _mm_add_ps( r, _mm_mul_ps( x, _mm_load1_ps( &hrir->right[k] ) ) );
+			}
+			l = _mm_mul_ps( l, g );
+			r = _mm_mul_ps( r, g );
+			g = _mm_add_ps( g, gstep );
+
+			_mm_storeu_ps( out + i*2, _mm_add_ps( _mm_loadu_ps( out + i*2 ), _mm_unpacklo_ps( l, r ) ) );
+			_mm_storeu_ps( out + i*2 + 4, _mm_add_ps( _mm_loadu_ps( out + i*2 + 4 ), _mm_unpackhi_ps( l, r ) ) );
+		}
+		gain += i * gainStep;
+	}
+#endif
+
+	for ( ; i < count ; i++ ) {
+		left = right = 0;
+		for ( k = 0 ; k < HRTF_LENGTH ; k++ ) {
+			left += in[i + k] * hrir->left[k];
+			right += in[i + k] * hrir->right[k];
+		}
+		samp[i].left += left * gain;
+		samp[i].right += right * gain;
+		gain += gainStep;
+	}
+}
+
+/*
+===================
+S_PaintChannelHRTF
+
+Binaural path for uncompressed sounds.  The filter history is read back
+from the sound itself, so channels carry no convolution state and loop
+channels can be rebuilt every frame.  A change of direction is
+crossfaded over the run to avoid zipper noise.
+===================
+*/
+static void S_PaintChannelHRTF( channel_t *ch, const sfx_t *sc, int count, int sampleOffset, int bufferOffset, qboolean loop ) {
+	paintsamplepair_t	*samp;
+	float				vol;
+
+	samp = &paintbuffer[ bufferOffset ];
+	vol = ch->leftvol * snd_vol * (1.0f/256);
+
+	S_GetSamples16( sc, sampleOffset - ( HRTF_LENGTH - 1 ), count + HRTF_LENGTH - 1, s_hrtfInput, loop );
+
+	if ( ch->oldHrtfIndex != ch->hrtfIndex && ch->oldHrtfIndex >= 0 ) {
+		S_ConvolveHRIR( samp, s_hrtfInput, count, &s_hrirs[ ch->oldHrtfIndex ], vol, -vol / count );
+		S_ConvolveHRIR( samp, s_hrtfInput, count, &s_hrirs[ ch->hrtfIndex ], 0, vol / count );
+	} else {
+		S_ConvolveHRIR( samp, s_hrtfInput, count, &s_hrirs[ ch->hrtfIndex ], vol, 0 );
+	}
+	ch->oldHrtfIndex = ch->hrtfIndex;
+}
+
 /*
 ===================
 S_PaintChannels
@@ -584,7 +966,7 @@ void S_PaintChannels( int endtime ) {
 			if ( s_rawend ) {
 				//Com_DPrintf ("background sound underrun\n");
 			}
-			Com_Memset(paintbuffer, 0, (end - s_paintedtime) * sizeof(portable_samplepair_t));
+			Com_Memset(paintbuffer, 0, (end - s_paintedtime) * sizeof(paintsamplepair_t));
 		} else {
 			// copy from the streaming sound source
 			int		s;
@@ -594,7 +976,8 @@ void S_PaintChannels( int endtime ) {
 
 			for ( i = s_paintedtime ; i < stop ; i++ ) {
 				s = i&(MAX_RAW_SAMPLES-1);
-				paintbuffer[i-s_paintedtime] = s_rawsamples[s];
+				paintbuffer[i-s_paintedtime].left = s_rawsamples[s].left;
+				paintbuffer[i-s_paintedtime].right = s_rawsamples[s].right;
 			}
 //		if (i != end)
 //			Com_Printf ("partial stream\n");
@@ -616,14 +999,32 @@ void S_PaintChannels( int endtime ) {
 			ltime = s_paintedtime;
 			sc = ch->thesfx;
 
+			if ( !sc->soundData ) {
+				continue;
+			}
+
 			sampleOffset = ltime - ch->startSample;
 			count = end - ltime;
 			if ( sampleOffset + count > sc->soundLength ) {
 				count = sc->soundLength - sampleOffset;
 			}
 
+			// only the window between streamBase and streamEnd
+			// of a streamed sound is resident
+			if ( sc->streamed ) {
+				if ( sampleOffset + count > sc->streamEnd ) {
+					count = sc->streamEnd - sampleOffset;
+				}
+				if ( sampleOffset < sc->streamBase ) {
+					count = 0;
+				}
+				sampleOffset -= sc->streamBase;
+			}
+
 			if ( count > 0 ) {	
-				if( sc->soundCompressionMethod == 1) {
+				if ( ch->hrtfIndex >= 0 && !sc->soundCompressionMethod && !ch->doppler ) {
+					S_PaintChannelHRTF			(ch, sc, count, sampleOffset, ltime - s_paintedtime, qfalse);
+				} else if( sc->soundCompressionMethod == 1) {
 					S_PaintChannelFromADPCM		(ch, sc, count, sampleOffset, ltime - s_paintedtime);
 				} else if( sc->soundCompressionMethod == 2) {
 					S_PaintChannelFromWavelet	(ch, sc, count, sampleOffset, ltime - s_paintedtime);
@@ -660,7 +1061,9 @@ void S_PaintChannels( int endtime ) {
 				}
 
 				if ( count > 0 ) {	
-					if( sc->soundCompressionMethod == 1) {
+					if ( ch->hrtfIndex >= 0 && !sc->soundCompressionMethod && !ch->doppler ) {
+						S_PaintChannelHRTF			(ch, sc, count, sampleOffset, ltime - s_paintedtime, qtrue);
+					} else if( sc->soundCompressionMethod == 1) {
 						S_PaintChannelFromADPCM		(ch, sc, count, sampleOffset, ltime - s_paintedtime);
 					} else if( sc->soundCompressionMethod == 2) {
 						S_PaintChannelFromWavelet	(ch, sc, count, sampleOffset, ltime - s_paintedtime);
@@ -679,3 +1082,130 @@ void S_PaintChannels( int endtime ) {
 		s_paintedtime = end;
 	}
 }
+
+/*
+===================
+S_MixBenchPass
+
+Mixes full paint buffers for about a second and prints the throughput
+===================
+*/
+static void S_MixBenchPass( const char *name, sfx_t *sfx, channel_t *channels, int numChannels, qboolean hrtf ) {
+	static short	out[PAINTBUFFER_SIZE*2];
+	channel_t		*ch;
+	int				i, start, msec, frames, speed;
+	float			usec;
+
+	start = Sys_Milliseconds();
+	frames = 0;
+	do {
+		Com_Memset( paintbuffer, 0, sizeof( paintbuffer ) );
+		for ( i = 0, ch = channels ; i < numChannels ; i++, ch++ ) {
+			if ( hrtf ) {
+				S_PaintChannelHRTF( ch, sfx, PAINTBUFFER_SIZE, ( frames * PAINTBUFFER_SIZE + i * 97 ) % sfx->soundLength, 0, qtrue );
+			} else {
+				S_PaintChannelFrom16( ch, sfx, PAINTBUFFER_SIZE, ( frames * PAINTBUFFER_SIZE + i * 97 ) % sfx->soundLength, 0 );
+			}
+		}
+		S_ClipStereo16( out, (paintsample_t *)paintbuffer, PAINTBUFFER_SIZE*2 );
+		frames++;
+		msec = Sys_Milliseconds() - start;
+	} while ( msec < 1000 );
+
+	speed = dma.speed ? dma.speed : 22050;
+	usec = msec * 1000.0f / ( (float)numChannels * frames );
+
+	Com_Printf( "%s: %i buffers of %i samples in %i msec\n", name, frames, PAINTBUFFER_SIZE, msec );
+	Com_Printf( "  %.2f channels mixed per msec, %.1f usec per channel buffer, %.3f%% of a core per channel at %ihz\n",
+		(float)numChannels * frames / msec, usec, usec * speed / PAINTBUFFER_SIZE / 10000.0f, speed );
+}
+
+/*
+===================
+S_MixBench_f
+
+Mixes a synthetic sound on a number of channels straight into the paint
+buffer and converts it, without touching the dma buffer, so it also runs
+with the null sound device.  Both the panned and the binaural paths are
+measured.
+===================
+*/
+void S_MixBench_f( void ) {
+	sfx_t			sfx;
+	sndBuffer		*chunks;
+	channel_t		*channels, *ch;
+	int				numChannels, numChunks;
+	int				i, j;
+
+	numChannels = 32;
+	if ( Cmd_Argc() > 1 ) {
+		numChannels = atoi( Cmd_Argv( 1 ) );
+	}
+	if ( numChannels < 1 ) {
+		numChannels = 1;
+	} else if ( numChannels > MAX_CHANNELS ) {
+		numChannels = MAX_CHANNELS;
+	}
+
+	// a looping sine over a few chunks, linked into a ring so any offset is valid
+	numChunks = 4;
+	chunks = Z_Malloc( numChunks * sizeof( sndBuffer ) );
+	for ( i = 0 ; i < numChunks ; i++ ) {
+		for ( j = 0 ; j < SND_CHUNK_SIZE ; j++ ) {
+			chunks[i].sndChunk[j] = sin( ( i * SND_CHUNK_SIZE + j ) * 0.05 ) * 16000;
+		}
+		chunks[i].next = &chunks[ ( i + 1 ) % numChunks ];
+	}
+
+	Com_Memset( &sfx, 0, sizeof( sfx ) );
+	sfx.soundData = chunks;
+	sfx.soundLength = numChunks * SND_CHUNK_SIZE;
+	sfx.inMemory = qtrue;
+	Q_strncpyz( sfx.soundName, "*mixbench", sizeof( sfx.soundName ) );
+
+	// every fourth channel takes the doppler resampling path
+	channels = Z_Malloc( numChannels * sizeof( channel_t ) );
+	for ( i = 0, ch = channels ; i < numChannels ; i++, ch++ ) {
+		ch->thesfx = &sfx;
+		ch->hrtfIndex = ch->oldHrtfIndex = -1;
+		ch->leftvol = 64 + ( i * 37 ) % 192;
+		ch->rightvol = 255 - ( i * 37 ) % 192;
+		if ( ( i & 3 ) == 3 ) {
+			ch->doppler = qtrue;
+			ch->dopplerScale = 1.1f;
+			ch->oldDopplerScale = 1.0f;
+		}
+	}
+
+	// the paint buffer is shared with the mixer thread
+	S_Lock();
+
+	snd_vol = s_volume->value*255;
+
+	Com_Printf( "%i channels\n", numChannels );
+	S_MixBenchPass( "panned", &sfx, channels, numChannels, qfalse );
+
+	// every channel from a different direction
+	S_HRTF_Init( dma.speed ? dma.speed : 22050 );
+	for ( i = 0, ch = channels ; i < numChannels ; i++, ch++ ) {
+		ch->leftvol = ch->rightvol = 64 + ( i * 37 ) % 192;
+		ch->hrtfIndex = ( i * 37 ) % HRTF_DIRECTIONS;
+		ch->oldHrtfIndex = ch->hrtfIndex;
+	}
+	S_MixBenchPass( "binaural", &sfx, channels, numChannels, qtrue );
+
+	S_Unlock();
+
+#if idavx2
+	Com_Printf( "mixer: AVX2\n" );
+#elif idsse2
+	Com_Printf( "mixer: SSE2\n" );
+#elif idppc_altivec
+	Com_Printf( "mixer: AltiVec\n" );
+#else
+	Com_Printf( "mixer: scalar\n" );
+#endif
+
+	Z_Free( channels );
+	Z_Free( chunks );
+}
@@ -3109,6 +3109,11 @@ void PmoveSingle (pmove_t *pmove) {
 		pmove->cmd.upmove = 0;
 	}
 
+	// head angles the client was tracking when it built the command
+	for ( i = 0 ; i < 3 ; i++ ) {
+		pm->ps->hmdAngles[i] = SHORT2ANGLE( pm->cmd.hangles[i] );
+	}
+
 	// clear all pmove local vars
 	memset (&pml, 0, sizeof(pml));
 
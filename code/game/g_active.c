@@ -2229,3 +2229,212 @@ void ClientEndFrame( gentity_t *ent ) {
 }
 
 
+
+
+/*
+=============================================================================
+
+LAG COMPENSATION
+
+Every server frame the box of each client is recorded as the other
+clients will see it in that frame's snapshot.  A hitscan attack moves
+everyone else back to where the attacker saw them at the usercmd's
+serverTime, traces, and puts them back.
+
+The history is kept apart from gclient_t so a rewind only touches the
+small per-client rings, times first so the search stays in a few
+cache lines.
+
+=============================================================================
+*/
+
+static clientHistory_t	clientHistory[MAX_CLIENTS];
+
+typedef struct {
+	vec3_t		origin;
+	vec3_t		mins, maxs;
+	vec3_t		rewoundMins, rewoundMaxs;
+} rewoundClient_t;
+
+static rewoundClient_t	rewound[MAX_CLIENTS];
+static int				rewoundNums[MAX_CLIENTS];
+static int				numRewound;
+
+/*
+==================
+G_ResetClientHistory
+==================
+*/
+void G_ResetClientHistory( int clientNum ) {
+	clientHistory[clientNum].head = 0;
+}
+
+/*
+==================
+G_RecordClientHistory
+
+Called at the end of G_RunFrame, after all the clients have moved
+==================
+*/
+void G_RecordClientHistory( void ) {
+	gentity_t		*ent;
+	clientHistory_t	*hist;
+	historyFrame_t	*frame;
+	int				i, slot;
+
+	for ( i = 0 ; i < level.maxclients ; i++ ) {
+		ent = &g_entities[i];
+		if ( !ent->inuse || !ent->client || !ent->r.linked
+			|| ent->client->sess.sessionTeam == TEAM_SPECTATOR ) {
+			continue;
+		}
+
+		hist = &clientHistory[i];
+		slot = hist->head & (HISTORY_FRAMES-1);
+		hist->times[slot] = level.time;
+		frame = &hist->frames[slot];
+
+		// where the snapshot will put it, extrapolated if g_smoothClients
+		BG_EvaluateTrajectory( &ent->s.pos, level.time, frame->origin );
+		VectorCopy( ent->r.mins, frame->mins );
+		VectorCopy( ent->r.maxs, frame->maxs );
+		frame->teleportBit = ent->client->ps.eFlags & EF_TELEPORT_BIT;
+		hist->head++;
+	}
+}
+
+/*
+==================
+G_RewindClient
+
+Lerps the box at time out of the history, qfalse if there is no
+usable frame
+==================
+*/
+static qboolean G_RewindClient( gentity_t *ent, int time, vec3_t origin, vec3_t mins, vec3_t maxs ) {
+	clientHistory_t	*hist;
+	historyFrame_t	*older, *newer;
+	int				count, i, slot, next;
+	float			frac;
+
+	hist = &clientHistory[ ent - g_entities ];
+	count = hist->head < HISTORY_FRAMES ? hist->head : HISTORY_FRAMES;
+	if ( count < 1 ) {
+		return qfalse;
+	}
+
+	// newest first, stop at the first frame at or before time
+	for ( i = 1 ; i <= count ; i++ ) {
+		slot = ( hist->head - i ) & (HISTORY_FRAMES-1);
+		if ( hist->times[slot] <= time ) {
+			break;
+		}
+	}
+	if ( i == 1 ) {
+		return qfalse;		// not older than the newest frame
+	}
+	if ( i > count ) {
+		// older than anything kept, use the oldest
+		i = count;
+		slot = ( hist->head - i ) & (HISTORY_FRAMES-1);
+		time = hist->times[slot];
+	}
+	next = ( hist->head - i + 1 ) & (HISTORY_FRAMES-1);
+
+	older = &hist->frames[slot];
+	newer = &hist->frames[next];
+
+	// don't drag a client back across a respawn or teleporter
+	if ( older->teleportBit != ( ent->client->ps.eFlags & EF_TELEPORT_BIT ) ) {
+		return qfalse;
+	}
+
+	if ( hist->times[next] > hist->times[slot] ) {
+		frac = (float)( time - hist->times[slot] ) / ( hist->times[next] - hist->times[slot] );
+	} else {
+		frac = 0;
+	}
+	for ( i = 0 ; i < 3 ; i++ ) {
+		origin[i] = older->origin[i] + frac * ( newer->origin[i] - older->origin[i] );
+		mins[i] = older->mins[i] + frac * ( newer->mins[i] - older->mins[i] );
+		maxs[i] = older->maxs[i] + frac * ( newer->maxs[i] - older->maxs[i] );
+	}
+	return qtrue;
+}
+
+/*
+==================
+G_RewindClients
+
+Moves every client but the attacker back to time, for the hitscan
+traces that follow.  G_RestoreClients must be called before anything
+else runs.  Returns the number of clients moved.
+==================
+*/
+int G_RewindClients( gentity_t *attacker, int time ) {
+	gentity_t		*ent;
+	rewoundClient_t	*save;
+	vec3_t			origin, mins, maxs;
+	int				i;
+
+	numRewound = 0;
+
+	if ( !g_lagCompensation.integer ) {
+		return 0;
+	}
+	if ( time < level.time - g_lagCompensationMax.integer ) {
+		time = level.time - g_lagCompensationMax.integer;
+	}
+
+	for ( i = 0 ; i < level.maxclients ; i++ ) {
+		ent = &g_entities[i];
+		if ( ent == attacker || !ent->inuse || !ent->client || !ent->r.linked
+			|| ent->client->sess.sessionTeam == TEAM_SPECTATOR ) {
+			continue;
+		}
+		if ( !G_RewindClient( ent, time, origin, mins, maxs ) ) {
+			continue;
+		}
+
+		save = &rewound[numRewound];
+		VectorCopy( ent->r.currentOrigin, save->origin );
+		VectorCopy( ent->r.mins, save->mins );
+		VectorCopy( ent->r.maxs, save->maxs );
+		rewoundNums[numRewound++] = i;
+
+		VectorCopy( mins, save->rewoundMins );
+		VectorCopy( maxs, save->rewoundMaxs );
+
+		VectorCopy( origin, ent->r.currentOrigin );
+		VectorCopy( mins, ent->r.mins );
+		VectorCopy( maxs, ent->r.maxs );
+		trap_LinkEntity( ent );
+	}
+
+	return numRewound;
+}
+
+/*
+==================
+G_RestoreClients
+
+A client killed while rewound keeps the box player_die gave it
+==================
+*/
+void G_RestoreClients( void ) {
+	gentity_t		*ent;
+	rewoundClient_t	*save;
+	int				i;
+
+	for ( i = 0 ; i < numRewound ; i++ ) {
+		ent = &g_entities[ rewoundNums[i] ];
+		save = &rewound[i];
+		VectorCopy( save->origin, ent->r.currentOrigin );
+		if ( VectorCompare( ent->r.mins, save->rewoundMins ) && VectorCompare( ent->r.maxs, save->rewoundMaxs ) ) {
+			VectorCopy( save->mins, ent->r.mins );
+			VectorCopy( save->maxs, ent->r.maxs );
+		}
+		trap_LinkEntity( ent );
+	}
+	numRewound = 0;
+}
@@ -332,6 +332,24 @@ struct gclient_s {
 };
 
 
+//
+// lag compensation history, one ring per client
+//
+#define	HISTORY_FRAMES		64		// power of 2, over a second up to sv_fps 60
+
+typedef struct {
+	vec3_t		origin;				// as the snapshot shows it
+	vec3_t		mins, maxs;
+	int			teleportBit;		// EF_TELEPORT_BIT when recorded
+} historyFrame_t;
+
+typedef struct {
+	int				head;			// frames recorded, the next slot to write
+	int				times[HISTORY_FRAMES];
+	historyFrame_t	frames[HISTORY_FRAMES];
+} clientHistory_t;
+
+
 //
 // this structure is cleared as each map is entered
 //
@@ -473,6 +491,8 @@ int		G_SoundIndex( char *name );
 void	G_TeamCommand( team_t team, char *cmd );
 void	G_KillBox (gentity_t *ent);
 gentity_t *G_Find (gentity_t *from, int fieldofs, const char *match);
+gentity_t *G_FindScan (gentity_t *from, int fieldofs, const char *match);
+void G_InvalidateTargetnames( void );
 gentity_t *G_PickTarget (char *targetname);
 void	G_UseTargets (gentity_t *ent, gentity_t *activator);
 void	G_SetMovedir ( vec3_t angles, vec3_t movedir);
@@ -649,6 +669,10 @@ void ClientCommand( int clientNum );
 void ClientThink( int clientNum );
 void ClientEndFrame( gentity_t *ent );
 void G_RunClient( gentity_t *ent );
+void G_ResetClientHistory( int clientNum );
+void G_RecordClientHistory( void );
+int G_RewindClients( gentity_t *attacker, int time );
+void G_RestoreClients( void );
 
 //
 // g_team.c
@@ -770,6 +794,8 @@ extern	vmCvar_t	g_cubeTimeout;
 extern	vmCvar_t	g_redteam;
 extern	vmCvar_t	g_blueteam;
 extern	vmCvar_t	g_smoothClients;
+extern	vmCvar_t	g_lagCompensation;
+extern	vmCvar_t	g_lagCompensationMax;
 extern	vmCvar_t	pmove_fixed;
 extern	vmCvar_t	pmove_msec;
 extern	vmCvar_t	g_rankings;
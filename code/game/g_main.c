@@ -86,6 +86,8 @@ vmCvar_t	g_teamForceBalance;
 vmCvar_t	g_banIPs;
 vmCvar_t	g_filterBan;
 vmCvar_t	g_smoothClients;
+vmCvar_t	g_lagCompensation;
+vmCvar_t	g_lagCompensationMax;
 vmCvar_t	pmove_fixed;
 vmCvar_t	pmove_msec;
 vmCvar_t	g_rankings;
@@ -190,6 +192,8 @@ static cvarTable_t		gameCvarTable[] = {
 	{ &g_proxMineTimeout, "g_proxMineTimeout", "20000", 0, 0, qfalse },
 #endif
 	{ &g_smoothClients, "g_smoothClients", "1", 0, 0, qfalse},
+	{ &g_lagCompensation, "g_lagCompensation", "1", CVAR_ARCHIVE, 0, qfalse},
+	{ &g_lagCompensationMax, "g_lagCompensationMax", "500", CVAR_ARCHIVE, 0, qfalse},
 	{ &pmove_fixed, "pmove_fixed", "0", CVAR_SYSTEMINFO, 0, qfalse},
 	{ &pmove_msec, "pmove_msec", "8", CVAR_SYSTEMINFO, 0, qfalse},
 
@@ -323,6 +327,7 @@ void G_FindTeams( void ) {
 				if ( e2->targetname ) {
 					e->targetname = e2->targetname;
 					e2->targetname = NULL;
+					G_InvalidateTargetnames();
 				}
 			}
 		}
@@ -504,6 +509,7 @@ void G_InitGame( int levelTime, int randomSeed, int restart ) {
 
 	// initialize all entities for this game
 	memset( g_entities, 0, MAX_GENTITIES * sizeof(g_entities[0]) );
+	G_InvalidateTargetnames();
 	level.gentities = g_entities;
 
 	// initialize all clients for this game
@@ -1857,6 +1863,9 @@ start = trap_Milliseconds();
 	}
 end = trap_Milliseconds();
 
+	// remember where everyone is for lag compensated hitscan
+	G_RecordClientHistory();
+
 	// see if it is time to do a tournement restart
 	CheckTournament();
 
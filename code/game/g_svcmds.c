@@ -435,6 +435,110 @@ void	Svcmd_ForceTeam_f( void ) {
 	SetTeam( &g_entities[cl - level.clients], str );
 }
 
+/*
+===================
+Svcmd_LagBench_f
+
+lagbench [shots]
+Rewinds and restores every client the way a hitscan shot does, at
+times spread over the g_lagCompensationMax window.  Add bots first.
+===================
+*/
+void	Svcmd_LagBench_f( void ) {
+	char		str[MAX_TOKEN_CHARS];
+	int			shots, window, moved;
+	int			i, start, msec;
+
+	shots = 10000;
+	if ( trap_Argc() > 1 ) {
+		trap_Argv( 1, str, sizeof( str ) );
+		shots = atoi( str );
+	}
+	if ( shots < 1 ) {
+		shots = 1;
+	}
+	window = g_lagCompensationMax.integer > 1 ? g_lagCompensationMax.integer : 1;
+
+	moved = 0;
+	start = trap_Milliseconds();
+	for ( i = 0 ; i < shots ; i++ ) {
+		moved += G_RewindClients( NULL, level.time - 1 - ( i * 17 ) % window );
+		G_RestoreClients();
+	}
+	msec = trap_Milliseconds() - start;
+
+	if ( !moved ) {
+		G_Printf( "no clients were rewound, check g_lagCompensation and add some bots\n" );
+		return;
+	}
+	G_Printf( "%i shots, %.1f clients rewound per shot, %.2f usec per shot\n",
+		shots, (float)moved / shots, msec * 1000.0f / shots );
+}
+
+/*
+===================
+Svcmd_FindBench_f
+
+findbench [passes]
+Looks up the targets of every entity that has one, the way
+G_UseTargets does, with the targetname index and with a plain scan
+of every entity.
+===================
+*/
+void	Svcmd_FindBench_f( void ) {
+	char		str[MAX_TOKEN_CHARS];
+	gentity_t	*ent, *t;
+	int			passes, lookups, found[2];
+	int			i, mode, start, msec[2];
+
+	passes = 1000;
+	if ( trap_Argc() > 1 ) {
+		trap_Argv( 1, str, sizeof( str ) );
+		passes = atoi( str );
+	}
+	if ( passes < 1 ) {
+		passes = 1;
+	}
+
+	lookups = 0;
+	for ( mode = 0 ; mode < 2 ; mode++ ) {
+		found[mode] = 0;
+		start = trap_Milliseconds();
+		for ( i = 0 ; i < passes ; i++ ) {
+			for ( ent = g_entities ; ent < &g_entities[level.num_entities] ; ent++ ) {
+				if ( !ent->inuse || !ent->target ) {
+					continue;
+				}
+				if ( !mode ) {
+					lookups++;
+				}
+				t = NULL;
+				if ( mode ) {
+					while ( ( t = G_Find( t, FOFS(targetname), ent->target ) ) != NULL ) {
+						found[mode]++;
+					}
+				} else {
+					while ( ( t = G_FindScan( t, FOFS(targetname), ent->target ) ) != NULL ) {
+						found[mode]++;
+					}
+				}
+			}
+		}
+		msec[mode] = trap_Milliseconds() - start;
+	}
+
+	if ( !lookups ) {
+		G_Printf( "no entities have a target\n" );
+		return;
+	}
+	G_Printf( "%i entities, %i targets looked up %i times\n", level.num_entities, lookups / passes, passes );
+	G_Printf( "scan: %.2f usec per lookup, index: %.2f usec per lookup\n",
+		msec[0] * 1000.0f / lookups, msec[1] * 1000.0f / lookups );
+	if ( found[0] != found[1] ) {
+		G_Printf( "the index found %i targets, the scan found %i\n", found[1], found[0] );
+	}
+}
+
 char	*ConcatArgs( int start );
 
 /*
@@ -488,6 +592,16 @@ qboolean	ConsoleCommand( void ) {
 		return qtrue;
 	}
 
+	if (Q_stricmp (cmd, "lagbench") == 0) {
+		Svcmd_LagBench_f();
+		return qtrue;
+	}
+
+	if (Q_stricmp (cmd, "findbench") == 0) {
+		Svcmd_FindBench_f();
+		return qtrue;
+	}
+
 	if (Q_stricmp (cmd, "listip") == 0) {
 		trap_SendConsoleCommand( EXEC_NOW, "g_banIPs\n" );
 		return qtrue;
@@ -144,6 +144,108 @@ void G_TeamCommand( team_t team, char *cmd ) {
 }
 
 
+/*
+=============================================================================
+
+TARGETNAME INDEX
+
+Hash chains of the entities with a targetname, in entity number order,
+so targeting doesn't scan every entity.  Anything that gives an entity
+a targetname calls G_InvalidateTargetnames and the index is rebuilt on
+the next lookup.  A stale entry is harmless, the name is compared again.
+
+=============================================================================
+*/
+
+#define	TARGETNAME_HASH_SIZE	256
+
+// FOFS(targetname) without going through a pointer to int cast
+#define	TARGETNAME_OFS			( (int)( (byte *)&g_entities[0].targetname - (byte *)g_entities ) )
+
+static int		targetnameHash[TARGETNAME_HASH_SIZE];	// first entity number or -1
+static int		targetnameNext[MAX_GENTITIES];
+static qboolean	targetnameIndexValid;
+
+static int G_TargetnameHash( const char *name ) {
+	int		i;
+	int		hash;
+
+	hash = 0;
+	for ( i = 0 ; name[i] ; i++ ) {
+		hash += tolower( name[i] ) * ( i + 119 );
+	}
+	return hash & ( TARGETNAME_HASH_SIZE - 1 );
+}
+
+void G_InvalidateTargetnames( void ) {
+	targetnameIndexValid = qfalse;
+}
+
+/*
+=============
+G_BuildTargetnames
+=============
+*/
+static void G_BuildTargetnames( void ) {
+	int			i, hash;
+	gentity_t	*ent;
+
+	for ( i = 0 ; i < TARGETNAME_HASH_SIZE ; i++ ) {
+		targetnameHash[i] = -1;
+	}
+
+	// link backwards so the chains come out in entity order
+	for ( i = level.num_entities - 1 ; i >= 0 ; i-- ) {
+		ent = &g_entities[i];
+		if ( !ent->inuse || !ent->targetname ) {
+			continue;
+		}
+		hash = G_TargetnameHash( ent->targetname );
+		targetnameNext[i] = targetnameHash[hash];
+		targetnameHash[hash] = i;
+	}
+
+	targetnameIndexValid = qtrue;
+}
+
+/*
+=============
+G_FindTargetname
+
+G_Find on FOFS(targetname)
+=============
+*/
+static gentity_t *G_FindTargetname( gentity_t *from, const char *match ) {
+	int			num;
+	gentity_t	*ent;
+
+	if ( !targetnameIndexValid ) {
+		G_BuildTargetnames();
+	}
+
+	if ( from && from->inuse && from->targetname && !Q_stricmp( from->targetname, match ) ) {
+		// still on the chain from the last call
+		num = targetnameNext[from - g_entities];
+	} else {
+		num = targetnameHash[G_TargetnameHash( match )];
+	}
+
+	for ( ; num != -1 ; num = targetnameNext[num] ) {
+		ent = &g_entities[num];
+		if ( from && ent <= from ) {
+			continue;
+		}
+		if ( num >= level.num_entities || !ent->inuse || !ent->targetname ) {
+			continue;
+		}
+		if ( !Q_stricmp( ent->targetname, match ) ) {
+			return ent;
+		}
+	}
+
+	return NULL;
+}
+
 /*
 =============
 G_Find
@@ -157,6 +259,23 @@ NULL will be returned if the end of the list is reached.
 =============
 */
 gentity_t *G_Find (gentity_t *from, int fieldofs, const char *match)
+{
+	// the index isn't worth rebuilding for every entity while the map spawns
+	if ( fieldofs == TARGETNAME_OFS && ( targetnameIndexValid || !level.spawning ) ) {
+		return G_FindTargetname( from, match );
+	}
+
+	return G_FindScan( from, fieldofs, match );
+}
+
+/*
+=============
+G_FindScan
+
+G_Find without the targetname index, for findbench to compare against
+=============
+*/
+gentity_t *G_FindScan (gentity_t *from, int fieldofs, const char *match)
 {
 	char	*s;
 
@@ -468,6 +587,10 @@ void G_FreeEntity( gentity_t *ed ) {
 		return;
 	}
 
+	if ( ed->targetname ) {
+		G_InvalidateTargetnames();
+	}
+
 	memset (ed, 0, sizeof(*ed));
 	ed->classname = "freed";
 	ed->freetime = level.time;
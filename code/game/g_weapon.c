@@ -80,7 +80,9 @@ qboolean CheckGauntletAttack( gentity_t *ent ) {
 
 	VectorMA (muzzle, 32, forward, end);
 
+	G_RewindClients( ent, ent->client->pers.cmd.serverTime );
 	trap_Trace (&tr, muzzle, NULL, NULL, end, ent->s.number, MASK_SHOT);
+	G_RestoreClients();
 	if ( tr.surfaceFlags & SURF_NOIMPACT ) {
 		return qfalse;
 	}
@@ -796,6 +798,8 @@ FireWeapon
 */
 void FireWeapon( gentity_t *ent ) {
 	playerState_t * ps;
+	qboolean	hitscan;
+
 	if (ent->client->ps.powerups[PW_QUAD] ) {
 		s_quadFactor = g_quadfactor.value;
 	} else {
@@ -829,6 +833,19 @@ void FireWeapon( gentity_t *ent ) {
 
 	//Com_Printf( "%f  %f  %f\n", forward[0], forward[1], forward[2] );
 
+	// hitscan traces against the other players where this client
+	// saw them when it fired, not where they are now
+	hitscan = ( ent->s.weapon == WP_MACHINEGUN || ent->s.weapon == WP_SHOTGUN
+		|| ent->s.weapon == WP_LIGHTNING || ent->s.weapon == WP_RAILGUN );
+#ifdef MISSIONPACK
+	if ( ent->s.weapon == WP_CHAINGUN ) {
+		hitscan = qtrue;
+	}
+#endif
+	if ( hitscan ) {
+		G_RewindClients( ent, ent->client->pers.cmd.serverTime );
+	}
+
 	// fire the specific weapon
 	switch( ent->s.weapon ) {
 	case WP_GAUNTLET:
@@ -880,6 +897,10 @@ void FireWeapon( gentity_t *ent ) {
 // FIXME		G_Error( "Bad ent->s.weapon" );
 		break;
 	}
+
+	if ( hitscan ) {
+		G_RestoreClients();
+	}
 }
 
 
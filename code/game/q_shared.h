@@ -125,6 +125,19 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #define idppc_altivec 0
 #endif
 
+// SSE2 is part of the x86-64 baseline, 32 bit builds only get it when the compiler targets it
+#if (defined __SSE2__ || defined _M_X64 || defined _M_AMD64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)) && !defined Q3_VM && !defined(C_ONLY)
+#define idsse2	1
+#if defined __AVX2__
+#define idavx2	1
+#else
+#define idavx2	0
+#endif
+#else
+#define idsse2	0
+#define idavx2	0
+#endif
+
 // for windows fastcall option
 
 #define	QDECL
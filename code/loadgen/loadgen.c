@@ -0,0 +1,1522 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Foobar; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+// loadgen.c -- headless fake clients for soaking a dedicated server
+
+/*
+=============================================================================
+
+Each fake client owns a UDP socket and goes through the same handshake
+as the real client: getchallenge, connect, gamestate, then usercmds and
+delta compressed snapshots over an encoded netchan.  Nothing is rendered
+or predicted, so a single process can hold a full server.
+
+The client count is stepped through a list (-clients 1,8,32,64) and one
+row is printed per step with the server's cpu time per frame, total
+bandwidth and snapshot latency percentiles.  Latency is measured the
+same way the client measures ping: the time from sending the newest
+usercmd that a snapshot's playerstate has already run.
+
+The server must be on a LAN address (no cd key authorization) and run
+with sv_pure 0, since the fake clients have no paks to report.
+
+=============================================================================
+*/
+
+#include "../game/q_shared.h"
+#include "../qcommon/qcommon.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <setjmp.h>
+#include <netdb.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define	LG_MAX_CLIENTS		MAX_CLIENTS
+#define	LG_PARSE_ENTITIES	2048
+#define	LG_CMD_BACKUP		64
+#define	LG_CMD_MASK			(LG_CMD_BACKUP-1)
+#define	LG_RETRANSMIT		3000		// connect and challenge resend
+#define	LG_TIMEOUT			10000		// drop when the server goes quiet
+#define	LG_MAX_SAMPLES		(1<<20)
+#define	LG_MAX_SEGMENTS		256
+#define	LG_MAX_STEPS		32
+
+typedef enum {
+	LG_FREE,
+	LG_CONNECTING,		// sending getchallenge
+	LG_CHALLENGING,		// sending connect
+	LG_CONNECTED,		// netchan up, waiting for the gamestate
+	LG_PRIMED,			// have a gamestate, sending usercmds
+	LG_ACTIVE,			// have a valid snapshot
+	LG_DROPPED
+} lgState_t;
+
+typedef struct {
+	qboolean		valid;
+	int				serverTime;
+	int				messageNum;
+	int				deltaNum;
+	playerState_t	ps;
+	int				numEntities;
+	int				parseEntitiesNum;
+} lgSnapshot_t;
+
+typedef struct {
+	int				realtime;		// when the packet was sent
+	int				serverTime;		// of the newest usercmd in it
+	int				cmdNumber;
+} lgOutPacket_t;
+
+typedef struct {
+	int				num;
+	int				socket;
+	lgState_t		state;
+	int				qport;
+	int				challenge;
+	int				connectTime;
+	int				lastPacketTime;
+	netchan_t		netchan;
+
+	int				serverId;
+	int				clientNum;
+	int				checksumFeed;
+	int				serverMessageSequence;
+	int				serverCommandSequence;
+	int				reliableSequence;
+	int				reliableAcknowledge;
+	char			serverCommands[MAX_RELIABLE_COMMANDS][MAX_STRING_CHARS];
+	char			reliableCommands[MAX_RELIABLE_COMMANDS][MAX_STRING_CHARS];
+
+	entityState_t	baselines[MAX_GENTITIES];
+	entityState_t	parseEntities[LG_PARSE_ENTITIES];
+	int				parseEntitiesNum;
+	lgSnapshot_t	snapshots[PACKET_BACKUP];
+	lgSnapshot_t	snap;
+	int				snapRealtime;
+
+	usercmd_t		cmds[LG_CMD_BACKUP];
+	int				cmdNumber;
+	int				cmdServerTime;
+	lgOutPacket_t	outPackets[PACKET_BACKUP];
+	int				nextSend;
+	int				scriptTime;		// offset into the usercmd script
+	float			yaw;
+
+	// measurement window
+	int				firstSnapTime, firstSnapReal;
+	int				lastSnapTime, lastSnapReal;
+} lgClient_t;
+
+// one line of the usercmd script
+typedef struct {
+	int				msec;
+	int				forwardmove, rightmove, upmove;
+	float			yawSpeed;		// degrees per second
+	float			pitch;
+	int				buttons;
+} lgSegment_t;
+
+typedef struct {
+	int				bytesIn;
+	int				bytesOut;
+	int				packetsIn;
+	int				packetsOut;
+	int				snapshots;
+	int				drops;			// clients lost during the step
+	int				numSamples;
+	int				*samples;		// snapshot latencies in msec
+} lgStats_t;
+
+static lgClient_t	*lg_clients[LG_MAX_CLIENTS];
+static int			lg_numClients;
+static lgClient_t	*lg_current;		// the client packets are sent from
+static jmp_buf		lg_abort;
+
+static netadr_t		lg_server;
+static int			lg_pps = 60;
+static int			lg_fps = 20;		// server sv_fps, for per frame numbers
+static int			lg_warmup = 3000;
+static int			lg_duration = 10000;
+static int			lg_pid;
+static int			lg_verbose;
+static int			lg_startTime;
+
+static lgSegment_t	lg_script[LG_MAX_SEGMENTS];
+static int			lg_numSegments;
+static int			lg_scriptLength;
+
+static lgStats_t	lg_stats;
+static qboolean		lg_recording;
+
+cvar_t				*cl_shownet;
+
+/*
+=============================================================================
+
+QCOMMON GLUE
+
+msg.c, net_chan.c and huffman.c only need these from the engine
+
+=============================================================================
+*/
+
+void QDECL Com_Printf( const char *fmt, ... ) {
+	va_list		argptr;
+
+	va_start( argptr, fmt );
+	vprintf( fmt, argptr );
+	va_end( argptr );
+}
+
+void QDECL Com_DPrintf( const char *fmt, ... ) {
+	va_list		argptr;
+
+	if ( !lg_verbose ) {
+		return;
+	}
+	va_start( argptr, fmt );
+	vprintf( fmt, argptr );
+	va_end( argptr );
+}
+
+/*
+=================
+Com_Error
+
+Drops the client whose packet was being handled, anything else is fatal
+=================
+*/
+void QDECL Com_Error( int code, const char *fmt, ... ) {
+	va_list		argptr;
+	char		text[1024];
+
+	va_start( argptr, fmt );
+	Q_vsnprintf( text, sizeof( text ), fmt, argptr );
+	va_end( argptr );
+
+	if ( code != ERR_FATAL && lg_current ) {
+		printf( "client %i dropped: %s\n", lg_current->num, text );
+		longjmp( lg_abort, 1 );
+	}
+	printf( "ERROR: %s\n", text );
+	exit( 1 );
+}
+
+void Com_Memcpy( void *dest, const void *src, const size_t count ) {
+	memcpy( dest, src, count );
+}
+
+void Com_Memset( void *dest, const int val, const size_t count ) {
+	memset( dest, val, count );
+}
+
+int Com_HashKey( char *string, int maxlen ) {
+	int		hash, i;
+
+	hash = 0;
+	for ( i = 0 ; i < maxlen && string[i] != '\0' ; i++ ) {
+		hash += string[i] * (119 + i);
+	}
+	hash = (hash ^ (hash >> 10) ^ (hash >> 20));
+	return hash;
+}
+
+/*
+=================
+Cvar_Get
+
+Only the netchan asks for cvars, they all keep their defaults
+=================
+*/
+cvar_t *Cvar_Get( const char *var_name, const char *var_value, int flags ) {
+	cvar_t	*var;
+
+	var = calloc( 1, sizeof( *var ) );
+	var->name = strdup( var_name );
+	var->string = strdup( var_value );
+	var->resetString = var->string;
+	var->flags = flags;
+	var->value = atof( var_value );
+	var->integer = atoi( var_value );
+	return var;
+}
+
+qboolean Sys_StringToAdr( const char *s, netadr_t *a ) {
+	struct hostent	*h;
+	struct in_addr	in;
+
+	Com_Memset( a, 0, sizeof( *a ) );
+	if ( inet_aton( s, &in ) ) {
+		Com_Memcpy( a->ip, &in.s_addr, 4 );
+	} else {
+		h = gethostbyname( s );
+		if ( !h || h->h_addrtype != AF_INET ) {
+			return qfalse;
+		}
+		Com_Memcpy( a->ip, h->h_addr_list[0], 4 );
+	}
+	a->type = NA_IP;
+	return qtrue;
+}
+
+/*
+=================
+Sys_SendPacket
+
+Everything goes out of the current client's socket
+=================
+*/
+void Sys_SendPacket( int length, const void *data, netadr_t to ) {
+	struct sockaddr_in	addr;
+
+	if ( !lg_current ) {
+		return;
+	}
+
+	Com_Memset( &addr, 0, sizeof( addr ) );
+	addr.sin_family = AF_INET;
+	addr.sin_port = to.port;
+	Com_Memcpy( &addr.sin_addr.s_addr, to.ip, 4 );
+
+	if ( sendto( lg_current->socket, data, length, 0, (struct sockaddr *)&addr, sizeof( addr ) ) == -1 ) {
+		if ( errno != EAGAIN ) {
+			Com_DPrintf( "client %i: sendto: %s\n", lg_current->num, strerror( errno ) );
+		}
+		return;
+	}
+	if ( lg_recording ) {
+		lg_stats.bytesOut += length;
+		lg_stats.packetsOut++;
+	}
+}
+
+/*
+=================
+LG_Milliseconds
+=================
+*/
+static int LG_Milliseconds( void ) {
+	struct timeval	tp;
+
+	gettimeofday( &tp, NULL );
+	return ( tp.tv_sec * 1000 + tp.tv_usec / 1000 ) - lg_startTime;
+}
+
+/*
+=============================================================================
+
+NETCHAN
+
+The same xor encoding the client applies in cl_net_chan.c
+
+=============================================================================
+*/
+
+/*
+=================
+LG_Netchan_Encode
+=================
+*/
+static void LG_Netchan_Encode( lgClient_t *cl, msg_t *msg ) {
+	int		serverId, messageAcknowledge, reliableAcknowledge;
+	int		i, index, srdc, sbit, soob;
+	byte	key, *string;
+
+	if ( msg->cursize <= CL_ENCODE_START ) {
+		return;
+	}
+
+	srdc = msg->readcount;
+	sbit = msg->bit;
+	soob = msg->oob;
+
+	msg->bit = 0;
+	msg->readcount = 0;
+	msg->oob = 0;
+
+	serverId = MSG_ReadLong( msg );
+	messageAcknowledge = MSG_ReadLong( msg );
+	reliableAcknowledge = MSG_ReadLong( msg );
+
+	msg->oob = soob;
+	msg->bit = sbit;
+	msg->readcount = srdc;
+
+	string = (byte *)cl->serverCommands[ reliableAcknowledge & (MAX_RELIABLE_COMMANDS-1) ];
+	index = 0;
+	key = cl->challenge ^ serverId ^ messageAcknowledge;
+	for ( i = CL_ENCODE_START ; i < msg->cursize ; i++ ) {
+		if ( !string[index] ) {
+			index = 0;
+		}
+		if ( string[index] > 127 || string[index] == '%' ) {
+			key ^= '.' << (i & 1);
+		} else {
+			key ^= string[index] << (i & 1);
+		}
+		index++;
+		msg->data[i] ^= key;
+	}
+}
+
+/*
+=================
+LG_Netchan_Decode
+=================
+*/
+static void LG_Netchan_Decode( lgClient_t *cl, msg_t *msg ) {
+	int		reliableAcknowledge, i, index;
+	int		srdc, sbit, soob;
+	byte	key, *string;
+
+	srdc = msg->readcount;
+	sbit = msg->bit;
+	soob = msg->oob;
+
+	msg->oob = 0;
+
+	reliableAcknowledge = MSG_ReadLong( msg );
+
+	msg->oob = soob;
+	msg->bit = sbit;
+	msg->readcount = srdc;
+
+	string = (byte *)cl->reliableCommands[ reliableAcknowledge & (MAX_RELIABLE_COMMANDS-1) ];
+	index = 0;
+	key = cl->challenge ^ LittleLong( *(unsigned *)msg->data );
+	for ( i = msg->readcount + CL_DECODE_START ; i < msg->cursize ; i++ ) {
+		if ( !string[index] ) {
+			index = 0;
+		}
+		if ( string[index] > 127 || string[index] == '%' ) {
+			key ^= '.' << (i & 1);
+		} else {
+			key ^= string[index] << (i & 1);
+		}
+		index++;
+		msg->data[i] ^= key;
+	}
+}
+
+/*
+=================
+LG_AddReliableCommand
+=================
+*/
+static void LG_AddReliableCommand( lgClient_t *cl, const char *cmd ) {
+	if ( cl->reliableSequence - cl->reliableAcknowledge > MAX_RELIABLE_COMMANDS ) {
+		Com_Error( ERR_DROP, "client command overflow" );
+	}
+	cl->reliableSequence++;
+	Q_strncpyz( cl->reliableCommands[ cl->reliableSequence & (MAX_RELIABLE_COMMANDS-1) ],
+		cmd, sizeof( cl->reliableCommands[0] ) );
+}
+
+/*
+=================
+LG_WritePacket
+
+Same layout as CL_WritePacket, with the last two packets' usercmds
+duplicated like cl_packetdup 1
+=================
+*/
+static void LG_WritePacket( lgClient_t *cl, int realtime ) {
+	msg_t		buf;
+	byte		data[MAX_MSGLEN];
+	usercmd_t	nullcmd, *cmd, *oldcmd;
+	int			i, count, key, oldPacketNum, packetNum;
+
+	Com_Memset( &nullcmd, 0, sizeof( nullcmd ) );
+	oldcmd = &nullcmd;
+
+	MSG_Init( &buf, data, sizeof( data ) );
+	MSG_Bitstream( &buf );
+
+	MSG_WriteLong( &buf, cl->serverId );
+	MSG_WriteLong( &buf, cl->serverMessageSequence );
+	MSG_WriteLong( &buf, cl->serverCommandSequence );
+
+	for ( i = cl->reliableAcknowledge + 1 ; i <= cl->reliableSequence ; i++ ) {
+		MSG_WriteByte( &buf, clc_clientCommand );
+		MSG_WriteLong( &buf, i );
+		MSG_WriteString( &buf, cl->reliableCommands[ i & (MAX_RELIABLE_COMMANDS-1) ] );
+	}
+
+	oldPacketNum = (cl->netchan.outgoingSequence - 2) & PACKET_MASK;
+	count = cl->cmdNumber - cl->outPackets[ oldPacketNum ].cmdNumber;
+	if ( count > MAX_PACKET_USERCMDS ) {
+		count = MAX_PACKET_USERCMDS;
+	}
+	if ( count >= 1 ) {
+		if ( !cl->snap.valid || cl->serverMessageSequence != cl->snap.messageNum ) {
+			MSG_WriteByte( &buf, clc_moveNoDelta );
+		} else {
+			MSG_WriteByte( &buf, clc_move );
+		}
+		MSG_WriteByte( &buf, count );
+
+		key = cl->checksumFeed ^ cl->serverMessageSequence;
+		key ^= Com_HashKey( cl->serverCommands[ cl->serverCommandSequence & (MAX_RELIABLE_COMMANDS-1) ], 32 );
+
+		for ( i = 0 ; i < count ; i++ ) {
+			cmd = &cl->cmds[ (cl->cmdNumber - count + i + 1) & LG_CMD_MASK ];
+			MSG_WriteDeltaUsercmdKey( &buf, key, oldcmd, cmd );
+			oldcmd = cmd;
+		}
+	}
+
+	packetNum = cl->netchan.outgoingSequence & PACKET_MASK;
+	cl->outPackets[ packetNum ].realtime = realtime;
+	cl->outPackets[ packetNum ].serverTime = oldcmd->serverTime;
+	cl->outPackets[ packetNum ].cmdNumber = cl->cmdNumber;
+
+	MSG_WriteByte( &buf, clc_EOF );
+	LG_Netchan_Encode( cl, &buf );
+	Netchan_Transmit( &cl->netchan, buf.cursize, buf.data );
+	while ( cl->netchan.unsentFragments ) {
+		Netchan_TransmitNextFragment( &cl->netchan );
+	}
+}
+
+/*
+=============================================================================
+
+SERVER MESSAGES
+
+=============================================================================
+*/
+
+/*
+=================
+LG_SystemInfoChanged
+=================
+*/
+static void LG_SystemInfoChanged( lgClient_t *cl, const char *systemInfo ) {
+	cl->serverId = atoi( Info_ValueForKey( systemInfo, "sv_serverid" ) );
+}
+
+/*
+=================
+LG_ServerCommand
+
+Only the commands that change the connection are looked at
+=================
+*/
+static void LG_ServerCommand( lgClient_t *cl, const char *s ) {
+	char	text[BIG_INFO_STRING];
+	char	*start, *end;
+	int		len;
+
+	if ( !Q_strncmp( s, "disconnect", 10 ) ) {
+		Com_Error( ERR_DROP, "server disconnected%s", s + 10 );
+	}
+
+	// "cs 1 \"<systeminfo>\"" after a map_restart
+	if ( !Q_strncmp( s, "cs ", 3 ) && atoi( s + 3 ) == CS_SYSTEMINFO ) {
+		start = strchr( s, '"' );
+		end = strrchr( s, '"' );
+		if ( start && end > start ) {
+			len = end - start;
+			if ( len > (int)sizeof( text ) ) {
+				len = sizeof( text );
+			}
+			Q_strncpyz( text, start + 1, len );
+			LG_SystemInfoChanged( cl, text );
+			cl->snap.valid = qfalse;
+		}
+	}
+}
+
+/*
+=================
+LG_ParseCommandString
+=================
+*/
+static void LG_ParseCommandString( lgClient_t *cl, msg_t *msg ) {
+	char	*s;
+	int		seq;
+
+	seq = MSG_ReadLong( msg );
+	s = MSG_ReadString( msg );
+
+	if ( cl->serverCommandSequence >= seq ) {
+		return;
+	}
+	cl->serverCommandSequence = seq;
+	Q_strncpyz( cl->serverCommands[ seq & (MAX_RELIABLE_COMMANDS-1) ], s, sizeof( cl->serverCommands[0] ) );
+
+	LG_ServerCommand( cl, s );
+}
+
+/*
+=================
+LG_ParseGamestate
+=================
+*/
+static void LG_ParseGamestate( lgClient_t *cl, msg_t *msg ) {
+	entityState_t	nullstate;
+	int				cmd, i;
+	char			*s;
+
+	cl->serverCommandSequence = MSG_ReadLong( msg );
+
+	Com_Memset( cl->snapshots, 0, sizeof( cl->snapshots ) );
+	Com_Memset( &cl->snap, 0, sizeof( cl->snap ) );
+	cl->parseEntitiesNum = 0;
+
+	while ( 1 ) {
+		cmd = MSG_ReadByte( msg );
+		if ( cmd == svc_EOF ) {
+			break;
+		}
+
+		if ( cmd == svc_configstring ) {
+			i = MSG_ReadShort( msg );
+			if ( i < 0 || i >= MAX_CONFIGSTRINGS ) {
+				Com_Error( ERR_DROP, "configstring > MAX_CONFIGSTRINGS" );
+			}
+			s = MSG_ReadBigString( msg );
+			if ( i == CS_SYSTEMINFO ) {
+				LG_SystemInfoChanged( cl, s );
+			}
+		} else if ( cmd == svc_baseline ) {
+			i = MSG_ReadBits( msg, GENTITYNUM_BITS );
+			if ( i < 0 || i >= MAX_GENTITIES ) {
+				Com_Error( ERR_DROP, "Baseline number out of range: %i", i );
+			}
+			Com_Memset( &nullstate, 0, sizeof( nullstate ) );
+			MSG_ReadDeltaEntity( msg, &nullstate, &cl->baselines[i], i );
+		} else {
+			Com_Error( ERR_DROP, "LG_ParseGamestate: bad command byte" );
+		}
+	}
+
+	cl->clientNum = MSG_ReadLong( msg );
+	cl->checksumFeed = MSG_ReadLong( msg );
+
+	if ( cl->state < LG_PRIMED ) {
+		cl->state = LG_PRIMED;
+	}
+}
+
+/*
+=================
+LG_DeltaEntity
+=================
+*/
+static void LG_DeltaEntity( lgClient_t *cl, msg_t *msg, lgSnapshot_t *frame, int newnum,
+						   entityState_t *old, qboolean unchanged ) {
+	entityState_t	*state;
+
+	state = &cl->parseEntities[ cl->parseEntitiesNum & (LG_PARSE_ENTITIES-1) ];
+	if ( unchanged ) {
+		*state = *old;
+	} else {
+		MSG_ReadDeltaEntity( msg, old, state, newnum );
+	}
+
+	if ( state->number == (MAX_GENTITIES-1) ) {
+		return;		// entity was delta removed
+	}
+	cl->parseEntitiesNum++;
+	frame->numEntities++;
+}
+
+/*
+=================
+LG_ParsePacketEntities
+=================
+*/
+static void LG_ParsePacketEntities( lgClient_t *cl, msg_t *msg, lgSnapshot_t *oldframe, lgSnapshot_t *newframe ) {
+	entityState_t	*oldstate;
+	int				newnum, oldindex, oldnum;
+
+	newframe->parseEntitiesNum = cl->parseEntitiesNum;
+	newframe->numEntities = 0;
+
+	oldindex = 0;
+	oldstate = NULL;
+	oldnum = 99999;
+	if ( oldframe && oldframe->numEntities > 0 ) {
+		oldstate = &cl->parseEntities[ oldframe->parseEntitiesNum & (LG_PARSE_ENTITIES-1) ];
+		oldnum = oldstate->number;
+	}
+
+	while ( 1 ) {
+		newnum = MSG_ReadBits( msg, GENTITYNUM_BITS );
+		if ( newnum == (MAX_GENTITIES-1) ) {
+			break;
+		}
+		if ( msg->readcount > msg->cursize ) {
+			Com_Error( ERR_DROP, "LG_ParsePacketEntities: end of message" );
+		}
+
+		while ( oldnum < newnum ) {
+			LG_DeltaEntity( cl, msg, newframe, oldnum, oldstate, qtrue );
+			oldindex++;
+			if ( oldindex >= oldframe->numEntities ) {
+				oldnum = 99999;
+			} else {
+				oldstate = &cl->parseEntities[ (oldframe->parseEntitiesNum + oldindex) & (LG_PARSE_ENTITIES-1) ];
+				oldnum = oldstate->number;
+			}
+		}
+
+		if ( oldnum == newnum ) {
+			LG_DeltaEntity( cl, msg, newframe, newnum, oldstate, qfalse );
+			oldindex++;
+			if ( oldindex >= oldframe->numEntities ) {
+				oldnum = 99999;
+			} else {
+				oldstate = &cl->parseEntities[ (oldframe->parseEntitiesNum + oldindex) & (LG_PARSE_ENTITIES-1) ];
+				oldnum = oldstate->number;
+			}
+			continue;
+		}
+
+		// delta from baseline
+		LG_DeltaEntity( cl, msg, newframe, newnum, &cl->baselines[newnum], qfalse );
+	}
+
+	// any remaining entities in the old frame are copied over
+	while ( oldnum != 99999 ) {
+		LG_DeltaEntity( cl, msg, newframe, oldnum, oldstate, qtrue );
+		oldindex++;
+		if ( oldindex >= oldframe->numEntities ) {
+			oldnum = 99999;
+		} else {
+			oldstate = &cl->parseEntities[ (oldframe->parseEntitiesNum + oldindex) & (LG_PARSE_ENTITIES-1) ];
+			oldnum = oldstate->number;
+		}
+	}
+}
+
+/*
+=================
+LG_ParseSnapshot
+=================
+*/
+static void LG_ParseSnapshot( lgClient_t *cl, msg_t *msg, int realtime ) {
+	lgSnapshot_t	newSnap, *old;
+	byte			areamask[MAX_MAP_AREA_BYTES];
+	int				deltaNum, len, i, packetNum, oldMessageNum;
+	lgOutPacket_t	*out;
+
+	Com_Memset( &newSnap, 0, sizeof( newSnap ) );
+	newSnap.serverTime = MSG_ReadLong( msg );
+	newSnap.messageNum = cl->serverMessageSequence;
+
+	deltaNum = MSG_ReadByte( msg );
+	newSnap.deltaNum = deltaNum ? newSnap.messageNum - deltaNum : -1;
+	MSG_ReadByte( msg );	// snapFlags
+
+	old = NULL;
+	if ( newSnap.deltaNum <= 0 ) {
+		newSnap.valid = qtrue;
+	} else {
+		old = &cl->snapshots[ newSnap.deltaNum & PACKET_MASK ];
+		if ( old->valid && old->messageNum == newSnap.deltaNum
+			&& cl->parseEntitiesNum - old->parseEntitiesNum <= LG_PARSE_ENTITIES-128 ) {
+			newSnap.valid = qtrue;
+		}
+	}
+
+	len = MSG_ReadByte( msg );
+	if ( len > (int)sizeof( areamask ) ) {
+		Com_Error( ERR_DROP, "LG_ParseSnapshot: invalid size %d for areamask", len );
+	}
+	MSG_ReadData( msg, areamask, len );
+
+	MSG_ReadDeltaPlayerstate( msg, old ? &old->ps : NULL, &newSnap.ps );
+	LG_ParsePacketEntities( cl, msg, old, &newSnap );
+
+	if ( !newSnap.valid ) {
+		return;
+	}
+
+	// invalidate anything skipped over, so a later delta can't use it
+	oldMessageNum = cl->snap.messageNum + 1;
+	if ( newSnap.messageNum - oldMessageNum >= PACKET_BACKUP ) {
+		oldMessageNum = newSnap.messageNum - ( PACKET_BACKUP - 1 );
+	}
+	for ( ; oldMessageNum < newSnap.messageNum ; oldMessageNum++ ) {
+		cl->snapshots[ oldMessageNum & PACKET_MASK ].valid = qfalse;
+	}
+
+	cl->snap = newSnap;
+	cl->snapRealtime = realtime;
+	cl->snapshots[ newSnap.messageNum & PACKET_MASK ] = newSnap;
+	cl->state = LG_ACTIVE;
+
+	if ( !lg_recording ) {
+		return;
+	}
+
+	lg_stats.snapshots++;
+	if ( !cl->firstSnapReal ) {
+		cl->firstSnapTime = newSnap.serverTime;
+		cl->firstSnapReal = realtime;
+	}
+	cl->lastSnapTime = newSnap.serverTime;
+	cl->lastSnapReal = realtime;
+
+	// latency of the newest usercmd this snapshot has run
+	for ( i = 0 ; i < PACKET_BACKUP ; i++ ) {
+		packetNum = ( cl->netchan.outgoingSequence - 1 - i ) & PACKET_MASK;
+		out = &cl->outPackets[ packetNum ];
+		if ( out->serverTime > 0 && newSnap.ps.commandTime >= out->serverTime ) {
+			if ( lg_stats.numSamples < LG_MAX_SAMPLES ) {
+				lg_stats.samples[ lg_stats.numSamples++ ] = realtime - out->realtime;
+			}
+			break;
+		}
+	}
+}
+
+/*
+=================
+LG_ParseServerMessage
+=================
+*/
+static void LG_ParseServerMessage( lgClient_t *cl, msg_t *msg, int realtime ) {
+	int		cmd;
+
+	MSG_Bitstream( msg );
+
+	cl->reliableAcknowledge = MSG_ReadLong( msg );
+	if ( cl->reliableAcknowledge < cl->reliableSequence - MAX_RELIABLE_COMMANDS ) {
+		cl->reliableAcknowledge = cl->reliableSequence;
+	}
+
+	while ( 1 ) {
+		if ( msg->readcount > msg->cursize ) {
+			Com_Error( ERR_DROP, "LG_ParseServerMessage: read past end of server message" );
+		}
+
+		cmd = MSG_ReadByte( msg );
+		if ( cmd == svc_EOF ) {
+			break;
+		}
+
+		switch ( cmd ) {
+		default:
+			Com_Error( ERR_DROP, "LG_ParseServerMessage: Illegible server message" );
+			break;
+		case svc_nop:
+			break;
+		case svc_serverCommand:
+			LG_ParseCommandString( cl, msg );
+			break;
+		case svc_gamestate:
+			LG_ParseGamestate( cl, msg );
+			break;
+		case svc_snapshot:
+			LG_ParseSnapshot( cl, msg, realtime );
+			break;
+		case svc_download:
+			Com_Error( ERR_DROP, "server wants to send a download, use sv_pure 0 and a map it has" );
+			break;
+		}
+	}
+}
+
+/*
+=================
+LG_ConnectionlessPacket
+=================
+*/
+static void LG_ConnectionlessPacket( lgClient_t *cl, msg_t *msg, int realtime ) {
+	char	*s;
+
+	MSG_BeginReadingOOB( msg );
+	MSG_ReadLong( msg );	// skip the -1
+
+	s = MSG_ReadStringLine( msg );
+
+	if ( !Q_strncmp( s, "challengeResponse", 17 ) ) {
+		if ( cl->state != LG_CONNECTING ) {
+			return;
+		}
+		cl->challenge = atoi( s + 17 );
+		cl->state = LG_CHALLENGING;
+		cl->connectTime = -LG_RETRANSMIT;	// send the connect right away
+		return;
+	}
+
+	if ( !Q_strncmp( s, "connectResponse", 15 ) ) {
+		if ( cl->state != LG_CHALLENGING ) {
+			return;
+		}
+		Netchan_Setup( NS_CLIENT, &cl->netchan, lg_server, cl->qport );
+		cl->state = LG_CONNECTED;
+		cl->nextSend = realtime;
+		return;
+	}
+
+	if ( !Q_strncmp( s, "print", 5 ) ) {
+		s = MSG_ReadString( msg );
+		Com_Error( ERR_DROP, "%s", s );
+	}
+
+	if ( !Q_strncmp( s, "disconnect", 10 ) ) {
+		Com_Error( ERR_DROP, "server disconnected" );
+	}
+}
+
+/*
+=================
+LG_PacketEvent
+=================
+*/
+static void LG_PacketEvent( lgClient_t *cl, msg_t *msg, int realtime ) {
+	cl->lastPacketTime = realtime;
+
+	if ( msg->cursize >= 4 && *(int *)msg->data == -1 ) {
+		LG_ConnectionlessPacket( cl, msg, realtime );
+		return;
+	}
+
+	if ( cl->state < LG_CONNECTED || msg->cursize < 4 ) {
+		return;
+	}
+
+	if ( !Netchan_Process( &cl->netchan, msg ) ) {
+		return;		// out of order, duplicated, fragment
+	}
+	LG_Netchan_Decode( cl, msg );
+
+	cl->serverMessageSequence = LittleLong( *(int *)msg->data );
+	LG_ParseServerMessage( cl, msg, realtime );
+}
+
+/*
+=============================================================================
+
+USERCMDS
+
+=============================================================================
+*/
+
+/*
+=================
+LG_LoadScript
+
+One segment per line:
+	msec forward right up yawspeed pitch buttons
+forward, right and up are -127..127, yawspeed is degrees per second
+and buttons is the usercmd button mask.  The script loops.
+=================
+*/
+static void LG_LoadScript( const char *filename ) {
+	FILE			*f;
+	char			line[256];
+	lgSegment_t		*seg;
+
+	lg_numSegments = 0;
+	lg_scriptLength = 0;
+
+	if ( !filename ) {
+		static const lgSegment_t	defaultScript[] = {
+			{ 2000,  127,    0,   0,    0,   0, 0 },
+			{ 1000,    0,  127,   0,   90,   0, 0 },
+			{  500,  127,    0, 127,    0,   0, 0 },
+			{ 1500,    0,    0,   0,  180, -10, BUTTON_ATTACK },
+			{ 1000, -127, -127,   0,    0,   0, 0 },
+			{ 1000,  127,    0,   0,  -45,  10, BUTTON_ATTACK },
+		};
+
+		lg_numSegments = sizeof( defaultScript ) / sizeof( defaultScript[0] );
+		Com_Memcpy( lg_script, defaultScript, sizeof( defaultScript ) );
+	} else {
+		f = fopen( filename, "r" );
+		if ( !f ) {
+			Com_Error( ERR_FATAL, "couldn't open script %s", filename );
+		}
+		while ( fgets( line, sizeof( line ), f ) && lg_numSegments < LG_MAX_SEGMENTS ) {
+			seg = &lg_script[lg_numSegments];
+			if ( line[0] == '#' || line[0] == '/' ) {
+				continue;
+			}
+			if ( sscanf( line, "%i %i %i %i %f %f %i", &seg->msec, &seg->forwardmove,
+				&seg->rightmove, &seg->upmove, &seg->yawSpeed, &seg->pitch, &seg->buttons ) < 1 ) {
+				continue;
+			}
+			if ( seg->msec <= 0 ) {
+				continue;
+			}
+			lg_numSegments++;
+		}
+		fclose( f );
+		if ( !lg_numSegments ) {
+			Com_Error( ERR_FATAL, "no segments in %s", filename );
+		}
+	}
+
+	for ( seg = lg_script ; seg < lg_script + lg_numSegments ; seg++ ) {
+		lg_scriptLength += seg->msec;
+	}
+}
+
+/*
+=================
+LG_CreateCmd
+
+Builds the next usercmd from the script, timed against the server's
+clock as extrapolated from the last snapshot
+=================
+*/
+static void LG_CreateCmd( lgClient_t *cl, int realtime ) {
+	usercmd_t	*cmd;
+	lgSegment_t	*seg;
+	int			serverTime, msec, t;
+
+	if ( cl->snap.valid ) {
+		serverTime = cl->snap.serverTime + ( realtime - cl->snapRealtime );
+	} else {
+		serverTime = cl->cmdServerTime + 1000 / lg_pps;
+	}
+	if ( serverTime <= cl->cmdServerTime ) {
+		serverTime = cl->cmdServerTime + 1;
+	}
+	msec = serverTime - cl->cmdServerTime;
+	if ( msec > 200 ) {
+		msec = 200;
+	}
+	cl->cmdServerTime = serverTime;
+
+	cl->scriptTime = ( cl->scriptTime + msec ) % lg_scriptLength;
+	t = cl->scriptTime;
+	for ( seg = lg_script ; t >= seg->msec ; seg++ ) {
+		t -= seg->msec;
+	}
+
+	cl->yaw += seg->yawSpeed * msec * 0.001f;
+
+	cl->cmdNumber++;
+	cmd = &cl->cmds[ cl->cmdNumber & LG_CMD_MASK ];
+	Com_Memset( cmd, 0, sizeof( *cmd ) );
+	cmd->serverTime = serverTime;
+	cmd->angles[YAW] = ANGLE2SHORT( cl->yaw );
+	cmd->angles[PITCH] = ANGLE2SHORT( seg->pitch );
+	cmd->forwardmove = seg->forwardmove;
+	cmd->rightmove = seg->rightmove;
+	cmd->upmove = seg->upmove;
+	cmd->buttons = seg->buttons;
+	cmd->weapon = cl->snap.ps.weapon;
+}
+
+/*
+=============================================================================
+
+CLIENTS
+
+=============================================================================
+*/
+
+/*
+=================
+LG_OpenClient
+=================
+*/
+static lgClient_t *LG_OpenClient( int num, int realtime ) {
+	lgClient_t			*cl;
+	struct sockaddr_in	addr;
+	int					sock;
+
+	sock = socket( PF_INET, SOCK_DGRAM, IPPROTO_UDP );
+	if ( sock == -1 ) {
+		Com_Error( ERR_FATAL, "socket: %s", strerror( errno ) );
+	}
+	Com_Memset( &addr, 0, sizeof( addr ) );
+	addr.sin_family = AF_INET;
+	if ( bind( sock, (struct sockaddr *)&addr, sizeof( addr ) ) == -1
+		|| fcntl( sock, F_SETFL, O_NONBLOCK ) == -1 ) {
+		Com_Error( ERR_FATAL, "bind: %s", strerror( errno ) );
+	}
+
+	cl = calloc( 1, sizeof( *cl ) );
+	if ( !cl ) {
+		Com_Error( ERR_FATAL, "out of memory for client %i", num );
+	}
+	cl->num = num;
+	cl->socket = sock;
+	cl->qport = ( getpid() * LG_MAX_CLIENTS + num ) & 0xffff;
+	cl->state = LG_CONNECTING;
+	cl->connectTime = -LG_RETRANSMIT;
+	cl->lastPacketTime = realtime;
+	cl->scriptTime = ( num * 397 ) % lg_scriptLength;	// don't move in lockstep
+	cl->yaw = num * 37;
+	return cl;
+}
+
+/*
+=================
+LG_CloseClient
+
+Sends the disconnect a few times, the way CL_Disconnect does
+=================
+*/
+static void LG_CloseClient( lgClient_t *cl, int realtime ) {
+	int		i;
+
+	lg_current = cl;
+	if ( !setjmp( lg_abort ) && cl->state >= LG_CONNECTED && cl->state != LG_DROPPED ) {
+		LG_AddReliableCommand( cl, "disconnect" );
+		for ( i = 0 ; i < 3 ; i++ ) {
+			LG_WritePacket( cl, realtime );
+		}
+	}
+	lg_current = NULL;
+
+	close( cl->socket );
+	free( cl );
+}
+
+/*
+=================
+LG_CheckForResend
+=================
+*/
+static void LG_CheckForResend( lgClient_t *cl, int realtime ) {
+	char	info[MAX_INFO_STRING];
+	char	data[MAX_INFO_STRING+16];
+
+	if ( realtime - cl->connectTime < LG_RETRANSMIT ) {
+		return;
+	}
+	cl->connectTime = realtime;
+
+	if ( cl->state == LG_CONNECTING ) {
+		NET_OutOfBandPrint( NS_CLIENT, lg_server, "getchallenge" );
+		return;
+	}
+
+	info[0] = 0;
+	Info_SetValueForKey( info, "name", va( "loadgen%i", cl->num ) );
+	Info_SetValueForKey( info, "model", "sarge" );
+	Info_SetValueForKey( info, "handicap", "100" );
+	Info_SetValueForKey( info, "rate", "25000" );
+	Info_SetValueForKey( info, "snaps", "20" );
+	Info_SetValueForKey( info, "protocol", va( "%i", PROTOCOL_VERSION ) );
+	Info_SetValueForKey( info, "qport", va( "%i", cl->qport ) );
+	Info_SetValueForKey( info, "challenge", va( "%i", cl->challenge ) );
+
+	Com_sprintf( data, sizeof( data ), "connect \"%s\"", info );
+	NET_OutOfBandData( NS_CLIENT, lg_server, (byte *)data, strlen( data ) );
+}
+
+/*
+=================
+LG_ClientFrame
+=================
+*/
+static void LG_ClientFrame( lgClient_t *cl, int realtime ) {
+	if ( cl->state == LG_DROPPED ) {
+		return;
+	}
+
+	if ( realtime - cl->lastPacketTime > LG_TIMEOUT ) {
+		Com_Error( ERR_DROP, "timed out" );
+	}
+
+	if ( cl->state == LG_CONNECTING || cl->state == LG_CHALLENGING ) {
+		LG_CheckForResend( cl, realtime );
+		return;
+	}
+
+	if ( realtime < cl->nextSend ) {
+		return;
+	}
+
+	// only poke the server once a second until the gamestate arrives
+	if ( cl->state == LG_CONNECTED ) {
+		cl->nextSend = realtime + 1000;
+		LG_WritePacket( cl, realtime );
+		return;
+	}
+
+	cl->nextSend += 1000 / lg_pps;
+	if ( cl->nextSend < realtime ) {
+		cl->nextSend = realtime + 1000 / lg_pps;
+	}
+	LG_CreateCmd( cl, realtime );
+	LG_WritePacket( cl, realtime );
+}
+
+/*
+=================
+LG_Run
+
+Services every client for msec
+=================
+*/
+static void LG_Run( int msec ) {
+	struct pollfd		fds[LG_MAX_CLIENTS];
+	struct sockaddr_in	from;
+	socklen_t			fromlen;
+	byte				data[MAX_MSGLEN];
+	msg_t				msg;
+	lgClient_t			*cl;
+	int					i, ret, realtime, end;
+
+	end = LG_Milliseconds() + msec;
+	while ( ( realtime = LG_Milliseconds() ) < end ) {
+		for ( i = 0 ; i < lg_numClients ; i++ ) {
+			cl = lg_clients[i];
+			lg_current = cl;
+			if ( setjmp( lg_abort ) ) {
+				cl->state = LG_DROPPED;
+				if ( lg_recording ) {
+					lg_stats.drops++;
+				}
+				continue;
+			}
+			LG_ClientFrame( cl, realtime );
+		}
+		lg_current = NULL;
+
+		for ( i = 0 ; i < lg_numClients ; i++ ) {
+			fds[i].fd = lg_clients[i]->socket;
+			fds[i].events = POLLIN;
+			fds[i].revents = 0;
+		}
+		if ( poll( fds, lg_numClients, 1 ) <= 0 ) {
+			continue;
+		}
+
+		realtime = LG_Milliseconds();
+		for ( i = 0 ; i < lg_numClients ; i++ ) {
+			if ( !( fds[i].revents & POLLIN ) ) {
+				continue;
+			}
+			cl = lg_clients[i];
+			lg_current = cl;
+
+			while ( 1 ) {
+				fromlen = sizeof( from );
+				ret = recvfrom( cl->socket, data, sizeof( data ), 0, (struct sockaddr *)&from, &fromlen );
+				if ( ret <= 0 ) {
+					break;
+				}
+				if ( from.sin_port != lg_server.port || memcmp( &from.sin_addr.s_addr, lg_server.ip, 4 ) ) {
+					continue;
+				}
+				if ( lg_recording ) {
+					lg_stats.bytesIn += ret;
+					lg_stats.packetsIn++;
+				}
+				if ( cl->state == LG_DROPPED ) {
+					continue;
+				}
+
+				MSG_Init( &msg, data, sizeof( data ) );
+				msg.cursize = ret;
+				if ( setjmp( lg_abort ) ) {
+					cl->state = LG_DROPPED;
+					if ( lg_recording ) {
+						lg_stats.drops++;
+					}
+					continue;
+				}
+				LG_PacketEvent( cl, &msg, realtime );
+			}
+		}
+		lg_current = NULL;
+	}
+}
+
+/*
+=============================================================================
+
+MEASUREMENT
+
+=============================================================================
+*/
+
+/*
+=================
+LG_ServerCpu
+
+Msec of cpu the server process has used, -1 without -pid
+=================
+*/
+static int LG_ServerCpu( void ) {
+	FILE	*f;
+	char	buf[1024];
+	char	*s;
+	long	utime, stime;
+	int		n;
+
+	if ( !lg_pid ) {
+		return -1;
+	}
+	f = fopen( va( "/proc/%i/stat", lg_pid ), "r" );
+	if ( !f ) {
+		return -1;
+	}
+	n = fread( buf, 1, sizeof( buf ) - 1, f );
+	fclose( f );
+	buf[n > 0 ? n : 0] = 0;
+
+	// the command name can contain spaces, so count fields from the ')'
+	s = strrchr( buf, ')' );
+	if ( !s || sscanf( s + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %ld %ld", &utime, &stime ) != 2 ) {
+		return -1;
+	}
+	return ( utime + stime ) * 1000 / sysconf( _SC_CLK_TCK );
+}
+
+static int LG_CompareInts( const void *a, const void *b ) {
+	return *(const int *)a - *(const int *)b;
+}
+
+/*
+=================
+LG_Percentile
+=================
+*/
+static int LG_Percentile( float fraction ) {
+	int		i;
+
+	if ( !lg_stats.numSamples ) {
+		return 0;
+	}
+	i = fraction * lg_stats.numSamples;
+	if ( i >= lg_stats.numSamples ) {
+		i = lg_stats.numSamples - 1;
+	}
+	return lg_stats.samples[i];
+}
+
+/*
+=================
+LG_RunStep
+
+Brings the client count up or down to numClients, lets the server
+settle, then measures for lg_duration
+=================
+*/
+static void LG_RunStep( int numClients ) {
+	lgClient_t	*cl;
+	int			i, active, cpuStart, cpuEnd, realStart, realEnd;
+	int			svTime, svReal;
+	float		seconds, frameMsec, svRate;
+	int			*samples;
+
+	realStart = LG_Milliseconds();
+	while ( lg_numClients > numClients ) {
+		lg_numClients--;
+		LG_CloseClient( lg_clients[lg_numClients], realStart );
+		lg_clients[lg_numClients] = NULL;
+	}
+	while ( lg_numClients < numClients ) {
+		lg_clients[lg_numClients] = LG_OpenClient( lg_numClients, realStart );
+		lg_numClients++;
+	}
+
+	lg_recording = qfalse;
+	LG_Run( lg_warmup );
+
+	samples = lg_stats.samples;
+	Com_Memset( &lg_stats, 0, sizeof( lg_stats ) );
+	lg_stats.samples = samples;
+	for ( i = 0 ; i < lg_numClients ; i++ ) {
+		cl = lg_clients[i];
+		cl->firstSnapTime = cl->firstSnapReal = 0;
+		cl->lastSnapTime = cl->lastSnapReal = 0;
+	}
+
+	cpuStart = LG_ServerCpu();
+	realStart = LG_Milliseconds();
+	lg_recording = qtrue;
+	LG_Run( lg_duration );
+	lg_recording = qfalse;
+	realEnd = LG_Milliseconds();
+	cpuEnd = LG_ServerCpu();
+
+	seconds = ( realEnd - realStart ) * 0.001f;
+
+	// a server that can't keep up advances its clock slower than ours
+	active = 0;
+	svTime = svReal = 0;
+	for ( i = 0 ; i < lg_numClients ; i++ ) {
+		cl = lg_clients[i];
+		if ( cl->state == LG_ACTIVE ) {
+			active++;
+		}
+		if ( cl->lastSnapReal > cl->firstSnapReal ) {
+			svTime += cl->lastSnapTime - cl->firstSnapTime;
+			svReal += cl->lastSnapReal - cl->firstSnapReal;
+		}
+	}
+	svRate = svReal ? (float)svTime / svReal : 0;
+
+	qsort( lg_stats.samples, lg_stats.numSamples, sizeof( int ), LG_CompareInts );
+
+	printf( "%4i %4i ", numClients, active );
+	if ( cpuStart >= 0 && cpuEnd >= 0 ) {
+		frameMsec = ( cpuEnd - cpuStart ) / ( seconds * lg_fps );
+		printf( "%7.2f %5.1f%% ", frameMsec, ( cpuEnd - cpuStart ) * 0.1f / seconds );
+	} else {
+		printf( "%7s %6s ", "-", "-" );
+	}
+	printf( "%5.2f %8.1f %8.1f %7.1f %5i %5i %5i %5i %5i\n",
+		svRate,
+		lg_stats.bytesIn / ( seconds * 1024 ), lg_stats.bytesOut / ( seconds * 1024 ),
+		active ? lg_stats.snapshots / ( seconds * active ) : 0,
+		LG_Percentile( 0.5f ), LG_Percentile( 0.9f ), LG_Percentile( 0.99f ),
+		lg_stats.numSamples ? lg_stats.samples[lg_stats.numSamples-1] : 0,
+		lg_stats.drops );
+	fflush( stdout );
+}
+
+/*
+=================
+LG_Usage
+=================
+*/
+static void LG_Usage( void ) {
+	printf( "usage: loadgen [options]\n"
+		"  -server <host[:port]>  server to load (default 127.0.0.1:%i)\n"
+		"  -clients <n,n,...>     client counts to step through (default 1,8,16,32,64)\n"
+		"  -warmup <msec>         settle time before each step is measured (default %i)\n"
+		"  -duration <msec>       measured time per step (default %i)\n"
+		"  -pps <n>               usercmd packets per second per client (default %i)\n"
+		"  -fps <n>               the server's sv_fps, for msec per frame (default %i)\n"
+		"  -pid <pid>             server process, its cpu time is sampled from /proc\n"
+		"  -script <file>         usercmd script, lines of\n"
+		"                         msec forward right up yawspeed pitch buttons\n"
+		"  -verbose               print netchan and developer messages\n",
+		PORT_SERVER, lg_warmup, lg_duration, lg_pps, lg_fps );
+	exit( 1 );
+}
+
+/*
+=================
+main
+=================
+*/
+int main( int argc, char **argv ) {
+	struct timeval	tp;
+	char			host[256];
+	char			*clients, *script, *s;
+	int				steps[LG_MAX_STEPS];
+	int				numSteps, port, i;
+
+	Q_strncpyz( host, va( "127.0.0.1:%i", PORT_SERVER ), sizeof( host ) );
+	clients = "1,8,16,32,64";
+	script = NULL;
+
+	for ( i = 1 ; i < argc ; i++ ) {
+		if ( !strcmp( argv[i], "-verbose" ) ) {
+			lg_verbose = 1;
+			continue;
+		}
+		if ( i + 1 >= argc ) {
+			LG_Usage();
+		}
+		if ( !strcmp( argv[i], "-server" ) ) {
+			Q_strncpyz( host, argv[++i], sizeof( host ) );
+		} else if ( !strcmp( argv[i], "-clients" ) ) {
+			clients = argv[++i];
+		} else if ( !strcmp( argv[i], "-warmup" ) ) {
+			lg_warmup = atoi( argv[++i] );
+		} else if ( !strcmp( argv[i], "-duration" ) ) {
+			lg_duration = atoi( argv[++i] );
+		} else if ( !strcmp( argv[i], "-pps" ) ) {
+			lg_pps = atoi( argv[++i] );
+		} else if ( !strcmp( argv[i], "-fps" ) ) {
+			lg_fps = atoi( argv[++i] );
+		} else if ( !strcmp( argv[i], "-pid" ) ) {
+			lg_pid = atoi( argv[++i] );
+		} else if ( !strcmp( argv[i], "-script" ) ) {
+			script = argv[++i];
+		} else {
+			LG_Usage();
+		}
+	}
+	if ( lg_pps < 1 || lg_pps > 1000 || lg_fps < 1 || lg_duration < 1000 ) {
+		LG_Usage();
+	}
+
+	numSteps = 0;
+	for ( s = clients ; *s && numSteps < LG_MAX_STEPS ; ) {
+		steps[numSteps] = atoi( s );
+		if ( steps[numSteps] < 1 || steps[numSteps] > LG_MAX_CLIENTS ) {
+			Com_Error( ERR_FATAL, "client counts must be 1 to %i", LG_MAX_CLIENTS );
+		}
+		numSteps++;
+		while ( *s && *s != ',' ) {
+			s++;
+		}
+		if ( *s == ',' ) {
+			s++;
+		}
+	}
+	if ( !numSteps ) {
+		LG_Usage();
+	}
+
+	port = PORT_SERVER;
+	s = strchr( host, ':' );
+	if ( s ) {
+		*s = 0;
+		port = atoi( s + 1 );
+	}
+	if ( !Sys_StringToAdr( host, &lg_server ) ) {
+		Com_Error( ERR_FATAL, "couldn't resolve %s", host );
+	}
+	lg_server.port = BigShort( (short)port );
+
+	gettimeofday( &tp, NULL );
+	lg_startTime = tp.tv_sec * 1000 + tp.tv_usec / 1000;
+
+	cl_shownet = Cvar_Get( "cl_shownet", "0", CVAR_TEMP );
+	Netchan_Init( 0 );
+	LG_LoadScript( script );
+
+	lg_stats.samples = malloc( LG_MAX_SAMPLES * sizeof( int ) );
+	if ( !lg_stats.samples ) {
+		Com_Error( ERR_FATAL, "out of memory for samples" );
+	}
+
+	printf( "loading %s:%i, %i usercmd packets/sec per client, %i msec per step\n",
+		host, port, lg_pps, lg_duration );
+	printf( "clnt actv  ms/frm   cpu%% svrate  in KB/s out KB/s  snaps/s   p50   p90   p99   max drops\n" );
+
+	for ( i = 0 ; i < numSteps ; i++ ) {
+		LG_RunStep( steps[i] );
+	}
+
+	while ( lg_numClients ) {
+		lg_numClients--;
+		LG_CloseClient( lg_clients[lg_numClients], LG_Milliseconds() );
+	}
+
+	return 0;
+}
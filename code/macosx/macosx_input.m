@@ -790,7 +790,7 @@ Sys_QueEvent
 
 A time of 0 will get the current time
 Ptr should either be null, or point to a block of data that can
-be freed by the game later.
+be released with Com_EventFree later.
 ================
 */
 void Sys_QueEvent( int time, sysEventType_t type, int value, int value2, int ptrLength, void *ptr ) {
@@ -868,7 +868,7 @@ sysEvent_t Sys_GetEvent( void )
         int		len;
     
         len = strlen( s ) + 1;
-        b = Z_Malloc( len );
+        b = Com_EventAlloc( len );
         strcpy( b, s );
         Sys_QueEvent( currentTime, SE_CONSOLE, 0, 0, len, b );
     }
@@ -893,7 +893,7 @@ sysEvent_t Sys_GetEvent( void )
     
         // copy out to a seperate buffer for qeueing
         len = sizeof( netadr_t ) + netmsg.cursize;
-        buf = Z_Malloc( len );
+        buf = Com_EventAlloc( len );
         *buf = adr;
         memcpy( buf+1, netmsg.data, netmsg.cursize );
         Sys_QueEvent( currentTime, SE_PACKET, 0, 0, len, buf );
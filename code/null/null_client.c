@@ -34,6 +34,9 @@ void CL_Init( void ) {
 void CL_MouseEvent( int dx, int dy, int time ) {
 }
 
+void CL_HMDEvent( int ax, int ay, int az, int aw, int time ) {
+}
+
 void Key_WriteBindings( fileHandle_t f ) {
 }
 
@@ -19,38 +19,1030 @@ along with Foobar; if not, write to the Free Software
 Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 ===========================================================================
 */
+/*
+** NULL_GLIMP.C
+**
+** A recording GL driver for machines without a display.  Every qgl
+** function the renderer uses is pointed at a stub that counts the call,
+** the draw calls, state changes, vertices and bytes it stands for, and
+** draws nothing.  The totals land in glCounters for the timedemo report,
+** "gltrace" lists the calls by function and r_logFile writes each call
+** to gltrace.log.
+*/
 #include "../renderer/tr_local.h"
 
+qboolean QGL_Init( const char *dllname );
+void QGL_Shutdown( void );
 
 qboolean ( * qwglSwapIntervalEXT)( int interval );
-void ( * qglMultiTexCoord2fARB )( GLenum texture, float s, float t );
-void ( * qglActiveTextureARB )( GLenum texture );
-void ( * qglClientActiveTextureARB )( GLenum texture );
+void ( APIENTRY * qglMultiTexCoord2fARB )( GLenum texture, GLfloat s, GLfloat t );
+void ( APIENTRY * qglActiveTextureARB )( GLenum texture );
+void ( APIENTRY * qglClientActiveTextureARB )( GLenum texture );
+
+
+void ( APIENTRY * qglLockArraysEXT)( GLint, GLint );
+void ( APIENTRY * qglUnlockArraysEXT) ( void );
+
+void ( APIENTRY * qglAlphaFunc )(GLenum func, GLclampf ref);
+void ( APIENTRY * qglArrayElement )(GLint i);
+void ( APIENTRY * qglBegin )(GLenum mode);
+void ( APIENTRY * qglBindTexture )(GLenum target, GLuint texture);
+void ( APIENTRY * qglBlendFunc )(GLenum sfactor, GLenum dfactor);
+void ( APIENTRY * qglCallList )(GLuint list);
+void ( APIENTRY * qglClear )(GLbitfield mask);
+void ( APIENTRY * qglClearColor )(GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha);
+void ( APIENTRY * qglClearDepth )(GLclampd depth);
+void ( APIENTRY * qglClearStencil )(GLint s);
+void ( APIENTRY * qglClipPlane )(GLenum plane, const GLdouble *equation);
+void ( APIENTRY * qglColor3f )(GLfloat red, GLfloat green, GLfloat blue);
+void ( APIENTRY * qglColor4f )(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha);
+void ( APIENTRY * qglColor4ubv )(const GLubyte *v);
+void ( APIENTRY * qglColorMask )(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha);
+void ( APIENTRY * qglColorPointer )(GLint size, GLenum type, GLsizei stride, const GLvoid *pointer);
+void ( APIENTRY * qglCullFace )(GLenum mode);
+void ( APIENTRY * qglDeleteTextures )(GLsizei n, const GLuint *textures);
+void ( APIENTRY * qglDepthFunc )(GLenum func);
+void ( APIENTRY * qglDepthMask )(GLboolean flag);
+void ( APIENTRY * qglDepthRange )(GLclampd zNear, GLclampd zFar);
+void ( APIENTRY * qglDisable )(GLenum cap);
+void ( APIENTRY * qglDisableClientState )(GLenum array);
+void ( APIENTRY * qglDrawBuffer )(GLenum mode);
+void ( APIENTRY * qglDrawElements )(GLenum mode, GLsizei count, GLenum type, const GLvoid *indices);
+void ( APIENTRY * qglEnable )(GLenum cap);
+void ( APIENTRY * qglEnableClientState )(GLenum array);
+void ( APIENTRY * qglEnd )(void);
+void ( APIENTRY * qglFinish )(void);
+GLenum ( APIENTRY * qglGetError )(void);
+void ( APIENTRY * qglGetIntegerv )(GLenum pname, GLint *params);
+void ( APIENTRY * qglLineWidth )(GLfloat width);
+void ( APIENTRY * qglLoadIdentity )(void);
+void ( APIENTRY * qglLoadMatrixf )(const GLfloat *m);
+void ( APIENTRY * qglMatrixMode )(GLenum mode);
+void ( APIENTRY * qglOrtho )(GLdouble left, GLdouble right, GLdouble bottom, GLdouble top, GLdouble zNear, GLdouble zFar);
+void ( APIENTRY * qglPolygonMode )(GLenum face, GLenum mode);
+void ( APIENTRY * qglPolygonOffset )(GLfloat factor, GLfloat units);
+void ( APIENTRY * qglPopMatrix )(void);
+void ( APIENTRY * qglPushMatrix )(void);
+void ( APIENTRY * qglReadPixels )(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, GLvoid *pixels);
+void ( APIENTRY * qglScissor )(GLint x, GLint y, GLsizei width, GLsizei height);
+void ( APIENTRY * qglShadeModel )(GLenum mode);
+void ( APIENTRY * qglStencilFunc )(GLenum func, GLint ref, GLuint mask);
+void ( APIENTRY * qglStencilMask )(GLuint mask);
+void ( APIENTRY * qglStencilOp )(GLenum fail, GLenum zfail, GLenum zpass);
+void ( APIENTRY * qglTexCoord2f )(GLfloat s, GLfloat t);
+void ( APIENTRY * qglTexCoord2fv )(const GLfloat *v);
+void ( APIENTRY * qglTexCoordPointer )(GLint size, GLenum type, GLsizei stride, const GLvoid *pointer);
+void ( APIENTRY * qglTexEnvf )(GLenum target, GLenum pname, GLfloat param);
+void ( APIENTRY * qglTexImage2D )(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const GLvoid *pixels);
+void ( APIENTRY * qglTexParameterf )(GLenum target, GLenum pname, GLfloat param);
+void ( APIENTRY * qglTexParameterfv )(GLenum target, GLenum pname, const GLfloat *params);
+void ( APIENTRY * qglTexSubImage2D )(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const GLvoid *pixels);
+void ( APIENTRY * qglTranslatef )(GLfloat x, GLfloat y, GLfloat z);
+void ( APIENTRY * qglVertex2f )(GLfloat x, GLfloat y);
+void ( APIENTRY * qglVertex3f )(GLfloat x, GLfloat y, GLfloat z);
+void ( APIENTRY * qglVertex3fv )(const GLfloat *v);
+void ( APIENTRY * qglVertexPointer )(GLint size, GLenum type, GLsizei stride, const GLvoid *pointer);
+void ( APIENTRY * qglViewport )(GLint x, GLint y, GLsizei width, GLsizei height);
+
+
+typedef enum {
+	TF_ACTIVETEXTURE,
+	TF_ALPHAFUNC,
+	TF_ARRAYELEMENT,
+	TF_BEGIN,
+	TF_BEGINQUERY,
+	TF_BINDBUFFER,
+	TF_BINDTEXTURE,
+	TF_BLENDFUNC,
+	TF_BUFFERDATA,
+	TF_CALLLIST,
+	TF_CLEAR,
+	TF_CLEARCOLOR,
+	TF_CLEARDEPTH,
+	TF_CLEARSTENCIL,
+	TF_CLIENTACTIVETEXTURE,
+	TF_CLIPPLANE,
+	TF_COLOR3F,
+	TF_COLOR4F,
+	TF_COLOR4UBV,
+	TF_COLORMASK,
+	TF_COLORPOINTER,
+	TF_CULLFACE,
+	TF_DELETEBUFFERS,
+	TF_DELETEQUERIES,
+	TF_DELETETEXTURES,
+	TF_DEPTHFUNC,
+	TF_DEPTHMASK,
+	TF_DEPTHRANGE,
+	TF_DISABLE,
+	TF_DISABLECLIENTSTATE,
+	TF_DRAWBUFFER,
+	TF_DRAWELEMENTS,
+	TF_ENABLE,
+	TF_ENABLECLIENTSTATE,
+	TF_END,
+	TF_ENDQUERY,
+	TF_FINISH,
+	TF_GENBUFFERS,
+	TF_GENQUERIES,
+	TF_GETERROR,
+	TF_GETINTEGERV,
+	TF_GETQUERYOBJECTIV,
+	TF_LINEWIDTH,
+	TF_LOADIDENTITY,
+	TF_LOADMATRIXF,
+	TF_LOCKARRAYS,
+	TF_MATRIXMODE,
+	TF_MULTIDRAWELEMENTS,
+	TF_MULTITEXCOORD2F,
+	TF_ORTHO,
+	TF_POLYGONMODE,
+	TF_POLYGONOFFSET,
+	TF_POPMATRIX,
+	TF_PUSHMATRIX,
+	TF_READPIXELS,
+	TF_SCISSOR,
+	TF_SHADEMODEL,
+	TF_STENCILFUNC,
+	TF_STENCILMASK,
+	TF_STENCILOP,
+	TF_TEXCOORD2F,
+	TF_TEXCOORD2FV,
+	TF_TEXCOORDPOINTER,
+	TF_TEXENVF,
+	TF_TEXIMAGE2D,
+	TF_TEXPARAMETERF,
+	TF_TEXPARAMETERFV,
+	TF_TEXSUBIMAGE2D,
+	TF_TRANSLATEF,
+	TF_UNLOCKARRAYS,
+	TF_VERTEX2F,
+	TF_VERTEX3F,
+	TF_VERTEX3FV,
+	TF_VERTEXPOINTER,
+	TF_VIEWPORT,
+
+	TF_NUM_FUNCS
+} traceFunc_t;
+
+static const char *traceNames[TF_NUM_FUNCS] = {
+	"glActiveTextureARB",
+	"glAlphaFunc",
+	"glArrayElement",
+	"glBegin",
+	"glBeginQueryARB",
+	"glBindBufferARB",
+	"glBindTexture",
+	"glBlendFunc",
+	"glBufferDataARB",
+	"glCallList",
+	"glClear",
+	"glClearColor",
+	"glClearDepth",
+	"glClearStencil",
+	"glClientActiveTextureARB",
+	"glClipPlane",
+	"glColor3f",
+	"glColor4f",
+	"glColor4ubv",
+	"glColorMask",
+	"glColorPointer",
+	"glCullFace",
+	"glDeleteBuffersARB",
+	"glDeleteQueriesARB",
+	"glDeleteTextures",
+	"glDepthFunc",
+	"glDepthMask",
+	"glDepthRange",
+	"glDisable",
+	"glDisableClientState",
+	"glDrawBuffer",
+	"glDrawElements",
+	"glEnable",
+	"glEnableClientState",
+	"glEnd",
+	"glEndQueryARB",
+	"glFinish",
+	"glGenBuffersARB",
+	"glGenQueriesARB",
+	"glGetError",
+	"glGetIntegerv",
+	"glGetQueryObjectivARB",
+	"glLineWidth",
+	"glLoadIdentity",
+	"glLoadMatrixf",
+	"glLockArraysEXT",
+	"glMatrixMode",
+	"glMultiDrawElementsEXT",
+	"glMultiTexCoord2fARB",
+	"glOrtho",
+	"glPolygonMode",
+	"glPolygonOffset",
+	"glPopMatrix",
+	"glPushMatrix",
+	"glReadPixels",
+	"glScissor",
+	"glShadeModel",
+	"glStencilFunc",
+	"glStencilMask",
+	"glStencilOp",
+	"glTexCoord2f",
+	"glTexCoord2fv",
+	"glTexCoordPointer",
+	"glTexEnvf",
+	"glTexImage2D",
+	"glTexParameterf",
+	"glTexParameterfv",
+	"glTexSubImage2D",
+	"glTranslatef",
+	"glUnlockArraysEXT",
+	"glVertex2f",
+	"glVertex3f",
+	"glVertex3fv",
+	"glVertexPointer",
+	"glViewport"
+};
+
+// client arrays, so drawing from them can be charged the bytes it pulls
+#define	TRACE_VERTEX_ARRAY		0
+#define	TRACE_COLOR_ARRAY		1
+#define	TRACE_TEXCOORD_ARRAY	2		// one per texture unit
+#define	TRACE_NUM_ARRAYS		4
+
+typedef struct {
+	int			calls[TF_NUM_FUNCS];
+
+	int			arrayBytes[TRACE_NUM_ARRAYS];	// per vertex
+	qboolean	arrayEnabled[TRACE_NUM_ARRAYS];
+	int			clientUnit;
+	qboolean	locked;
+
+	GLuint		numBuffers;
+	GLuint		arrayBuffer;	// vertexes and indexes are already on the card
+	GLuint		elementBuffer;
+
+	GLuint		numQueries;
+
+	FILE		*log_fp;
+	glCounters_t	logged;		// totals at the last logged frame
+} glTrace_t;
+
+static glTrace_t	trace;
+
+
+static void TraceCall( traceFunc_t func ) {
+	trace.calls[func]++;
+	if ( trace.log_fp ) {
+		fprintf( trace.log_fp, "%s\n", traceNames[func] );
+	}
+}
+
+static void TraceState( traceFunc_t func ) {
+	TraceCall( func );
+	glCounters.stateChanges++;
+}
+
+static int TraceTypeSize( GLenum type ) {
+	switch ( type ) {
+	case GL_BYTE:
+	case GL_UNSIGNED_BYTE:
+		return 1;
+	case GL_SHORT:
+	case GL_UNSIGNED_SHORT:
+		return 2;
+	case GL_DOUBLE:
+		return 8;
+	default:
+		return 4;
+	}
+}
+
+static int TracePixelSize( GLenum format ) {
+	switch ( format ) {
+	case GL_RGBA:
+		return 4;
+	case GL_RGB:
+		return 3;
+	case GL_LUMINANCE_ALPHA:
+		return 2;
+	default:
+		return 1;
+	}
+}
+
+static int TraceArrayIndex( GLenum array ) {
+	switch ( array ) {
+	case GL_VERTEX_ARRAY:
+		return TRACE_VERTEX_ARRAY;
+	case GL_COLOR_ARRAY:
+		return TRACE_COLOR_ARRAY;
+	case GL_TEXTURE_COORD_ARRAY:
+		if ( trace.clientUnit < TRACE_NUM_ARRAYS - TRACE_TEXCOORD_ARRAY ) {
+			return TRACE_TEXCOORD_ARRAY + trace.clientUnit;
+		}
+	default:
+		return -1;
+	}
+}
+
+// bytes one vertex pulls from the enabled arrays
+static int TraceArrayStride( void ) {
+	int		i, bytes;
+
+	bytes = 0;
+	for ( i = 0 ; i < TRACE_NUM_ARRAYS ; i++ ) {
+		if ( trace.arrayEnabled[i] ) {
+			bytes += trace.arrayBytes[i];
+		}
+	}
+	return bytes;
+}
+
+static void TraceArrayPointer( traceFunc_t func, int array, GLint size, GLenum type ) {
+	TraceState( func );
+	if ( array >= 0 ) {
+		trace.arrayBytes[array] = size * TraceTypeSize( type );
+	}
+}
+
+/*
+** the recording functions
+*/
+static void APIENTRY traceActiveTextureARB( GLenum texture ) {
+	TraceState( TF_ACTIVETEXTURE );
+}
+
+static void APIENTRY traceAlphaFunc( GLenum func, GLclampf ref ) {
+	TraceState( TF_ALPHAFUNC );
+}
+
+static void APIENTRY traceArrayElement( GLint i ) {
+	TraceCall( TF_ARRAYELEMENT );
+	glCounters.vertices++;
+	if ( !trace.locked ) {
+		glCounters.bytes += TraceArrayStride();
+	}
+}
+
+static void APIENTRY traceBegin( GLenum mode ) {
+	TraceCall( TF_BEGIN );
+	glCounters.drawCalls++;
+}
+
+static void APIENTRY traceBeginQueryARB( GLenum target, GLuint id ) {
+	TraceState( TF_BEGINQUERY );
+}
+
+static void APIENTRY traceBindBufferARB( GLenum target, GLuint buffer ) {
+	TraceState( TF_BINDBUFFER );
+	if ( target == GL_ARRAY_BUFFER_ARB ) {
+		trace.arrayBuffer = buffer;
+	} else {
+		trace.elementBuffer = buffer;
+	}
+}
+
+static void APIENTRY traceBindTexture( GLenum target, GLuint texture ) {
+	TraceState( TF_BINDTEXTURE );
+}
+
+static void APIENTRY traceBlendFunc( GLenum sfactor, GLenum dfactor ) {
+	TraceState( TF_BLENDFUNC );
+}
+
+static void APIENTRY traceBufferDataARB( GLenum target, ptrdiff_t size, const GLvoid *data, GLenum usage ) {
+	TraceCall( TF_BUFFERDATA );
+	glCounters.bytes += size;
+}
+
+static void APIENTRY traceCallList( GLuint list ) {
+	TraceCall( TF_CALLLIST );
+	glCounters.drawCalls++;
+}
+
+static void APIENTRY traceClear( GLbitfield mask ) {
+	TraceCall( TF_CLEAR );
+}
+
+static void APIENTRY traceClearColor( GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha ) {
+	TraceState( TF_CLEARCOLOR );
+}
 
+static void APIENTRY traceClearDepth( GLclampd depth ) {
+	TraceState( TF_CLEARDEPTH );
+}
+
+static void APIENTRY traceClearStencil( GLint s ) {
+	TraceState( TF_CLEARSTENCIL );
+}
+
+static void APIENTRY traceClientActiveTextureARB( GLenum texture ) {
+	TraceState( TF_CLIENTACTIVETEXTURE );
+	trace.clientUnit = texture - GL_TEXTURE0_ARB;
+}
+
+static void APIENTRY traceClipPlane( GLenum plane, const GLdouble *equation ) {
+	TraceState( TF_CLIPPLANE );
+}
+
+static void APIENTRY traceColor3f( GLfloat red, GLfloat green, GLfloat blue ) {
+	TraceCall( TF_COLOR3F );
+	glCounters.bytes += 3 * sizeof( GLfloat );
+}
+
+static void APIENTRY traceColor4f( GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha ) {
+	TraceCall( TF_COLOR4F );
+	glCounters.bytes += 4 * sizeof( GLfloat );
+}
+
+static void APIENTRY traceColor4ubv( const GLubyte *v ) {
+	TraceCall( TF_COLOR4UBV );
+	glCounters.bytes += 4;
+}
+
+static void APIENTRY traceColorMask( GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha ) {
+	TraceState( TF_COLORMASK );
+}
+
+static void APIENTRY traceColorPointer( GLint size, GLenum type, GLsizei stride, const GLvoid *pointer ) {
+	TraceArrayPointer( TF_COLORPOINTER, TRACE_COLOR_ARRAY, size, type );
+}
+
+static void APIENTRY traceCullFace( GLenum mode ) {
+	TraceState( TF_CULLFACE );
+}
+
+static void APIENTRY traceDeleteBuffersARB( GLsizei n, const GLuint *buffers ) {
+	TraceCall( TF_DELETEBUFFERS );
+}
+
+static void APIENTRY traceDeleteQueriesARB( GLsizei n, const GLuint *ids ) {
+	TraceCall( TF_DELETEQUERIES );
+}
+
+static void APIENTRY traceDeleteTextures( GLsizei n, const GLuint *textures ) {
+	TraceCall( TF_DELETETEXTURES );
+}
+
+static void APIENTRY traceDepthFunc( GLenum func ) {
+	TraceState( TF_DEPTHFUNC );
+}
+
+static void APIENTRY traceDepthMask( GLboolean flag ) {
+	TraceState( TF_DEPTHMASK );
+}
 
-void ( * qglLockArraysEXT)( int, int);
-void ( * qglUnlockArraysEXT) ( void );
+static void APIENTRY traceDepthRange( GLclampd zNear, GLclampd zFar ) {
+	TraceState( TF_DEPTHRANGE );
+}
+
+static void APIENTRY traceDisable( GLenum cap ) {
+	TraceState( TF_DISABLE );
+}
+
+static void APIENTRY traceDisableClientState( GLenum array ) {
+	int		i;
 
+	TraceState( TF_DISABLECLIENTSTATE );
+	i = TraceArrayIndex( array );
+	if ( i >= 0 ) {
+		trace.arrayEnabled[i] = qfalse;
+	}
+}
+
+static void APIENTRY traceDrawBuffer( GLenum mode ) {
+	TraceState( TF_DRAWBUFFER );
+}
 
+static void TraceElements( GLsizei count, GLenum type ) {
+	glCounters.drawCalls++;
+	glCounters.vertices += count;
+	if ( !trace.elementBuffer ) {
+		glCounters.bytes += count * TraceTypeSize( type );
+	}
+	if ( !trace.locked && !trace.arrayBuffer ) {
+		glCounters.bytes += (double)count * TraceArrayStride();
+	}
+}
+
+static void APIENTRY traceDrawElements( GLenum mode, GLsizei count, GLenum type, const GLvoid *indices ) {
+	TraceCall( TF_DRAWELEMENTS );
+	TraceElements( count, type );
+}
+
+static void APIENTRY traceEnable( GLenum cap ) {
+	TraceState( TF_ENABLE );
+}
+
+static void APIENTRY traceEnableClientState( GLenum array ) {
+	int		i;
+
+	TraceState( TF_ENABLECLIENTSTATE );
+	i = TraceArrayIndex( array );
+	if ( i >= 0 ) {
+		trace.arrayEnabled[i] = qtrue;
+	}
+}
+
+static void APIENTRY traceEnd( void ) {
+	TraceCall( TF_END );
+}
+
+static void APIENTRY traceEndQueryARB( GLenum target ) {
+	TraceState( TF_ENDQUERY );
+}
+
+static void APIENTRY traceFinish( void ) {
+	TraceCall( TF_FINISH );
+}
+
+static void APIENTRY traceGenBuffersARB( GLsizei n, GLuint *buffers ) {
+	int		i;
+
+	TraceCall( TF_GENBUFFERS );
+	for ( i = 0 ; i < n ; i++ ) {
+		buffers[i] = ++trace.numBuffers;
+	}
+}
+
+static void APIENTRY traceGenQueriesARB( GLsizei n, GLuint *ids ) {
+	int		i;
+
+	TraceCall( TF_GENQUERIES );
+	for ( i = 0 ; i < n ; i++ ) {
+		ids[i] = ++trace.numQueries;
+	}
+}
+
+static GLenum APIENTRY traceGetError( void ) {
+	TraceCall( TF_GETERROR );
+	return GL_NO_ERROR;
+}
+
+static void APIENTRY traceGetIntegerv( GLenum pname, GLint *params ) {
+	TraceCall( TF_GETINTEGERV );
+	switch ( pname ) {
+	case GL_MAX_TEXTURE_SIZE:
+		*params = 2048;
+		break;
+	case GL_MAX_ACTIVE_TEXTURES_ARB:
+		*params = 2;
+		break;
+	default:
+		*params = 0;
+		break;
+	}
+}
+
+static void APIENTRY traceGetQueryObjectivARB( GLuint id, GLenum pname, GLint *params ) {
+	TraceCall( TF_GETQUERYOBJECTIV );
+	// results are always back, and nothing was drawn to hide anything
+	*params = 1;
+}
+
+static void APIENTRY traceLineWidth( GLfloat width ) {
+	TraceState( TF_LINEWIDTH );
+}
+
+static void APIENTRY traceLoadIdentity( void ) {
+	TraceState( TF_LOADIDENTITY );
+}
+
+static void APIENTRY traceLoadMatrixf( const GLfloat *m ) {
+	TraceState( TF_LOADMATRIXF );
+}
+
+static void APIENTRY traceLockArraysEXT( GLint first, GLint count ) {
+	TraceCall( TF_LOCKARRAYS );
+	// a locked range is pulled once, however often it is indexed
+	glCounters.bytes += (double)count * TraceArrayStride();
+	trace.locked = qtrue;
+}
+
+static void APIENTRY traceMatrixMode( GLenum mode ) {
+	TraceState( TF_MATRIXMODE );
+}
+
+static void APIENTRY traceMultiDrawElementsEXT( GLenum mode, const GLsizei *count, GLenum type, const GLvoid **indices, GLsizei primcount ) {
+	int		i;
+
+	TraceCall( TF_MULTIDRAWELEMENTS );
+	for ( i = 0 ; i < primcount ; i++ ) {
+		TraceElements( count[i], type );
+	}
+	// one call, however many ranges
+	glCounters.drawCalls -= primcount - 1;
+}
+
+static void APIENTRY traceMultiTexCoord2fARB( GLenum texture, GLfloat s, GLfloat t ) {
+	TraceCall( TF_MULTITEXCOORD2F );
+	glCounters.bytes += 2 * sizeof( GLfloat );
+}
+
+static void APIENTRY traceOrtho( GLdouble left, GLdouble right, GLdouble bottom, GLdouble top, GLdouble zNear, GLdouble zFar ) {
+	TraceState( TF_ORTHO );
+}
+
+static void APIENTRY tracePolygonMode( GLenum face, GLenum mode ) {
+	TraceState( TF_POLYGONMODE );
+}
+
+static void APIENTRY tracePolygonOffset( GLfloat factor, GLfloat units ) {
+	TraceState( TF_POLYGONOFFSET );
+}
+
+static void APIENTRY tracePopMatrix( void ) {
+	TraceState( TF_POPMATRIX );
+}
+
+static void APIENTRY tracePushMatrix( void ) {
+	TraceState( TF_PUSHMATRIX );
+}
+
+static void APIENTRY traceReadPixels( GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, GLvoid *pixels ) {
+	int		size;
+
+	TraceCall( TF_READPIXELS );
+	// nothing was drawn, hand back black
+	size = width * height * TracePixelSize( format ) * TraceTypeSize( type );
+	Com_Memset( pixels, 0, size );
+	glCounters.bytes += size;
+}
+
+static void APIENTRY traceScissor( GLint x, GLint y, GLsizei width, GLsizei height ) {
+	TraceState( TF_SCISSOR );
+}
+
+static void APIENTRY traceShadeModel( GLenum mode ) {
+	TraceState( TF_SHADEMODEL );
+}
+
+static void APIENTRY traceStencilFunc( GLenum func, GLint ref, GLuint mask ) {
+	TraceState( TF_STENCILFUNC );
+}
+
+static void APIENTRY traceStencilMask( GLuint mask ) {
+	TraceState( TF_STENCILMASK );
+}
+
+static void APIENTRY traceStencilOp( GLenum fail, GLenum zfail, GLenum zpass ) {
+	TraceState( TF_STENCILOP );
+}
+
+static void APIENTRY traceTexCoord2f( GLfloat s, GLfloat t ) {
+	TraceCall( TF_TEXCOORD2F );
+	glCounters.bytes += 2 * sizeof( GLfloat );
+}
+
+static void APIENTRY traceTexCoord2fv( const GLfloat *v ) {
+	TraceCall( TF_TEXCOORD2FV );
+	glCounters.bytes += 2 * sizeof( GLfloat );
+}
+
+static void APIENTRY traceTexCoordPointer( GLint size, GLenum type, GLsizei stride, const GLvoid *pointer ) {
+	TraceArrayPointer( TF_TEXCOORDPOINTER, TraceArrayIndex( GL_TEXTURE_COORD_ARRAY ), size, type );
+}
+
+static void APIENTRY traceTexEnvf( GLenum target, GLenum pname, GLfloat param ) {
+	TraceState( TF_TEXENVF );
+}
+
+static void APIENTRY traceTexImage2D( GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const GLvoid *pixels ) {
+	TraceCall( TF_TEXIMAGE2D );
+	if ( pixels ) {
+		glCounters.bytes += width * height * TracePixelSize( format ) * TraceTypeSize( type );
+	}
+}
+
+static void APIENTRY traceTexParameterf( GLenum target, GLenum pname, GLfloat param ) {
+	TraceState( TF_TEXPARAMETERF );
+}
+
+static void APIENTRY traceTexParameterfv( GLenum target, GLenum pname, const GLfloat *params ) {
+	TraceState( TF_TEXPARAMETERFV );
+}
+
+static void APIENTRY traceTexSubImage2D( GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const GLvoid *pixels ) {
+	TraceCall( TF_TEXSUBIMAGE2D );
+	glCounters.bytes += width * height * TracePixelSize( format ) * TraceTypeSize( type );
+}
+
+static void APIENTRY traceTranslatef( GLfloat x, GLfloat y, GLfloat z ) {
+	TraceState( TF_TRANSLATEF );
+}
+
+static void APIENTRY traceUnlockArraysEXT( void ) {
+	TraceCall( TF_UNLOCKARRAYS );
+	trace.locked = qfalse;
+}
+
+static void APIENTRY traceVertex2f( GLfloat x, GLfloat y ) {
+	TraceCall( TF_VERTEX2F );
+	glCounters.vertices++;
+	glCounters.bytes += 2 * sizeof( GLfloat );
+}
+
+static void APIENTRY traceVertex3f( GLfloat x, GLfloat y, GLfloat z ) {
+	TraceCall( TF_VERTEX3F );
+	glCounters.vertices++;
+	glCounters.bytes += 3 * sizeof( GLfloat );
+}
+
+static void APIENTRY traceVertex3fv( const GLfloat *v ) {
+	TraceCall( TF_VERTEX3FV );
+	glCounters.vertices++;
+	glCounters.bytes += 3 * sizeof( GLfloat );
+}
+
+static void APIENTRY traceVertexPointer( GLint size, GLenum type, GLsizei stride, const GLvoid *pointer ) {
+	TraceArrayPointer( TF_VERTEXPOINTER, TRACE_VERTEX_ARRAY, size, type );
+}
+
+static void APIENTRY traceViewport( GLint x, GLint y, GLsizei width, GLsizei height ) {
+	TraceState( TF_VIEWPORT );
+}
+
+/*
+** GLimp_TraceList_f
+*/
+static void GLimp_TraceList_f( void ) {
+	int		i;
+
+	for ( i = 0 ; i < TF_NUM_FUNCS ; i++ ) {
+		if ( trace.calls[i] ) {
+			ri.Printf( PRINT_ALL, "%10i %s\n", trace.calls[i], traceNames[i] );
+		}
+	}
+	ri.Printf( PRINT_ALL, "%i frames, %i draw calls, %i state changes, %i vertices, %.0f bytes\n",
+		glCounters.frames, glCounters.drawCalls, glCounters.stateChanges, glCounters.vertices, glCounters.bytes );
+}
+
+/*
+** GLimp_EnableTraceLog
+**
+** r_logFile counts down the frames written to gltrace.log
+*/
+static void GLimp_EnableTraceLog( void ) {
+	char	buffer[1024];
+	cvar_t	*basedir;
+
+	if ( trace.log_fp ) {
+		ri.Cvar_Set( "r_logFile", va( "%d", r_logFile->integer - 1 ) );
+		if ( r_logFile->integer ) {
+			return;
+		}
+		fclose( trace.log_fp );
+		trace.log_fp = NULL;
+		return;
+	}
+
+	basedir = ri.Cvar_Get( "fs_basepath", "", 0 );
+	Com_sprintf( buffer, sizeof( buffer ), "%s/gltrace.log", basedir->string );
+	trace.log_fp = fopen( buffer, "wt" );
+	if ( trace.log_fp ) {
+		ri.Printf( PRINT_ALL, "GLimp_EnableTraceLog(%d): writing %s\n", r_logFile->integer, buffer );
+	}
+}
+
+/*
+** GLimp_EndFrame
+*/
 void		GLimp_EndFrame( void ) {
+	glCounters.frames++;
+
+	if ( trace.log_fp ) {
+		fprintf( trace.log_fp, "*** frame %i: %i draw calls, %i state changes, %i vertices, %.0f bytes\n",
+			glCounters.frames,
+			glCounters.drawCalls - trace.logged.drawCalls,
+			glCounters.stateChanges - trace.logged.stateChanges,
+			glCounters.vertices - trace.logged.vertices,
+			glCounters.bytes - trace.logged.bytes );
+		trace.logged = glCounters;
+	}
+
+	if ( r_logFile->integer ) {
+		GLimp_EnableTraceLog();
+		trace.logged = glCounters;
+	} else if ( trace.log_fp ) {
+		fclose( trace.log_fp );
+		trace.log_fp = NULL;
+	}
 }
 
-int 		GLimp_Init( void )
+/*
+** GLimp_Init
+**
+** There is no window, the mode only sets the size the renderer
+** believes it is drawing at
+*/
+void		GLimp_Init( void )
 {
+	ri.Printf( PRINT_ALL, "Initializing recording GL driver\n" );
+
+	if ( !R_GetModeInfo( &glConfig.vidWidth, &glConfig.vidHeight, &glConfig.windowAspect, r_mode->integer ) ) {
+		R_GetModeInfo( &glConfig.vidWidth, &glConfig.vidHeight, &glConfig.windowAspect, 3 );
+	}
+	glConfig.colorBits = 32;
+	glConfig.depthBits = 24;
+	glConfig.stencilBits = 8;
+	glConfig.displayFrequency = 0;
+	glConfig.isFullscreen = qfalse;
+	glConfig.stereoEnabled = qfalse;
+	glConfig.smpActive = qfalse;
+	glConfig.deviceSupportsGamma = qfalse;
+	glConfig.driverType = GLDRV_ICD;
+	glConfig.hardwareType = GLHW_GENERIC;
+
+	Q_strncpyz( glConfig.vendor_string, "none", sizeof( glConfig.vendor_string ) );
+	Q_strncpyz( glConfig.renderer_string, "recording", sizeof( glConfig.renderer_string ) );
+	Q_strncpyz( glConfig.version_string, "1.1", sizeof( glConfig.version_string ) );
+	Q_strncpyz( glConfig.extensions_string, "GL_ARB_multitexture GL_EXT_compiled_vertex_array GL_EXT_texture_env_add "
+		"GL_ARB_vertex_buffer_object GL_EXT_multi_draw_arrays GL_ARB_occlusion_query",
+		sizeof( glConfig.extensions_string ) );
+
+	QGL_Init( NULL );
+
+	// take the extensions a typical card has, so the same paths are recorded
+	glConfig.textureCompression = TC_NONE;
+	glConfig.textureEnvAddAvailable = qfalse;
+	glConfig.maxActiveTextures = 1;
+	if ( r_allowExtensions->integer ) {
+		glConfig.textureEnvAddAvailable = r_ext_texture_env_add->integer != 0;
+
+		if ( r_ext_multitexture->integer ) {
+			qglMultiTexCoord2fARB = traceMultiTexCoord2fARB;
+			qglActiveTextureARB = traceActiveTextureARB;
+			qglClientActiveTextureARB = traceClientActiveTextureARB;
+			qglGetIntegerv( GL_MAX_ACTIVE_TEXTURES_ARB, &glConfig.maxActiveTextures );
+		}
+		if ( r_ext_compiled_vertex_array->integer ) {
+			qglLockArraysEXT = traceLockArraysEXT;
+			qglUnlockArraysEXT = traceUnlockArraysEXT;
+		}
+		if ( r_ext_vertex_buffer_object->integer ) {
+			qglBindBufferARB = traceBindBufferARB;
+			qglDeleteBuffersARB = traceDeleteBuffersARB;
+			qglGenBuffersARB = traceGenBuffersARB;
+			qglBufferDataARB = traceBufferDataARB;
+			qglMultiDrawElementsEXT = traceMultiDrawElementsEXT;
+		}
+		if ( r_ext_occlusion_query->integer ) {
+			qglGenQueriesARB = traceGenQueriesARB;
+			qglDeleteQueriesARB = traceDeleteQueriesARB;
+			qglBeginQueryARB = traceBeginQueryARB;
+			qglEndQueryARB = traceEndQueryARB;
+			qglGetQueryObjectivARB = traceGetQueryObjectivARB;
+		}
+	}
+
+	ri.Cmd_AddCommand( "gltrace", GLimp_TraceList_f );
 }
 
 void		GLimp_Shutdown( void ) {
+	ri.Cmd_RemoveCommand( "gltrace" );
+
+	if ( trace.log_fp ) {
+		fclose( trace.log_fp );
+		trace.log_fp = NULL;
+	}
+	QGL_Shutdown();
+
+	Com_Memset( &glConfig, 0, sizeof( glConfig ) );
+	Com_Memset( &glState, 0, sizeof( glState ) );
 }
 
 void		GLimp_EnableLogging( qboolean enable ) {
 }
 
 void GLimp_LogComment( char *comment ) {
+	if ( trace.log_fp ) {
+		fprintf( trace.log_fp, "%s", comment );
+	}
+}
+
+void		GLimp_SetGamma( unsigned char red[256], unsigned char green[256], unsigned char blue[256] ) {
+}
+
+/*
+** there is nothing to hand to a render thread
+*/
+qboolean GLimp_SpawnRenderThread( void (*function)( void ) ) {
+	return qfalse;
+}
+
+void *GLimp_RendererSleep( void ) {
+	return NULL;
+}
+
+void GLimp_FrontEndSleep( void ) {
 }
 
+void GLimp_WakeRenderer( void *data ) {
+}
+
+/*
+** QGL_Init
+**
+** Points the core functions at the recorder, the extensions are
+** hooked up by GLimp_Init
+*/
 qboolean QGL_Init( const char *dllname ) {
+	Com_Memset( &trace, 0, sizeof( trace ) );
+
+	qglAlphaFunc                 = traceAlphaFunc;
+	qglArrayElement              = traceArrayElement;
+	qglBegin                     = traceBegin;
+	qglBindTexture               = traceBindTexture;
+	qglBlendFunc                 = traceBlendFunc;
+	qglCallList                  = traceCallList;
+	qglClear                     = traceClear;
+	qglClearColor                = traceClearColor;
+	qglClearDepth                = traceClearDepth;
+	qglClearStencil              = traceClearStencil;
+	qglClipPlane                 = traceClipPlane;
+	qglColor3f                   = traceColor3f;
+	qglColor4f                   = traceColor4f;
+	qglColor4ubv                 = traceColor4ubv;
+	qglColorMask                 = traceColorMask;
+	qglColorPointer              = traceColorPointer;
+	qglCullFace                  = traceCullFace;
+	qglDeleteTextures            = traceDeleteTextures;
+	qglDepthFunc                 = traceDepthFunc;
+	qglDepthMask                 = traceDepthMask;
+	qglDepthRange                = traceDepthRange;
+	qglDisable                   = traceDisable;
+	qglDisableClientState        = traceDisableClientState;
+	qglDrawBuffer                = traceDrawBuffer;
+	qglDrawElements              = traceDrawElements;
+	qglEnable                    = traceEnable;
+	qglEnableClientState         = traceEnableClientState;
+	qglEnd                       = traceEnd;
+	qglFinish                    = traceFinish;
+	qglGetError                  = traceGetError;
+	qglGetIntegerv               = traceGetIntegerv;
+	qglLineWidth                 = traceLineWidth;
+	qglLoadIdentity              = traceLoadIdentity;
+	qglLoadMatrixf               = traceLoadMatrixf;
+	qglMatrixMode                = traceMatrixMode;
+	qglOrtho                     = traceOrtho;
+	qglPolygonMode               = tracePolygonMode;
+	qglPolygonOffset             = tracePolygonOffset;
+	qglPopMatrix                 = tracePopMatrix;
+	qglPushMatrix                = tracePushMatrix;
+	qglReadPixels                = traceReadPixels;
+	qglScissor                   = traceScissor;
+	qglShadeModel                = traceShadeModel;
+	qglStencilFunc               = traceStencilFunc;
+	qglStencilMask               = traceStencilMask;
+	qglStencilOp                 = traceStencilOp;
+	qglTexCoord2f                = traceTexCoord2f;
+	qglTexCoord2fv               = traceTexCoord2fv;
+	qglTexCoordPointer           = traceTexCoordPointer;
+	qglTexEnvf                   = traceTexEnvf;
+	qglTexImage2D                = traceTexImage2D;
+	qglTexParameterf             = traceTexParameterf;
+	qglTexParameterfv            = traceTexParameterfv;
+	qglTexSubImage2D             = traceTexSubImage2D;
+	qglTranslatef                = traceTranslatef;
+	qglVertex2f                  = traceVertex2f;
+	qglVertex3f                  = traceVertex3f;
+	qglVertex3fv                 = traceVertex3fv;
+	qglVertexPointer             = traceVertexPointer;
+	qglViewport                  = traceViewport;
+
+	qglMultiTexCoord2fARB        = NULL;
+	qglActiveTextureARB          = NULL;
+	qglClientActiveTextureARB    = NULL;
+	qglLockArraysEXT             = NULL;
+	qglUnlockArraysEXT           = NULL;
+	qglBindBufferARB             = NULL;
+	qglDeleteBuffersARB          = NULL;
+	qglGenBuffersARB             = NULL;
+	qglBufferDataARB             = NULL;
+	qglMultiDrawElementsEXT      = NULL;
+	qglGenQueriesARB             = NULL;
+	qglDeleteQueriesARB          = NULL;
+	qglBeginQueryARB             = NULL;
+	qglEndQueryARB               = NULL;
+	qglGetQueryObjectivARB       = NULL;
+
 	return qtrue;
 }
 
 void		QGL_Shutdown( void ) {
+	qglMultiTexCoord2fARB        = NULL;
+	qglActiveTextureARB          = NULL;
+	qglClientActiveTextureARB    = NULL;
+	qglLockArraysEXT             = NULL;
+	qglUnlockArraysEXT           = NULL;
+	qglBindBufferARB             = NULL;
+	qglDeleteBuffersARB          = NULL;
+	qglGenBuffersARB             = NULL;
+	qglBufferDataARB             = NULL;
+	qglMultiDrawElementsEXT      = NULL;
+	qglGenQueriesARB             = NULL;
+	qglDeleteQueriesARB          = NULL;
+	qglBeginQueryARB             = NULL;
+	qglEndQueryARB               = NULL;
+	qglGetQueryObjectivARB       = NULL;
 }
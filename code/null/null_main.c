@@ -99,6 +99,45 @@ void	Sys_FindClose (void) {
 void	Sys_Init (void) {
 }
 
+void	*Sys_CreateThread( void (*function)( void *arg ), void *arg ) {
+	return NULL;
+}
+
+void	Sys_JoinThread( void *thread ) {
+}
+
+void	*Sys_CreateMutex( void ) {
+	return NULL;
+}
+
+void	Sys_DestroyMutex( void *mutex ) {
+}
+
+void	Sys_LockMutex( void *mutex ) {
+}
+
+void	Sys_UnlockMutex( void *mutex ) {
+}
+
+void	*Sys_CreateCondition( void ) {
+	return NULL;
+}
+
+void	Sys_DestroyCondition( void *cond ) {
+}
+
+void	Sys_WaitCondition( void *cond, void *mutex ) {
+}
+
+void	Sys_WakeCondition( void *cond ) {
+}
+
+void	Sys_Sleep( int msec ) {
+}
+
+void	Sys_MemoryBarrier( void ) {
+}
+
 
 void	Sys_EarlyOutput( char *string ) {
 	printf( "%s", string );
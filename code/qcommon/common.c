@@ -35,7 +35,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #endif
 
 int demo_protocols[] =
-{ 66, 67, 68, 0 };
+{ 66, 67, 68, 69, 0 };
 
 #define MAX_NUM_ARGVS	50
 
@@ -102,6 +102,9 @@ char	com_errorMessage[MAXPRINTMSG];
 void Com_WriteConfig_f( void );
 void CIN_CloseAllVideos();
 
+static void	*com_dispatchedEvent;		// evPtr of the event Com_EventLoop is handling
+static void	Com_FreeDispatchedEvent( void );
+
 //============================================================================
 
 static char	*rd_buffer;
@@ -278,6 +281,9 @@ void QDECL Com_Error( int code, const char *fmt, ... ) {
 		Cvar_Set("com_errorMessage", com_errorMessage);
 	}
 
+	// the event being handled won't get back to Com_EventLoop to be freed
+	Com_FreeDispatchedEvent();
+
 	if ( code == ERR_SERVERDISCONNECT ) {
 		CL_Disconnect( qtrue );
 		CL_FlushMemory( );
@@ -712,7 +718,16 @@ int Com_RealTime(qtime_t *qtime) {
 There is never any space between memblocks, and there will never be two
 contiguous free memblocks.
 
-The rover can be left pointing at a non-empty block
+Free blocks are also kept in size class bins, so an allocation takes the
+first non-empty bin that is big enough instead of walking the block list.
+Below ZONE_SMALL_SIZE every size has its own bin, so the small strings that
+make up most of the small zone are reused exactly, above it each power of
+two is split into ZONE_SUBBINS bins.  The bin links are kept in the free
+block's own memory.
+
+A zone without bins uses the original first fit scan from the rover, which
+zonebench replays traces against for comparison.  The rover can be left
+pointing at a non-empty block.
 
 The zone calls are pretty much only used for small strings and structures,
 all big things are allocated on the hunk.
@@ -722,6 +737,15 @@ all big things are allocated on the hunk.
 #define	ZONEID	0x1d4a11
 #define MINFRAGMENT	64
 
+#define	ZONE_ALIGN			8
+#define	ZONE_SMALL_SIZE		512				// blocks below this have a bin per size
+#define	ZONE_SMALL_BITS		9				// log2( ZONE_SMALL_SIZE )
+#define	ZONE_SMALL_BINS		( ZONE_SMALL_SIZE / ZONE_ALIGN )
+#define	ZONE_SUBBIN_BITS	3
+#define	ZONE_SUBBINS		( 1 << ZONE_SUBBIN_BITS )
+#define	ZONE_NUM_BINS		( ZONE_SMALL_BINS + ( 31 - ZONE_SMALL_BITS ) * ZONE_SUBBINS )
+#define	ZONE_BIN_WORDS		( ( ZONE_NUM_BINS + 31 ) / 32 )
+
 typedef struct zonedebug_s {
 	char *label;
 	char *file;
@@ -739,11 +763,23 @@ typedef struct memblock_s {
 #endif
 } memblock_t;
 
+// stored just past the header of a free block in a zone with bins
+typedef struct {
+	memblock_t	*nextFree, *prevFree;
+} memfree_t;
+
+// every block must be able to hold its bin links once it is freed
+#define	ZONE_MIN_BLOCK	( ( sizeof( memblock_t ) + sizeof( memfree_t ) + ZONE_ALIGN - 1 ) & ~( ZONE_ALIGN - 1 ) )
+
 typedef struct {
 	int		size;			// total bytes malloced, including header
 	int		used;			// total bytes used
 	memblock_t	blocklist;	// start / end cap for linked list
 	memblock_t	*rover;
+
+	qboolean	bins;
+	memblock_t	*freeBins[ZONE_NUM_BINS];
+	unsigned	binMap[ZONE_BIN_WORDS];		// a bit for every non-empty bin
 } memzone_t;
 
 // main zone for all "dynamic" memory allocation
@@ -752,14 +788,131 @@ memzone_t	*mainzone;
 // fragment the main zone (think of cvar and cmd strings)
 memzone_t	*smallzone;
 
+// zone traces, see Z_Trace_f
+#define	ZONETRACE_BUFFER	1024
+
+typedef enum {
+	ZT_ALLOC = 1,
+	ZT_FREE
+} zoneTraceOp_t;
+
+typedef struct {
+	int		op;				// zoneTraceOp_t
+	int		tag;
+	int		size;			// as asked for, 0 for frees
+	int		offset;			// of the block from the start of its zone
+} zoneTraceRecord_t;
+
+static struct {
+	qboolean			recording;
+	fileHandle_t		file;			// 0 while the file system restarts
+	char				name[MAX_QPATH];
+	qboolean			suspended;
+	qboolean			overflowed;		// the buffer filled while suspended
+	int					numRecords;
+	int					total;
+	zoneTraceRecord_t	records[ZONETRACE_BUFFER];
+} zoneTrace;
+
+static void Z_TraceRecord( int op, int tag, int size, int offset );
+
 void Z_CheckHeap( void );
 
+/*
+========================
+Z_BinForSize
+
+The bin a free block of this size is kept in
+========================
+*/
+static int Z_BinForSize( int size ) {
+	int		bits;
+
+	if ( size < ZONE_SMALL_SIZE ) {
+		return size / ZONE_ALIGN;
+	}
+
+	for ( bits = ZONE_SMALL_BITS ; size >> ( bits + 1 ) ; bits++ ) {
+	}
+
+	return ZONE_SMALL_BINS + ( bits - ZONE_SMALL_BITS ) * ZONE_SUBBINS
+		+ ( ( size >> ( bits - ZONE_SUBBIN_BITS ) ) & ( ZONE_SUBBINS - 1 ) );
+}
+
+/*
+========================
+Z_FitBinForSize
+
+The first bin where every block is at least this size
+========================
+*/
+static int Z_FitBinForSize( int size ) {
+	int		bits;
+
+	if ( size < ZONE_SMALL_SIZE ) {
+		return size / ZONE_ALIGN;
+	}
+
+	for ( bits = ZONE_SMALL_BITS ; size >> ( bits + 1 ) ; bits++ ) {
+	}
+
+	// round up to the start of the next bin
+	return Z_BinForSize( size + ( 1 << ( bits - ZONE_SUBBIN_BITS ) ) - 1 );
+}
+
+/*
+========================
+Z_LinkFree
+========================
+*/
+static void Z_LinkFree( memzone_t *zone, memblock_t *block ) {
+	memfree_t	*links;
+	int			bin;
+
+	bin = Z_BinForSize( block->size );
+
+	links = (memfree_t *)( block + 1 );
+	links->prevFree = NULL;
+	links->nextFree = zone->freeBins[bin];
+	if ( links->nextFree ) {
+		( (memfree_t *)( links->nextFree + 1 ) )->prevFree = block;
+	}
+	zone->freeBins[bin] = block;
+	zone->binMap[bin >> 5] |= 1u << ( bin & 31 );
+}
+
+/*
+========================
+Z_UnlinkFree
+
+Must be called before the block's size changes
+========================
+*/
+static void Z_UnlinkFree( memzone_t *zone, memblock_t *block ) {
+	memfree_t	*links;
+	int			bin;
+
+	links = (memfree_t *)( block + 1 );
+	if ( links->prevFree ) {
+		( (memfree_t *)( links->prevFree + 1 ) )->nextFree = links->nextFree;
+	} else {
+		bin = Z_BinForSize( block->size );
+		zone->freeBins[bin] = links->nextFree;
+		if ( !links->nextFree ) {
+			zone->binMap[bin >> 5] &= ~( 1u << ( bin & 31 ) );
+		}
+	}
+	if ( links->nextFree ) {
+		( (memfree_t *)( links->nextFree + 1 ) )->prevFree = links->prevFree;
+	}
+}
+
 /*
 ========================
 Z_ClearZone
 ========================
 */
-void Z_ClearZone( memzone_t *zone, int size ) {
+void Z_ClearZone( memzone_t *zone, int size, qboolean bins ) {
 	memblock_t	*block;
 	
 	// set the entire zone to one free block
@@ -776,7 +929,200 @@ void Z_ClearZone( memzone_t *zone, int size ) {
 	block->prev = block->next = &zone->blocklist;
 	block->tag = 0;			// free block
 	block->id = ZONEID;
-	block->size = size - sizeof(memzone_t);
+	block->size = ( size - sizeof(memzone_t) ) & ~( ZONE_ALIGN - 1 );
+
+	zone->bins = bins;
+	Com_Memset( zone->freeBins, 0, sizeof( zone->freeBins ) );
+	Com_Memset( zone->binMap, 0, sizeof( zone->binMap ) );
+	if ( bins ) {
+		Z_LinkFree( zone, block );
+	}
+}
+
+/*
+========================
+Z_TakeFreeBlock
+
+Removes the first block from the first non-empty bin whose blocks are all
+big enough.  Only if there is none is the bin the size falls in searched,
+so an allocation never fails while a big enough block is free.
+========================
+*/
+static memblock_t *Z_TakeFreeBlock( memzone_t *zone, int size ) {
+	memblock_t	*block;
+	unsigned	bits;
+	int			bin, word;
+
+	bin = Z_FitBinForSize( size );
+
+	bits = 0;
+	word = bin >> 5;
+	if ( word < ZONE_BIN_WORDS ) {
+		bits = zone->binMap[word] & ( ~0u << ( bin & 31 ) );
+		while ( !bits && ++word < ZONE_BIN_WORDS ) {
+			bits = zone->binMap[word];
+		}
+	}
+
+	if ( bits ) {
+		for ( bin = word * 32 ; !( bits & 1 ) ; bits >>= 1, bin++ ) {
+		}
+		block = zone->freeBins[bin];
+	} else {
+		for ( block = zone->freeBins[ Z_BinForSize( size ) ] ; block ;
+			block = ( (memfree_t *)( block + 1 ) )->nextFree ) {
+			if ( block->size >= size ) {
+				break;
+			}
+		}
+		if ( !block ) {
+			return NULL;
+		}
+	}
+
+	Z_UnlinkFree( zone, block );
+	return block;
+}
+
+/*
+========================
+Z_ScanFreeBlock
+
+Scans through the block list looking for the first free block of
+sufficient size
+========================
+*/
+static memblock_t *Z_ScanFreeBlock( memzone_t *zone, int size ) {
+	memblock_t	*start, *rover, *base;
+
+	base = rover = zone->rover;
+	start = base->prev;
+	
+	do {
+		if (rover == start)	{
+			// scaned all the way around the list
+			return NULL;
+		}
+		if (rover->tag) {
+			base = rover = rover->next;
+		} else {
+			rover = rover->next;
+		}
+	} while (base->tag || base->size < size);
+
+	return base;
+}
+
+/*
+========================
+Z_AllocBlock
+
+Returns NULL if no free block is big enough
+========================
+*/
+static memblock_t *Z_AllocBlock( memzone_t *zone, int size, int tag ) {
+	int			extra;
+	memblock_t	*base, *new;
+
+	if ( zone->bins ) {
+		base = Z_TakeFreeBlock( zone, size );
+	} else {
+		base = Z_ScanFreeBlock( zone, size );
+	}
+	if ( !base ) {
+		return NULL;
+	}
+	
+	//
+	// found a block big enough
+	//
+	extra = base->size - size;
+	if (extra > MINFRAGMENT) {
+		// there will be a free fragment after the allocated block
+		new = (memblock_t *) ((byte *)base + size );
+		new->size = extra;
+		new->tag = 0;			// free block
+		new->prev = base;
+		new->id = ZONEID;
+		new->next = base->next;
+		new->next->prev = new;
+		base->next = new;
+		base->size = size;
+		if ( zone->bins ) {
+			Z_LinkFree( zone, new );
+		}
+	}
+	
+	base->tag = tag;			// no longer a free block
+	
+	zone->rover = base->next;	// next allocation will start looking here
+	zone->used += base->size;	//
+	
+	base->id = ZONEID;
+
+	return base;
+}
+
+/*
+========================
+Z_FreeBlock
+
+Merges the block with its free neighbours.  The rover is left on the
+resulting free block, which Z_FreeTags relies on.
+========================
+*/
+static void Z_FreeBlock( memzone_t *zone, memblock_t *block ) {
+	memblock_t	*other;
+
+	zone->used -= block->size;
+
+	block->tag = 0;		// mark as free
+	
+	other = block->prev;
+	if (!other->tag) {
+		// merge with previous free block
+		if ( zone->bins ) {
+			Z_UnlinkFree( zone, other );
+		}
+		other->size += block->size;
+		other->next = block->next;
+		other->next->prev = other;
+		block = other;
+	}
+
+	other = block->next;
+	if ( !other->tag ) {
+		// merge the next free block onto the end
+		if ( zone->bins ) {
+			Z_UnlinkFree( zone, other );
+		}
+		block->size += other->size;
+		block->next = other->next;
+		block->next->prev = block;
+	}
+
+	zone->rover = block;
+
+	if ( zone->bins ) {
+		Z_LinkFree( zone, block );
+	}
+}
+
+/*
+========================
+Z_BlockSize
+
+The size of the block for an allocation of size bytes
+========================
+*/
+static int Z_BlockSize( int size ) {
+	size += sizeof(memblock_t);	// account for size of block header
+	size += 4;					// space for memory trash tester
+	size = ( size + ZONE_ALIGN - 1 ) & ~( ZONE_ALIGN - 1 );
+	if ( size < ZONE_MIN_BLOCK ) {
+		size = ZONE_MIN_BLOCK;
+	}
+	return size;
 }
 
 /*
@@ -803,7 +1149,7 @@ Z_Free
 ========================
 */
 void Z_Free( void *ptr ) {
-	memblock_t	*block, *other;
+	memblock_t	*block;
 	memzone_t *zone;
 	
 	if (!ptr) {
@@ -834,37 +1180,15 @@ void Z_Free( void *ptr ) {
 		zone = mainzone;
 	}
 
-	zone->used -= block->size;
+	if ( zoneTrace.recording ) {
+		Z_TraceRecord( ZT_FREE, block->tag, 0, (byte *)block - (byte *)zone );
+	}
+
 	// set the block to something that should cause problems
 	// if it is referenced...
 	Com_Memset( ptr, 0xaa, block->size - sizeof( *block ) );
 
-	block->tag = 0;		// mark as free
-	
-	other = block->prev;
-	if (!other->tag) {
-		// merge with previous free block
-		other->size += block->size;
-		other->next = block->next;
-		other->next->prev = other;
-		if (block == zone->rover) {
-			zone->rover = other;
-		}
-		block = other;
-	}
-
-	zone->rover = block;
-
-	other = block->next;
-	if ( !other->tag ) {
-		// merge the next free block onto the end
-		block->size += other->size;
-		block->next = other->next;
-		block->next->prev = block;
-		if (other == zone->rover) {
-			zone->rover = block;
-		}
-	}
+	Z_FreeBlock( zone, block );
 }
 
 
@@ -908,8 +1232,8 @@ void *Z_TagMallocDebug( int size, int tag, char *label, char *file, int line ) {
 #else
 void *Z_TagMalloc( int size, int tag ) {
 #endif
-	int		extra, allocSize;
-	memblock_t	*start, *rover, *new, *base;
+	int		allocSize;
+	memblock_t	*base;
 	memzone_t *zone;
 
 	if (!tag) {
@@ -924,57 +1248,17 @@ void *Z_TagMalloc( int size, int tag ) {
 	}
 
 	allocSize = size;
-	//
-	// scan through the block list looking for the first free block
-	// of sufficient size
-	//
-	size += sizeof(memblock_t);	// account for size of block header
-	size += 4;					// space for memory trash tester
-	size = (size + 3) & ~3;		// align to 32 bit boundary
-	
-	base = rover = zone->rover;
-	start = base->prev;
-	
-	do {
-		if (rover == start)	{
+	size = Z_BlockSize( size );
+
+	base = Z_AllocBlock( zone, size, tag );
+	if ( !base ) {
 #ifdef ZONE_DEBUG
-			Z_LogHeap();
+		Z_LogHeap();
 #endif
-			// scaned all the way around the list
-			Com_Error( ERR_FATAL, "Z_Malloc: failed on allocation of %i bytes from the %s zone",
-								size, zone == smallzone ? "small" : "main");
-			return NULL;
-		}
-		if (rover->tag) {
-			base = rover = rover->next;
-		} else {
-			rover = rover->next;
-		}
-	} while (base->tag || base->size < size);
-	
-	//
-	// found a block big enough
-	//
-	extra = base->size - size;
-	if (extra > MINFRAGMENT) {
-		// there will be a free fragment after the allocated block
-		new = (memblock_t *) ((byte *)base + size );
-		new->size = extra;
-		new->tag = 0;			// free block
-		new->prev = base;
-		new->id = ZONEID;
-		new->next = base->next;
-		new->next->prev = new;
-		base->next = new;
-		base->size = size;
+		Com_Error( ERR_FATAL, "Z_Malloc: failed on allocation of %i bytes from the %s zone",
+							size, zone == smallzone ? "small" : "main");
+		return NULL;
 	}
-	
-	base->tag = tag;			// no longer a free block
-	
-	zone->rover = base->next;	// next allocation will start looking here
-	zone->used += base->size;	//
-	
-	base->id = ZONEID;
 
 #ifdef ZONE_DEBUG
 	base->d.label = label;
@@ -986,6 +1270,10 @@ void *Z_TagMalloc( int size, int tag ) {
 	// marker for memory trash testing
 	*(int *)((byte *)base + base->size - 4) = ZONEID;
 
+	if ( zoneTrace.recording ) {
+		Z_TraceRecord( ZT_ALLOC, tag, allocSize, (byte *)base - (byte *)zone );
+	}
+
 	return (void *) ((byte *)base + sizeof(memblock_t));
 }
 
@@ -1021,92 +1309,460 @@ void *S_MallocDebug( int size, char *label, char *file, int line ) {
 void *S_Malloc( int size ) {
 	return Z_TagMalloc( size, TAG_SMALL );
 }
-#endif
+#endif
+
+/*
+========================
+Z_CheckHeap
+========================
+*/
+void Z_CheckHeap( void ) {
+	memblock_t	*block;
+	memfree_t	*links;
+	int			i, numFree;
+	
+	numFree = 0;
+	for (block = mainzone->blocklist.next ; ; block = block->next) {
+		if ( !block->tag ) {
+			numFree++;
+		}
+		if (block->next == &mainzone->blocklist) {
+			break;			// all blocks have been hit
+		}
+		if ( (byte *)block + block->size != (byte *)block->next)
+			Com_Error( ERR_FATAL, "Z_CheckHeap: block size does not touch the next block\n" );
+		if ( block->next->prev != block) {
+			Com_Error( ERR_FATAL, "Z_CheckHeap: next block doesn't have proper back link\n" );
+		}
+		if ( !block->tag && !block->next->tag ) {
+			Com_Error( ERR_FATAL, "Z_CheckHeap: two consecutive free blocks\n" );
+		}
+	}
+
+	if ( !mainzone->bins ) {
+		return;
+	}
+
+	// every free block must be in the bin for its size, and nothing else
+	for ( i = 0 ; i < ZONE_NUM_BINS ; i++ ) {
+		if ( !mainzone->freeBins[i] != !( mainzone->binMap[i >> 5] & ( 1u << ( i & 31 ) ) ) ) {
+			Com_Error( ERR_FATAL, "Z_CheckHeap: bin map doesn't match bin %i\n", i );
+		}
+		for ( block = mainzone->freeBins[i] ; block ; block = links->nextFree ) {
+			links = (memfree_t *)( block + 1 );
+			if ( block->tag || block->id != ZONEID ) {
+				Com_Error( ERR_FATAL, "Z_CheckHeap: used block in a free bin\n" );
+			}
+			if ( Z_BinForSize( block->size ) != i ) {
+				Com_Error( ERR_FATAL, "Z_CheckHeap: free block in the wrong bin\n" );
+			}
+			if ( links->nextFree && ( (memfree_t *)( links->nextFree + 1 ) )->prevFree != block ) {
+				Com_Error( ERR_FATAL, "Z_CheckHeap: free block doesn't have proper back link\n" );
+			}
+			numFree--;
+		}
+	}
+	if ( numFree ) {
+		Com_Error( ERR_FATAL, "Z_CheckHeap: free blocks missing from the bins\n" );
+	}
+}
+
+/*
+========================
+Z_LogZoneHeap
+========================
+*/
+void Z_LogZoneHeap( memzone_t *zone, char *name ) {
+#ifdef ZONE_DEBUG
+	char dump[32], *ptr;
+	int  i, j;
+#endif
+	memblock_t	*block;
+	char		buf[4096];
+	int size, allocSize, numBlocks;
+
+	if (!logfile || !FS_Initialized())
+		return;
+	size = allocSize = numBlocks = 0;
+	Com_sprintf(buf, sizeof(buf), "\r\n================\r\n%s log\r\n================\r\n", name);
+	FS_Write(buf, strlen(buf), logfile);
+	for (block = zone->blocklist.next ; block->next != &zone->blocklist; block = block->next) {
+		if (block->tag) {
+#ifdef ZONE_DEBUG
+			ptr = ((char *) block) + sizeof(memblock_t);
+			j = 0;
+			for (i = 0; i < 20 && i < block->d.allocSize; i++) {
+				if (ptr[i] >= 32 && ptr[i] < 127) {
+					dump[j++] = ptr[i];
+				}
+				else {
+					dump[j++] = '_';
+				}
+			}
+			dump[j] = '\0';
+			Com_sprintf(buf, sizeof(buf), "size = %8d: %s, line: %d (%s) [%s]\r\n", block->d.allocSize, block->d.file, block->d.line, block->d.label, dump);
+			FS_Write(buf, strlen(buf), logfile);
+			allocSize += block->d.allocSize;
+#endif
+			size += block->size;
+			numBlocks++;
+		}
+	}
+#ifdef ZONE_DEBUG
+	// subtract debug memory
+	size -= numBlocks * sizeof(zonedebug_t);
+#else
+	allocSize = numBlocks * sizeof(memblock_t); // + 32 bit alignment
+#endif
+	Com_sprintf(buf, sizeof(buf), "%d %s memory in %d blocks\r\n", size, name, numBlocks);
+	FS_Write(buf, strlen(buf), logfile);
+	Com_sprintf(buf, sizeof(buf), "%d %s memory overhead\r\n", size - allocSize, name);
+	FS_Write(buf, strlen(buf), logfile);
+}
+
+/*
+========================
+Z_LogHeap
+========================
+*/
+void Z_LogHeap( void ) {
+	Z_LogZoneHeap( mainzone, "MAIN" );
+	Z_LogZoneHeap( smallzone, "SMALL" );
+}
+
+/*
+==============================================================================
+
+ZONE TRACES
+
+"zonetrace <name>" records every zone allocation and free in
+zonetrace/<name>.ztr until "zonetrace stop", so the allocation pattern of a
+long server run can be replayed by "zonebench <name>" against both the bins
+and the first fit scan.  Blocks are identified by their offset in the zone.
+
+==============================================================================
+*/
+
+#define	ZONETRACE_IDENT		(('1'<<24)+('R'<<16)+('T'<<8)+'Z')	// little-endian "ZTR1"
+
+typedef struct {
+	int		ident;
+	int		mainSize;		// zone sizes at capture
+	int		smallSize;
+} zoneTraceHeader_t;
+
+static void Z_TraceFlush( void ) {
+	if ( zoneTrace.numRecords ) {
+		FS_Write( zoneTrace.records, zoneTrace.numRecords * sizeof( zoneTraceRecord_t ), zoneTrace.file );
+		zoneTrace.numRecords = 0;
+	}
+}
+
+/*
+========================
+Z_TraceRecord
+========================
+*/
+static void Z_TraceRecord( int op, int tag, int size, int offset ) {
+	zoneTraceRecord_t	*record;
+
+	if ( zoneTrace.numRecords == ZONETRACE_BUFFER ) {
+		// suspended with nowhere to flush to
+		zoneTrace.overflowed = qtrue;
+		return;
+	}
+
+	record = &zoneTrace.records[zoneTrace.numRecords];
+	record->op = LittleLong( op );
+	record->tag = LittleLong( tag );
+	record->size = LittleLong( size );
+	record->offset = LittleLong( offset );
+	zoneTrace.total++;
+
+	if ( ++zoneTrace.numRecords == ZONETRACE_BUFFER && zoneTrace.file ) {
+		Z_TraceFlush();
+	}
+}
+
+/*
+========================
+Z_StopTrace
+========================
+*/
+static void Z_StopTrace( void ) {
+	fileHandle_t	f;
+
+	if ( !zoneTrace.recording ) {
+		return;
+	}
+
+	// stop recording before the file system gets to allocate anything
+	zoneTrace.recording = qfalse;
+	zoneTrace.suspended = qfalse;
+	f = zoneTrace.file;
+	if ( f ) {
+		Z_TraceFlush();
+		zoneTrace.file = 0;
+		FS_FCloseFile( f );
+	}
+
+	Com_Printf( "zone trace stopped after %i operations\n", zoneTrace.total );
+}
+
+/*
+========================
+Z_SuspendTrace
+
+FS_Shutdown closes every file handle, so it closes the trace file
+here first.  What is allocated until Z_ResumeTrace reopens it stays
+in the buffer.
+========================
+*/
+void Z_SuspendTrace( void ) {
+	fileHandle_t	f;
+
+	if ( !zoneTrace.file ) {
+		return;
+	}
+
+	f = zoneTrace.file;
+	Z_TraceFlush();
+	zoneTrace.file = 0;
+	zoneTrace.suspended = qtrue;
+	zoneTrace.overflowed = qfalse;
+	FS_FCloseFile( f );
+}
+
+/*
+========================
+Z_ResumeTrace
+
+Appends to the trace file again once FS_Restart has the file
+system back up
+========================
+*/
+void Z_ResumeTrace( void ) {
+	fileHandle_t	f;
+
+	if ( !zoneTrace.suspended ) {
+		return;
+	}
+	zoneTrace.suspended = qfalse;
+
+	if ( zoneTrace.overflowed ) {
+		zoneTrace.recording = qfalse;
+		Com_Printf( "zone trace stopped after %i operations, too many while the file system restarted\n",
+			zoneTrace.total );
+		return;
+	}
+
+	FS_FOpenFileByMode( zoneTrace.name, &f, FS_APPEND );
+	if ( !f ) {
+		zoneTrace.recording = qfalse;
+		Com_Printf( "couldn't reopen %s, zone trace stopped\n", zoneTrace.name );
+		return;
+	}
+	zoneTrace.file = f;
+	if ( zoneTrace.numRecords == ZONETRACE_BUFFER ) {
+		Z_TraceFlush();
+	}
+}
+
+/*
+========================
+Z_Trace_f
+========================
+*/
+static void Z_Trace_f( void ) {
+	zoneTraceHeader_t	header;
+	fileHandle_t		f;
+	char				*name;
+
+	if ( Cmd_Argc() != 2 ) {
+		Com_Printf( "usage: zonetrace <name|stop>\n" );
+		return;
+	}
+
+	Z_StopTrace();
+	if ( !Q_stricmp( Cmd_Argv( 1 ), "stop" ) ) {
+		return;
+	}
+
+	name = va( "zonetrace/%s.ztr", Cmd_Argv( 1 ) );
+	f = FS_FOpenFileWrite( name );
+	if ( !f ) {
+		Com_Printf( "couldn't open %s\n", name );
+		return;
+	}
+
+	header.ident = LittleLong( ZONETRACE_IDENT );
+	header.mainSize = LittleLong( mainzone->size );
+	header.smallSize = LittleLong( smallzone->size );
+	FS_Write( &header, sizeof( header ), f );
+
+	Q_strncpyz( zoneTrace.name, name, sizeof( zoneTrace.name ) );
+	zoneTrace.numRecords = 0;
+	zoneTrace.total = 0;
+	zoneTrace.file = f;
+	zoneTrace.recording = qtrue;
+
+	Com_Printf( "recording zone trace to %s\n", name );
+}
 
 /*
 ========================
-Z_CheckHeap
+Z_BenchReplay
+
+Replays the trace once into fresh zones and returns the msec it took
 ========================
 */
-void Z_CheckHeap( void ) {
-	memblock_t	*block;
-	
-	for (block = mainzone->blocklist.next ; ; block = block->next) {
-		if (block->next == &mainzone->blocklist) {
-			break;			// all blocks have been hit
-		}
-		if ( (byte *)block + block->size != (byte *)block->next)
-			Com_Error( ERR_FATAL, "Z_CheckHeap: block size does not touch the next block\n" );
-		if ( block->next->prev != block) {
-			Com_Error( ERR_FATAL, "Z_CheckHeap: next block doesn't have proper back link\n" );
-		}
-		if ( !block->tag && !block->next->tag ) {
-			Com_Error( ERR_FATAL, "Z_CheckHeap: two consecutive free blocks\n" );
+static int Z_BenchReplay( zoneTraceRecord_t *records, int numRecords, memzone_t *zones[2],
+						 memblock_t **blocks[2], int *failed ) {
+	zoneTraceRecord_t	*record;
+	memblock_t			**slot;
+	int					i, z, start;
+
+	*failed = 0;
+
+	start = Sys_Milliseconds();
+	for ( i = 0, record = records ; i < numRecords ; i++, record++ ) {
+		z = ( record->tag == TAG_SMALL );
+		slot = &blocks[z][record->offset / ZONE_ALIGN];
+		if ( record->op == ZT_ALLOC ) {
+			*slot = Z_AllocBlock( zones[z], Z_BlockSize( record->size ), record->tag );
+			if ( !*slot ) {
+				(*failed)++;
+			}
+		} else if ( *slot ) {
+			// frees of blocks from before the trace started are skipped
+			Z_FreeBlock( zones[z], *slot );
+			*slot = NULL;
 		}
 	}
+	return Sys_Milliseconds() - start;
 }
 
 /*
 ========================
-Z_LogZoneHeap
+Z_Bench_f
+
+"zonebench <name> [iterations]" replays zonetrace/<name>.ztr into zones of
+the captured sizes, first with the first fit scan, then with the bins,
+and reports the time and the fragmentation left at the end
 ========================
 */
-void Z_LogZoneHeap( memzone_t *zone, char *name ) {
-#ifdef ZONE_DEBUG
-	char dump[32], *ptr;
-	int  i, j;
-#endif
-	memblock_t	*block;
-	char		buf[4096];
-	int size, allocSize, numBlocks;
+static void Z_Bench_f( void ) {
+	zoneTraceHeader_t	header;
+	zoneTraceRecord_t	*records;
+	memzone_t			*zones[2];
+	memblock_t			**blocks[2];
+	memblock_t			*block;
+	fileHandle_t		f;
+	char				*name;
+	int					sizes[2];
+	int					len, numRecords, iterations;
+	int					i, z, mode, msec, failed;
+	int					numFree, largestFree;
+
+	if ( Cmd_Argc() < 2 ) {
+		Com_Printf( "usage: zonebench <name> [iterations]\n" );
+		return;
+	}
+	iterations = 1;
+	if ( Cmd_Argc() > 2 ) {
+		iterations = atoi( Cmd_Argv( 2 ) );
+		if ( iterations < 1 ) {
+			iterations = 1;
+		}
+	}
 
-	if (!logfile || !FS_Initialized())
+	name = va( "zonetrace/%s.ztr", Cmd_Argv( 1 ) );
+	len = FS_FOpenFileRead( name, &f, qtrue );
+	if ( !f ) {
+		Com_Printf( "couldn't open %s\n", name );
 		return;
-	size = allocSize = numBlocks = 0;
-	Com_sprintf(buf, sizeof(buf), "\r\n================\r\n%s log\r\n================\r\n", name);
-	FS_Write(buf, strlen(buf), logfile);
-	for (block = zone->blocklist.next ; block->next != &zone->blocklist; block = block->next) {
-		if (block->tag) {
-#ifdef ZONE_DEBUG
-			ptr = ((char *) block) + sizeof(memblock_t);
-			j = 0;
-			for (i = 0; i < 20 && i < block->d.allocSize; i++) {
-				if (ptr[i] >= 32 && ptr[i] < 127) {
-					dump[j++] = ptr[i];
-				}
-				else {
-					dump[j++] = '_';
+	}
+	if ( len < sizeof( header ) ) {
+		FS_FCloseFile( f );
+		Com_Printf( "%s is too short\n", name );
+		return;
+	}
+	FS_Read( &header, sizeof( header ), f );
+	sizes[0] = LittleLong( header.mainSize );
+	sizes[1] = LittleLong( header.smallSize );
+	if ( LittleLong( header.ident ) != ZONETRACE_IDENT
+		|| sizes[0] <= (int)sizeof( memzone_t ) || sizes[1] <= (int)sizeof( memzone_t ) ) {
+		FS_FCloseFile( f );
+		Com_Printf( "%s is not a zone trace\n", name );
+		return;
+	}
+
+	// traces of a long run are far bigger than the zone, so they
+	// don't go through it
+	numRecords = ( len - sizeof( header ) ) / sizeof( zoneTraceRecord_t );
+	records = malloc( numRecords * sizeof( zoneTraceRecord_t ) + 1 );
+	zones[0] = calloc( sizes[0], 1 );
+	zones[1] = calloc( sizes[1], 1 );
+	blocks[0] = calloc( sizes[0] / ZONE_ALIGN, sizeof( memblock_t * ) );
+	blocks[1] = calloc( sizes[1] / ZONE_ALIGN, sizeof( memblock_t * ) );
+	if ( !records || !zones[0] || !zones[1] || !blocks[0] || !blocks[1] ) {
+		Com_Printf( "not enough memory to replay %s\n", name );
+		numRecords = 0;
+	}
+
+	FS_Read( records, numRecords * sizeof( zoneTraceRecord_t ), f );
+	FS_FCloseFile( f );
+
+	for ( i = 0 ; i < numRecords ; i++ ) {
+		records[i].op = LittleLong( records[i].op );
+		records[i].tag = LittleLong( records[i].tag );
+		records[i].size = LittleLong( records[i].size );
+		records[i].offset = LittleLong( records[i].offset );
+
+		z = ( records[i].tag == TAG_SMALL );
+		if ( records[i].offset < 0 || records[i].offset >= sizes[z]
+			|| records[i].size < 0 || records[i].size > sizes[z] ) {
+			Com_Printf( "%s has a bad record at %i\n", name, i );
+			numRecords = 0;
+		}
+	}
+
+	if ( numRecords ) {
+		Com_Printf( "%i operations, %i and %i byte zones\n", numRecords, sizes[0], sizes[1] );
+	}
+
+	for ( mode = 0 ; mode < 2 && numRecords ; mode++ ) {
+		msec = 0;
+		for ( i = 0 ; i < iterations ; i++ ) {
+			for ( z = 0 ; z < 2 ; z++ ) {
+				Z_ClearZone( zones[z], sizes[z], mode );
+				Com_Memset( blocks[z], 0, sizes[z] / ZONE_ALIGN * sizeof( memblock_t * ) );
+			}
+			msec += Z_BenchReplay( records, numRecords, zones, blocks, &failed );
+		}
+
+		numFree = 0;
+		largestFree = 0;
+		for ( block = zones[0]->blocklist.next ; block != &zones[0]->blocklist ; block = block->next ) {
+			if ( !block->tag ) {
+				numFree++;
+				if ( block->size > largestFree ) {
+					largestFree = block->size;
 				}
 			}
-			dump[j] = '\0';
-			Com_sprintf(buf, sizeof(buf), "size = %8d: %s, line: %d (%s) [%s]\r\n", block->d.allocSize, block->d.file, block->d.line, block->d.label, dump);
-			FS_Write(buf, strlen(buf), logfile);
-			allocSize += block->d.allocSize;
-#endif
-			size += block->size;
-			numBlocks++;
 		}
+
+		Com_Printf( "%s: %i msec per replay, %.1f nsec per operation\n", mode ? "bins" : "first fit",
+			msec / iterations, msec * 1000000.0 / ( (double)iterations * numRecords ) );
+		Com_Printf( "  %i failed allocations, %i bytes used, %i free blocks, largest %i\n",
+			failed, zones[0]->used, numFree, largestFree );
 	}
-#ifdef ZONE_DEBUG
-	// subtract debug memory
-	size -= numBlocks * sizeof(zonedebug_t);
-#else
-	allocSize = numBlocks * sizeof(memblock_t); // + 32 bit alignment
-#endif
-	Com_sprintf(buf, sizeof(buf), "%d %s memory in %d blocks\r\n", size, name, numBlocks);
-	FS_Write(buf, strlen(buf), logfile);
-	Com_sprintf(buf, sizeof(buf), "%d %s memory overhead\r\n", size - allocSize, name);
-	FS_Write(buf, strlen(buf), logfile);
-}
 
-/*
-========================
-Z_LogHeap
-========================
-*/
-void Z_LogHeap( void ) {
-	Z_LogZoneHeap( mainzone, "MAIN" );
-	Z_LogZoneHeap( smallzone, "SMALL" );
+	free( blocks[1] );
+	free( blocks[0] );
+	free( zones[1] );
+	free( zones[0] );
+	free( records );
 }
 
 // static mem blocks to reduce a lot of small zone overhead
@@ -1225,6 +1881,263 @@ static	int		s_hunkTotal;
 static	int		s_zoneTotal;
 static	int		s_smallZoneTotal;
 
+/*
+==============================================================================
+
+FRAME MEMORY
+
+A pair of bump allocated banks for data that only has to live through
+the current frame.  Com_ClearFrameMemory switches banks at the top of
+each Com_Frame and rewinds the new one, so a block stays valid for the
+rest of the frame it was allocated in and all of the next one.  That
+covers events pushed back by Com_Milliseconds late in a frame, which
+aren't consumed until the next frame's event loop.
+
+Nothing is ever freed individually, and Com_FrameAlloc returns NULL
+rather than growing when a bank is full.
+
+==============================================================================
+*/
+
+#define	FRAME_BANK_SIZE		( 512 * 1024 )
+#define	FRAME_ALIGN			16
+#define	FRAME_POISON		0xcd
+
+static	byte	*s_frameData;
+static	int		s_frameUsed[2];
+static	int		s_frameBank;
+static	int		s_frameHighwater;
+static	int		s_frameOverflows;
+
+/*
+=================
+Com_InitFrameMemory
+=================
+*/
+void Com_InitFrameMemory( void ) {
+	s_frameData = calloc( 2 * FRAME_BANK_SIZE, 1 );
+	if ( !s_frameData ) {
+		Com_Error( ERR_FATAL, "Frame memory failed to allocate %i bytes", 2 * FRAME_BANK_SIZE );
+	}
+	s_frameUsed[0] = s_frameUsed[1] = 0;
+	s_frameBank = 0;
+}
+
+/*
+=================
+Com_ClearFrameMemory
+
+Called at the start of every frame.  Anything allocated two frames
+ago is gone after this.
+=================
+*/
+void Com_ClearFrameMemory( void ) {
+	if ( !s_frameData ) {
+		return;
+	}
+
+	s_frameBank ^= 1;
+
+#ifdef ZONE_DEBUG
+	// anyone still holding on to these will read garbage instead of
+	// stale data that happens to look right
+	Com_Memset( s_frameData + s_frameBank * FRAME_BANK_SIZE, FRAME_POISON, s_frameUsed[s_frameBank] );
+#endif
+	s_frameUsed[s_frameBank] = 0;
+}
+
+/*
+=================
+Com_FrameAlloc
+
+NOT 0 filled memory, valid until the end of the next frame.
+Returns NULL if the current bank is out of space.
+=================
+*/
+void *Com_FrameAlloc( int size ) {
+	byte	*buf;
+	int		used;
+
+	if ( !s_frameData || size < 0 ) {
+		return NULL;
+	}
+
+	size = ( size + FRAME_ALIGN - 1 ) & ~( FRAME_ALIGN - 1 );
+	used = s_frameUsed[s_frameBank];
+	if ( size > FRAME_BANK_SIZE - used ) {
+		return NULL;
+	}
+
+	buf = s_frameData + s_frameBank * FRAME_BANK_SIZE + used;
+	used += size;
+	s_frameUsed[s_frameBank] = used;
+	if ( used > s_frameHighwater ) {
+		s_frameHighwater = used;
+	}
+
+	return buf;
+}
+
+/*
+=================
+Com_FrameOwns
+=================
+*/
+qboolean Com_FrameOwns( const void *ptr ) {
+	if ( !s_frameData ) {
+		return qfalse;
+	}
+	return (const byte *)ptr >= s_frameData && (const byte *)ptr < s_frameData + 2 * FRAME_BANK_SIZE;
+}
+
+/*
+=================
+Com_EventAlloc
+
+Event data comes from frame memory, falling back to the zone when a
+burst of packets fills the bank.  Release it with Com_EventFree.
+=================
+*/
+void *Com_EventAlloc( int size ) {
+	void	*buf;
+
+	buf = Com_FrameAlloc( size );
+	if ( !buf ) {
+		s_frameOverflows++;
+		buf = Z_Malloc( size );
+	}
+	return buf;
+}
+
+/*
+=================
+Com_EventFree
+=================
+*/
+void Com_EventFree( void *ptr ) {
+	if ( Com_PacketOwns( ptr ) ) {
+		Com_FreePacket( ptr );
+	} else if ( !Com_FrameOwns( ptr ) ) {
+		Z_Free( ptr );
+	}
+}
+
+/*
+==============================================================================
+
+PACKET BUFFERS
+
+A fixed set of netPacket_t the platform receives into.  They are handed
+out and returned on the main thread unless a platform network thread
+calls Com_SharePackets, which puts them behind a lock.
+
+==============================================================================
+*/
+
+static	netPacket_t	com_packets[MAX_NET_PACKETS];
+static	int			com_freePackets[MAX_NET_PACKETS];
+static	int			com_numFreePackets;
+static	int			com_packetsHighwater;
+static	int			com_packetsExhausted;
+static	void		*com_packetLock;
+
+/*
+=================
+Com_InitPackets
+=================
+*/
+void Com_InitPackets( void ) {
+	int		i;
+
+	for ( i = 0 ; i < MAX_NET_PACKETS ; i++ ) {
+		com_freePackets[i] = MAX_NET_PACKETS - 1 - i;
+	}
+	com_numFreePackets = MAX_NET_PACKETS;
+}
+
+/*
+=================
+Com_SharePackets
+
+Called before another thread starts allocating packets
+=================
+*/
+void Com_SharePackets( void ) {
+	if ( !com_packetLock ) {
+		com_packetLock = Sys_CreateMutex();
+	}
+}
+
+/*
+=================
+Com_AllocPacket
+=================
+*/
+netPacket_t *Com_AllocPacket( void ) {
+	netPacket_t	*packet;
+	int			inUse;
+
+	if ( com_packetLock ) {
+		Sys_LockMutex( com_packetLock );
+	}
+
+	if ( !com_numFreePackets ) {
+		com_packetsExhausted++;
+		packet = NULL;
+	} else {
+		com_numFreePackets--;
+		inUse = MAX_NET_PACKETS - com_numFreePackets;
+		if ( inUse > com_packetsHighwater ) {
+			com_packetsHighwater = inUse;
+		}
+		packet = &com_packets[ com_freePackets[com_numFreePackets] ];
+	}
+
+	if ( com_packetLock ) {
+		Sys_UnlockMutex( com_packetLock );
+	}
+	return packet;
+}
+
+/*
+=================
+Com_FreePacket
+=================
+*/
+void Com_FreePacket( netPacket_t *packet ) {
+	qboolean	full;
+
+	if ( !Com_PacketOwns( packet ) ) {
+		Com_Error( ERR_FATAL, "Com_FreePacket: bad packet" );
+	}
+
+	if ( com_packetLock ) {
+		Sys_LockMutex( com_packetLock );
+	}
+	full = ( com_numFreePackets == MAX_NET_PACKETS );
+	if ( !full ) {
+		com_freePackets[com_numFreePackets++] = packet - com_packets;
+	}
+	if ( com_packetLock ) {
+		Sys_UnlockMutex( com_packetLock );
+	}
+
+	if ( full ) {
+		Com_Error( ERR_FATAL, "Com_FreePacket: freed a free packet" );
+	}
+}
+
+/*
+=================
+Com_PacketOwns
+=================
+*/
+qboolean Com_PacketOwns( const void *ptr ) {
+	return (const byte *)ptr >= (const byte *)com_packets
+		&& (const byte *)ptr < (const byte *)( com_packets + MAX_NET_PACKETS );
+}
+
+
 
 /*
 =================
@@ -1236,9 +2149,12 @@ void Com_Meminfo_f( void ) {
 	int			zoneBytes, zoneBlocks;
 	int			smallZoneBytes, smallZoneBlocks;
 	int			botlibBytes, rendererBytes;
+	int			freeBlocks, largestFree;
 	int			unused;
 
 	zoneBytes = 0;
+	freeBlocks = 0;
+	largestFree = 0;
 	botlibBytes = 0;
 	rendererBytes = 0;
 	zoneBlocks = 0;
@@ -1255,6 +2171,11 @@ void Com_Meminfo_f( void ) {
 			} else if ( block->tag == TAG_RENDERER ) {
 				rendererBytes += block->size;
 			}
+		} else {
+			freeBlocks++;
+			if ( block->size > largestFree ) {
+				largestFree = block->size;
+			}
 		}
 
 		if (block->next == &mainzone->blocklist) {
@@ -1316,6 +2237,13 @@ void Com_Meminfo_f( void ) {
 	Com_Printf( "        %8i bytes in dynamic renderer\n", rendererBytes );
 	Com_Printf( "        %8i bytes in dynamic other\n", zoneBytes - ( botlibBytes + rendererBytes ) );
 	Com_Printf( "        %8i bytes in small Zone memory\n", smallZoneBytes );
+	Com_Printf( "%8i free zone blocks, largest %i bytes\n", freeBlocks, largestFree );
+	Com_Printf( "\n" );
+	Com_Printf( "%8i bytes per frame memory bank\n", FRAME_BANK_SIZE );
+	Com_Printf( "%8i frame highwater\n", s_frameHighwater );
+	Com_Printf( "%8i event blocks overflowed to the zone\n", s_frameOverflows );
+	Com_Printf( "%8i of %i packet buffers highwater, %i times exhausted\n",
+		com_packetsHighwater, MAX_NET_PACKETS, com_packetsExhausted );
 }
 
 /*
@@ -1379,7 +2307,7 @@ void Com_InitSmallZoneMemory( void ) {
 	if ( !smallzone ) {
 		Com_Error( ERR_FATAL, "Small zone data failed to allocate %1.1f megs", (float)s_smallZoneTotal / (1024*1024) );
 	}
-	Z_ClearZone( smallzone, s_smallZoneTotal );
+	Z_ClearZone( smallzone, s_smallZoneTotal, qtrue );
 	
 	return;
 }
@@ -1400,7 +2328,7 @@ void Com_InitZoneMemory( void ) {
 	if ( !mainzone ) {
 		Com_Error( ERR_FATAL, "Zone data failed to allocate %i megs", s_zoneTotal / (1024*1024) );
 	}
-	Z_ClearZone( mainzone, s_zoneTotal );
+	Z_ClearZone( mainzone, s_zoneTotal, qtrue );
 
 }
 
@@ -1531,6 +2459,8 @@ void Com_InitHunkMemory( void ) {
 	Hunk_Clear();
 
 	Cmd_AddCommand( "meminfo", Com_Meminfo_f );
+	Cmd_AddCommand( "zonetrace", Z_Trace_f );
+	Cmd_AddCommand( "zonebench", Z_Bench_f );
 #ifdef ZONE_DEBUG
 	Cmd_AddCommand( "zonelog", Z_LogHeap );
 #endif
@@ -1941,7 +2871,7 @@ sysEvent_t	Com_GetRealEvent( void ) {
 			Com_Error( ERR_FATAL, "Error reading from journal file" );
 		}
 		if ( ev.evPtrLength ) {
-			ev.evPtr = Z_Malloc( ev.evPtrLength );
+			ev.evPtr = Com_EventAlloc( ev.evPtrLength );
 			r = FS_Read( ev.evPtr, ev.evPtrLength, com_journalFile );
 			if ( r != ev.evPtrLength ) {
 				Com_Error( ERR_FATAL, "Error reading from journal file" );
@@ -2006,7 +2936,7 @@ void Com_PushEvent( sysEvent_t *event ) {
 		}
 
 		if ( ev->evPtr ) {
-			Z_Free( ev->evPtr );
+			Com_EventFree( ev->evPtr );
 		}
 		com_pushedEventsTail++;
 	} else {
@@ -2035,7 +2965,7 @@ sysEvent_t	Com_GetEvent( void ) {
 Com_RunAndTimeServerPacket
 =================
 */
-void Com_RunAndTimeServerPacket( netadr_t *evFrom, msg_t *buf ) {
+void Com_RunAndTimeServerPacket( netadr_t *evFrom, msg_t *buf, int time ) {
 	int		t1, t2, msec;
 
 	t1 = 0;
@@ -2044,7 +2974,7 @@ void Com_RunAndTimeServerPacket( netadr_t *evFrom, msg_t *buf ) {
 		t1 = Sys_Milliseconds ();
 	}
 
-	SV_PacketEvent( *evFrom, buf );
+	SV_PacketEvent( *evFrom, buf, time );
 
 	if ( com_speeds->integer ) {
 		t2 = Sys_Milliseconds ();
@@ -2055,6 +2985,25 @@ void Com_RunAndTimeServerPacket( netadr_t *evFrom, msg_t *buf ) {
 	}
 }
 
+/*
+=================
+Com_FreeDispatchedEvent
+
+Frees the data of the event Com_EventLoop is handling, for Com_Error
+to call before it longjmps past the free.  Otherwise a drop while
+parsing a packet would lose its buffer for good.
+=================
+*/
+static void Com_FreeDispatchedEvent( void ) {
+	void	*ptr;
+
+	ptr = com_dispatchedEvent;
+	com_dispatchedEvent = NULL;
+	if ( ptr ) {
+		Com_EventFree( ptr );
+	}
+}
+
 /*
 =================
 Com_EventLoop
@@ -2066,7 +3015,7 @@ int Com_EventLoop( void ) {
 	sysEvent_t	ev;
 	netadr_t	evFrom;
 	byte		bufData[MAX_MSGLEN];
-	msg_t		buf;
+	msg_t		buf, packetBuf, *msg;
 
 	MSG_Init( &buf, bufData, sizeof( bufData ) );
 	
@@ -2083,7 +3032,7 @@ int Com_EventLoop( void ) {
 			while ( NET_GetLoopPacket( NS_SERVER, &evFrom, &buf ) ) {
 				// if the server just shut down, flush the events
 				if ( com_sv_running->integer ) {
-					Com_RunAndTimeServerPacket( &evFrom, &buf );
+					Com_RunAndTimeServerPacket( &evFrom, &buf, ev.evTime );
 				}
 			}
 
@@ -2091,6 +3040,8 @@ int Com_EventLoop( void ) {
 		}
 
 
+		com_dispatchedEvent = ev.evPtr;
+
 		switch ( ev.evType ) {
 		default:
 		  // bk001129 - was ev.evTime
@@ -2107,6 +3058,9 @@ int Com_EventLoop( void ) {
 		case SE_MOUSE:
 			CL_MouseEvent( ev.evValue, ev.evValue2, ev.evTime );
 			break;
+		case SE_HMD:
+			CL_HMDEvent( ev.evValue, ev.evValue2, ev.evValue3, ev.evValue4, ev.evTime );
+			break;
 		case SE_JOYSTICK_AXIS:
 			CL_JoystickEvent( ev.evValue, ev.evValue2, ev.evTime );
 			break;
@@ -2127,29 +3081,38 @@ int Com_EventLoop( void ) {
 			}
 
 			evFrom = *(netadr_t *)ev.evPtr;
-			buf.cursize = ev.evPtrLength - sizeof( evFrom );
-
-			// we must copy the contents of the message out, because
-			// the event buffers are only large enough to hold the
-			// exact payload, but channel messages need to be large
-			// enough to hold fragment reassembly
-			if ( (unsigned)buf.cursize > buf.maxsize ) {
-				Com_Printf("Com_EventLoop: oversize packet\n");
-				continue;
+
+			if ( Com_PacketOwns( ev.evPtr ) ) {
+				// received straight into a full size buffer, so it
+				// can be parsed and reassembled where it is
+				MSG_Init( &packetBuf, ((netPacket_t *)ev.evPtr)->data, MAX_MSGLEN );
+				packetBuf.cursize = ev.evPtrLength - sizeof( evFrom );
+				msg = &packetBuf;
+			} else {
+				msg = &buf;
+				buf.cursize = ev.evPtrLength - sizeof( evFrom );
+
+				// we must copy the contents of the message out, because
+				// the event buffers are only large enough to hold the
+				// exact payload, but channel messages need to be large
+				// enough to hold fragment reassembly
+				if ( (unsigned)buf.cursize > buf.maxsize ) {
+					Com_Printf("Com_EventLoop: oversize packet\n");
+					break;
+				}
+				Com_Memcpy( buf.data, (byte *)((netadr_t *)ev.evPtr + 1), buf.cursize );
 			}
-			Com_Memcpy( buf.data, (byte *)((netadr_t *)ev.evPtr + 1), buf.cursize );
+
 			if ( com_sv_running->integer ) {
-				Com_RunAndTimeServerPacket( &evFrom, &buf );
+				Com_RunAndTimeServerPacket( &evFrom, msg, ev.evTime );
 			} else {
-				CL_PacketEvent( evFrom, &buf );
+				CL_PacketEvent( evFrom, msg );
 			}
 			break;
 		}
 
 		// free any block data
-		if ( ev.evPtr ) {
-			Z_Free( ev.evPtr );
-		}
+		Com_FreeDispatchedEvent();
 	}
 
 	return 0;	// never reached
@@ -2361,6 +3324,8 @@ void Com_Init( char *commandLine ) {
   Com_InitPushEvent();
 
 	Com_InitSmallZoneMemory();
+	Com_InitFrameMemory();
+	Com_InitPackets();
 	Cvar_Init ();
 
 	// prepare enough of the subsystems to handle
@@ -2652,6 +3617,8 @@ void Com_Frame( void ) {
 		return;			// an ERR_DROP was thrown
 	}
 
+	Com_ClearFrameMemory();
+
 	// bk001204 - init to zero.
 	//  also:  might be clobbered by `longjmp' or `vfork'
 	timeBeforeFirstEvents =0;
@@ -2803,6 +3770,8 @@ Com_Shutdown
 =================
 */
 void Com_Shutdown (void) {
+	Z_StopTrace();
+
 	if (logfile) {
 		FS_FCloseFile (logfile);
 		logfile = 0;
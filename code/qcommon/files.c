@@ -410,6 +410,37 @@ static FILE	*FS_FileForHandle( fileHandle_t f ) {
 	return fsh[f].handleFiles.file.o;
 }
 
+/*
+================
+FS_ThreadSafeRead
+
+A file outside a pak has its own FILE.  A file in a pak needs its own
+unzFile, and it has to be stored rather than compressed, because
+inflating allocates from the zone.
+================
+*/
+qboolean FS_ThreadSafeRead( fileHandle_t f, FILE **file ) {
+	unz_file_info	info;
+
+	*file = NULL;
+	if ( f <= 0 || f >= MAX_FILE_HANDLES ) {
+		return qfalse;
+	}
+
+	if ( fsh[f].zipFile == qfalse ) {
+		*file = fsh[f].handleFiles.file.o;
+		return *file != NULL;
+	}
+
+	if ( !fsh[f].handleFiles.unique ) {
+		return qfalse;
+	}
+	if ( unzGetCurrentFileInfo( fsh[f].handleFiles.file.z, &info, NULL, 0, NULL, 0, NULL, 0 ) != UNZ_OK ) {
+		return qfalse;
+	}
+	return info.compression_method == 0;
+}
+
 void	FS_ForceFlush( fileHandle_t f ) {
 	FILE *file;
 
@@ -821,9 +852,9 @@ void FS_FCloseFile( fileHandle_t f ) {
 		Com_Error( ERR_FATAL, "Filesystem call made without initialization\n" );
 	}
 
-	if (fsh[f].streamed) {
-		Sys_EndStreamedFile(f);
-	}
+	// cinematics and background music begin their streams directly,
+	// so stop the stream whether or not FS_FOpenFileRead started it
+	Sys_EndStreamedFile(f);
 	if (fsh[f].zipFile == qtrue) {
 		unzCloseCurrentFile( fsh[f].handleFiles.file.z );
 		if ( fsh[f].handleFiles.unique ) {
@@ -1377,9 +1408,11 @@ int FS_Seek( fileHandle_t f, long offset, int origin ) {
 	}
 
 	if (fsh[f].streamed) {
+		// the stream seeks the file itself, relative to what it has returned
 		fsh[f].streamed = qfalse;
 		Sys_StreamSeek( f, offset, origin );
 		fsh[f].streamed = qtrue;
+		return 0;
 	}
 
 	if (fsh[f].zipFile == qtrue) {
@@ -2653,6 +2686,8 @@ void FS_Shutdown( qboolean closemfp ) {
 	searchpath_t	*p, *next;
 	int	i;
 
+	Z_SuspendTrace();
+
 	for(i = 0; i < MAX_FILE_HANDLES; i++) {
 		if (fsh[i].fileSize) {
 			FS_FCloseFile(i);
@@ -3291,6 +3326,8 @@ void FS_Restart( int checksumFeed ) {
 	// try to start up normally
 	FS_Startup( BASEGAME );
 
+	Z_ResumeTrace();
+
 	// see if we are going to allow add-ons
 	FS_SetRestrictions();
 
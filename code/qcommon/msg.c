@@ -655,6 +655,9 @@ void MSG_WriteDeltaUsercmd( msg_t *msg, usercmd_t *from, usercmd_t *to ) {
 	MSG_WriteDelta( msg, from->upmove, to->upmove, 8 );
 	MSG_WriteDelta( msg, from->buttons, to->buttons, 16 );
 	MSG_WriteDelta( msg, from->weapon, to->weapon, 8 );
+	MSG_WriteDelta( msg, from->hangles[0], to->hangles[0], 16 );
+	MSG_WriteDelta( msg, from->hangles[1], to->hangles[1], 16 );
+	MSG_WriteDelta( msg, from->hangles[2], to->hangles[2], 16 );
 }
 
 
@@ -677,6 +680,9 @@ void MSG_ReadDeltaUsercmd( msg_t *msg, usercmd_t *from, usercmd_t *to ) {
 	to->upmove = MSG_ReadDelta( msg, from->upmove, 8);
 	to->buttons = MSG_ReadDelta( msg, from->buttons, 16);
 	to->weapon = MSG_ReadDelta( msg, from->weapon, 8);
+	to->hangles[0] = MSG_ReadDelta( msg, from->hangles[0], 16);
+	to->hangles[1] = MSG_ReadDelta( msg, from->hangles[1], 16);
+	to->hangles[2] = MSG_ReadDelta( msg, from->hangles[2], 16);
 }
 
 /*
@@ -699,7 +705,10 @@ void MSG_WriteDeltaUsercmdKey( msg_t *msg, int key, usercmd_t *from, usercmd_t *
 		from->rightmove == to->rightmove &&
 		from->upmove == to->upmove &&
 		from->buttons == to->buttons &&
-		from->weapon == to->weapon) {
+		from->weapon == to->weapon &&
+		from->hangles[0] == to->hangles[0] &&
+		from->hangles[1] == to->hangles[1] &&
+		from->hangles[2] == to->hangles[2]) {
 			MSG_WriteBits( msg, 0, 1 );				// no change
 			oldsize += 7;
 			return;
@@ -714,6 +723,9 @@ void MSG_WriteDeltaUsercmdKey( msg_t *msg, int key, usercmd_t *from, usercmd_t *
 	MSG_WriteDeltaKey( msg, key, from->upmove, to->upmove, 8 );
 	MSG_WriteDeltaKey( msg, key, from->buttons, to->buttons, 16 );
 	MSG_WriteDeltaKey( msg, key, from->weapon, to->weapon, 8 );
+	MSG_WriteDeltaKey( msg, key, from->hangles[0], to->hangles[0], 16 );
+	MSG_WriteDeltaKey( msg, key, from->hangles[1], to->hangles[1], 16 );
+	MSG_WriteDeltaKey( msg, key, from->hangles[2], to->hangles[2], 16 );
 }
 
 
@@ -738,6 +750,9 @@ void MSG_ReadDeltaUsercmdKey( msg_t *msg, int key, usercmd_t *from, usercmd_t *t
 		to->upmove = MSG_ReadDeltaKey( msg, key, from->upmove, 8);
 		to->buttons = MSG_ReadDeltaKey( msg, key, from->buttons, 16);
 		to->weapon = MSG_ReadDeltaKey( msg, key, from->weapon, 8);
+		to->hangles[0] = MSG_ReadDeltaKey( msg, key, from->hangles[0], 16);
+		to->hangles[1] = MSG_ReadDeltaKey( msg, key, from->hangles[1], 16);
+		to->hangles[2] = MSG_ReadDeltaKey( msg, key, from->hangles[2], 16);
 	} else {
 		to->angles[0] = from->angles[0];
 		to->angles[1] = from->angles[1];
@@ -747,6 +762,9 @@ void MSG_ReadDeltaUsercmdKey( msg_t *msg, int key, usercmd_t *from, usercmd_t *t
 		to->upmove = from->upmove;
 		to->buttons = from->buttons;
 		to->weapon = from->weapon;
+		to->hangles[0] = from->hangles[0];
+		to->hangles[1] = from->hangles[1];
+		to->hangles[2] = from->hangles[2];
 	}
 }
 
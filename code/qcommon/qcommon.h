@@ -169,6 +169,22 @@ void		NET_Sleep(int msec);
 #define	MAX_MSGLEN				16384		// max length of a message, which may
 											// be fragmented into multiple packets
 
+// full size receive buffers, the platform can receive straight into
+// one and queue it as the evPtr of an SE_PACKET event, which is then
+// parsed and reassembled in place instead of copied
+typedef struct {
+	netadr_t	adr;
+	byte		data[MAX_MSGLEN];
+} netPacket_t;
+
+#define	MAX_NET_PACKETS			256
+
+void		Com_InitPackets( void );
+void		Com_SharePackets( void );
+netPacket_t	*Com_AllocPacket( void );		// NULL when they are all in use
+void		Com_FreePacket( netPacket_t *packet );
+qboolean	Com_PacketOwns( const void *ptr );
+
 #define MAX_DOWNLOAD_WINDOW			8		// max of eight download frames
 #define MAX_DOWNLOAD_BLKSIZE		2048	// 2048 byte block chunks
  
@@ -219,8 +235,9 @@ PROTOCOL
 ==============================================================
 */
 
-#define	PROTOCOL_VERSION	68
+#define	PROTOCOL_VERSION	69
 // 1.31 - 67
+// 68 with head angles in the usercmd - 69
 
 // maintain a list of compatible protocols for demo playing
 // NOTE: that stuff only works with two digits protocols
@@ -599,6 +616,10 @@ int		FS_FOpenFileByMode( const char *qpath, fileHandle_t *f, fsMode_t mode );
 int		FS_Seek( fileHandle_t f, long offset, int origin );
 // seek on a file (doesn't work for zip files!!!!!!!!)
 
+qboolean FS_ThreadSafeRead( fileHandle_t f, FILE **file );
+// true if FS_Read on the handle can run on another thread, file gets the
+// FILE of a handle outside a pak file
+
 qboolean FS_FilenameCompare( const char *s1, const char *s2 );
 
 const char *FS_GamePureChecksum( void );
@@ -792,6 +813,8 @@ void Z_Free( void *ptr );
 void Z_FreeTags( int tag );
 int Z_AvailableMemory( void );
 void Z_LogHeap( void );
+void Z_SuspendTrace( void );
+void Z_ResumeTrace( void );
 
 void Hunk_Clear( void );
 void Hunk_ClearToMark( void );
@@ -806,6 +829,14 @@ void Hunk_Trash( void );
 
 void Com_TouchMemory( void );
 
+// frame lifetime memory, valid until the end of the next frame
+void Com_InitFrameMemory( void );
+void Com_ClearFrameMemory( void );
+void *Com_FrameAlloc( int size );		// NOT 0 filled, NULL when out of space
+qboolean Com_FrameOwns( const void *ptr );
+void *Com_EventAlloc( int size );		// sysEvent_t evPtr data
+void Com_EventFree( void *ptr );
+
 // commandLine should not include the executable name (argv[0])
 void Com_Init( char *commandLine );
 void Com_Frame( void );
@@ -885,7 +916,7 @@ void SCR_DebugGraph (float value, int color);	// FIXME: move logging to common?
 void SV_Init( void );
 void SV_Shutdown( char *finalmsg );
 void SV_Frame( int msec );
-void SV_PacketEvent( netadr_t from, msg_t *msg );
+void SV_PacketEvent( netadr_t from, msg_t *msg, int time );	// time is when it arrived, in Sys_Milliseconds
 qboolean SV_GameCommand( void );
 
 
@@ -919,7 +950,7 @@ typedef enum {
 	SE_KEY,		// evValue is a key code, evValue2 is the down flag
 	SE_CHAR,	// evValue is an ascii char
 	SE_MOUSE,	// evValue and evValue2 are reletive signed x / y moves
-	SE_HMD,
+	SE_HMD,		// evValue to evValue3 are head pitch / yaw / roll in millionths of a degree
 	SE_JOYSTICK_AXIS,	// evValue is an axis number and evValue2 is the current state (-127 to 127)
 	SE_CONSOLE,	// evPtr is a char*
 	SE_PACKET	// evPtr is a netadr_t followed by data bytes to evPtrLength
@@ -930,7 +961,7 @@ typedef struct {
 	sysEventType_t	evType;
 	int				evValue, evValue2, evValue3, evValue4;
 	int				evPtrLength;	// bytes of data pointed to by evPtr, for journaling
-	void			*evPtr;			// this must be manually freed if not NULL
+	void			*evPtr;			// release with Com_EventFree if not NULL
 } sysEvent_t;
 
 sysEvent_t	Sys_GetEvent( void );
@@ -975,6 +1006,8 @@ void	Sys_DisplaySystemConsole( qboolean show );
 
 int		Sys_GetProcessorId( void );
 
+void	Sys_InitStreamThread( void );
+void	Sys_ShutdownStreamThread( void );
 void	Sys_BeginStreamedFile( fileHandle_t f, int readahead );
 void	Sys_EndStreamedFile( fileHandle_t f );
 int		Sys_StreamedRead( void *buffer, int size, int count, fileHandle_t f );
@@ -1011,6 +1044,22 @@ void	Sys_EndProfiling( void );
 qboolean Sys_LowPhysicalMemory();
 unsigned int Sys_ProcessorCount();
 
+// threads for work that runs beside the main loop, Sys_CreateThread
+// returns NULL if the platform can't start one and the caller should
+// fall back to doing the work inline
+void	*Sys_CreateThread( void (*function)( void *arg ), void *arg );
+void	Sys_JoinThread( void *thread );
+void	*Sys_CreateMutex( void );
+void	Sys_DestroyMutex( void *mutex );
+void	Sys_LockMutex( void *mutex );		// recursive
+void	Sys_UnlockMutex( void *mutex );
+void	*Sys_CreateCondition( void );
+void	Sys_DestroyCondition( void *cond );
+void	Sys_WaitCondition( void *cond, void *mutex );	// mutex locked once by the caller
+void	Sys_WakeCondition( void *cond );		// wakes every waiter
+void	Sys_Sleep( int msec );
+void	Sys_MemoryBarrier( void );			// for lock-free queues between threads
+
 int Sys_MonkeyShouldBeSpanked( void );
 
 /* This is based on the Adaptive Huffman algorithm described in Sayood's Data
@@ -68,6 +68,8 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 #endif
 
+#include <stddef.h>		// ptrdiff_t for buffer sizes
+
 #ifndef APIENTRY
 #define APIENTRY
 #endif
@@ -146,6 +148,16 @@ typedef void (APIENTRY * PFNGLCLIENTACTIVETEXTUREARBPROC) (GLenum target);
 #define GL_RGB_S3TC							0x83A0
 #define GL_RGB4_S3TC						0x83A1
 
+// GL_ARB_vertex_buffer_object
+#define GL_ARRAY_BUFFER_ARB					0x8892
+#define GL_ELEMENT_ARRAY_BUFFER_ARB			0x8893
+#define GL_STATIC_DRAW_ARB					0x88E4
+
+// GL_ARB_occlusion_query
+#define GL_SAMPLES_PASSED_ARB				0x8914
+#define GL_QUERY_RESULT_ARB					0x8866
+#define GL_QUERY_RESULT_AVAILABLE_ARB		0x8867
+
 
 // extensions will be function pointers on all platforms
 
@@ -156,6 +168,19 @@ extern	void ( APIENTRY * qglClientActiveTextureARB )( GLenum texture );
 extern	void ( APIENTRY * qglLockArraysEXT) (GLint, GLint);
 extern	void ( APIENTRY * qglUnlockArraysEXT) (void);
 
+extern	void ( APIENTRY * qglBindBufferARB )( GLenum target, GLuint buffer );
+extern	void ( APIENTRY * qglDeleteBuffersARB )( GLsizei n, const GLuint *buffers );
+extern	void ( APIENTRY * qglGenBuffersARB )( GLsizei n, GLuint *buffers );
+extern	void ( APIENTRY * qglBufferDataARB )( GLenum target, ptrdiff_t size, const GLvoid *data, GLenum usage );
+
+extern	void ( APIENTRY * qglMultiDrawElementsEXT )( GLenum mode, const GLsizei *count, GLenum type, const GLvoid **indices, GLsizei primcount );
+
+extern	void ( APIENTRY * qglGenQueriesARB )( GLsizei n, GLuint *ids );
+extern	void ( APIENTRY * qglDeleteQueriesARB )( GLsizei n, const GLuint *ids );
+extern	void ( APIENTRY * qglBeginQueryARB )( GLenum target, GLuint id );
+extern	void ( APIENTRY * qglEndQueryARB )( GLenum target );
+extern	void ( APIENTRY * qglGetQueryObjectivARB )( GLuint id, GLenum pname, GLint *params );
+
 //===========================================================================
 
 // non-windows systems will just redefine qgl* to gl*
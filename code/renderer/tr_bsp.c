@@ -1351,6 +1351,141 @@ static	void R_SetParent (mnode_t *node, mnode_t *parent)
 	R_SetParent (node->children[1], node);
 }
 
+/*
+=================
+R_SetWorldJobs_r
+=================
+*/
+static void R_SetWorldJobs_r( mnode_t *node, int depth, int job ) {
+	msurface_t	*surf;
+	int			i;
+
+	node->worldJob = -1;
+	if ( job < 0 && ( depth == WORLDJOB_DEPTH || node->contents != CONTENTS_NODE ) ) {
+		job = s_worldData.numWorldJobs++;
+		node->worldJob = job;
+	}
+
+	if ( node->contents == CONTENTS_NODE ) {
+		R_SetWorldJobs_r( node->children[0], depth + 1, job );
+		R_SetWorldJobs_r( node->children[1], depth + 1, job );
+		return;
+	}
+
+	for ( i = 0 ; i < node->nummarksurfaces ; i++ ) {
+		surf = node->firstmarksurface[i];
+		if ( surf->worldJob == WORLDJOB_NONE ) {
+			surf->worldJob = job;
+		} else if ( surf->worldJob != job ) {
+			surf->worldJob = WORLDJOB_SHARED;
+		}
+	}
+}
+
+/*
+=================
+R_SetWorldJobs
+
+Numbers the subtrees that front end jobs walk in parallel, and finds
+the surfaces marked by leafs in more than one of them
+=================
+*/
+static void R_SetWorldJobs( void ) {
+	mnode_t		*leaf;
+	int			i, j;
+
+	for ( i = 0 ; i < s_worldData.numsurfaces ; i++ ) {
+		s_worldData.surfaces[i].worldJob = WORLDJOB_NONE;
+	}
+
+	s_worldData.numWorldJobs = 0;
+	R_SetWorldJobs_r( s_worldData.nodes, 0, -1 );
+
+	s_worldData.numSharedMarks = 0;
+	leaf = s_worldData.nodes + s_worldData.numDecisionNodes;
+	for ( i = s_worldData.numDecisionNodes ; i < s_worldData.numnodes ; i++, leaf++ ) {
+		for ( j = 0 ; j < leaf->nummarksurfaces ; j++ ) {
+			if ( leaf->firstmarksurface[j]->worldJob == WORLDJOB_SHARED ) {
+				s_worldData.numSharedMarks++;
+			}
+		}
+	}
+}
+
+/*
+=================
+R_SetLeafOrder_r
+=================
+*/
+static void R_SetLeafOrder_r( mnode_t *node ) {
+	if ( node->worldJob >= 0 ) {
+		s_worldData.jobFirstLeaf[ node->worldJob ] = s_worldData.numLeafs;
+	}
+
+	if ( node->contents == CONTENTS_NODE ) {
+		R_SetLeafOrder_r( node->children[0] );
+		R_SetLeafOrder_r( node->children[1] );
+		return;
+	}
+
+	s_worldData.leafOrder[ s_worldData.numLeafs++ ] = node;
+}
+
+/*
+=================
+R_SetVisLeafs
+
+Numbers the leafs depth first and groups them by cluster, so the
+visible leaf lists can be built from the clusters in the PVS without
+looking at every leaf.  Needs the cluster count from R_LoadVisibility.
+=================
+*/
+static void R_SetVisLeafs( void ) {
+	int		*first;
+	int		numLeafs, numClusters, maxChunks;
+	int		i, cluster;
+
+	numLeafs = s_worldData.numnodes - s_worldData.numDecisionNodes;
+	numClusters = s_worldData.numClusters;
+
+	s_worldData.leafOrder = ri.Hunk_Alloc( numLeafs * sizeof( *s_worldData.leafOrder ), h_low );
+	s_worldData.numLeafs = 0;
+	R_SetLeafOrder_r( s_worldData.nodes );
+	s_worldData.jobFirstLeaf[ s_worldData.numWorldJobs ] = s_worldData.numLeafs;
+
+	// counting sort, which keeps each cluster's leafs depth first
+	first = ri.Hunk_Alloc( ( numClusters + 1 ) * sizeof( *first ), h_low );
+	s_worldData.clusterFirstLeaf = first;
+	s_worldData.clusterLeafs = ri.Hunk_Alloc( numLeafs * sizeof( *s_worldData.clusterLeafs ), h_low );
+	for ( i = 0 ; i < numLeafs ; i++ ) {
+		cluster = s_worldData.leafOrder[i]->cluster;
+		if ( cluster >= 0 && cluster < numClusters ) {
+			first[ cluster + 1 ]++;
+		}
+	}
+	for ( i = 0 ; i < numClusters ; i++ ) {
+		first[ i + 1 ] += first[i];
+	}
+	for ( i = 0 ; i < numLeafs ; i++ ) {
+		cluster = s_worldData.leafOrder[i]->cluster;
+		if ( cluster >= 0 && cluster < numClusters ) {
+			s_worldData.clusterLeafs[ first[cluster]++ ] = i;
+		}
+	}
+	// the inserts moved every start up to the next cluster's
+	for ( i = numClusters ; i > 0 ; i-- ) {
+		first[i] = first[ i - 1 ];
+	}
+	first[0] = 0;
+
+	// a chunk ends at VISCHUNK_LEAFS leafs or at the end of a world job
+	maxChunks = numLeafs / VISCHUNK_LEAFS + MAX_WORLD_JOBS + 1;
+	for ( i = 0 ; i < MAX_VISLISTS ; i++ ) {
+		s_worldData.visLists[i].leafs = ri.Hunk_Alloc( numLeafs * sizeof( int ), h_low );
+		s_worldData.visLists[i].chunks = ri.Hunk_Alloc( maxChunks * sizeof( visChunk_t ), h_low );
+	}
+}
+
 /*
 =================
 R_LoadNodesAndLeafs
@@ -1425,6 +1560,8 @@ static	void R_LoadNodesAndLeafs (lump_t *nodeLump, lump_t *leafLump) {
 
 	// chain decendants
 	R_SetParent (s_worldData.nodes, NULL);
+
+	R_SetWorldJobs ();
 }
 
 //=============================================================================
@@ -1779,6 +1916,255 @@ qboolean R_GetEntityToken( char *buffer, int size ) {
 	}
 }
 
+/*
+=================
+R_SurfaceBufferSize
+
+Returns qfalse if the surface has to keep going through tess
+=================
+*/
+static qboolean R_SurfaceBufferSize( msurface_t *surf, int *numVerts, int *numIndexes ) {
+	srfSurfaceFace_t	*face;
+	srfGridMesh_t		*grid;
+	srfTriangles_t		*tri;
+	int					i, *indexes;
+
+	if ( !surf->shader->staticGeometry ) {
+		return qfalse;
+	}
+
+	switch ( *surf->data ) {
+	case SF_FACE:
+		face = (srfSurfaceFace_t *)surf->data;
+		// faces clipped to MAX_FACE_POINTS may index past their points
+		indexes = (int *)( (byte *)face + face->ofsIndices );
+		for ( i = 0 ; i < face->numIndices ; i++ ) {
+			if ( indexes[i] < 0 || indexes[i] >= face->numPoints ) {
+				return qfalse;
+			}
+		}
+		*numVerts = face->numPoints;
+		*numIndexes = face->numIndices;
+		return qtrue;
+	case SF_GRID:
+		grid = (srfGridMesh_t *)surf->data;
+		*numVerts = grid->width * grid->height;
+		*numIndexes = ( grid->width - 1 ) * ( grid->height - 1 ) * 6;
+		return qtrue;
+	case SF_TRIANGLES:
+		tri = (srfTriangles_t *)surf->data;
+		*numVerts = tri->numVerts;
+		*numIndexes = tri->numIndexes;
+		return qtrue;
+	default:
+		return qfalse;
+	}
+}
+
+/*
+=================
+R_CompareBufferSurfaces
+
+Shader by shader, and in map order within a shader so that
+neighbouring visible surfaces merge into one index range
+=================
+*/
+static int R_CompareBufferSurfaces( const void *a, const void *b ) {
+	msurface_t	*sa, *sb;
+
+	sa = *(msurface_t **)a;
+	sb = *(msurface_t **)b;
+
+	if ( sa->shader->index != sb->shader->index ) {
+		return sa->shader->index - sb->shader->index;
+	}
+	return sa - sb;
+}
+
+/*
+=================
+R_CopyBufferVert
+=================
+*/
+static void R_CopyBufferVert( const drawVert_t *dv, bufferVert_t *v ) {
+	VectorCopy( dv->xyz, v->xyz );
+	v->st[0] = dv->st[0];
+	v->st[1] = dv->st[1];
+	v->lightmap[0] = dv->lightmap[0];
+	v->lightmap[1] = dv->lightmap[1];
+	*(int *)v->color = *(int *)dv->color;
+}
+
+/*
+=================
+R_BuildWorldBuffers
+
+Static surfaces whose shaders compute nothing per vertex are copied
+once into a vertex and an index buffer, so the back end only has to
+queue their index ranges
+=================
+*/
+static void R_BuildWorldBuffers( void ) {
+	int				i, j, k;
+	int				numSurfs, numVerts, numIndexes;
+	int				surfVerts, surfIndexes;
+	int				*firstBufferIndex, *numBufferIndexes;
+	msurface_t		**surfs;
+	bufferVert_t	*verts, *v;
+	glIndex_t		*indexes, *ndx;
+	srfSurfaceFace_t	*face;
+	srfGridMesh_t	*grid;
+	srfTriangles_t	*tri;
+	float			*point;
+	int				*faceIndexes;
+
+	if ( !qglBindBufferARB ) {
+		return;
+	}
+
+	surfs = ri.Hunk_AllocateTempMemory( s_worldData.numsurfaces * sizeof( *surfs ) );
+
+	numSurfs = 0;
+	numVerts = 0;
+	numIndexes = 0;
+	for ( i = 0 ; i < s_worldData.numsurfaces ; i++ ) {
+		if ( !R_SurfaceBufferSize( &s_worldData.surfaces[i], &surfVerts, &surfIndexes ) ) {
+			continue;
+		}
+		surfs[numSurfs++] = &s_worldData.surfaces[i];
+		numVerts += surfVerts;
+		numIndexes += surfIndexes;
+	}
+
+	if ( !numIndexes ) {
+		ri.Hunk_FreeTempMemory( surfs );
+		return;
+	}
+
+	qsort( surfs, numSurfs, sizeof( *surfs ), R_CompareBufferSurfaces );
+
+	verts = ri.Hunk_AllocateTempMemory( numVerts * sizeof( *verts ) );
+	indexes = ri.Hunk_AllocateTempMemory( numIndexes * sizeof( *indexes ) );
+
+	numVerts = 0;
+	numIndexes = 0;
+	for ( i = 0 ; i < numSurfs ; i++ ) {
+		R_SurfaceBufferSize( surfs[i], &surfVerts, &surfIndexes );
+
+		v = verts + numVerts;
+		ndx = indexes + numIndexes;
+
+		switch ( *surfs[i]->data ) {
+		case SF_FACE:
+			face = (srfSurfaceFace_t *)surfs[i]->data;
+			for ( j = 0 ; j < face->numPoints ; j++ ) {
+				point = face->points[j];
+				VectorCopy( point, v[j].xyz );
+				v[j].st[0] = point[3];
+				v[j].st[1] = point[4];
+				v[j].lightmap[0] = point[5];
+				v[j].lightmap[1] = point[6];
+				*(int *)v[j].color = *(int *)&point[7];
+			}
+			faceIndexes = (int *)( (byte *)face + face->ofsIndices );
+			for ( j = 0 ; j < face->numIndices ; j++ ) {
+				ndx[j] = numVerts + faceIndexes[j];
+			}
+			firstBufferIndex = &face->firstBufferIndex;
+			numBufferIndexes = &face->numBufferIndexes;
+			break;
+		case SF_GRID:
+			grid = (srfGridMesh_t *)surfs[i]->data;
+			for ( j = 0 ; j < surfVerts ; j++ ) {
+				R_CopyBufferVert( &grid->verts[j], &v[j] );
+			}
+			// same triangulation as RB_SurfaceGrid at full detail
+			for ( j = 0 ; j < grid->height - 1 ; j++ ) {
+				for ( k = 0 ; k < grid->width - 1 ; k++ ) {
+					int		v1, v2, v3, v4;
+
+					v1 = numVerts + j*grid->width + k + 1;
+					v2 = v1 - 1;
+					v3 = v2 + grid->width;
+					v4 = v3 + 1;
+
+					ndx[0] = v2;
+					ndx[1] = v3;
+					ndx[2] = v1;
+
+					ndx[3] = v1;
+					ndx[4] = v3;
+					ndx[5] = v4;
+					ndx += 6;
+				}
+			}
+			firstBufferIndex = &grid->firstBufferIndex;
+			numBufferIndexes = &grid->numBufferIndexes;
+			break;
+		case SF_TRIANGLES:
+		default:
+			tri = (srfTriangles_t *)surfs[i]->data;
+			for ( j = 0 ; j < tri->numVerts ; j++ ) {
+				R_CopyBufferVert( &tri->verts[j], &v[j] );
+			}
+			for ( j = 0 ; j < tri->numIndexes ; j++ ) {
+				ndx[j] = numVerts + tri->indexes[j];
+			}
+			firstBufferIndex = &tri->firstBufferIndex;
+			numBufferIndexes = &tri->numBufferIndexes;
+			break;
+		}
+
+		// rgbGen vertex is scaled by the overbright range, which is
+		// fixed for the life of the map
+		for ( j = 0 ; j < surfVerts ; j++ ) {
+			v[j].litColor[0] = v[j].color[0] * tr.identityLight;
+			v[j].litColor[1] = v[j].color[1] * tr.identityLight;
+			v[j].litColor[2] = v[j].color[2] * tr.identityLight;
+			v[j].litColor[3] = v[j].color[3];
+		}
+
+		*firstBufferIndex = numIndexes;
+		*numBufferIndexes = surfIndexes;
+
+		numVerts += surfVerts;
+		numIndexes += surfIndexes;
+	}
+
+	qglGenBuffersARB( 1, &s_worldData.vertexBuffer );
+	qglBindBufferARB( GL_ARRAY_BUFFER_ARB, s_worldData.vertexBuffer );
+	qglBufferDataARB( GL_ARRAY_BUFFER_ARB, numVerts * sizeof( *verts ), verts, GL_STATIC_DRAW_ARB );
+	qglBindBufferARB( GL_ARRAY_BUFFER_ARB, 0 );
+
+	qglGenBuffersARB( 1, &s_worldData.indexBuffer );
+	qglBindBufferARB( GL_ELEMENT_ARRAY_BUFFER_ARB, s_worldData.indexBuffer );
+	qglBufferDataARB( GL_ELEMENT_ARRAY_BUFFER_ARB, numIndexes * sizeof( *indexes ), indexes, GL_STATIC_DRAW_ARB );
+	qglBindBufferARB( GL_ELEMENT_ARRAY_BUFFER_ARB, 0 );
+
+	ri.Hunk_FreeTempMemory( indexes );
+	ri.Hunk_FreeTempMemory( verts );
+	ri.Hunk_FreeTempMemory( surfs );
+
+	ri.Printf( PRINT_ALL, "...%i of %i surfaces in world buffers, %i verts, %i indexes\n",
+		numSurfs, s_worldData.numsurfaces, numVerts, numIndexes );
+}
+
+/*
+=================
+R_DeleteWorldBuffers
+=================
+*/
+void R_DeleteWorldBuffers( void ) {
+	if ( s_worldData.vertexBuffer ) {
+		qglDeleteBuffersARB( 1, &s_worldData.vertexBuffer );
+		s_worldData.vertexBuffer = 0;
+	}
+	if ( s_worldData.indexBuffer ) {
+		qglDeleteBuffersARB( 1, &s_worldData.indexBuffer );
+		s_worldData.indexBuffer = 0;
+	}
+}
+
 /*
 =================
 RE_LoadWorldMap
@@ -1849,8 +2235,10 @@ void RE_LoadWorldMap( const char *name ) {
 	R_LoadNodesAndLeafs (&header->lumps[LUMP_NODES], &header->lumps[LUMP_LEAFS]);
 	R_LoadSubmodels (&header->lumps[LUMP_MODELS]);
 	R_LoadVisibility( &header->lumps[LUMP_VISIBILITY] );
+	R_SetVisLeafs();
 	R_LoadEntities( &header->lumps[LUMP_ENTITIES] );
 	R_LoadLightGrid( &header->lumps[LUMP_LIGHTGRID] );
+	R_BuildWorldBuffers();
 
 	s_worldData.dataSize = (byte *)ri.Hunk_Alloc(0, h_low) - startMarker;
 
@@ -36,6 +36,8 @@ void R_PerformanceCounters( void ) {
 		// clear the counters even if we aren't printing
 		Com_Memset( &tr.pc, 0, sizeof( tr.pc ) );
 		Com_Memset( &backEnd.pc, 0, sizeof( backEnd.pc ) );
+		tr.stereoMsec[0] = tr.stereoMsec[1] = 0;
+		tr.stereoReplays = tr.stereoRenders = 0;
 		return;
 	}
 
@@ -66,9 +68,17 @@ void R_PerformanceCounters( void ) {
 	}
 	else if (r_speeds->integer == 6 )
 	{
-		ri.Printf( PRINT_ALL, "flare adds:%i tests:%i renders:%i\n", 
-			backEnd.pc.c_flareAdds, backEnd.pc.c_flareTests, backEnd.pc.c_flareRenders );
+		ri.Printf( PRINT_ALL, "flare adds:%i tests:%i renders:%i stalls:%i\n", 
+			backEnd.pc.c_flareAdds, backEnd.pc.c_flareTests, backEnd.pc.c_flareRenders, backEnd.pc.c_flareStalls );
 	}
+	else if (r_speeds->integer == 7 )
+	{
+		ri.Printf( PRINT_ALL, "stereo front end: left %i msec, right %i msec, %i scenes replayed, %i rendered\n",
+			tr.stereoMsec[0], tr.stereoMsec[1], tr.stereoReplays, tr.stereoRenders );
+	}
+
+	tr.stereoMsec[0] = tr.stereoMsec[1] = 0;
+	tr.stereoReplays = tr.stereoRenders = 0;
 
 	Com_Memset( &tr.pc, 0, sizeof( tr.pc ) );
 	Com_Memset( &backEnd.pc, 0, sizeof( backEnd.pc ) );
@@ -313,6 +323,13 @@ void RE_BeginFrame( stereoFrame_t stereoFrame ) {
 	tr.frameCount++;
 	tr.frameSceneNum = 0;
 
+	tr.stereoFrame = stereoFrame;
+	if ( stereoFrame == STEREO_RIGHT ) {
+		tr.stereoSceneNum = 0;
+	} else {
+		tr.numStereoScenes = 0;
+	}
+
 	//
 	// do overdraw measurement
 	//
@@ -40,6 +40,11 @@ After all opaque surfaces have been rendered, the depth buffer is read back for
 each flare in view.  If the point has not been obscured by a closer surface, the
 flare should be drawn.
 
+With GL_ARB_occlusion_query the readback is replaced by a query that draws the
+point, and the answer is picked up by the next test of the same flare, so the
+card never has to catch up with the cpu in the middle of a frame.  A flare
+shows or hides a frame late, which the fade covers.
+
 Surfaces that have a repeated texture should never be flagged as flaring, because
 there will only be a single flare added at the midpoint of the polygon.
 
@@ -73,7 +78,10 @@ typedef struct flare_s {
 	float		drawIntensity;		// may be non 0 even if !visible due to fading
 
 	int			windowX, windowY;
-	float		eyeZ;
+	float		eyeX, eyeY, eyeZ;
+
+	qboolean	queryPending;		// query issued, result not read yet
+	int			queryTime;			// refdef time the query was issued
 
 	vec3_t		color;
 } flare_t;
@@ -83,6 +91,8 @@ typedef struct flare_s {
 flare_t		r_flareStructs[MAX_FLARES];
 flare_t		*r_activeFlares, *r_inactiveFlares;
 
+static GLuint	r_flareQueries[MAX_FLARES];	// one per flare_t, outlives R_ClearFlares
+
 /*
 ==================
 R_ClearFlares
@@ -101,6 +111,18 @@ void R_ClearFlares( void ) {
 	}
 }
 
+/*
+==================
+R_DeleteFlareQueries
+==================
+*/
+void R_DeleteFlareQueries( void ) {
+	if ( r_flareQueries[0] ) {
+		qglDeleteQueriesARB( MAX_FLARES, r_flareQueries );
+		Com_Memset( r_flareQueries, 0, sizeof( r_flareQueries ) );
+	}
+}
+
 
 /*
 ==================
@@ -166,6 +188,7 @@ void RB_AddFlare( void *surface, int fogNum, vec3_t point, vec3_t color, vec3_t
 	if ( f->addedFrame != backEnd.viewParms.frameCount - 1 ) {
 		f->visible = qfalse;
 		f->fadeTime = backEnd.refdef.time - 2000;
+		f->queryPending = qfalse;	// an old answer is for somewhere else
 	}
 
 	f->addedFrame = backEnd.viewParms.frameCount;
@@ -186,6 +209,8 @@ void RB_AddFlare( void *surface, int fogNum, vec3_t point, vec3_t color, vec3_t
 	f->windowX = backEnd.viewParms.viewportX + window[0];
 	f->windowY = backEnd.viewParms.viewportY + window[1];
 
+	f->eyeX = eye[0];
+	f->eyeY = eye[1];
 	f->eyeZ = eye[2];
 }
 
@@ -235,6 +260,89 @@ FLARE BACK END
 ===============================================================================
 */
 
+/*
+==================
+RB_BeginFlareQueries
+
+The queries draw in eye space with the view's projection, and only
+touch the depth test
+==================
+*/
+static void RB_BeginFlareQueries( void ) {
+	if ( !r_flareQueries[0] ) {
+		qglGenQueriesARB( MAX_FLARES, r_flareQueries );
+	}
+
+	GL_State( 0 );
+	qglColorMask( GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE );
+
+	qglPushMatrix();
+	qglLoadIdentity();
+}
+
+/*
+==================
+RB_EndFlareQueries
+==================
+*/
+static void RB_EndFlareQueries( void ) {
+	qglPopMatrix();
+	qglColorMask( GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE );
+}
+
+/*
+==================
+RB_QueryFlare
+
+Returns the answer to the flare's previous query, or its last known
+visibility if that isn't back yet, and sets testTime to when the answer
+was true.  A new query is only issued once the old one has been read.
+==================
+*/
+static qboolean RB_QueryFlare( flare_t *f, int *testTime ) {
+	GLuint		query;
+	GLint		available, samples;
+	qboolean	visible;
+	float		dist, scale;
+
+	query = r_flareQueries[ f - r_flareStructs ];
+	visible = f->visible;
+	*testTime = backEnd.refdef.time;
+
+	// the test point is pulled 24 units towards the eye, which is the
+	// same tolerance the readback gives, and nothing can be in front
+	// of it once it is past the near plane
+	dist = -f->eyeZ - 24;
+	if ( dist <= r_znear->value ) {
+		f->queryPending = qfalse;
+		return qtrue;
+	}
+
+	if ( f->queryPending ) {
+		qglGetQueryObjectivARB( query, GL_QUERY_RESULT_AVAILABLE_ARB, &available );
+		if ( !available ) {
+			backEnd.pc.c_flareStalls++;
+			return visible;
+		}
+		qglGetQueryObjectivARB( query, GL_QUERY_RESULT_ARB, &samples );
+		visible = ( samples > 0 );
+		*testTime = f->queryTime;
+	}
+
+	scale = dist / -f->eyeZ;
+
+	qglBeginQueryARB( GL_SAMPLES_PASSED_ARB, query );
+	qglBegin( GL_POINTS );
+	qglVertex3f( f->eyeX * scale, f->eyeY * scale, f->eyeZ * scale );
+	qglEnd();
+	qglEndQueryARB( GL_SAMPLES_PASSED_ARB );
+
+	f->queryPending = qtrue;
+	f->queryTime = backEnd.refdef.time;
+
+	return visible;
+}
+
 /*
 ==================
 RB_TestFlare
@@ -245,31 +353,39 @@ void RB_TestFlare( flare_t *f ) {
 	qboolean		visible;
 	float			fade;
 	float			screenZ;
+	int				testTime;
 
 	backEnd.pc.c_flareTests++;
 
-	// doing a readpixels is as good as doing a glFinish(), so
-	// don't bother with another sync
-	glState.finishCalled = qfalse;
+	if ( r_flareQueries[0] ) {
+		visible = RB_QueryFlare( f, &testTime );
+	} else {
+		// doing a readpixels is as good as doing a glFinish(), so
+		// don't bother with another sync
+		glState.finishCalled = qfalse;
 
-	// read back the z buffer contents
-	qglReadPixels( f->windowX, f->windowY, 1, 1, GL_DEPTH_COMPONENT, GL_FLOAT, &depth );
+		// read back the z buffer contents
+		qglReadPixels( f->windowX, f->windowY, 1, 1, GL_DEPTH_COMPONENT, GL_FLOAT, &depth );
 
-	screenZ = backEnd.viewParms.projectionMatrix[14] / 
-		( ( 2*depth - 1 ) * backEnd.viewParms.projectionMatrix[11] - backEnd.viewParms.projectionMatrix[10] );
+		screenZ = backEnd.viewParms.projectionMatrix[14] / 
+			( ( 2*depth - 1 ) * backEnd.viewParms.projectionMatrix[11] - backEnd.viewParms.projectionMatrix[10] );
 
-	visible = ( -f->eyeZ - -screenZ ) < 24;
+		visible = ( -f->eyeZ - -screenZ ) < 24;
+		testTime = backEnd.refdef.time;
+	}
 
+	// a late answer starts its fade from when it was true, so the
+	// latency doesn't make the fade any longer
 	if ( visible ) {
 		if ( !f->visible ) {
 			f->visible = qtrue;
-			f->fadeTime = backEnd.refdef.time - 1;
+			f->fadeTime = testTime - 1;
 		}
 		fade = ( ( backEnd.refdef.time - f->fadeTime ) /1000.0f ) * r_flareFade->value;
 	} else {
 		if ( f->visible ) {
 			f->visible = qfalse;
-			f->fadeTime = backEnd.refdef.time - 1;
+			f->fadeTime = testTime - 1;
 		}
 		fade = 1.0f - ( ( backEnd.refdef.time - f->fadeTime ) / 1000.0f ) * r_flareFade->value;
 	}
@@ -377,6 +493,7 @@ void RB_RenderFlares (void) {
 	flare_t		*f;
 	flare_t		**prev;
 	qboolean	draw;
+	qboolean	queries;
 
 	if ( !r_flares->integer ) {
 		return;
@@ -384,6 +501,15 @@ void RB_RenderFlares (void) {
 
 //	RB_AddDlightFlares();
 
+	if ( backEnd.viewParms.isPortal ) {
+		qglDisable (GL_CLIP_PLANE0);
+	}
+
+	queries = ( qglGenQueriesARB != NULL );
+	if ( queries ) {
+		RB_BeginFlareQueries();
+	}
+
 	// perform z buffer readback on each flare in this view
 	draw = qfalse;
 	prev = &r_activeFlares;
@@ -401,9 +527,10 @@ void RB_RenderFlares (void) {
 		if ( f->frameSceneNum == backEnd.viewParms.frameSceneNum
 			&& f->inPortal == backEnd.viewParms.isPortal ) {
 			RB_TestFlare( f );
+			// one still waiting on its query may yet turn out visible
 			if ( f->drawIntensity ) {
 				draw = qtrue;
-			} else {
+			} else if ( !f->queryPending ) {
 				// this flare has completely faded out, so remove it from the chain
 				*prev = f->next;
 				f->next = r_inactiveFlares;
@@ -415,12 +542,12 @@ void RB_RenderFlares (void) {
 		prev = &f->next;
 	}
 
-	if ( !draw ) {
-		return;		// none visible
+	if ( queries ) {
+		RB_EndFlareQueries();
 	}
 
-	if ( backEnd.viewParms.isPortal ) {
-		qglDisable (GL_CLIP_PLANE0);
+	if ( !draw ) {
+		return;		// none visible
 	}
 
 	qglPushMatrix();
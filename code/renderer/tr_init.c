@@ -25,6 +25,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 glconfig_t	glConfig;
 glstate_t	glState;
+glCounters_t	glCounters;
 
 static void GfxInfo_f( void );
 
@@ -47,6 +48,7 @@ cvar_t	*r_detailTextures;
 cvar_t	*r_znear;
 
 cvar_t	*r_smp;
+cvar_t	*r_frontEndThreads;
 cvar_t	*r_showSmp;
 cvar_t	*r_skipBackEnd;
 
@@ -79,6 +81,8 @@ cvar_t	*r_ext_compressed_textures;
 cvar_t	*r_ext_gamma_control;
 cvar_t	*r_ext_multitexture;
 cvar_t	*r_ext_compiled_vertex_array;
+cvar_t	*r_ext_vertex_buffer_object;
+cvar_t	*r_ext_occlusion_query;
 cvar_t	*r_ext_texture_env_add;
 
 cvar_t	*r_ignoreGLErrors;
@@ -88,6 +92,7 @@ cvar_t	*r_stencilbits;
 cvar_t	*r_depthbits;
 cvar_t	*r_colorbits;
 cvar_t	*r_stereo;
+cvar_t	*r_stereoSinglePass;
 cvar_t	*r_primitives;
 cvar_t	*r_texturebits;
 
@@ -120,6 +125,10 @@ cvar_t	*r_noportals;
 cvar_t	*r_portalOnly;
 
 cvar_t	*r_subdivisions;
+cvar_t	*r_md3Cache;
+cvar_t	*r_simdTess;
+cvar_t	*r_visLists;
+cvar_t	*r_shaderCache;
 cvar_t	*r_lodCurveError;
 
 cvar_t	*r_fullscreen;
@@ -155,6 +164,19 @@ void ( APIENTRY * qglClientActiveTextureARB )( GLenum texture );
 void ( APIENTRY * qglLockArraysEXT)( GLint, GLint);
 void ( APIENTRY * qglUnlockArraysEXT) ( void );
 
+void ( APIENTRY * qglBindBufferARB )( GLenum target, GLuint buffer );
+void ( APIENTRY * qglDeleteBuffersARB )( GLsizei n, const GLuint *buffers );
+void ( APIENTRY * qglGenBuffersARB )( GLsizei n, GLuint *buffers );
+void ( APIENTRY * qglBufferDataARB )( GLenum target, ptrdiff_t size, const GLvoid *data, GLenum usage );
+
+void ( APIENTRY * qglMultiDrawElementsEXT )( GLenum mode, const GLsizei *count, GLenum type, const GLvoid **indices, GLsizei primcount );
+
+void ( APIENTRY * qglGenQueriesARB )( GLsizei n, GLuint *ids );
+void ( APIENTRY * qglDeleteQueriesARB )( GLsizei n, const GLuint *ids );
+void ( APIENTRY * qglBeginQueryARB )( GLenum target, GLuint id );
+void ( APIENTRY * qglEndQueryARB )( GLenum target );
+void ( APIENTRY * qglGetQueryObjectivARB )( GLuint id, GLenum pname, GLint *params );
+
 static void AssertCvarRange( cvar_t *cv, float minVal, float maxVal, qboolean shouldBeIntegral )
 {
 	if ( shouldBeIntegral )
@@ -825,6 +847,8 @@ void GfxInfo_f( void )
 	ri.Printf( PRINT_ALL, "texture bits: %d\n", r_texturebits->integer );
 	ri.Printf( PRINT_ALL, "multitexture: %s\n", enablestrings[qglActiveTextureARB != 0] );
 	ri.Printf( PRINT_ALL, "compiled vertex arrays: %s\n", enablestrings[qglLockArraysEXT != 0 ] );
+	ri.Printf( PRINT_ALL, "vertex buffer objects: %s\n", enablestrings[qglBindBufferARB != 0 ] );
+	ri.Printf( PRINT_ALL, "occlusion queries: %s\n", enablestrings[qglGenQueriesARB != 0 ] );
 	ri.Printf( PRINT_ALL, "texenv add: %s\n", enablestrings[glConfig.textureEnvAddAvailable != 0] );
 	ri.Printf( PRINT_ALL, "compressed textures: %s\n", enablestrings[glConfig.textureCompression!=TC_NONE] );
 	if ( r_vertexLight->integer || glConfig.hardwareType == GLHW_PERMEDIA2 )
@@ -863,6 +887,8 @@ void R_Register( void )
 	r_ext_gamma_control = ri.Cvar_Get( "r_ext_gamma_control", "1", CVAR_ARCHIVE | CVAR_LATCH );
 	r_ext_multitexture = ri.Cvar_Get( "r_ext_multitexture", "1", CVAR_ARCHIVE | CVAR_LATCH );
 	r_ext_compiled_vertex_array = ri.Cvar_Get( "r_ext_compiled_vertex_array", "1", CVAR_ARCHIVE | CVAR_LATCH);
+	r_ext_vertex_buffer_object = ri.Cvar_Get( "r_ext_vertex_buffer_object", "1", CVAR_ARCHIVE | CVAR_LATCH );
+	r_ext_occlusion_query = ri.Cvar_Get( "r_ext_occlusion_query", "1", CVAR_ARCHIVE | CVAR_LATCH );
 #ifdef __linux__ // broken on linux
 	r_ext_texture_env_add = ri.Cvar_Get( "r_ext_texture_env_add", "0", CVAR_ARCHIVE | CVAR_LATCH);
 #else
@@ -877,6 +903,7 @@ void R_Register( void )
 	r_texturebits = ri.Cvar_Get( "r_texturebits", "0", CVAR_ARCHIVE | CVAR_LATCH );
 	r_colorbits = ri.Cvar_Get( "r_colorbits", "0", CVAR_ARCHIVE | CVAR_LATCH );
 	r_stereo = ri.Cvar_Get( "r_stereo", "0", CVAR_ARCHIVE | CVAR_LATCH );
+	r_stereoSinglePass = ri.Cvar_Get( "r_stereoSinglePass", "1", CVAR_ARCHIVE );
 #ifdef __linux__
 	r_stencilbits = ri.Cvar_Get( "r_stencilbits", "0", CVAR_ARCHIVE | CVAR_LATCH );
 #else
@@ -894,12 +921,17 @@ void R_Register( void )
 	r_vertexLight = ri.Cvar_Get( "r_vertexLight", "0", CVAR_ARCHIVE | CVAR_LATCH );
 	r_uiFullScreen = ri.Cvar_Get( "r_uifullscreen", "0", 0);
 	r_subdivisions = ri.Cvar_Get ("r_subdivisions", "4", CVAR_ARCHIVE | CVAR_LATCH);
+	r_md3Cache = ri.Cvar_Get( "r_md3Cache", "1", CVAR_ARCHIVE | CVAR_LATCH );
+	r_simdTess = ri.Cvar_Get( "r_simdTess", "1", CVAR_ARCHIVE );
+	r_visLists = ri.Cvar_Get( "r_visLists", "1", CVAR_ARCHIVE | CVAR_LATCH );
+	r_shaderCache = ri.Cvar_Get( "r_shaderCache", "1", CVAR_ARCHIVE );
 #if (defined(MACOS_X) || defined(__linux__)) && defined(SMP)
   // Default to using SMP on Mac OS X or Linux if we have multiple processors
 	r_smp = ri.Cvar_Get( "r_smp", Sys_ProcessorCount() > 1 ? "1" : "0", CVAR_ARCHIVE | CVAR_LATCH);
 #else        
 	r_smp = ri.Cvar_Get( "r_smp", "0", CVAR_ARCHIVE | CVAR_LATCH);
 #endif
+	r_frontEndThreads = ri.Cvar_Get( "r_frontEndThreads", "-1", CVAR_ARCHIVE | CVAR_LATCH );
 	r_ignoreFastPath = ri.Cvar_Get( "r_ignoreFastPath", "1", CVAR_ARCHIVE | CVAR_LATCH );
 
 	//
@@ -1003,6 +1035,11 @@ void R_Register( void )
 	ri.Cmd_AddCommand( "screenshot", R_ScreenShot_f );
 	ri.Cmd_AddCommand( "screenshotJPEG", R_ScreenShotJPEG_f );
 	ri.Cmd_AddCommand( "gfxinfo", GfxInfo_f );
+	ri.Cmd_AddCommand( "capturedrawsurfs", R_CaptureDrawSurfs_f );
+	ri.Cmd_AddCommand( "sortbench", R_SortBench_f );
+	ri.Cmd_AddCommand( "md3bench", R_MD3Bench_f );
+	ri.Cmd_AddCommand( "capturetess", R_CaptureTess_f );
+	ri.Cmd_AddCommand( "tessbench", R_TessBench_f );
 }
 
 /*
@@ -1084,6 +1121,8 @@ void R_Init( void ) {
 	}
 	R_ToggleSmpFrame();
 
+	R_InitFrontEndJobs();
+
 	InitOpenGL();
 
 	R_InitImages();
@@ -1122,11 +1161,19 @@ void RE_Shutdown( qboolean destroyWindow ) {
 	ri.Cmd_RemoveCommand ("gfxinfo");
 	ri.Cmd_RemoveCommand( "modelist" );
 	ri.Cmd_RemoveCommand( "shaderstate" );
+	ri.Cmd_RemoveCommand( "capturedrawsurfs" );
+	ri.Cmd_RemoveCommand( "sortbench" );
+	ri.Cmd_RemoveCommand( "md3bench" );
+	ri.Cmd_RemoveCommand( "capturetess" );
+	ri.Cmd_RemoveCommand( "tessbench" );
 
 
 	if ( tr.registered ) {
 		R_SyncRenderThread();
+		R_ShutdownFrontEndJobs();
 		R_ShutdownCommandBuffers();
+		R_DeleteWorldBuffers();
+		R_DeleteFlareQueries();
 		R_DeleteTextures();
 	}
 
@@ -1156,6 +1203,16 @@ void RE_EndRegistration( void ) {
 }
 
 
+/*
+=============
+RE_GetGLCounters
+=============
+*/
+void RE_GetGLCounters( glCounters_t *counters ) {
+	*counters = glCounters;
+}
+
+
 /*
 @@@@@@@@@@@@@@@@@@@@@
 GetRefAPI
@@ -1212,6 +1269,7 @@ refexport_t *GetRefAPI ( int apiVersion, refimport_t *rimp ) {
 	re.RemapShader = R_RemapShader;
 	re.GetEntityToken = R_GetEntityToken;
 	re.inPVS = R_inPVS;
+	re.GetGLCounters = RE_GetGLCounters;
 
 	return &re;
 }
@@ -0,0 +1,417 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Foobar; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+// tr_jobs.c -- spreads drawsurf generation over worker threads
+
+#include "tr_local.h"
+
+/*
+=============================================================================
+
+FRONT END JOBS
+
+A batch is a function and a count of jobs.  The main thread and the
+workers take job indexes until they run out, and the main thread waits
+for the last one before merging what the workers produced.  Idle
+workers block on the start condition, so they cost nothing in menus.  This only
+runs beside the front end on the main thread, the r_smp render thread
+is not involved.
+
+=============================================================================
+*/
+
+frontEndThread_t	frontEndThreads[1+MAX_FRONTEND_WORKERS];
+int					numFrontEndThreads = 1;
+
+Q_THREADLOCAL frontEndThread_t	*frontEnd = &frontEndThreads[0];
+
+typedef struct {
+	void			*lock;
+	void			*start;		// a new batch or quit
+	void			*done;		// the last job of the batch finished
+	void			*threads[MAX_FRONTEND_WORKERS];
+
+	// all changed with the lock held
+	void			(*job)( int index );
+	int				numJobs;
+	int				nextJob;
+	int				doneJobs;
+
+	int				batch;
+	qboolean		quit;
+
+	qboolean		running;	// main thread only, a batch is out
+} frontEndJobs_t;
+
+static frontEndJobs_t	jobs;
+
+/*
+=================
+R_JobPrintf
+
+ri.Printf for code that can run in a job.  Inside a batch the text is
+kept with the calling thread and printed by R_ReportJobMessages.
+=================
+*/
+void QDECL R_JobPrintf( int printLevel, const char *fmt, ... ) {
+	va_list		argptr;
+	char		text[1024];
+	int			len;
+
+	va_start( argptr, fmt );
+	vsprintf( text, fmt, argptr );
+	va_end( argptr );
+
+	if ( frontEnd == &frontEndThreads[0] && !jobs.running ) {
+		ri.Printf( printLevel, "%s", text );
+		return;
+	}
+
+	len = strlen( text ) + 2;
+	if ( frontEnd->messagesLength + len > (int)sizeof( frontEnd->messages ) ) {
+		frontEnd->droppedMessages++;
+		return;
+	}
+	frontEnd->messages[frontEnd->messagesLength] = '0' + printLevel;
+	strcpy( frontEnd->messages + frontEnd->messagesLength + 1, text );
+	frontEnd->messagesLength += len;
+}
+
+/*
+=================
+R_JobError
+
+ri.Error for code that can run in a job.  Inside a batch only the
+first error is kept, the caller carries on past the bad data and
+R_ReportJobMessages raises it once the batch is done.
+=================
+*/
+void QDECL R_JobError( int errorCode, const char *fmt, ... ) {
+	va_list		argptr;
+	char		text[1024];
+
+	va_start( argptr, fmt );
+	vsprintf( text, fmt, argptr );
+	va_end( argptr );
+
+	if ( frontEnd == &frontEndThreads[0] && !jobs.running ) {
+		ri.Error( errorCode, "%s", text );
+		return;
+	}
+
+	if ( frontEnd->hasError ) {
+		return;
+	}
+	frontEnd->hasError = qtrue;
+	frontEnd->errorCode = errorCode;
+	Q_strncpyz( frontEnd->error, text, sizeof( frontEnd->error ) );
+}
+
+/*
+=================
+R_ReportJobMessages
+
+Prints what the threads kept during the batch and raises the first
+error, on the main thread after the join
+=================
+*/
+static void R_ReportJobMessages( void ) {
+	frontEndThread_t	*thread;
+	char				*text;
+	int					i, errorCode;
+	char				error[256];
+	qboolean			hasError;
+
+	hasError = qfalse;
+	errorCode = 0;
+	for ( i = 0 ; i < numFrontEndThreads ; i++ ) {
+		thread = &frontEndThreads[i];
+
+		for ( text = thread->messages ; text < thread->messages + thread->messagesLength ; text += strlen( text ) + 1 ) {
+			ri.Printf( text[0] - '0', "%s", text + 1 );
+		}
+		if ( thread->droppedMessages ) {
+			ri.Printf( PRINT_DEVELOPER, "%i front end job messages dropped\n", thread->droppedMessages );
+		}
+		thread->messagesLength = 0;
+		thread->droppedMessages = 0;
+
+		if ( thread->hasError && !hasError ) {
+			hasError = qtrue;
+			errorCode = thread->errorCode;
+			Q_strncpyz( error, thread->error, sizeof( error ) );
+		}
+		thread->hasError = qfalse;
+	}
+
+	if ( hasError ) {
+		ri.Error( errorCode, "%s", error );
+	}
+}
+
+/*
+=================
+R_WorkFrontEndJobs
+
+Takes jobs from the current batch until there are none left
+=================
+*/
+static void R_WorkFrontEndJobs( void ) {
+	void	(*job)( int index );
+	int		index;
+
+	while ( 1 ) {
+		Sys_LockMutex( jobs.lock );
+		if ( jobs.nextJob >= jobs.numJobs ) {
+			Sys_UnlockMutex( jobs.lock );
+			return;
+		}
+		index = jobs.nextJob++;
+		job = jobs.job;
+		Sys_UnlockMutex( jobs.lock );
+
+		job( index );
+
+		Sys_LockMutex( jobs.lock );
+		jobs.doneJobs++;
+		if ( jobs.doneJobs == jobs.numJobs ) {
+			Sys_WakeCondition( jobs.done );
+		}
+		Sys_UnlockMutex( jobs.lock );
+	}
+}
+
+/*
+=================
+R_FrontEndWorker
+=================
+*/
+static void R_FrontEndWorker( void *arg ) {
+	int		batch;
+
+	frontEnd = (frontEndThread_t *)arg;
+
+	batch = 0;
+	Sys_LockMutex( jobs.lock );
+	while ( !jobs.quit ) {
+		if ( jobs.batch == batch ) {
+			Sys_WaitCondition( jobs.start, jobs.lock );
+			continue;
+		}
+
+		batch = jobs.batch;
+		Sys_UnlockMutex( jobs.lock );
+		R_WorkFrontEndJobs();
+		Sys_LockMutex( jobs.lock );
+	}
+	Sys_UnlockMutex( jobs.lock );
+}
+
+/*
+=================
+R_RunFrontEndJobs
+
+Runs job( 0 ) through job( numJobs - 1 ) and returns when they are all
+done, with the workers' drawsurfs appended to tr.refdef.drawSurfs.
+The workers start each batch with the calling thread's current entity
+and orientation.
+=================
+*/
+void R_RunFrontEndJobs( void (*job)( int index ), int numJobs ) {
+	frontEndThread_t	*thread;
+	int					*in, *out;
+	int					i, j, count;
+
+	if ( numFrontEndThreads == 1 || numJobs < 2 ) {
+		for ( i = 0 ; i < numJobs ; i++ ) {
+			job( i );
+		}
+		return;
+	}
+
+	for ( i = 1 ; i < numFrontEndThreads ; i++ ) {
+		thread = &frontEndThreads[i];
+		thread->currentEntity = frontEnd->currentEntity;
+		thread->currentEntityNum = frontEnd->currentEntityNum;
+		thread->shiftedEntityNum = frontEnd->shiftedEntityNum;
+		thread->currentModel = frontEnd->currentModel;
+		thread->or = frontEnd->or;
+		thread->numDrawSurfs = 0;
+	}
+
+	Sys_LockMutex( jobs.lock );
+	jobs.job = job;
+	jobs.numJobs = numJobs;
+	jobs.nextJob = 0;
+	jobs.doneJobs = 0;
+	jobs.batch++;
+	jobs.running = qtrue;
+	Sys_WakeCondition( jobs.start );
+	Sys_UnlockMutex( jobs.lock );
+
+	R_WorkFrontEndJobs();
+
+	// wait for the jobs the workers picked up
+	Sys_LockMutex( jobs.lock );
+	while ( jobs.doneJobs != jobs.numJobs ) {
+		Sys_WaitCondition( jobs.done, jobs.lock );
+	}
+	jobs.running = qfalse;
+	Sys_UnlockMutex( jobs.lock );
+
+	for ( i = 1 ; i < numFrontEndThreads ; i++ ) {
+		thread = &frontEndThreads[i];
+
+		count = thread->numDrawSurfs;
+		if ( count > MAX_DRAWSURFS ) {
+			count = MAX_DRAWSURFS;
+		}
+		for ( j = 0 ; j < count ; j++ ) {
+			tr.refdef.drawSurfs[ tr.refdef.numDrawSurfs & DRAWSURF_MASK ] = thread->drawSurfs[j];
+			tr.refdef.numDrawSurfs++;
+		}
+
+		in = (int *)&thread->workerCounters;
+		out = (int *)&tr.pc;
+		for ( j = 0 ; j < (int)( sizeof( frontEndCounters_t ) / sizeof( int ) ) ; j++ ) {
+			out[j] += in[j];
+		}
+		Com_Memset( &thread->workerCounters, 0, sizeof( thread->workerCounters ) );
+	}
+
+	R_ReportJobMessages();
+}
+
+/*
+=================
+R_FreeFrontEndSync
+=================
+*/
+static void R_FreeFrontEndSync( void ) {
+	if ( jobs.lock ) {
+		Sys_DestroyMutex( jobs.lock );
+	}
+	if ( jobs.start ) {
+		Sys_DestroyCondition( jobs.start );
+	}
+	if ( jobs.done ) {
+		Sys_DestroyCondition( jobs.done );
+	}
+	jobs.lock = jobs.start = jobs.done = NULL;
+}
+
+/*
+=================
+R_InitFrontEndJobs
+=================
+*/
+void R_InitFrontEndJobs( void ) {
+	frontEndThread_t	*thread;
+	int					workers;
+
+	Com_Memset( &frontEndThreads[0], 0, sizeof( frontEndThreads[0] ) );
+	frontEndThreads[0].pc = &tr.pc;
+	numFrontEndThreads = 1;
+
+#ifndef R_NO_FRONTEND_JOBS
+	workers = r_frontEndThreads->integer;
+	if ( workers < 0 ) {
+		// leave a core for the render thread
+		workers = Sys_ProcessorCount() - 1;
+		if ( r_smp->integer ) {
+			workers--;
+		}
+	}
+	if ( workers > MAX_FRONTEND_WORKERS ) {
+		workers = MAX_FRONTEND_WORKERS;
+	}
+	if ( workers <= 0 ) {
+		return;
+	}
+
+	jobs.lock = Sys_CreateMutex();
+	jobs.start = Sys_CreateCondition();
+	jobs.done = Sys_CreateCondition();
+	if ( !jobs.lock || !jobs.start || !jobs.done ) {
+		R_FreeFrontEndSync();
+		return;
+	}
+	jobs.quit = qfalse;
+	jobs.batch = 0;
+
+	while ( numFrontEndThreads <= workers ) {
+		thread = &frontEndThreads[numFrontEndThreads];
+		Com_Memset( thread, 0, sizeof( *thread ) );
+		thread->pc = &thread->workerCounters;
+		thread->drawSurfs = ri.Malloc( MAX_DRAWSURFS * sizeof( drawSurf_t ) );
+
+		jobs.threads[numFrontEndThreads-1] = Sys_CreateThread( R_FrontEndWorker, thread );
+		if ( !jobs.threads[numFrontEndThreads-1] ) {
+			ri.Free( thread->drawSurfs );
+			thread->drawSurfs = NULL;
+			break;
+		}
+		numFrontEndThreads++;
+	}
+
+	if ( numFrontEndThreads == 1 ) {
+		ri.Printf( PRINT_ALL, "couldn't start front end workers, using the main thread\n" );
+		R_FreeFrontEndSync();
+		return;
+	}
+	ri.Printf( PRINT_ALL, "front end jobs on %i threads\n", numFrontEndThreads );
+#endif
+}
+
+/*
+=================
+R_ShutdownFrontEndJobs
+=================
+*/
+void R_ShutdownFrontEndJobs( void ) {
+	frontEndThread_t	*thread;
+	int					i;
+
+	if ( numFrontEndThreads > 1 ) {
+		Sys_LockMutex( jobs.lock );
+		jobs.quit = qtrue;
+		Sys_WakeCondition( jobs.start );
+		Sys_UnlockMutex( jobs.lock );
+		for ( i = 1 ; i < numFrontEndThreads ; i++ ) {
+			Sys_JoinThread( jobs.threads[i-1] );
+			jobs.threads[i-1] = NULL;
+		}
+		R_FreeFrontEndSync();
+	}
+
+	for ( i = 0 ; i < numFrontEndThreads ; i++ ) {
+		thread = &frontEndThreads[i];
+		if ( thread->drawSurfs ) {
+			ri.Free( thread->drawSurfs );
+		}
+		if ( thread->deferred ) {
+			ri.Free( thread->deferred );
+		}
+		Com_Memset( thread, 0, sizeof( *thread ) );
+	}
+	frontEndThreads[0].pc = &tr.pc;
+	numFrontEndThreads = 1;
+}
@@ -63,20 +63,25 @@ void R_DlightBmodel( bmodel_t *bmodel ) {
 	dlight_t	*dl;
 	int			mask;
 	msurface_t	*surf;
-
-	// transform all the lights
-	R_TransformDlights( tr.refdef.num_dlights, tr.refdef.dlights, &tr.or );
+	vec3_t		temp, transformed;
 
 	mask = 0;
 	for ( i=0 ; i<tr.refdef.num_dlights ; i++ ) {
 		dl = &tr.refdef.dlights[i];
 
+		// transform the light into the model's space, locally because
+		// entity jobs on other threads are doing the same for theirs
+		VectorSubtract( dl->origin, frontEnd->or.origin, temp );
+		transformed[0] = DotProduct( temp, frontEnd->or.axis[0] );
+		transformed[1] = DotProduct( temp, frontEnd->or.axis[1] );
+		transformed[2] = DotProduct( temp, frontEnd->or.axis[2] );
+
 		// see if the point is close enough to the bounds to matter
 		for ( j = 0 ; j < 3 ; j++ ) {
-			if ( dl->transformed[j] - bmodel->bounds[1][j] > dl->radius ) {
+			if ( transformed[j] - bmodel->bounds[1][j] > dl->radius ) {
 				break;
 			}
-			if ( bmodel->bounds[0][j] - dl->transformed[j] > dl->radius ) {
+			if ( bmodel->bounds[0][j] - transformed[j] > dl->radius ) {
 				break;
 			}
 		}
@@ -88,7 +93,7 @@ void R_DlightBmodel( bmodel_t *bmodel ) {
 		mask |= 1 << i;
 	}
 
-	tr.currentEntity->needDlights = (mask != 0);
+	frontEnd->currentEntity->needDlights = (mask != 0);
 
 	// set the dlight bits in all the surfaces
 	for ( i = 0 ; i < bmodel->numSurfaces ; i++ ) {
@@ -268,7 +273,7 @@ static void LogLight( trRefEntity_t *ent ) {
 		max2 = ent->directedLight[2];
 	}
 
-	ri.Printf( PRINT_ALL, "amb:%i  dir:%i\n", max1, max2 );
+	R_JobPrintf( PRINT_ALL, "amb:%i  dir:%i\n", max1, max2 );
 }
 
 /*
@@ -48,6 +48,17 @@ long myftol( float f );
 // parallel on a dual cpu machine
 #define	SMP_FRAMES		2
 
+// front end jobs need each thread to find its own frontEndThread_t,
+// without compiler support for that the jobs all run on the main thread
+#if defined(_MSC_VER)
+#define	Q_THREADLOCAL	__declspec(thread)
+#elif defined(__GNUC__) && !defined(MACOS_X)
+#define	Q_THREADLOCAL	__thread
+#else
+#define	Q_THREADLOCAL
+#define	R_NO_FRONTEND_JOBS
+#endif
+
 // 12 bits
 // see QSORT_SHADERNUM_SHIFT
 #define	MAX_SHADERS				16384
@@ -394,6 +405,8 @@ typedef struct shader_s {
 	qboolean	needsST2;
 	qboolean	needsColor;
 
+	qboolean	staticGeometry;			// world surfaces can draw straight from the world buffers
+
 	int			numDeforms;
 	deformStage_t	deforms[MAX_SHADER_DEFORMS];
 
@@ -506,6 +519,7 @@ typedef struct {
 	cplane_t	frustum[4];
 	vec3_t		visBounds[2];
 	float		zFar;
+	float		stereoMargin;		// side planes widened to cull for both eyes at once
 } viewParms_t;
 
 
@@ -535,8 +549,21 @@ typedef enum {
 	SF_MAX = 0x7fffffff			// ensures that sizeof( surfaceType_t ) == sizeof( int )
 } surfaceType_t;
 
+// drawsurf sort keys, see QSORT_SHADERNUM_SHIFT
+//#define R_SORTKEY64
+
+#ifdef R_SORTKEY64
+#ifdef _MSC_VER
+typedef unsigned __int64	sortKey_t;
+#else
+typedef unsigned long long	sortKey_t;
+#endif
+#else
+typedef unsigned			sortKey_t;
+#endif
+
 typedef struct drawSurf_s {
-	unsigned			sort;			// bit combination for fast compares
+	sortKey_t			sort;			// bit combination for fast compares
 	surfaceType_t		*surface;		// any of surface*_t
 } drawSurf_t;
 
@@ -588,6 +615,10 @@ typedef struct srfGridMesh_s {
 	int				lodStitched;
 
 	// vertexes
+	// range in the world index buffer, 0 if not there
+	int				firstBufferIndex;
+	int				numBufferIndexes;
+
 	int				width, height;
 	float			*widthLodError;
 	float			*heightLodError;
@@ -604,6 +635,10 @@ typedef struct {
 	// dynamic lighting information
 	int			dlightBits[SMP_FRAMES];
 
+	// range in the world index buffer, 0 if not there
+	int			firstBufferIndex;
+	int			numBufferIndexes;
+
 	// triangle definitions (no normals at points)
 	int			numPoints;
 	int			numIndices;
@@ -625,6 +660,10 @@ typedef struct {
 	vec3_t			localOrigin;
 	float			radius;
 
+	// range in the world index buffer, 0 if not there
+	int				firstBufferIndex;
+	int				numBufferIndexes;
+
 	// triangle definitions
 	int				numIndexes;
 	int				*indexes;
@@ -653,10 +692,17 @@ BRUSH MODELS
 #define	SIDE_BACK	1
 #define	SIDE_ON		2
 
+// world jobs are rooted WORLDJOB_DEPTH nodes down, or at shallower leafs
+#define	WORLDJOB_DEPTH		6
+#define	MAX_WORLD_JOBS		(1<<WORLDJOB_DEPTH)
+#define	WORLDJOB_SHARED		-1		// msurface_t marked by leafs of several world jobs
+#define	WORLDJOB_NONE		-2		// not in any leaf, brush model surfaces
+
 typedef struct msurface_s {
 	int					viewCount;		// if == tr.viewCount, already added
 	struct shader_s		*shader;
 	int					fogIndex;
+	int					worldJob;		// world subtree marking it, WORLDJOB_SHARED if several
 
 	surfaceType_t		*data;			// any of srf*_t
 } msurface_t;
@@ -681,8 +727,40 @@ typedef struct mnode_s {
 
 	msurface_t	**firstmarksurface;
 	int			nummarksurfaces;
+
+	int			worldJob;		// subtree index if it roots a world job, else -1
 } mnode_t;
 
+// the leafs visible from a cluster, in depth first order, so that each
+// chunk of neighbouring leafs can be culled by one box and the world
+// jobs own contiguous runs of chunks
+#define	VISCHUNK_LEAFS		16
+#define	MAX_VISLISTS		4		// recent clusters, portal views alternate
+
+typedef struct {
+	vec3_t		mins, maxs;
+	int			firstLeaf;		// into visList_t leafs
+	int			numLeafs;
+} visChunk_t;
+
+typedef struct {
+	int			firstChunk;
+	int			numChunks;
+} visJob_t;
+
+typedef struct {
+	int			cluster;		// -1 for every leaf, r_novis or outside the world
+	byte		areamask[MAX_MAP_AREA_BYTES];
+	int			lastUsed;		// 0 if never built
+
+	int			numLeafs;
+	int			*leafs;			// depth first leaf numbers
+	int			numChunks;
+	visChunk_t	*chunks;
+	int			numJobs;
+	visJob_t	jobs[MAX_WORLD_JOBS];
+} visList_t;
+
 typedef struct {
 	vec3_t		bounds[2];		// for culling
 	msurface_t	*firstSurface;
@@ -709,6 +787,17 @@ typedef struct {
 
 	int			numsurfaces;
 	msurface_t	*surfaces;
+	int			numWorldJobs;		// subtrees walked in parallel
+	int			numSharedMarks;		// marksurfaces of surfaces shared between them
+
+	int			numLeafs;
+	mnode_t		**leafOrder;		// every leaf, depth first
+	int			*clusterLeafs;		// depth first leaf numbers grouped by cluster
+	int			*clusterFirstLeaf;	// numClusters + 1 offsets into clusterLeafs
+	int			jobFirstLeaf[MAX_WORLD_JOBS+1];	// world jobs cover these leaf runs
+	visList_t	visLists[MAX_VISLISTS];
+	visList_t	*visList;			// the one r_lockpvs keeps
+	int			visListFrame;
 
 	int			nummarksurfaces;
 	msurface_t	**marksurfaces;
@@ -731,6 +820,10 @@ typedef struct {
 
 	char		*entityString;
 	char		*entityParsePoint;
+
+	// static surface geometry, 0 if the driver has no buffer objects
+	GLuint		vertexBuffer;
+	GLuint		indexBuffer;
 } world_t;
 
 //======================================================================
@@ -755,6 +848,11 @@ typedef struct model_s {
 	int			 numLods;
 } model_t;
 
+// with r_md3Cache, every md3 surface's flags hold the offset from the
+// surface to its frames decoded as floats: x, y, z, normal x, y, z,
+// each an array of MD3_DECODED_STRIDE floats
+#define	MD3_DECODED_STRIDE(numVerts)	(((numVerts)+3)&~3)
+
 
 #define	MAX_MOD_KNOWN	1024
 
@@ -765,6 +863,7 @@ int			R_LerpTag( orientation_t *tag, qhandle_t handle, int startFrame, int endFr
 void		R_ModelBounds( qhandle_t handle, vec3_t mins, vec3_t maxs );
 
 void		R_Modellist_f (void);
+void		R_MD3Bench_f( void );
 
 //====================================================
 extern	refimport_t		ri;
@@ -795,9 +894,25 @@ the bits are allocated as follows:
 7-16  : entity index
 2-6   : fog index
 0-1   : dlightmap index
+
+	R_SORTKEY64 widens the key so MAX_SHADERS and MAX_ENTITIES can grow:
+32-63 : sorted shader index
+12-31 : entity index
+2-6   : fog index
+0-1   : dlightmap index
+
+the keys are ordered with a radix sort, which is stable, so surfaces with
+equal keys are drawn in the order they were added
 */
+#ifdef R_SORTKEY64
+#define	QSORT_SHADERNUM_SHIFT	32
+#define	QSORT_ENTITYNUM_SHIFT	12
+#define	QSORT_ENTITYNUM_MASK	0xfffff
+#else
 #define	QSORT_SHADERNUM_SHIFT	17
 #define	QSORT_ENTITYNUM_SHIFT	7
+#define	QSORT_ENTITYNUM_MASK	1023
+#endif
 #define	QSORT_FOGNUM_SHIFT		2
 
 extern	int			gl_filter_min, gl_filter_max;
@@ -843,6 +958,7 @@ typedef struct {
 	int		c_flareAdds;
 	int		c_flareTests;
 	int		c_flareRenders;
+	int		c_flareStalls;		// query results not back in time
 
 	int		msec;			// total msec for backend run
 } backEndCounters_t;
@@ -865,6 +981,72 @@ typedef struct {
 	trRefEntity_t	entity2D;	// currentEntity will point at this when doing 2D rendering
 } backEndState_t;
 
+/*
+** In stereo the left eye runs the front end with a frustum wide enough
+** for both eyes, and the right eye replays its sorted surfaces with
+** only the view origin moved.
+*/
+#define	MAX_STEREO_SCENES	8
+#define	STEREO_CULL_MARGIN	8		// largest eye offset the left eye culls for
+
+typedef struct {
+	trRefdef_t		refdef;
+	viewParms_t		viewParms;
+	drawSurf_t		*drawSurfs;
+	int				numDrawSurfs;
+	int				viewCluster;
+	qboolean		valid;
+} stereoScene_t;
+
+/*
+** frontEndThread_t
+**
+** The part of the front end that changes while surfaces are generated.
+** The main thread and every job worker have their own, and frontEnd
+** points at the calling thread's.  Workers collect drawsurfs into their
+** own list, which is appended to tr.refdef.drawSurfs when a batch of
+** jobs is done.
+*/
+#define	MAX_FRONTEND_WORKERS	7
+
+typedef struct {
+	msurface_t		*surf;
+	int				dlightBits;
+} deferredSurf_t;
+
+typedef struct {
+	trRefEntity_t	*currentEntity;
+	int				currentEntityNum;
+	sortKey_t		shiftedEntityNum;	// currentEntityNum << QSORT_ENTITYNUM_SHIFT
+	model_t			*currentModel;
+
+	orientationr_t	or;					// for current entity
+
+	drawSurf_t		*drawSurfs;			// NULL on the main thread
+	int				numDrawSurfs;
+
+	// world jobs running in parallel leave surfaces that other jobs
+	// may also reach for the main thread to add afterwards
+	qboolean		deferShared;
+	deferredSurf_t	*deferred;
+	int				numDeferred;
+	int				maxDeferred;
+
+	vec3_t			visBounds[2];		// leafs reached by world jobs
+
+	// R_JobPrintf and R_JobError from inside a batch, reported by
+	// the main thread once the batch is done
+	char			messages[1024];		// print level digit, text, 0, ...
+	int				messagesLength;
+	int				droppedMessages;
+	qboolean		hasError;
+	int				errorCode;
+	char			error[256];
+
+	frontEndCounters_t	*pc;			// &tr.pc on the main thread
+	frontEndCounters_t	workerCounters;
+} frontEndThread_t;
+
 /*
 ** trGlobals_t 
 **
@@ -909,11 +1091,7 @@ typedef struct {
 	int						numLightmaps;
 	image_t					*lightmaps[MAX_LIGHTMAPS];
 
-	trRefEntity_t			*currentEntity;
 	trRefEntity_t			worldEntity;		// point currentEntity at this when rendering world
-	int						currentEntityNum;
-	int						shiftedEntityNum;	// currentEntityNum << QSORT_ENTITYNUM_SHIFT
-	model_t					*currentModel;
 
 	viewParms_t				viewParms;
 
@@ -921,8 +1099,6 @@ typedef struct {
 	int						identityLightByte;	// identityLight * 255
 	int						overbrightBits;		// r_overbrightBits->integer, but set to 0 if no hw gamma
 
-	orientationr_t			or;					// for current entity
-
 	trRefdef_t				refdef;
 
 	int						viewCluster;
@@ -933,6 +1109,14 @@ typedef struct {
 	frontEndCounters_t		pc;
 	int						frontEndMsec;		// not in pc due to clearing issue
 
+	stereoFrame_t			stereoFrame;		// from RE_BeginFrame
+	stereoScene_t			stereoScenes[MAX_STEREO_SCENES];
+	int						numStereoScenes;	// recorded by the left eye
+	int						stereoSceneNum;		// next one for the right eye
+	int						stereoReplays;		// right eye scenes that reused the left eye's
+	int						stereoRenders;		// right eye scenes that had to run the front end
+	int						stereoMsec[2];		// front end msec of each eye, for r_speeds 7
+
 	//
 	// put large tables at the end, so most elements will be
 	// within the +/32K indexed range on risc processors
@@ -963,8 +1147,12 @@ typedef struct {
 
 extern backEndState_t	backEnd;
 extern trGlobals_t	tr;
+extern Q_THREADLOCAL frontEndThread_t	*frontEnd;
+extern frontEndThread_t	frontEndThreads[1+MAX_FRONTEND_WORKERS];	// main thread first
+extern int				numFrontEndThreads;
 extern glconfig_t	glConfig;		// outside of TR since it shouldn't be cleared during ref re-init
 extern glstate_t	glState;		// outside of TR since it shouldn't be cleared during ref re-init
+extern glCounters_t	glCounters;		// bumped by recording GL drivers
 
 
 //
@@ -987,6 +1175,7 @@ extern cvar_t	*r_stencilbits;			// number of desired stencil bits
 extern cvar_t	*r_depthbits;			// number of desired depth bits
 extern cvar_t	*r_colorbits;			// number of desired color bits, only relevant for fullscreen
 extern cvar_t	*r_stereo;				// desired pixelformat stereo flag
+extern cvar_t	*r_stereoSinglePass;	// right eye reuses the left eye's front end
 extern cvar_t	*r_texturebits;			// number of desired texture bits
 										// 0 = use framebuffer depth
 										// 16 = use 16-bit textures
@@ -1032,6 +1221,8 @@ extern cvar_t	*r_ext_gamma_control;
 extern cvar_t	*r_ext_texenv_op;
 extern cvar_t	*r_ext_multitexture;
 extern cvar_t	*r_ext_compiled_vertex_array;
+extern cvar_t	*r_ext_vertex_buffer_object;
+extern cvar_t	*r_ext_occlusion_query;
 extern cvar_t	*r_ext_texture_env_add;
 
 extern	cvar_t	*r_nobind;						// turns off binding to appropriate textures
@@ -1068,8 +1259,13 @@ extern	cvar_t	*r_noportals;
 extern	cvar_t	*r_portalOnly;
 
 extern	cvar_t	*r_subdivisions;
+extern	cvar_t	*r_md3Cache;			// decode md3 frames to floats at load time
+extern	cvar_t	*r_simdTess;			// vector versions of the tess stage kernels
+extern	cvar_t	*r_visLists;			// cached cluster leaf lists instead of R_MarkLeaves
+extern	cvar_t	*r_shaderCache;			// load the shader text and labels from shadercache.dat
 extern	cvar_t	*r_lodCurveError;
 extern	cvar_t	*r_smp;
+extern	cvar_t	*r_frontEndThreads;		// -1 = one per spare core, 0 = front end on the main thread only
 extern	cvar_t	*r_showSmp;
 extern	cvar_t	*r_skipBackEnd;
 
@@ -1095,6 +1291,9 @@ void  R_NoiseInit( void );
 void R_SwapBuffers( int );
 
 void R_RenderView( viewParms_t *parms );
+void R_RotateForViewer( void );
+void R_SetupFrustum( void );
+void R_SetupProjection( void );
 
 void R_AddMD3Surfaces( trRefEntity_t *e );
 void R_AddNullModelSurfaces( trRefEntity_t *e );
@@ -1104,10 +1303,13 @@ void R_AddLightningBoltSurfaces( trRefEntity_t *e );
 
 void R_AddPolygonSurfaces( void );
 
-void R_DecomposeSort( unsigned sort, int *entityNum, shader_t **shader, 
+void R_DecomposeSort( sortKey_t sort, int *entityNum, shader_t **shader, 
 					 int *fogNum, int *dlightMap );
 
 void R_AddDrawSurf( surfaceType_t *surface, shader_t *shader, int fogIndex, int dlightMap );
+void R_RadixSortDrawSurfs( drawSurf_t *drawSurfs, int numDrawSurfs );
+void R_CaptureDrawSurfs_f( void );
+void R_SortBench_f( void );
 
 
 #define	CULL_IN		0		// completely unclipped
@@ -1174,6 +1376,7 @@ void	RE_UploadCinematic (int w, int h, int cols, int rows, const byte *data, int
 void		RE_BeginFrame( stereoFrame_t stereoFrame );
 void		RE_BeginRegistration( glconfig_t *glconfig );
 void		RE_LoadWorldMap( const char *mapname );
+void		R_DeleteWorldBuffers( void );
 void		RE_SetWorldVisData( const byte *vis );
 qhandle_t	RE_RegisterModel( const char *name );
 qhandle_t	RE_RegisterSkin( const char *name );
@@ -1265,6 +1468,17 @@ typedef struct stageVars
 	vec2_t		texcoords[NUM_TEXTURE_BUNDLES][SHADER_MAX_VERTEXES];
 } stageVars_t;
 
+#define	MAX_BUFFER_RANGES	1024
+
+// vertex layout of the world vertex buffer
+typedef struct {
+	vec3_t		xyz;
+	vec2_t		st;
+	vec2_t		lightmap;
+	color4ub_t	color;			// as CGEN_EXACT_VERTEX
+	color4ub_t	litColor;		// as CGEN_VERTEX
+} bufferVert_t;
+
 typedef struct shaderCommands_s 
 {
 	glIndex_t	indexes[SHADER_MAX_INDEXES];
@@ -1287,6 +1501,11 @@ typedef struct shaderCommands_s
 	int			numIndexes;
 	int			numVertexes;
 
+	// world buffer index ranges drawn alongside the tess arrays
+	int			numBufferRanges;
+	int			bufferFirstIndex[MAX_BUFFER_RANGES];
+	GLsizei		bufferNumIndexes[MAX_BUFFER_RANGES];
+
 	// info extracted from current shader
 	int			numPasses;
 	void		(*currentStageIteratorFunc)( void );
@@ -1322,6 +1541,22 @@ WORLD MAP
 void R_AddBrushModelSurfaces( trRefEntity_t *e );
 void R_AddWorldSurfaces( void );
 qboolean R_inPVS( const vec3_t p1, const vec3_t p2 );
+int R_PointCluster( const vec3_t p );
+
+
+/*
+============================================================
+
+FRONT END JOBS
+
+============================================================
+*/
+
+void R_InitFrontEndJobs( void );
+void R_ShutdownFrontEndJobs( void );
+void R_RunFrontEndJobs( void (*job)( int index ), int numJobs );
+void QDECL R_JobPrintf( int printLevel, const char *fmt, ... );
+void QDECL R_JobError( int errorCode, const char *fmt, ... );
 
 
 /*
@@ -1333,6 +1568,7 @@ FLARES
 */
 
 void R_ClearFlares( void );
+void R_DeleteFlareQueries( void );
 
 void RB_AddFlare( void *surface, int fogNum, vec3_t point, vec3_t color, vec3_t normal );
 void RB_AddDlightFlares( void );
@@ -1465,6 +1701,11 @@ void	RB_CalcColorFromOneMinusEntity( unsigned char *dstColors );
 void	RB_CalcSpecularAlpha( unsigned char *alphas );
 void	RB_CalcDiffuseColor( unsigned char *colors );
 
+void	RB_CaptureTess( void );
+void	RB_CaptureTessFrame( void );
+void	R_CaptureTess_f( void );
+void	R_TessBench_f( void );
+
 /*
 =============================================================
 
@@ -67,10 +67,10 @@ int R_CullLocalBox (vec3_t bounds[2]) {
 		v[1] = bounds[(i>>1)&1][1];
 		v[2] = bounds[(i>>2)&1][2];
 
-		VectorCopy( tr.or.origin, transformed[i] );
-		VectorMA( transformed[i], v[0], tr.or.axis[0], transformed[i] );
-		VectorMA( transformed[i], v[1], tr.or.axis[1], transformed[i] );
-		VectorMA( transformed[i], v[2], tr.or.axis[2], transformed[i] );
+		VectorCopy( frontEnd->or.origin, transformed[i] );
+		VectorMA( transformed[i], v[0], frontEnd->or.axis[0], transformed[i] );
+		VectorMA( transformed[i], v[1], frontEnd->or.axis[1], transformed[i] );
+		VectorMA( transformed[i], v[2], frontEnd->or.axis[2], transformed[i] );
 	}
 
 	// check against frustum planes
@@ -162,9 +162,9 @@ R_LocalNormalToWorld
 =================
 */
 void R_LocalNormalToWorld (vec3_t local, vec3_t world) {
-	world[0] = local[0] * tr.or.axis[0][0] + local[1] * tr.or.axis[1][0] + local[2] * tr.or.axis[2][0];
-	world[1] = local[0] * tr.or.axis[0][1] + local[1] * tr.or.axis[1][1] + local[2] * tr.or.axis[2][1];
-	world[2] = local[0] * tr.or.axis[0][2] + local[1] * tr.or.axis[1][2] + local[2] * tr.or.axis[2][2];
+	world[0] = local[0] * frontEnd->or.axis[0][0] + local[1] * frontEnd->or.axis[1][0] + local[2] * frontEnd->or.axis[2][0];
+	world[1] = local[0] * frontEnd->or.axis[0][1] + local[1] * frontEnd->or.axis[1][1] + local[2] * frontEnd->or.axis[2][1];
+	world[2] = local[0] * frontEnd->or.axis[0][2] + local[1] * frontEnd->or.axis[1][2] + local[2] * frontEnd->or.axis[2][2];
 }
 
 /*
@@ -174,9 +174,9 @@ R_LocalPointToWorld
 =================
 */
 void R_LocalPointToWorld (vec3_t local, vec3_t world) {
-	world[0] = local[0] * tr.or.axis[0][0] + local[1] * tr.or.axis[1][0] + local[2] * tr.or.axis[2][0] + tr.or.origin[0];
-	world[1] = local[0] * tr.or.axis[0][1] + local[1] * tr.or.axis[1][1] + local[2] * tr.or.axis[2][1] + tr.or.origin[1];
-	world[2] = local[0] * tr.or.axis[0][2] + local[1] * tr.or.axis[1][2] + local[2] * tr.or.axis[2][2] + tr.or.origin[2];
+	world[0] = local[0] * frontEnd->or.axis[0][0] + local[1] * frontEnd->or.axis[1][0] + local[2] * frontEnd->or.axis[2][0] + frontEnd->or.origin[0];
+	world[1] = local[0] * frontEnd->or.axis[0][1] + local[1] * frontEnd->or.axis[1][1] + local[2] * frontEnd->or.axis[2][1] + frontEnd->or.origin[1];
+	world[2] = local[0] * frontEnd->or.axis[0][2] + local[1] * frontEnd->or.axis[1][2] + local[2] * frontEnd->or.axis[2][2] + frontEnd->or.origin[2];
 }
 
 /*
@@ -186,9 +186,9 @@ R_WorldToLocal
 =================
 */
 void R_WorldToLocal (vec3_t world, vec3_t local) {
-	local[0] = DotProduct(world, tr.or.axis[0]);
-	local[1] = DotProduct(world, tr.or.axis[1]);
-	local[2] = DotProduct(world, tr.or.axis[2]);
+	local[0] = DotProduct(world, frontEnd->or.axis[0]);
+	local[1] = DotProduct(world, frontEnd->or.axis[1]);
+	local[2] = DotProduct(world, frontEnd->or.axis[2]);
 }
 
 /*
@@ -339,11 +339,11 @@ void R_RotateForViewer (void)
 	float	viewerMatrix[16];
 	vec3_t	origin;
 
-	Com_Memset (&tr.or, 0, sizeof(tr.or));
-	tr.or.axis[0][0] = 1;
-	tr.or.axis[1][1] = 1;
-	tr.or.axis[2][2] = 1;
-	VectorCopy (tr.viewParms.or.origin, tr.or.viewOrigin);
+	Com_Memset (&frontEnd->or, 0, sizeof(frontEnd->or));
+	frontEnd->or.axis[0][0] = 1;
+	frontEnd->or.axis[1][1] = 1;
+	frontEnd->or.axis[2][2] = 1;
+	VectorCopy (tr.viewParms.or.origin, frontEnd->or.viewOrigin);
 
 	// transform by the camera placement
 	VectorCopy( tr.viewParms.or.origin, origin );
@@ -370,9 +370,9 @@ void R_RotateForViewer (void)
 
 	// convert from our coordinate system (looking down X)
 	// to OpenGL's coordinate system (looking down -Z)
-	myGlMultMatrix( viewerMatrix, s_flipMatrix, tr.or.modelMatrix );
+	myGlMultMatrix( viewerMatrix, s_flipMatrix, frontEnd->or.modelMatrix );
 
-	tr.viewParms.world = tr.or;
+	tr.viewParms.world = frontEnd->or;
 
 }
 
@@ -502,11 +502,15 @@ void R_SetupFrustum (void) {
 	int		i;
 	float	xs, xc;
 	float	ang;
+	float	margin;
 
 	ang = tr.viewParms.fovX / 180 * M_PI * 0.5f;
 	xs = sin( ang );
 	xc = cos( ang );
 
+	// moving the eye sideways only moves the left and right planes
+	margin = tr.viewParms.stereoMargin * xc;
+
 	VectorScale( tr.viewParms.or.axis[0], xs, tr.viewParms.frustum[0].normal );
 	VectorMA( tr.viewParms.frustum[0].normal, xc, tr.viewParms.or.axis[1], tr.viewParms.frustum[0].normal );
 
@@ -526,6 +530,9 @@ void R_SetupFrustum (void) {
 	for (i=0 ; i<4 ; i++) {
 		tr.viewParms.frustum[i].type = PLANE_NON_AXIAL;
 		tr.viewParms.frustum[i].dist = DotProduct (tr.viewParms.or.origin, tr.viewParms.frustum[i].normal);
+		if ( i < 2 ) {
+			tr.viewParms.frustum[i].dist -= margin;
+		}
 		SetPlaneSignbits( &tr.viewParms.frustum[i] );
 	}
 }
@@ -631,19 +638,19 @@ qboolean R_GetPortalOrientations( drawSurf_t *drawSurf, int entityNum,
 
 	// rotate the plane if necessary
 	if ( entityNum != ENTITYNUM_WORLD ) {
-		tr.currentEntityNum = entityNum;
-		tr.currentEntity = &tr.refdef.entities[entityNum];
+		frontEnd->currentEntityNum = entityNum;
+		frontEnd->currentEntity = &tr.refdef.entities[entityNum];
 
 		// get the orientation of the entity
-		R_RotateForEntity( tr.currentEntity, &tr.viewParms, &tr.or );
+		R_RotateForEntity( frontEnd->currentEntity, &tr.viewParms, &frontEnd->or );
 
 		// rotate the plane, but keep the non-rotated version for matching
 		// against the portalSurface entities
 		R_LocalNormalToWorld( originalPlane.normal, plane.normal );
-		plane.dist = originalPlane.dist + DotProduct( plane.normal, tr.or.origin );
+		plane.dist = originalPlane.dist + DotProduct( plane.normal, frontEnd->or.origin );
 
 		// translate the original plane
-		originalPlane.dist = originalPlane.dist + DotProduct( originalPlane.normal, tr.or.origin );
+		originalPlane.dist = originalPlane.dist + DotProduct( originalPlane.normal, frontEnd->or.origin );
 	} else {
 		plane = originalPlane;
 	}
@@ -749,19 +756,19 @@ static qboolean IsMirror( const drawSurf_t *drawSurf, int entityNum )
 	// rotate the plane if necessary
 	if ( entityNum != ENTITYNUM_WORLD ) 
 	{
-		tr.currentEntityNum = entityNum;
-		tr.currentEntity = &tr.refdef.entities[entityNum];
+		frontEnd->currentEntityNum = entityNum;
+		frontEnd->currentEntity = &tr.refdef.entities[entityNum];
 
 		// get the orientation of the entity
-		R_RotateForEntity( tr.currentEntity, &tr.viewParms, &tr.or );
+		R_RotateForEntity( frontEnd->currentEntity, &tr.viewParms, &frontEnd->or );
 
 		// rotate the plane, but keep the non-rotated version for matching
 		// against the portalSurface entities
 		R_LocalNormalToWorld( originalPlane.normal, plane.normal );
-		plane.dist = originalPlane.dist + DotProduct( plane.normal, tr.or.origin );
+		plane.dist = originalPlane.dist + DotProduct( plane.normal, frontEnd->or.origin );
 
 		// translate the original plane
-		originalPlane.dist = originalPlane.dist + DotProduct( originalPlane.normal, tr.or.origin );
+		originalPlane.dist = originalPlane.dist + DotProduct( originalPlane.normal, frontEnd->or.origin );
 	} 
 	else 
 	{
@@ -830,7 +837,7 @@ static qboolean SurfIsOffscreen( const drawSurf_t *drawSurf, vec4_t clipDest[128
 		int j;
 		unsigned int pointFlags = 0;
 
-		R_TransformModelToClip( tess.xyz[i], tr.or.modelMatrix, tr.viewParms.projectionMatrix, eye, clip );
+		R_TransformModelToClip( tess.xyz[i], frontEnd->or.modelMatrix, tr.viewParms.projectionMatrix, eye, clip );
 
 		for ( j = 0; j < 3; j++ )
 		{
@@ -1003,7 +1010,7 @@ qsort replacement
 
 =================
 */
-#define	SWAP_DRAW_SURF(a,b) temp=((int *)a)[0];((int *)a)[0]=((int *)b)[0];((int *)b)[0]=temp; temp=((int *)a)[1];((int *)a)[1]=((int *)b)[1];((int *)b)[1]=temp;
+#define	SWAP_DRAW_SURF(a,b) temp=*(drawSurf_t *)(a);*(drawSurf_t *)(a)=*(drawSurf_t *)(b);*(drawSurf_t *)(b)=temp;
 
 /* this parameter defines the cutoff between using quick sort and
    insertion sort for arrays; arrays with lengths shorter or equal to the
@@ -1013,7 +1020,7 @@ qsort replacement
 
 static void shortsort( drawSurf_t *lo, drawSurf_t *hi ) {
     drawSurf_t	*p, *max;
-	int			temp;
+	drawSurf_t	temp;
 
     while (hi > lo) {
         max = lo;
@@ -1032,7 +1039,7 @@ static void shortsort( drawSurf_t *lo, drawSurf_t *hi ) {
 FIXME: this was lifted and modified from the microsoft lib source...
  */
 
-void qsortFast (
+static void qsortFast (
     void *base,
     unsigned num,
     unsigned width
@@ -1044,11 +1051,7 @@ void qsortFast (
     unsigned size;              /* size of the sub-array */
     char *lostk[30], *histk[30];
     int stkptr;                 /* stack for saving sub-array to be processed */
-	int	temp;
-
-	if ( sizeof(drawSurf_t) != 8 ) {
-		ri.Error( ERR_DROP, "change SWAP_DRAW_SURF macro" );
-	}
+	drawSurf_t	temp;
 
     /* Note: the number of stack entries required is no more than
        1 + log2(size), so 30 is sufficient for any array */
@@ -1189,6 +1192,242 @@ recurse:
         return;                 /* all subarrays done */
 }
 
+/*
+=================
+R_RadixSortDrawSurfs
+
+Stable least significant digit sort, eight bits of the key per pass.
+All of the digit histograms are gathered in one walk over the keys, and
+a pass is skipped when every key has the same digit, which usually drops
+the unused high shader bits and the fog byte.
+=================
+*/
+#define	RADIX_BITS		8
+#define	RADIX_SIZE		(1<<RADIX_BITS)
+#define	RADIX_PASSES	((int)sizeof(sortKey_t) * 8 / RADIX_BITS)
+#define	RADIX_CUTOFF	32		// shorter lists use an insertion sort
+
+static drawSurf_t	radixSurfs[MAX_DRAWSURFS];
+
+void R_RadixSortDrawSurfs( drawSurf_t *drawSurfs, int numDrawSurfs ) {
+	int			counts[RADIX_PASSES][RADIX_SIZE];
+	int			*count;
+	drawSurf_t	*src, *dst, *swap;
+	drawSurf_t	temp;
+	sortKey_t	key;
+	int			pass, shift;
+	int			i, j, c, sum;
+
+	if ( numDrawSurfs <= RADIX_CUTOFF ) {
+		for ( i = 1 ; i < numDrawSurfs ; i++ ) {
+			temp = drawSurfs[i];
+			for ( j = i ; j > 0 && drawSurfs[j-1].sort > temp.sort ; j-- ) {
+				drawSurfs[j] = drawSurfs[j-1];
+			}
+			drawSurfs[j] = temp;
+		}
+		return;
+	}
+
+	Com_Memset( counts, 0, sizeof( counts ) );
+	for ( i = 0 ; i < numDrawSurfs ; i++ ) {
+		key = drawSurfs[i].sort;
+		for ( pass = 0 ; pass < RADIX_PASSES ; pass++, key >>= RADIX_BITS ) {
+			counts[pass][ key & (RADIX_SIZE-1) ]++;
+		}
+	}
+
+	src = drawSurfs;
+	dst = radixSurfs;
+	for ( pass = 0 ; pass < RADIX_PASSES ; pass++ ) {
+		shift = pass * RADIX_BITS;
+		count = counts[pass];
+
+		// every key has the same digit, so nothing would move
+		if ( count[ ( src[0].sort >> shift ) & (RADIX_SIZE-1) ] == numDrawSurfs ) {
+			continue;
+		}
+
+		for ( i = 0, sum = 0 ; i < RADIX_SIZE ; i++ ) {
+			c = count[i];
+			count[i] = sum;
+			sum += c;
+		}
+		for ( i = 0 ; i < numDrawSurfs ; i++ ) {
+			dst[ count[ ( src[i].sort >> shift ) & (RADIX_SIZE-1) ]++ ] = src[i];
+		}
+
+		swap = src;
+		src = dst;
+		dst = swap;
+	}
+
+	if ( src != drawSurfs ) {
+		Com_Memcpy( drawSurfs, src, numDrawSurfs * sizeof( *drawSurfs ) );
+	}
+}
+
+/*
+==========================================================================================
+
+DRAWSURF CAPTURE
+
+"capturedrawsurfs <name>" writes the unsorted keys of the next main view
+to drawsurfs/<name>.dsl, and "sortbench <name>" replays them through both
+sorts.  Keys are stored as little endian ints, low word first.
+
+==========================================================================================
+*/
+
+#define	DSL_IDENT		(('1'<<24)+('L'<<16)+('S'<<8)+'D')
+
+typedef struct {
+	int		ident;
+	int		keyBytes;
+	int		numDrawSurfs;
+} dslHeader_t;
+
+static char		captureName[MAX_QPATH];
+
+/*
+=================
+R_WriteDrawSurfs
+=================
+*/
+static void R_WriteDrawSurfs( const drawSurf_t *drawSurfs, int numDrawSurfs ) {
+	dslHeader_t	*header;
+	int			*out;
+	int			size;
+	int			i;
+
+	size = sizeof( *header ) + numDrawSurfs * sizeof( sortKey_t );
+	header = ri.Hunk_AllocateTempMemory( size );
+	header->ident = LittleLong( DSL_IDENT );
+	header->keyBytes = LittleLong( sizeof( sortKey_t ) );
+	header->numDrawSurfs = LittleLong( numDrawSurfs );
+
+	out = (int *)( header + 1 );
+	for ( i = 0 ; i < numDrawSurfs ; i++ ) {
+		*out++ = LittleLong( (int)drawSurfs[i].sort );
+#ifdef R_SORTKEY64
+		*out++ = LittleLong( (int)( drawSurfs[i].sort >> 32 ) );
+#endif
+	}
+
+	ri.FS_WriteFile( va( "drawsurfs/%s.dsl", captureName ), header, size );
+	ri.Hunk_FreeTempMemory( header );
+
+	ri.Printf( PRINT_ALL, "Wrote %i drawsurfs to drawsurfs/%s.dsl\n", numDrawSurfs, captureName );
+	captureName[0] = 0;
+}
+
+/*
+=================
+R_CaptureDrawSurfs_f
+=================
+*/
+void R_CaptureDrawSurfs_f( void ) {
+	if ( ri.Cmd_Argc() != 2 ) {
+		ri.Printf( PRINT_ALL, "usage: capturedrawsurfs <name>\n" );
+		return;
+	}
+	Q_strncpyz( captureName, ri.Cmd_Argv( 1 ), sizeof( captureName ) );
+}
+
+/*
+=================
+R_SortBench_f
+
+Times the old quicksort against the radix sort on a captured list
+and checks that both produce the same key order.
+=================
+*/
+void R_SortBench_f( void ) {
+	dslHeader_t	*header;
+	const int	*in;
+	drawSurf_t	*surfs, *work, *check;
+	int			numDrawSurfs, iterations;
+	int			len, size;
+	int			i, start;
+	int			qsortMsec, radixMsec;
+	qboolean	mismatch;
+
+	if ( ri.Cmd_Argc() < 2 ) {
+		ri.Printf( PRINT_ALL, "usage: sortbench <name> [iterations]\n" );
+		return;
+	}
+	iterations = 200;
+	if ( ri.Cmd_Argc() > 2 ) {
+		iterations = atoi( ri.Cmd_Argv( 2 ) );
+		if ( iterations < 1 ) {
+			iterations = 1;
+		}
+	}
+
+	len = ri.FS_ReadFile( va( "drawsurfs/%s.dsl", ri.Cmd_Argv( 1 ) ), (void **)&header );
+	if ( !header ) {
+		ri.Printf( PRINT_ALL, "Couldn't load drawsurfs/%s.dsl\n", ri.Cmd_Argv( 1 ) );
+		return;
+	}
+	numDrawSurfs = LittleLong( header->numDrawSurfs );
+	if ( len < (int)sizeof( *header ) || LittleLong( header->ident ) != DSL_IDENT
+		|| numDrawSurfs < 1 || numDrawSurfs > MAX_DRAWSURFS
+		|| len < (int)( sizeof( *header ) + numDrawSurfs * LittleLong( header->keyBytes ) ) ) {
+		ri.Printf( PRINT_ALL, "drawsurfs/%s.dsl is not a drawsurf capture\n", ri.Cmd_Argv( 1 ) );
+		ri.FS_FreeFile( header );
+		return;
+	}
+	if ( LittleLong( header->keyBytes ) != sizeof( sortKey_t ) ) {
+		ri.Printf( PRINT_ALL, "drawsurfs/%s.dsl was captured with %i byte sort keys\n",
+			ri.Cmd_Argv( 1 ), LittleLong( header->keyBytes ) );
+		ri.FS_FreeFile( header );
+		return;
+	}
+
+	size = numDrawSurfs * sizeof( drawSurf_t );
+	surfs = ri.Hunk_AllocateTempMemory( size * 3 );
+	work = surfs + numDrawSurfs;
+	check = work + numDrawSurfs;
+
+	in = (const int *)( header + 1 );
+	for ( i = 0 ; i < numDrawSurfs ; i++ ) {
+		surfs[i].sort = (unsigned)LittleLong( *in++ );
+#ifdef R_SORTKEY64
+		surfs[i].sort |= (sortKey_t)(unsigned)LittleLong( *in++ ) << 32;
+#endif
+		surfs[i].surface = NULL;
+	}
+	ri.FS_FreeFile( header );
+
+	start = ri.Milliseconds();
+	for ( i = 0 ; i < iterations ; i++ ) {
+		Com_Memcpy( work, surfs, size );
+		qsortFast( work, numDrawSurfs, sizeof( drawSurf_t ) );
+	}
+	qsortMsec = ri.Milliseconds() - start;
+	Com_Memcpy( check, work, size );
+
+	start = ri.Milliseconds();
+	for ( i = 0 ; i < iterations ; i++ ) {
+		Com_Memcpy( work, surfs, size );
+		R_RadixSortDrawSurfs( work, numDrawSurfs );
+	}
+	radixMsec = ri.Milliseconds() - start;
+
+	mismatch = qfalse;
+	for ( i = 0 ; i < numDrawSurfs ; i++ ) {
+		if ( work[i].sort != check[i].sort ) {
+			mismatch = qtrue;
+			break;
+		}
+	}
+	ri.Hunk_FreeTempMemory( surfs );
+
+	ri.Printf( PRINT_ALL, "%i drawsurfs, %i iterations: qsort %.3f msec, radix %.3f msec%s\n",
+		numDrawSurfs, iterations, qsortMsec / (float)iterations, radixMsec / (float)iterations,
+		mismatch ? " (ORDER MISMATCH)" : "" );
+}
+
 
 //==========================================================================================
 
@@ -1199,17 +1438,23 @@ R_AddDrawSurf
 */
 void R_AddDrawSurf( surfaceType_t *surface, shader_t *shader, 
 				   int fogIndex, int dlightMap ) {
-	int			index;
+	drawSurf_t	*drawSurf;
 
 	// instead of checking for overflow, we just mask the index
 	// so it wraps around
-	index = tr.refdef.numDrawSurfs & DRAWSURF_MASK;
-	// the sort data is packed into a single 32 bit value so it can be
-	// compared quickly during the qsorting process
-	tr.refdef.drawSurfs[index].sort = (shader->sortedIndex << QSORT_SHADERNUM_SHIFT) 
-		| tr.shiftedEntityNum | ( fogIndex << QSORT_FOGNUM_SHIFT ) | (int)dlightMap;
-	tr.refdef.drawSurfs[index].surface = surface;
-	tr.refdef.numDrawSurfs++;
+	if ( frontEnd->drawSurfs ) {
+		// job workers keep their own list until the batch is merged
+		drawSurf = &frontEnd->drawSurfs[ frontEnd->numDrawSurfs & DRAWSURF_MASK ];
+		frontEnd->numDrawSurfs++;
+	} else {
+		drawSurf = &tr.refdef.drawSurfs[ tr.refdef.numDrawSurfs & DRAWSURF_MASK ];
+		tr.refdef.numDrawSurfs++;
+	}
+	// the sort data is packed into a single sortKey_t so it can be
+	// compared quickly during the sorting process
+	drawSurf->sort = ((sortKey_t)shader->sortedIndex << QSORT_SHADERNUM_SHIFT) 
+		| frontEnd->shiftedEntityNum | ( fogIndex << QSORT_FOGNUM_SHIFT ) | (int)dlightMap;
+	drawSurf->surface = surface;
 }
 
 /*
@@ -1217,11 +1462,11 @@ void R_AddDrawSurf( surfaceType_t *surface, shader_t *shader,
 R_DecomposeSort
 =================
 */
-void R_DecomposeSort( unsigned sort, int *entityNum, shader_t **shader, 
+void R_DecomposeSort( sortKey_t sort, int *entityNum, shader_t **shader, 
 					 int *fogNum, int *dlightMap ) {
 	*fogNum = ( sort >> QSORT_FOGNUM_SHIFT ) & 31;
 	*shader = tr.sortedShaders[ ( sort >> QSORT_SHADERNUM_SHIFT ) & (MAX_SHADERS-1) ];
-	*entityNum = ( sort >> QSORT_ENTITYNUM_SHIFT ) & 1023;
+	*entityNum = ( sort >> QSORT_ENTITYNUM_SHIFT ) & QSORT_ENTITYNUM_MASK;
 	*dlightMap = sort & 3;
 }
 
@@ -1251,8 +1496,12 @@ void R_SortDrawSurfs( drawSurf_t *drawSurfs, int numDrawSurfs ) {
 		numDrawSurfs = MAX_DRAWSURFS;
 	}
 
+	if ( captureName[0] && !tr.viewParms.isPortal ) {
+		R_WriteDrawSurfs( drawSurfs, numDrawSurfs );
+	}
+
 	// sort the drawsurfs by sort type, then orientation, then shader
-	qsortFast (drawSurfs, numDrawSurfs, sizeof(drawSurf_t) );
+	R_RadixSortDrawSurfs( drawSurfs, numDrawSurfs );
 
 	// check for any pass through drawing, which
 	// may cause another view to be rendered first
@@ -1283,26 +1532,30 @@ void R_SortDrawSurfs( drawSurf_t *drawSurfs, int numDrawSurfs ) {
 
 /*
 =============
-R_AddEntitySurfaces
+R_AddEntitySurfacesJob
 =============
 */
-void R_AddEntitySurfaces (void) {
+#define	ENTITIES_PER_JOB	4
+
+static void R_AddEntitySurfacesJob( int index ) {
 	trRefEntity_t	*ent;
 	shader_t		*shader;
+	int				last;
 
-	if ( !r_drawentities->integer ) {
-		return;
+	last = ( index + 1 ) * ENTITIES_PER_JOB;
+	if ( last > tr.refdef.num_entities ) {
+		last = tr.refdef.num_entities;
 	}
 
-	for ( tr.currentEntityNum = 0; 
-	      tr.currentEntityNum < tr.refdef.num_entities; 
-		  tr.currentEntityNum++ ) {
-		ent = tr.currentEntity = &tr.refdef.entities[tr.currentEntityNum];
+	for ( frontEnd->currentEntityNum = index * ENTITIES_PER_JOB; 
+	      frontEnd->currentEntityNum < last; 
+		  frontEnd->currentEntityNum++ ) {
+		ent = frontEnd->currentEntity = &tr.refdef.entities[frontEnd->currentEntityNum];
 
 		ent->needDlights = qfalse;
 
 		// preshift the value we are going to OR into the drawsurf sort
-		tr.shiftedEntityNum = tr.currentEntityNum << QSORT_ENTITYNUM_SHIFT;
+		frontEnd->shiftedEntityNum = (sortKey_t)frontEnd->currentEntityNum << QSORT_ENTITYNUM_SHIFT;
 
 		//
 		// the weapon model must be handled special --
@@ -1333,14 +1586,14 @@ void R_AddEntitySurfaces (void) {
 			break;
 
 		case RT_MODEL:
-			// we must set up parts of tr.or for model culling
-			R_RotateForEntity( ent, &tr.viewParms, &tr.or );
+			// we must set up parts of frontEnd->or for model culling
+			R_RotateForEntity( ent, &tr.viewParms, &frontEnd->or );
 
-			tr.currentModel = R_GetModelByHandle( ent->e.hModel );
-			if (!tr.currentModel) {
+			frontEnd->currentModel = R_GetModelByHandle( ent->e.hModel );
+			if (!frontEnd->currentModel) {
 				R_AddDrawSurf( &entitySurface, tr.defaultShader, 0, 0 );
 			} else {
-				switch ( tr.currentModel->type ) {
+				switch ( frontEnd->currentModel->type ) {
 				case MOD_MESH:
 					R_AddMD3Surfaces( ent );
 					break;
@@ -1358,16 +1611,31 @@ void R_AddEntitySurfaces (void) {
 					R_AddDrawSurf( &entitySurface, tr.defaultShader, 0, 0 );
 					break;
 				default:
-					ri.Error( ERR_DROP, "R_AddEntitySurfaces: Bad modeltype" );
+					R_JobError( ERR_DROP, "R_AddEntitySurfaces: Bad modeltype" );
 					break;
 				}
 			}
 			break;
 		default:
-			ri.Error( ERR_DROP, "R_AddEntitySurfaces: Bad reType" );
+			R_JobError( ERR_DROP, "R_AddEntitySurfaces: Bad reType" );
 		}
 	}
+}
+
+/*
+=============
+R_AddEntitySurfaces
+
+Entities are handed to the front end jobs a few at a time
+=============
+*/
+void R_AddEntitySurfaces (void) {
+	if ( !r_drawentities->integer ) {
+		return;
+	}
 
+	R_RunFrontEndJobs( R_AddEntitySurfacesJob,
+		( tr.refdef.num_entities + ENTITIES_PER_JOB - 1 ) / ENTITIES_PER_JOB );
 }
 
 
@@ -92,15 +92,15 @@ static int R_CullModel( md3Header_t *header, trRefEntity_t *ent ) {
 			switch ( R_CullLocalPointAndRadius( newFrame->localOrigin, newFrame->radius ) )
 			{
 			case CULL_OUT:
-				tr.pc.c_sphere_cull_md3_out++;
+				frontEnd->pc->c_sphere_cull_md3_out++;
 				return CULL_OUT;
 
 			case CULL_IN:
-				tr.pc.c_sphere_cull_md3_in++;
+				frontEnd->pc->c_sphere_cull_md3_in++;
 				return CULL_IN;
 
 			case CULL_CLIP:
-				tr.pc.c_sphere_cull_md3_clip++;
+				frontEnd->pc->c_sphere_cull_md3_clip++;
 				break;
 			}
 		}
@@ -119,17 +119,17 @@ static int R_CullModel( md3Header_t *header, trRefEntity_t *ent ) {
 			{
 				if ( sphereCull == CULL_OUT )
 				{
-					tr.pc.c_sphere_cull_md3_out++;
+					frontEnd->pc->c_sphere_cull_md3_out++;
 					return CULL_OUT;
 				}
 				else if ( sphereCull == CULL_IN )
 				{
-					tr.pc.c_sphere_cull_md3_in++;
+					frontEnd->pc->c_sphere_cull_md3_in++;
 					return CULL_IN;
 				}
 				else
 				{
-					tr.pc.c_sphere_cull_md3_clip++;
+					frontEnd->pc->c_sphere_cull_md3_clip++;
 				}
 			}
 		}
@@ -144,14 +144,14 @@ static int R_CullModel( md3Header_t *header, trRefEntity_t *ent ) {
 	switch ( R_CullLocalBox( bounds ) )
 	{
 	case CULL_IN:
-		tr.pc.c_box_cull_md3_in++;
+		frontEnd->pc->c_box_cull_md3_in++;
 		return CULL_IN;
 	case CULL_CLIP:
-		tr.pc.c_box_cull_md3_clip++;
+		frontEnd->pc->c_box_cull_md3_clip++;
 		return CULL_CLIP;
 	case CULL_OUT:
 	default:
-		tr.pc.c_box_cull_md3_out++;
+		frontEnd->pc->c_box_cull_md3_out++;
 		return CULL_OUT;
 	}
 }
@@ -170,7 +170,7 @@ int R_ComputeLOD( trRefEntity_t *ent ) {
 	md3Frame_t *frame;
 	int lod;
 
-	if ( tr.currentModel->numLods < 2 )
+	if ( frontEnd->currentModel->numLods < 2 )
 	{
 		// model has only 1 LOD level, skip computations and bias
 		lod = 0;
@@ -180,7 +180,7 @@ int R_ComputeLOD( trRefEntity_t *ent ) {
 		// multiple LODs exist, so compute projected bounding sphere
 		// and use that as a criteria for selecting LOD
 
-		frame = ( md3Frame_t * ) ( ( ( unsigned char * ) tr.currentModel->md3[0] ) + tr.currentModel->md3[0]->ofsFrames );
+		frame = ( md3Frame_t * ) ( ( ( unsigned char * ) frontEnd->currentModel->md3[0] ) + frontEnd->currentModel->md3[0]->ofsFrames );
 
 		frame += ent->e.frame;
 
@@ -198,23 +198,23 @@ int R_ComputeLOD( trRefEntity_t *ent ) {
 			flod = 0;
 		}
 
-		flod *= tr.currentModel->numLods;
+		flod *= frontEnd->currentModel->numLods;
 		lod = myftol( flod );
 
 		if ( lod < 0 )
 		{
 			lod = 0;
 		}
-		else if ( lod >= tr.currentModel->numLods )
+		else if ( lod >= frontEnd->currentModel->numLods )
 		{
-			lod = tr.currentModel->numLods - 1;
+			lod = frontEnd->currentModel->numLods - 1;
 		}
 	}
 
 	lod += r_lodbias->integer;
 	
-	if ( lod >= tr.currentModel->numLods )
-		lod = tr.currentModel->numLods - 1;
+	if ( lod >= frontEnd->currentModel->numLods )
+		lod = frontEnd->currentModel->numLods - 1;
 	if ( lod < 0 )
 		lod = 0;
 
@@ -279,8 +279,8 @@ void R_AddMD3Surfaces( trRefEntity_t *ent ) {
 	personalModel = (ent->e.renderfx & RF_THIRD_PERSON) && !tr.viewParms.isPortal;
 
 	if ( ent->e.renderfx & RF_WRAP_FRAMES ) {
-		ent->e.frame %= tr.currentModel->md3[0]->numFrames;
-		ent->e.oldframe %= tr.currentModel->md3[0]->numFrames;
+		ent->e.frame %= frontEnd->currentModel->md3[0]->numFrames;
+		ent->e.oldframe %= frontEnd->currentModel->md3[0]->numFrames;
 	}
 
 	//
@@ -289,13 +289,13 @@ void R_AddMD3Surfaces( trRefEntity_t *ent ) {
 	// when the surfaces are rendered, they don't need to be
 	// range checked again.
 	//
-	if ( (ent->e.frame >= tr.currentModel->md3[0]->numFrames) 
+	if ( (ent->e.frame >= frontEnd->currentModel->md3[0]->numFrames) 
 		|| (ent->e.frame < 0)
-		|| (ent->e.oldframe >= tr.currentModel->md3[0]->numFrames)
+		|| (ent->e.oldframe >= frontEnd->currentModel->md3[0]->numFrames)
 		|| (ent->e.oldframe < 0) ) {
-			ri.Printf( PRINT_DEVELOPER, "R_AddMD3Surfaces: no such frame %d to %d for '%s'\n",
+			R_JobPrintf( PRINT_DEVELOPER, "R_AddMD3Surfaces: no such frame %d to %d for '%s'\n",
 				ent->e.oldframe, ent->e.frame,
-				tr.currentModel->name );
+				frontEnd->currentModel->name );
 			ent->e.frame = 0;
 			ent->e.oldframe = 0;
 	}
@@ -305,7 +305,7 @@ void R_AddMD3Surfaces( trRefEntity_t *ent ) {
 	//
 	lod = R_ComputeLOD( ent );
 
-	header = tr.currentModel->md3[lod];
+	header = frontEnd->currentModel->md3[lod];
 
 	//
 	// cull the entire model if merged bounding box of both frames
@@ -352,10 +352,10 @@ void R_AddMD3Surfaces( trRefEntity_t *ent ) {
 				}
 			}
 			if (shader == tr.defaultShader) {
-				ri.Printf( PRINT_DEVELOPER, "WARNING: no shader for surface %s in skin %s\n", surface->name, skin->name);
+				R_JobPrintf( PRINT_DEVELOPER, "WARNING: no shader for surface %s in skin %s\n", surface->name, skin->name);
 			}
 			else if (shader->defaultShader) {
-				ri.Printf( PRINT_DEVELOPER, "WARNING: shader %s in skin %s not found\n", shader->name, skin->name);
+				R_JobPrintf( PRINT_DEVELOPER, "WARNING: shader %s in skin %s not found\n", shader->name, skin->name);
 			}
 		} else if ( surface->numShaders <= 0 ) {
 			shader = tr.defaultShader;
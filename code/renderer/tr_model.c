@@ -209,6 +209,59 @@ fail:
 }
 
 
+/*
+=================
+R_DecodeMD3Frames
+
+Expands every frame of every surface into float arrays of x, y, z and
+normal x, y, z so RB_SurfaceMesh can lerp them without unpacking
+=================
+*/
+static void R_DecodeMD3Frames( model_t *mod, md3Header_t *md3 ) {
+	md3Surface_t	*surf;
+	md3XyzNormal_t	*xyz;
+	float			*out;
+	int				i, j, f;
+	int				stride, size;
+	unsigned		lat, lng;
+
+	size = 0;
+	surf = (md3Surface_t *)( (byte *)md3 + md3->ofsSurfaces );
+	for ( i = 0 ; i < md3->numSurfaces ; i++ ) {
+		size += MD3_DECODED_STRIDE( surf->numVerts ) * 6 * surf->numFrames * sizeof( float );
+		surf = (md3Surface_t *)( (byte *)surf + surf->ofsEnd );
+	}
+
+	out = ri.Hunk_Alloc( size, h_low );
+	mod->dataSize += size;
+
+	surf = (md3Surface_t *)( (byte *)md3 + md3->ofsSurfaces );
+	for ( i = 0 ; i < md3->numSurfaces ; i++ ) {
+		stride = MD3_DECODED_STRIDE( surf->numVerts );
+		surf->flags = (byte *)out - (byte *)surf;
+
+		xyz = (md3XyzNormal_t *)( (byte *)surf + surf->ofsXyzNormals );
+		for ( f = 0 ; f < surf->numFrames ; f++, out += stride * 6 ) {
+			for ( j = 0 ; j < surf->numVerts ; j++, xyz++ ) {
+				out[j] = xyz->xyz[0] * MD3_XYZ_SCALE;
+				out[stride+j] = xyz->xyz[1] * MD3_XYZ_SCALE;
+				out[stride*2+j] = xyz->xyz[2] * MD3_XYZ_SCALE;
+
+				// the same lat/long decode as LerpMeshVertexes
+				lat = ( xyz->normal >> 8 ) & 0xff;
+				lng = ( xyz->normal & 0xff );
+				lat *= (FUNCTABLE_SIZE/256);
+				lng *= (FUNCTABLE_SIZE/256);
+				out[stride*3+j] = tr.sinTable[(lat+(FUNCTABLE_SIZE/4))&FUNCTABLE_MASK] * tr.sinTable[lng];
+				out[stride*4+j] = tr.sinTable[lat] * tr.sinTable[lng];
+				out[stride*5+j] = tr.sinTable[(lng+(FUNCTABLE_SIZE/4))&FUNCTABLE_MASK];
+			}
+		}
+
+		surf = (md3Surface_t *)( (byte *)surf + surf->ofsEnd );
+	}
+}
+
 /*
 =================
 R_LoadMD3
@@ -295,6 +348,10 @@ static qboolean R_LoadMD3 (model_t *mod, int lod, void *buffer, const char *mod_
         LL(surf->ofsSt);
         LL(surf->ofsXyzNormals);
         LL(surf->ofsEnd);
+
+		// flags are unused in md3 files, R_DecodeMD3Frames
+		// reuses them for the offset to the decoded frames
+		surf->flags = 0;
 		
 		if ( surf->numVerts > SHADER_MAX_VERTEXES ) {
 			ri.Error (ERR_DROP, "R_LoadMD3: %s has more than %i verts on a surface (%i)",
@@ -361,6 +418,10 @@ static qboolean R_LoadMD3 (model_t *mod, int lod, void *buffer, const char *mod_
 		// find the next surface
 		surf = (md3Surface_t *)( (byte *)surf + surf->ofsEnd );
 	}
+
+	if ( r_md3Cache->integer ) {
+		R_DecodeMD3Frames( mod, mod->md3[lod] );
+	}
     
 	return qtrue;
 }
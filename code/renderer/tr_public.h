@@ -24,7 +24,16 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include "../cgame/tr_types.h"
 
-#define	REF_API_VERSION		8
+#define	REF_API_VERSION		9
+
+// what the GL driver was asked to do, only counted by drivers that record
+typedef struct {
+	int		frames;
+	int		drawCalls;
+	int		stateChanges;
+	int		vertices;
+	double	bytes;		// vertex, index and texel traffic
+} glCounters_t;
 
 //
 // these are the functions exported by the refresh module
@@ -97,6 +106,9 @@ typedef struct {
 	void	(*RemapShader)(const char *oldShader, const char *newShader, const char *offsetTime);
 	qboolean (*GetEntityToken)( char *buffer, int size );
 	qboolean (*inPVS)( const vec3_t p1, const vec3_t p2 );
+
+	// running totals, all zero unless the GL driver records
+	void	(*GetGLCounters)( glCounters_t *counters );
 } refexport_t;
 
 //
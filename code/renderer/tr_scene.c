@@ -100,8 +100,8 @@ void R_AddPolygonSurfaces( void ) {
 	shader_t	*sh;
 	srfPoly_t	*poly;
 
-	tr.currentEntityNum = ENTITYNUM_WORLD;
-	tr.shiftedEntityNum = tr.currentEntityNum << QSORT_ENTITYNUM_SHIFT;
+	frontEnd->currentEntityNum = ENTITYNUM_WORLD;
+	frontEnd->shiftedEntityNum = (sortKey_t)frontEnd->currentEntityNum << QSORT_ENTITYNUM_SHIFT;
 
 	for ( i = 0, poly = tr.refdef.polys; i < tr.refdef.numPolys ; i++, poly++ ) {
 		sh = R_GetShaderByHandle( poly->hShader );
@@ -274,6 +274,140 @@ void RE_AddAdditiveLightToScene( const vec3_t org, float intensity, float r, flo
 	RE_AddDynamicLightToScene( org, intensity, r, g, b, qtrue );
 }
 
+/*
+=================
+R_StereoSceneMatches
+
+The right eye can use the left eye's surfaces if its scene is the same
+one seen from a sideways offset the left eye's cull allowed for
+=================
+*/
+static qboolean R_StereoSceneMatches( const stereoScene_t *scene ) {
+	const trRefdef_t	*left = &scene->refdef;
+	vec3_t				delta;
+
+	if ( !scene->valid ) {
+		return qfalse;
+	}
+	if ( left->x != tr.refdef.x || left->y != tr.refdef.y
+		|| left->width != tr.refdef.width || left->height != tr.refdef.height
+		|| left->fov_x != tr.refdef.fov_x || left->fov_y != tr.refdef.fov_y
+		|| left->time != tr.refdef.time || left->rdflags != tr.refdef.rdflags ) {
+		return qfalse;
+	}
+	if ( left->num_entities != tr.refdef.num_entities || left->num_dlights != tr.refdef.num_dlights
+		|| left->numPolys != tr.refdef.numPolys ) {
+		return qfalse;
+	}
+	if ( memcmp( left->viewaxis, tr.refdef.viewaxis, sizeof( left->viewaxis ) )
+		|| memcmp( left->areamask, tr.refdef.areamask, sizeof( left->areamask ) ) ) {
+		return qfalse;
+	}
+
+	VectorSubtract( tr.refdef.vieworg, left->vieworg, delta );
+	if ( fabs( DotProduct( delta, left->viewaxis[0] ) ) > 0.01f
+		|| fabs( DotProduct( delta, left->viewaxis[2] ) ) > 0.01f
+		|| fabs( DotProduct( delta, left->viewaxis[1] ) ) > STEREO_CULL_MARGIN ) {
+		return qfalse;
+	}
+
+	// the left eye's leafs are only right for the same cluster
+	if ( !( tr.refdef.rdflags & RDF_NOWORLDMODEL ) && R_PointCluster( tr.refdef.vieworg ) != scene->viewCluster ) {
+		return qfalse;
+	}
+
+	return qtrue;
+}
+
+/*
+=================
+R_StereoReplayScene
+
+Queues the left eye's sorted surfaces again from the right eye's origin,
+only the view and projection matrices are rebuilt
+=================
+*/
+static qboolean R_StereoReplayScene( const viewParms_t *parms ) {
+	stereoScene_t	*scene;
+	trRefdef_t		refdef;
+
+	if ( tr.stereoFrame != STEREO_RIGHT || !r_stereoSinglePass->integer ) {
+		return qfalse;
+	}
+	if ( tr.stereoSceneNum >= tr.numStereoScenes ) {
+		return qfalse;
+	}
+	scene = &tr.stereoScenes[tr.stereoSceneNum++];
+	if ( !R_StereoSceneMatches( scene ) ) {
+		return qfalse;
+	}
+
+	// the surfaces refer to the left eye's entities and dlights
+	refdef = tr.refdef;
+	tr.refdef = scene->refdef;
+	VectorCopy( refdef.vieworg, tr.refdef.vieworg );
+
+	tr.viewCount++;
+
+	tr.viewParms = scene->viewParms;
+	VectorCopy( parms->or.origin, tr.viewParms.or.origin );
+	VectorCopy( parms->pvsOrigin, tr.viewParms.pvsOrigin );
+	tr.viewParms.frameSceneNum = tr.frameSceneNum;
+	tr.viewParms.frameCount = tr.frameCount;
+	tr.viewParms.stereoMargin = 0;
+
+	R_RotateForViewer();
+	R_SetupFrustum();
+	R_SetupProjection();
+
+	R_AddDrawSurfCmd( scene->drawSurfs, scene->numDrawSurfs );
+
+	tr.refdef = refdef;
+	tr.stereoReplays++;
+	return qtrue;
+}
+
+/*
+=================
+R_StereoRecordScene
+
+Keeps the left eye's scene for the right eye, unless something in it
+depends on where exactly the eye is
+=================
+*/
+static void R_StereoRecordScene( const viewParms_t *parms, int firstDrawSurf ) {
+	stereoScene_t	*scene;
+	shader_t		*shader;
+	int				entityNum, fogNum, dlighted;
+
+	if ( tr.numStereoScenes >= MAX_STEREO_SCENES ) {
+		return;
+	}
+	scene = &tr.stereoScenes[tr.numStereoScenes++];
+
+	scene->refdef = tr.refdef;
+	scene->viewParms = tr.viewParms;
+	scene->drawSurfs = tr.refdef.drawSurfs + firstDrawSurf;
+	scene->numDrawSurfs = tr.refdef.numDrawSurfs - firstDrawSurf;
+	scene->viewCluster = tr.viewCluster;
+	scene->valid = qtrue;
+
+	// wrapped around the drawsurf buffer, or nothing was queued at all
+	if ( tr.refdef.numDrawSurfs > MAX_DRAWSURFS || parms->viewportWidth <= 0
+		|| parms->viewportHeight <= 0 ) {
+		scene->valid = qfalse;
+		return;
+	}
+
+	// portal and mirror views are rendered from the eye position
+	if ( scene->numDrawSurfs > 0 ) {
+		R_DecomposeSort( scene->drawSurfs[0].sort, &entityNum, &shader, &fogNum, &dlighted );
+		if ( shader->sort <= SS_PORTAL ) {
+			scene->valid = qfalse;
+		}
+	}
+}
+
 /*
 @@@@@@@@@@@@@@@@@@@@@
 RE_RenderScene
@@ -447,7 +581,20 @@ void RE_RenderScene( const refdef_t *fd ) {
 		R_RenderView( &parms );
 		R_RenderView( &parms2 );
 	} else {*/
-		R_RenderView( &parms ); 
+	if ( !R_StereoReplayScene( &parms ) ) {
+		int		firstDrawSurf = tr.refdef.numDrawSurfs;
+
+		if ( tr.stereoFrame == STEREO_LEFT && r_stereoSinglePass->integer ) {
+			parms.stereoMargin = STEREO_CULL_MARGIN;
+			R_RenderView( &parms );
+			R_StereoRecordScene( &parms, firstDrawSurf );
+		} else {
+			if ( tr.stereoFrame == STEREO_RIGHT ) {
+				tr.stereoRenders++;
+			}
+			R_RenderView( &parms );
+		}
+	}
 	/*}
 
 	// Render Scene to Eye Buffers
@@ -481,5 +628,9 @@ void RE_RenderScene( const refdef_t *fd ) {
 	r_firstSceneDlight = r_numdlights;
 	r_firstScenePoly = r_numpolys;
 
-	tr.frontEndMsec += ri.Milliseconds() - startTime;
+	startTime = ri.Milliseconds() - startTime;
+	tr.frontEndMsec += startTime;
+	if ( tr.stereoFrame == STEREO_LEFT || tr.stereoFrame == STEREO_RIGHT ) {
+		tr.stereoMsec[tr.stereoFrame == STEREO_RIGHT] += startTime;
+	}
 }
@@ -317,6 +317,7 @@ void RB_BeginSurface( shader_t *shader, int fogNum ) {
 
 	tess.numIndexes = 0;
 	tess.numVertexes = 0;
+	tess.numBufferRanges = 0;
 	tess.shader = state;
 	tess.fogNum = fogNum;
 	tess.dlightBits = 0;		// will be OR'd in by surface functions
@@ -1302,14 +1303,186 @@ void RB_StageIteratorLightmappedMultitexture( void ) {
 	}
 }
 
+/*
+** RB_DrawBufferRanges
+*/
+#define	BUFFER_OFFSET(i)	((byte *)NULL + (i))
+
+static void RB_DrawBufferRanges( void ) {
+	const GLvoid	*offsets[MAX_BUFFER_RANGES];
+	int				i;
+
+	for ( i = 0; i < tess.numBufferRanges; i++ ) {
+		offsets[i] = BUFFER_OFFSET( tess.bufferFirstIndex[i] * sizeof( glIndex_t ) );
+	}
+
+	if ( qglMultiDrawElementsEXT ) {
+		qglMultiDrawElementsEXT( GL_TRIANGLES, tess.bufferNumIndexes, GL_INDEX_TYPE, offsets, tess.numBufferRanges );
+		return;
+	}
+
+	for ( i = 0; i < tess.numBufferRanges; i++ ) {
+		qglDrawElements( GL_TRIANGLES, tess.bufferNumIndexes[i], GL_INDEX_TYPE, offsets[i] );
+	}
+}
+
+/*
+** RB_StaticColors
+**
+** Returns the offset of the vertex colors the stage draws with, or -1
+** after filling in the constant color.  Only handles what
+** ComputeStaticGeometry lets through.
+*/
+static int RB_StaticColors( shaderStage_t *pStage, byte *color ) {
+	switch ( pStage->rgbGen ) {
+	case CGEN_EXACT_VERTEX:
+		return offsetof( bufferVert_t, color );
+	case CGEN_VERTEX:
+		if ( tr.identityLight == 1 ) {
+			return offsetof( bufferVert_t, color );
+		}
+		return offsetof( bufferVert_t, litColor );
+	case CGEN_IDENTITY:
+		color[0] = color[1] = color[2] = color[3] = 0xff;
+		break;
+	case CGEN_CONST:
+		*(int *)color = *(int *)pStage->constantColor;
+		break;
+	case CGEN_IDENTITY_LIGHTING:
+	default:
+		color[0] = color[1] = color[2] = color[3] = tr.identityLightByte;
+		break;
+	}
+
+	switch ( pStage->alphaGen ) {
+	case AGEN_IDENTITY:
+		color[3] = 0xff;
+		break;
+	case AGEN_CONST:
+		color[3] = pStage->constantColor[3];
+		break;
+	default:
+		break;
+	}
+
+	return -1;
+}
+
+/*
+** RB_StageIteratorStatic
+**
+** Draws the queued world buffer ranges with the current shader
+*/
+static void RB_StageIteratorStatic( void ) {
+	shader_t		*shader;
+	shaderStage_t	*pStage;
+	int				stage;
+	int				colors;
+	byte			color[4];
+
+	shader = tess.shader;
+
+	if ( r_logFile->integer ) {
+		GLimp_LogComment( va("--- RB_StageIteratorStatic( %s ) ---\n", shader->name) );
+	}
+
+	GL_Cull( shader->cullType );
+
+	if ( shader->polygonOffset ) {
+		qglEnable( GL_POLYGON_OFFSET_FILL );
+		qglPolygonOffset( r_offsetFactor->value, r_offsetUnits->value );
+	}
+
+	qglBindBufferARB( GL_ARRAY_BUFFER_ARB, tr.world->vertexBuffer );
+	qglBindBufferARB( GL_ELEMENT_ARRAY_BUFFER_ARB, tr.world->indexBuffer );
+
+	qglVertexPointer( 3, GL_FLOAT, sizeof( bufferVert_t ), BUFFER_OFFSET( offsetof( bufferVert_t, xyz ) ) );
+	qglEnableClientState( GL_TEXTURE_COORD_ARRAY );
+
+	for ( stage = 0; stage < MAX_SHADER_STAGES; stage++ ) {
+		pStage = tess.xstages[stage];
+
+		if ( !pStage ) {
+			break;
+		}
+
+		colors = RB_StaticColors( pStage, color );
+		if ( colors >= 0 ) {
+			qglEnableClientState( GL_COLOR_ARRAY );
+			qglColorPointer( 4, GL_UNSIGNED_BYTE, sizeof( bufferVert_t ), BUFFER_OFFSET( colors ) );
+		} else {
+			qglDisableClientState( GL_COLOR_ARRAY );
+			qglColor4ubv( color );
+		}
+
+		GL_State( pStage->stateBits );
+
+		qglTexCoordPointer( 2, GL_FLOAT, sizeof( bufferVert_t ), BUFFER_OFFSET( pStage->bundle[0].tcGen == TCGEN_LIGHTMAP ?
+			offsetof( bufferVert_t, lightmap ) : offsetof( bufferVert_t, st ) ) );
+		R_BindAnimatedImage( &pStage->bundle[0] );
+
+		if ( !pStage->bundle[1].image[0] ) {
+			RB_DrawBufferRanges();
+			continue;
+		}
+
+		// same hack as DrawMultitextured
+		if ( backEnd.viewParms.isPortal ) {
+			qglPolygonMode( GL_FRONT_AND_BACK, GL_FILL );
+		}
+
+		GL_SelectTexture( 1 );
+		qglEnable( GL_TEXTURE_2D );
+		qglEnableClientState( GL_TEXTURE_COORD_ARRAY );
+		GL_TexEnv( shader->multitextureEnv );
+		qglTexCoordPointer( 2, GL_FLOAT, sizeof( bufferVert_t ), BUFFER_OFFSET( pStage->bundle[1].tcGen == TCGEN_LIGHTMAP ?
+			offsetof( bufferVert_t, lightmap ) : offsetof( bufferVert_t, st ) ) );
+		R_BindAnimatedImage( &pStage->bundle[1] );
+
+		RB_DrawBufferRanges();
+
+		// unlike DrawMultitextured, don't leave the array pointing
+		// into the buffer for the tess paths
+		qglDisableClientState( GL_TEXTURE_COORD_ARRAY );
+		qglDisable( GL_TEXTURE_2D );
+		GL_SelectTexture( 0 );
+	}
+
+	qglBindBufferARB( GL_ARRAY_BUFFER_ARB, 0 );
+	qglBindBufferARB( GL_ELEMENT_ARRAY_BUFFER_ARB, 0 );
+
+	// point the arrays back at tess
+	qglVertexPointer( 3, GL_FLOAT, 16, tess.xyz );
+	qglColorPointer( 4, GL_UNSIGNED_BYTE, 0, tess.svars.colors );
+	qglTexCoordPointer( 2, GL_FLOAT, 0, tess.svars.texcoords[0] );
+
+	if ( shader->polygonOffset ) {
+		qglDisable( GL_POLYGON_OFFSET_FILL );
+	}
+}
+
 /*
 ** RB_EndSurface
 */
 void RB_EndSurface( void ) {
 	shaderCommands_t *input;
+	int			i;
 
 	input = &tess;
 
+	if ( input->numBufferRanges ) {
+		// for debugging of sort order issues, stop rendering after a given sort value
+		if ( !r_debugSort->integer || r_debugSort->integer >= tess.shader->sort ) {
+			backEnd.pc.c_shaders++;
+			for ( i = 0; i < input->numBufferRanges; i++ ) {
+				backEnd.pc.c_indexes += input->bufferNumIndexes[i];
+				backEnd.pc.c_totalIndexes += input->bufferNumIndexes[i] * tess.numPasses;
+			}
+			RB_StageIteratorStatic();
+		}
+		input->numBufferRanges = 0;
+	}
+
 	if (input->numIndexes == 0) {
 		return;
 	}
@@ -1331,6 +1504,8 @@ void RB_EndSurface( void ) {
 		return;
 	}
 
+	RB_CaptureTess();
+
 	//
 	// update performance counters
 	//
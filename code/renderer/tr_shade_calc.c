@@ -22,6 +22,9 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 // tr_shade_calc.c
 
 #include "tr_local.h"
+#if idsse2
+#include <emmintrin.h>
+#endif
 
 
 #define	WAVEVALUE( table, base, amplitude, phase, freq )  ((base) + table[ myftol( ( ( (phase) + tess.shaderTime * (freq) ) * FUNCTABLE_SIZE ) ) & FUNCTABLE_MASK ] * (amplitude))
@@ -80,6 +83,65 @@ static float EvalWaveFormClamped( const waveForm_t *wf )
 	return glow;
 }
 
+#if idsse2
+/*
+** SSE2 helpers
+*
+* The vector kernels below work on four vertexes at a time.  tess.xyz and
+* tess.normal are vec4_t, so four of them transpose into x, y and z lanes.
+* Everything follows the scalar code's order of operations, and Q_rsqrt4
+* is Q_rsqrt's bit trick, so results match the scalar loops.
+*/
+static void LoadVectors4( const float *v, __m128 *x, __m128 *y, __m128 *z ) {
+	__m128	a, b, c, d;
+
+	a = _mm_loadu_ps( v );
+	b = _mm_loadu_ps( v + 4 );
+	c = _mm_loadu_ps( v + 8 );
+	d = _mm_loadu_ps( v + 12 );
+	_MM_TRANSPOSE4_PS( a, b, c, d );
+	*x = a;
+	*y = b;
+	*z = c;
+}
+
+static __m128 DotProduct4( __m128 x, __m128 y, __m128 z, __m128 vx, __m128 vy, __m128 vz ) {
+	return _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, vx ), _mm_mul_ps( y, vy ) ), _mm_mul_ps( z, vz ) );
+}
+
+static __m128 Q_rsqrt4( __m128 number ) {
+	__m128	y;
+
+	y = _mm_castsi128_ps( _mm_sub_epi32( _mm_set1_epi32( 0x5f3759df ),
+		_mm_srai_epi32( _mm_castps_si128( number ), 1 ) ) );
+	return _mm_mul_ps( y, _mm_sub_ps( _mm_set1_ps( 1.5f ),
+		_mm_mul_ps( _mm_mul_ps( _mm_mul_ps( number, _mm_set1_ps( 0.5f ) ), y ), y ) ) );
+}
+
+// four table entries, with the indexes truncated like myftol
+static __m128 TableLookup4( const float *table, __m128 index ) {
+	int		i[4];
+
+	_mm_storeu_si128( (__m128i *)i, _mm_and_si128( _mm_cvttps_epi32( index ), _mm_set1_epi32( FUNCTABLE_MASK ) ) );
+	return _mm_setr_ps( table[i[0]], table[i[1]], table[i[2]], table[i[3]] );
+}
+
+// splits four st pairs into s and t lanes
+static void LoadTexCoords4( const float *st, __m128 *s, __m128 *t ) {
+	__m128	a, b;
+
+	a = _mm_loadu_ps( st );
+	b = _mm_loadu_ps( st + 4 );
+	*s = _mm_shuffle_ps( a, b, _MM_SHUFFLE( 2, 0, 2, 0 ) );
+	*t = _mm_shuffle_ps( a, b, _MM_SHUFFLE( 3, 1, 3, 1 ) );
+}
+
+static void StoreTexCoords4( float *st, __m128 s, __m128 t ) {
+	_mm_storeu_ps( st, _mm_unpacklo_ps( s, t ) );
+	_mm_storeu_ps( st + 4, _mm_unpackhi_ps( s, t ) );
+}
+#endif
+
 /*
 ** RB_CalcStretchTexCoords
 */
@@ -124,11 +186,23 @@ void RB_CalcDeformVertexes( deformStage_t *ds )
 	float	*normal = ( float * ) tess.normal;
 	float	*table;
 
+	i = 0;
 	if ( ds->deformationWave.frequency == 0 )
 	{
 		scale = EvalWaveForm( &ds->deformationWave );
 
-		for ( i = 0; i < tess.numVertexes; i++, xyz += 4, normal += 4 )
+#if idsse2
+		if ( r_simdTess->integer ) {
+			__m128	scale4;
+
+			// leave w alone
+			scale4 = _mm_setr_ps( scale, scale, scale, 0 );
+			for ( ; i < tess.numVertexes; i++, xyz += 4, normal += 4 ) {
+				_mm_storeu_ps( xyz, _mm_add_ps( _mm_loadu_ps( xyz ), _mm_mul_ps( _mm_loadu_ps( normal ), scale4 ) ) );
+			}
+		}
+#endif
+		for ( ; i < tess.numVertexes; i++, xyz += 4, normal += 4 )
 		{
 			VectorScale( normal, scale, offset );
 			
@@ -141,7 +215,32 @@ void RB_CalcDeformVertexes( deformStage_t *ds )
 	{
 		table = TableForFunc( ds->deformationWave.func );
 
-		for ( i = 0; i < tess.numVertexes; i++, xyz += 4, normal += 4 )
+#if idsse2
+		if ( r_simdTess->integer ) {
+			__m128	x, y, z, index, mask;
+			float	scales[4];
+			int		j;
+
+			mask = _mm_castsi128_ps( _mm_setr_epi32( -1, -1, -1, 0 ) );
+			for ( ; i + 4 <= tess.numVertexes; i += 4, xyz += 16, normal += 16 ) {
+				LoadVectors4( xyz, &x, &y, &z );
+
+				// WAVEVALUE with the phase offset by position
+				index = _mm_add_ps( _mm_set1_ps( ds->deformationWave.phase ),
+					_mm_mul_ps( _mm_add_ps( _mm_add_ps( x, y ), z ), _mm_set1_ps( ds->deformationSpread ) ) );
+				index = _mm_mul_ps( _mm_add_ps( index, _mm_set1_ps( tess.shaderTime * ds->deformationWave.frequency ) ),
+					_mm_set1_ps( FUNCTABLE_SIZE ) );
+				_mm_storeu_ps( scales, _mm_add_ps( _mm_set1_ps( ds->deformationWave.base ),
+					_mm_mul_ps( TableLookup4( table, index ), _mm_set1_ps( ds->deformationWave.amplitude ) ) ) );
+
+				for ( j = 0 ; j < 4 ; j++ ) {
+					_mm_storeu_ps( xyz + j*4, _mm_add_ps( _mm_loadu_ps( xyz + j*4 ),
+						_mm_mul_ps( _mm_loadu_ps( normal + j*4 ), _mm_and_ps( _mm_set1_ps( scales[j] ), mask ) ) ) );
+				}
+			}
+		}
+#endif
+		for ( ; i < tess.numVertexes; i++, xyz += 4, normal += 4 )
 		{
 			float off = ( xyz[0] + xyz[1] + xyz[2] ) * ds->deformationSpread;
 
@@ -207,7 +306,28 @@ void RB_CalcBulgeVertexes( deformStage_t *ds ) {
 
 	now = backEnd.refdef.time * ds->bulgeSpeed * 0.001f;
 
-	for ( i = 0; i < tess.numVertexes; i++, xyz += 4, st += 4, normal += 4 ) {
+	i = 0;
+#if idsse2
+	if ( r_simdTess->integer ) {
+		__m128	off, mask;
+		float	scales[4];
+		int		j;
+
+		mask = _mm_castsi128_ps( _mm_setr_epi32( -1, -1, -1, 0 ) );
+		for ( ; i + 4 <= tess.numVertexes; i += 4, xyz += 16, st += 16, normal += 16 ) {
+			off = _mm_mul_ps( _mm_set1_ps( (float)( FUNCTABLE_SIZE / (M_PI*2) ) ),
+				_mm_add_ps( _mm_mul_ps( _mm_setr_ps( st[0], st[4], st[8], st[12] ), _mm_set1_ps( ds->bulgeWidth ) ),
+				_mm_set1_ps( now ) ) );
+			_mm_storeu_ps( scales, _mm_mul_ps( TableLookup4( tr.sinTable, off ), _mm_set1_ps( ds->bulgeHeight ) ) );
+
+			for ( j = 0 ; j < 4 ; j++ ) {
+				_mm_storeu_ps( xyz + j*4, _mm_add_ps( _mm_loadu_ps( xyz + j*4 ),
+					_mm_mul_ps( _mm_loadu_ps( normal + j*4 ), _mm_and_ps( _mm_set1_ps( scales[j] ), mask ) ) ) );
+			}
+		}
+	}
+#endif
+	for ( ; i < tess.numVertexes; i++, xyz += 4, st += 4, normal += 4 ) {
 		int		off;
 		float scale;
 
@@ -246,7 +366,18 @@ void RB_CalcMoveVertexes( deformStage_t *ds ) {
 	VectorScale( ds->moveVector, scale, offset );
 
 	xyz = ( float * ) tess.xyz;
-	for ( i = 0; i < tess.numVertexes; i++, xyz += 4 ) {
+	i = 0;
+#if idsse2
+	if ( r_simdTess->integer ) {
+		__m128	offset4;
+
+		offset4 = _mm_setr_ps( offset[0], offset[1], offset[2], 0 );
+		for ( ; i < tess.numVertexes; i++, xyz += 4 ) {
+			_mm_storeu_ps( xyz, _mm_add_ps( _mm_loadu_ps( xyz ), offset4 ) );
+		}
+	}
+#endif
+	for ( ; i < tess.numVertexes; i++, xyz += 4 ) {
 		VectorAdd( xyz, offset, xyz );
 	}
 }
@@ -839,6 +970,9 @@ void RB_CalcFogTexCoords( float *st ) {
 
 		eyeT = DotProduct( backEnd.or.viewOrigin, fogDepthVector ) + fogDepthVector[3];
 	} else {
+		// every point is inside, t was computed from an uninitialized vector before
+		fogDepthVector[0] = fogDepthVector[1] = fogDepthVector[2] = 0;
+		fogDepthVector[3] = 1;
 		eyeT = 1;	// non-surface fog always has eye inside
 	}
 
@@ -853,8 +987,37 @@ void RB_CalcFogTexCoords( float *st ) {
 
 	fogDistanceVector[3] += 1.0/512;
 
+	i = 0;
+	v = tess.xyz[0];
+#if idsse2
+	if ( r_simdTess->integer ) {
+		__m128	x, y, z, s4, t4, cut, outside;
+
+		for ( ; i + 4 <= tess.numVertexes ; i += 4, v += 16, st += 8 ) {
+			LoadVectors4( v, &x, &y, &z );
+			s4 = _mm_add_ps( DotProduct4( x, y, z, _mm_set1_ps( fogDistanceVector[0] ), _mm_set1_ps( fogDistanceVector[1] ),
+				_mm_set1_ps( fogDistanceVector[2] ) ), _mm_set1_ps( fogDistanceVector[3] ) );
+			t4 = _mm_add_ps( DotProduct4( x, y, z, _mm_set1_ps( fogDepthVector[0] ), _mm_set1_ps( fogDepthVector[1] ),
+				_mm_set1_ps( fogDepthVector[2] ) ), _mm_set1_ps( fogDepthVector[3] ) );
+
+			// the same cases as below, selected per lane
+			if ( eyeOutside ) {
+				outside = _mm_cmplt_ps( t4, _mm_set1_ps( 1.0f ) );
+				cut = _mm_add_ps( _mm_set1_ps( 1.0f/32 ), _mm_div_ps( _mm_mul_ps( _mm_set1_ps( 30.0f/32 ), t4 ),
+					_mm_sub_ps( t4, _mm_set1_ps( eyeT ) ) ) );
+			} else {
+				outside = _mm_cmplt_ps( t4, _mm_setzero_ps() );
+				cut = _mm_set1_ps( 31.0f/32 );
+			}
+			t4 = _mm_or_ps( _mm_and_ps( outside, _mm_set1_ps( 1.0f/32 ) ), _mm_andnot_ps( outside, cut ) );
+
+			StoreTexCoords4( st, s4, t4 );
+		}
+	}
+#endif
+
 	// calculate density for each point
-	for (i = 0, v = tess.xyz[0] ; i < tess.numVertexes ; i++, v += 4) {
+	for ( ; i < tess.numVertexes ; i++, v += 4) {
 		// calculate the length in fog
 		s = DotProduct( v, fogDistanceVector ) + fogDistanceVector[3];
 		t = DotProduct( v, fogDepthVector ) + fogDepthVector[3];
@@ -895,7 +1058,37 @@ void RB_CalcEnvironmentTexCoords( float *st )
 	v = tess.xyz[0];
 	normal = tess.normal[0];
 
-	for (i = 0 ; i < tess.numVertexes ; i++, v += 4, normal += 4, st += 2 ) 
+	i = 0;
+#if idsse2
+	if ( r_simdTess->integer ) {
+		__m128	x, y, z, nx, ny, nz, il, d;
+		__m128	half;
+
+		half = _mm_set1_ps( 0.5f );
+		for ( ; i + 4 <= tess.numVertexes ; i += 4, v += 16, normal += 16, st += 8 ) {
+			LoadVectors4( v, &x, &y, &z );
+			LoadVectors4( normal, &nx, &ny, &nz );
+
+			x = _mm_sub_ps( _mm_set1_ps( backEnd.or.viewOrigin[0] ), x );
+			y = _mm_sub_ps( _mm_set1_ps( backEnd.or.viewOrigin[1] ), y );
+			z = _mm_sub_ps( _mm_set1_ps( backEnd.or.viewOrigin[2] ), z );
+			il = Q_rsqrt4( DotProduct4( x, y, z, x, y, z ) );
+			x = _mm_mul_ps( x, il );
+			y = _mm_mul_ps( y, il );
+			z = _mm_mul_ps( z, il );
+
+			d = DotProduct4( nx, ny, nz, x, y, z );
+
+			// only the y and z of the reflection are used
+			y = _mm_sub_ps( _mm_mul_ps( _mm_mul_ps( ny, _mm_set1_ps( 2 ) ), d ), y );
+			z = _mm_sub_ps( _mm_mul_ps( _mm_mul_ps( nz, _mm_set1_ps( 2 ) ), d ), z );
+
+			StoreTexCoords4( st, _mm_add_ps( half, _mm_mul_ps( y, half ) ), _mm_sub_ps( half, _mm_mul_ps( z, half ) ) );
+		}
+	}
+#endif
+
+	for ( ; i < tess.numVertexes ; i++, v += 4, normal += 4, st += 2 ) 
 	{
 		VectorSubtract (backEnd.or.viewOrigin, v, viewer);
 		VectorNormalizeFast (viewer);
@@ -921,7 +1114,29 @@ void RB_CalcTurbulentTexCoords( const waveForm_t *wf, float *st )
 
 	now = ( wf->phase + tess.shaderTime * wf->frequency );
 
-	for ( i = 0; i < tess.numVertexes; i++, st += 2 )
+	i = 0;
+#if idsse2
+	if ( r_simdTess->integer ) {
+		__m128	x, y, z, s, t, amplitude;
+
+		amplitude = _mm_set1_ps( wf->amplitude );
+		for ( ; i + 4 <= tess.numVertexes; i += 4, st += 8 ) {
+			LoadVectors4( tess.xyz[i], &x, &y, &z );
+			LoadTexCoords4( st, &s, &t );
+
+			x = _mm_mul_ps( _mm_add_ps( _mm_mul_ps( _mm_add_ps( x, z ), _mm_set1_ps( 1.0f/128 * 0.125f ) ), _mm_set1_ps( now ) ),
+				_mm_set1_ps( FUNCTABLE_SIZE ) );
+			y = _mm_mul_ps( _mm_add_ps( _mm_mul_ps( y, _mm_set1_ps( 1.0f/128 * 0.125f ) ), _mm_set1_ps( now ) ),
+				_mm_set1_ps( FUNCTABLE_SIZE ) );
+			s = _mm_add_ps( s, _mm_mul_ps( TableLookup4( tr.sinTable, x ), amplitude ) );
+			t = _mm_add_ps( t, _mm_mul_ps( TableLookup4( tr.sinTable, y ), amplitude ) );
+
+			StoreTexCoords4( st, s, t );
+		}
+	}
+#endif
+
+	for ( ; i < tess.numVertexes; i++, st += 2 )
 	{
 		float s = st[0];
 		float t = st[1];
@@ -938,7 +1153,20 @@ void RB_CalcScaleTexCoords( const float scale[2], float *st )
 {
 	int i;
 
-	for ( i = 0; i < tess.numVertexes; i++, st += 2 )
+	i = 0;
+#if idsse2
+	if ( r_simdTess->integer ) {
+		__m128	scale2;
+
+		// two st pairs at a time
+		scale2 = _mm_setr_ps( scale[0], scale[1], scale[0], scale[1] );
+		for ( ; i + 2 <= tess.numVertexes; i += 2, st += 4 ) {
+			_mm_storeu_ps( st, _mm_mul_ps( _mm_loadu_ps( st ), scale2 ) );
+		}
+	}
+#endif
+
+	for ( ; i < tess.numVertexes; i++, st += 2 )
 	{
 		st[0] *= scale[0];
 		st[1] *= scale[1];
@@ -962,7 +1190,19 @@ void RB_CalcScrollTexCoords( const float scrollSpeed[2], float *st )
 	adjustedScrollS = adjustedScrollS - floor( adjustedScrollS );
 	adjustedScrollT = adjustedScrollT - floor( adjustedScrollT );
 
-	for ( i = 0; i < tess.numVertexes; i++, st += 2 )
+	i = 0;
+#if idsse2
+	if ( r_simdTess->integer ) {
+		__m128	scroll2;
+
+		scroll2 = _mm_setr_ps( adjustedScrollS, adjustedScrollT, adjustedScrollS, adjustedScrollT );
+		for ( ; i + 2 <= tess.numVertexes; i += 2, st += 4 ) {
+			_mm_storeu_ps( st, _mm_add_ps( _mm_loadu_ps( st ), scroll2 ) );
+		}
+	}
+#endif
+
+	for ( ; i < tess.numVertexes; i++, st += 2 )
 	{
 		st[0] += adjustedScrollS;
 		st[1] += adjustedScrollT;
@@ -976,7 +1216,25 @@ void RB_CalcTransformTexCoords( const texModInfo_t *tmi, float *st  )
 {
 	int i;
 
-	for ( i = 0; i < tess.numVertexes; i++, st += 2 )
+	i = 0;
+#if idsse2
+	if ( r_simdTess->integer ) {
+		__m128	st2, s2, t2;
+		__m128	m0, m1, translate;
+
+		m0 = _mm_setr_ps( tmi->matrix[0][0], tmi->matrix[0][1], tmi->matrix[0][0], tmi->matrix[0][1] );
+		m1 = _mm_setr_ps( tmi->matrix[1][0], tmi->matrix[1][1], tmi->matrix[1][0], tmi->matrix[1][1] );
+		translate = _mm_setr_ps( tmi->translate[0], tmi->translate[1], tmi->translate[0], tmi->translate[1] );
+		for ( ; i + 2 <= tess.numVertexes; i += 2, st += 4 ) {
+			st2 = _mm_loadu_ps( st );
+			s2 = _mm_shuffle_ps( st2, st2, _MM_SHUFFLE( 2, 2, 0, 0 ) );
+			t2 = _mm_shuffle_ps( st2, st2, _MM_SHUFFLE( 3, 3, 1, 1 ) );
+			_mm_storeu_ps( st, _mm_add_ps( _mm_add_ps( _mm_mul_ps( s2, m0 ), _mm_mul_ps( t2, m1 ) ), translate ) );
+		}
+	}
+#endif
+
+	for ( ; i < tess.numVertexes; i++, st += 2 )
 	{
 		float s = st[0];
 		float t = st[1];
@@ -1048,11 +1306,56 @@ void RB_CalcSpecularAlpha( unsigned char *alphas ) {
 
 	v = tess.xyz[0];
 	normal = tess.normal[0];
+	numVertexes = tess.numVertexes;
+	i = 0;
+
+#if idsse2
+	if ( r_simdTess->integer ) {
+		__m128	x, y, z, nx, ny, nz;
+		__m128	lx, ly, lz, il, d, l;
+		__m128i	rgba;
+
+		for ( ; i + 4 <= numVertexes ; i += 4, v += 16, normal += 16, alphas += 16 ) {
+			LoadVectors4( v, &x, &y, &z );
+			LoadVectors4( normal, &nx, &ny, &nz );
+
+			lx = _mm_sub_ps( _mm_set1_ps( lightOrigin[0] ), x );
+			ly = _mm_sub_ps( _mm_set1_ps( lightOrigin[1] ), y );
+			lz = _mm_sub_ps( _mm_set1_ps( lightOrigin[2] ), z );
+			il = Q_rsqrt4( DotProduct4( lx, ly, lz, lx, ly, lz ) );
+			lx = _mm_mul_ps( lx, il );
+			ly = _mm_mul_ps( ly, il );
+			lz = _mm_mul_ps( lz, il );
+
+			// reflected
+			d = _mm_mul_ps( DotProduct4( nx, ny, nz, lx, ly, lz ), _mm_set1_ps( 2 ) );
+			lx = _mm_sub_ps( _mm_mul_ps( nx, d ), lx );
+			ly = _mm_sub_ps( _mm_mul_ps( ny, d ), ly );
+			lz = _mm_sub_ps( _mm_mul_ps( nz, d ), lz );
+
+			// viewer
+			x = _mm_sub_ps( _mm_set1_ps( backEnd.or.viewOrigin[0] ), x );
+			y = _mm_sub_ps( _mm_set1_ps( backEnd.or.viewOrigin[1] ), y );
+			z = _mm_sub_ps( _mm_set1_ps( backEnd.or.viewOrigin[2] ), z );
+			il = Q_rsqrt4( DotProduct4( x, y, z, x, y, z ) );
+			l = _mm_mul_ps( DotProduct4( lx, ly, lz, x, y, z ), il );
+
+			// l^4 clamped to 0..255, zero where l is negative
+			d = _mm_mul_ps( l, l );
+			d = _mm_min_ps( _mm_mul_ps( _mm_mul_ps( d, d ), _mm_set1_ps( 255 ) ), _mm_set1_ps( 255 ) );
+			d = _mm_andnot_ps( _mm_cmplt_ps( l, _mm_setzero_ps() ), d );
+
+			rgba = _mm_loadu_si128( (__m128i *)alphas );
+			rgba = _mm_or_si128( _mm_and_si128( rgba, _mm_set1_epi32( 0x00ffffff ) ),
+				_mm_slli_epi32( _mm_cvttps_epi32( d ), 24 ) );
+			_mm_storeu_si128( (__m128i *)alphas, rgba );
+		}
+	}
+#endif
 
 	alphas += 3;
 
-	numVertexes = tess.numVertexes;
-	for (i = 0 ; i < numVertexes ; i++, v += 4, normal += 4, alphas += 4) {
+	for ( ; i < numVertexes ; i++, v += 4, normal += 4, alphas += 4) {
 		float ilength;
 
 		VectorSubtract( lightOrigin, v, lightDir );
@@ -1155,7 +1458,36 @@ void RB_CalcDiffuseColor( unsigned char *colors )
 	normalPerm = vec_lvsl(0,normal);
 #endif
 	numVertexes = tess.numVertexes;
-	for (i = 0 ; i < numVertexes ; i++, v += 4, normal += 4) {
+	i = 0;
+#if idsse2
+	if ( r_simdTess->integer ) {
+		__m128	nx, ny, nz, incoming;
+		__m128	r, g, b, a;
+		__m128i	c01, c23;
+
+		for ( ; i + 4 <= numVertexes ; i += 4, v += 16, normal += 16 ) {
+			LoadVectors4( normal, &nx, &ny, &nz );
+
+			// clamping incoming at zero gives the ambientLightInt bytes
+			incoming = _mm_max_ps( DotProduct4( nx, ny, nz, _mm_set1_ps( lightDir[0] ),
+				_mm_set1_ps( lightDir[1] ), _mm_set1_ps( lightDir[2] ) ), _mm_setzero_ps() );
+			r = _mm_castsi128_ps( _mm_cvttps_epi32( _mm_add_ps( _mm_set1_ps( ambientLight[0] ),
+				_mm_mul_ps( incoming, _mm_set1_ps( directedLight[0] ) ) ) ) );
+			g = _mm_castsi128_ps( _mm_cvttps_epi32( _mm_add_ps( _mm_set1_ps( ambientLight[1] ),
+				_mm_mul_ps( incoming, _mm_set1_ps( directedLight[1] ) ) ) ) );
+			b = _mm_castsi128_ps( _mm_cvttps_epi32( _mm_add_ps( _mm_set1_ps( ambientLight[2] ),
+				_mm_mul_ps( incoming, _mm_set1_ps( directedLight[2] ) ) ) ) );
+			a = _mm_castsi128_ps( _mm_set1_epi32( 255 ) );
+
+			// one RGBA per lane, then saturate down to bytes
+			_MM_TRANSPOSE4_PS( r, g, b, a );
+			c01 = _mm_packs_epi32( _mm_castps_si128( r ), _mm_castps_si128( g ) );
+			c23 = _mm_packs_epi32( _mm_castps_si128( b ), _mm_castps_si128( a ) );
+			_mm_storeu_si128( (__m128i *)( colors + i*4 ), _mm_packus_epi16( c01, c23 ) );
+		}
+	}
+#endif
+	for ( ; i < numVertexes ; i++, v += 4, normal += 4) {
 #if idppc_altivec
 		normalVec0 = vec_ld(0,(vector float *)normal);
 		normalVec1 = vec_ld(11,(vector float *)normal);
@@ -1203,3 +1535,416 @@ void RB_CalcDiffuseColor( unsigned char *colors )
 	}
 }
 
+
+
+/*
+====================================================================
+
+TESS CAPTURE
+
+"capturetess <name>" records the input of every batch of the next full
+frame to tess/<name>.tsb, and "tessbench <name>" replays the batches
+through the kernels above with r_simdTess off and on.  A batch is its
+vertex count, then xyz, normals, texcoords and vertex colors.
+
+====================================================================
+*/
+
+#define	TSB_IDENT			(('1'<<24)+('B'<<16)+('S'<<8)+'T')
+#define	TSB_VERTEX_BYTES	( 8 * sizeof( float ) + 4 )
+#define	TESS_CAPTURE_SIZE	( 8 << 20 )
+
+typedef struct {
+	int		ident;
+	int		numBatches;
+} tsbHeader_t;
+
+static char		tessCaptureName[MAX_QPATH];
+static byte		*tessCapture;
+static int		tessCaptureSize;
+
+/*
+=================
+RB_CaptureTess
+
+Called from RB_EndSurface for each batch that is drawn
+=================
+*/
+void RB_CaptureTess( void ) {
+	tsbHeader_t	*header;
+	int			*out;
+	int			i, j;
+
+	if ( !tessCapture ) {
+		return;
+	}
+	if ( tessCaptureSize + sizeof( int ) + tess.numVertexes * TSB_VERTEX_BYTES > TESS_CAPTURE_SIZE ) {
+		return;
+	}
+
+	header = (tsbHeader_t *)tessCapture;
+	header->numBatches++;
+
+	out = (int *)( tessCapture + tessCaptureSize );
+	*out++ = LittleLong( tess.numVertexes );
+	for ( i = 0 ; i < tess.numVertexes ; i++ ) {
+		for ( j = 0 ; j < 3 ; j++ ) {
+			*(float *)out++ = LittleFloat( tess.xyz[i][j] );
+		}
+		for ( j = 0 ; j < 3 ; j++ ) {
+			*(float *)out++ = LittleFloat( tess.normal[i][j] );
+		}
+		*(float *)out++ = LittleFloat( tess.texCoords[i][0][0] );
+		*(float *)out++ = LittleFloat( tess.texCoords[i][0][1] );
+		*out++ = *(int *)tess.vertexColors[i];
+	}
+	tessCaptureSize = (byte *)out - tessCapture;
+}
+
+/*
+=================
+RB_CaptureTessFrame
+
+Called from RB_SwapBuffers, so the capture always covers a whole frame
+=================
+*/
+void RB_CaptureTessFrame( void ) {
+	tsbHeader_t	*header;
+	int			numBatches;
+
+	if ( tessCapture ) {
+		header = (tsbHeader_t *)tessCapture;
+		numBatches = header->numBatches;
+		header->ident = LittleLong( TSB_IDENT );
+		header->numBatches = LittleLong( numBatches );
+
+		ri.FS_WriteFile( va( "tess/%s.tsb", tessCaptureName ), tessCapture, tessCaptureSize );
+		ri.Printf( PRINT_ALL, "Wrote %i batches to tess/%s.tsb\n", numBatches, tessCaptureName );
+
+		ri.Free( tessCapture );
+		tessCapture = NULL;
+		tessCaptureName[0] = 0;
+		return;
+	}
+
+	if ( tessCaptureName[0] ) {
+		tessCapture = ri.Malloc( TESS_CAPTURE_SIZE );
+		Com_Memset( tessCapture, 0, sizeof( tsbHeader_t ) );
+		tessCaptureSize = sizeof( tsbHeader_t );
+	}
+}
+
+/*
+=================
+R_CaptureTess_f
+=================
+*/
+void R_CaptureTess_f( void ) {
+	if ( ri.Cmd_Argc() != 2 ) {
+		ri.Printf( PRINT_ALL, "usage: capturetess <name>\n" );
+		return;
+	}
+	Q_strncpyz( tessCaptureName, ri.Cmd_Argv( 1 ), sizeof( tessCaptureName ) );
+}
+
+/*
+=================
+R_LoadTessBatch
+
+Fills tess and the stage vars from one captured batch
+=================
+*/
+static const int *R_LoadTessBatch( const int *in ) {
+	int		i, j;
+
+	tess.numVertexes = LittleLong( *in++ );
+	for ( i = 0 ; i < tess.numVertexes ; i++ ) {
+		for ( j = 0 ; j < 3 ; j++ ) {
+			tess.xyz[i][j] = LittleFloat( *(float *)in++ );
+		}
+		tess.xyz[i][3] = 0;
+		for ( j = 0 ; j < 3 ; j++ ) {
+			tess.normal[i][j] = LittleFloat( *(float *)in++ );
+		}
+		tess.normal[i][3] = 0;
+		tess.texCoords[i][0][0] = LittleFloat( *(float *)in++ );
+		tess.texCoords[i][0][1] = LittleFloat( *(float *)in++ );
+		*(int *)tess.vertexColors[i] = *in++;
+
+		tess.svars.texcoords[0][i][0] = tess.texCoords[i][0][0];
+		tess.svars.texcoords[0][i][1] = tess.texCoords[i][0][1];
+		*(int *)tess.svars.colors[i] = *(int *)tess.vertexColors[i];
+	}
+	return in;
+}
+
+/*
+=================
+R_TessBench_f
+
+tessbench <name> [iterations]
+
+Every kernel gets fixed parameters, the captured batches supply the
+vertexes.  The error is the largest difference between the scalar and
+vector output, in texcoord or world units, or in color bytes.
+=================
+*/
+typedef enum {
+	TK_XYZ,
+	TK_ST,
+	TK_COLORS
+} tessKernelOutput_t;
+
+typedef struct {
+	const char			*name;
+	void				(*run)( void );
+	tessKernelOutput_t	output;
+} tessKernel_t;
+
+static deformStage_t	tkDeform, tkDeformNormal;
+static texModInfo_t		tkTexMod;
+static trRefEntity_t	tkEntity;
+
+static void TK_DeformVertexes( void ) { RB_CalcDeformVertexes( &tkDeform ); }
+static void TK_DeformNormal( void ) { RB_CalcDeformVertexes( &tkDeformNormal ); }
+static void TK_Bulge( void ) { RB_CalcBulgeVertexes( &tkDeform ); }
+static void TK_Move( void ) { RB_CalcMoveVertexes( &tkDeform ); }
+static void TK_Diffuse( void ) { RB_CalcDiffuseColor( tess.svars.colors[0] ); }
+static void TK_Specular( void ) { RB_CalcSpecularAlpha( tess.svars.colors[0] ); }
+static void TK_Environment( void ) { RB_CalcEnvironmentTexCoords( tess.svars.texcoords[0][0] ); }
+static void TK_Fog( void ) { RB_CalcFogTexCoords( tess.svars.texcoords[0][0] ); }
+static void TK_Turbulent( void ) { RB_CalcTurbulentTexCoords( &tkTexMod.wave, tess.svars.texcoords[0][0] ); }
+static void TK_Scale( void ) { RB_CalcScaleTexCoords( tkTexMod.scale, tess.svars.texcoords[0][0] ); }
+static void TK_Scroll( void ) { RB_CalcScrollTexCoords( tkTexMod.scroll, tess.svars.texcoords[0][0] ); }
+static void TK_Rotate( void ) { RB_CalcRotateTexCoords( tkTexMod.rotateSpeed, tess.svars.texcoords[0][0] ); }
+
+static tessKernel_t	tessKernels[] = {
+	{ "deformVertexes wave", TK_DeformVertexes, TK_XYZ },
+	{ "deformVertexes normal", TK_DeformNormal, TK_XYZ },
+	{ "deformVertexes bulge", TK_Bulge, TK_XYZ },
+	{ "deformVertexes move", TK_Move, TK_XYZ },
+	{ "rgbGen lightingDiffuse", TK_Diffuse, TK_COLORS },
+	{ "alphaGen lightingSpecular", TK_Specular, TK_COLORS },
+	{ "tcGen environment", TK_Environment, TK_ST },
+	{ "fog", TK_Fog, TK_ST },
+	{ "tcMod turb", TK_Turbulent, TK_ST },
+	{ "tcMod scale", TK_Scale, TK_ST },
+	{ "tcMod scroll", TK_Scroll, TK_ST },
+	{ "tcMod rotate", TK_Rotate, TK_ST }
+};
+
+static float R_TessKernelError( tessKernelOutput_t output, const float *checkXyz, const float *checkSt, const byte *checkColors ) {
+	float	err, maxErr;
+	int		i, j;
+
+	maxErr = 0;
+	for ( i = 0 ; i < tess.numVertexes ; i++ ) {
+		switch ( output ) {
+		case TK_XYZ:
+			for ( j = 0 ; j < 3 ; j++ ) {
+				err = fabs( tess.xyz[i][j] - checkXyz[i*4+j] );
+				if ( err > maxErr ) {
+					maxErr = err;
+				}
+			}
+			break;
+		case TK_ST:
+			for ( j = 0 ; j < 2 ; j++ ) {
+				err = fabs( tess.svars.texcoords[0][i][j] - checkSt[i*2+j] );
+				if ( err > maxErr ) {
+					maxErr = err;
+				}
+			}
+			break;
+		case TK_COLORS:
+			for ( j = 0 ; j < 4 ; j++ ) {
+				err = abs( tess.svars.colors[i][j] - checkColors[i*4+j] );
+				if ( err > maxErr ) {
+					maxErr = err;
+				}
+			}
+			break;
+		}
+	}
+	return maxErr;
+}
+
+void R_TessBench_f( void ) {
+	tsbHeader_t		*header;
+	const int		*batches, *in;
+	float			*checkXyz, *checkSt;
+	byte			*checkColors;
+	tessKernel_t	*k;
+	int				len, numBatches, numVertexes;
+	int				iterations;
+	int				i, b, n, simd;
+	int				start, msec[2];
+	int				oldSimd;
+	float			err, maxErr;
+	trRefEntity_t	*oldEntity;
+	orientationr_t	oldOr, oldViewOr;
+	world_t			*oldWorld;
+	world_t			world;
+	fog_t			fog;
+
+	if ( ri.Cmd_Argc() < 2 ) {
+		ri.Printf( PRINT_ALL, "usage: tessbench <name> [iterations]\n" );
+		return;
+	}
+	iterations = 100;
+	if ( ri.Cmd_Argc() > 2 ) {
+		iterations = atoi( ri.Cmd_Argv( 2 ) );
+		if ( iterations < 1 ) {
+			iterations = 1;
+		}
+	}
+
+	len = ri.FS_ReadFile( va( "tess/%s.tsb", ri.Cmd_Argv( 1 ) ), (void **)&header );
+	if ( !header ) {
+		ri.Printf( PRINT_ALL, "Couldn't load tess/%s.tsb\n", ri.Cmd_Argv( 1 ) );
+		return;
+	}
+
+	// check every batch before replaying any of them
+	numBatches = 0;
+	numVertexes = 0;
+	if ( len >= (int)sizeof( *header ) && LittleLong( header->ident ) == TSB_IDENT ) {
+		numBatches = LittleLong( header->numBatches );
+		in = (const int *)( header + 1 );
+		for ( b = 0 ; b < numBatches ; b++ ) {
+			if ( (byte *)in + sizeof( int ) > (byte *)header + len ) {
+				break;
+			}
+			n = LittleLong( *in );
+			if ( n < 0 || n > SHADER_MAX_VERTEXES
+				|| (byte *)in + sizeof( int ) + n * TSB_VERTEX_BYTES > (byte *)header + len ) {
+				break;
+			}
+			numVertexes += n;
+			in = (const int *)( (byte *)in + sizeof( int ) + n * TSB_VERTEX_BYTES );
+		}
+	}
+	if ( !numBatches || b != numBatches ) {
+		ri.Printf( PRINT_ALL, "tess/%s.tsb is not a tess capture\n", ri.Cmd_Argv( 1 ) );
+		ri.FS_FreeFile( header );
+		return;
+	}
+	batches = (const int *)( header + 1 );
+
+	// the kernels run on the back end's tess
+	R_SyncRenderThread();
+
+	oldSimd = r_simdTess->integer;
+	oldEntity = backEnd.currentEntity;
+	oldOr = backEnd.or;
+	oldViewOr = backEnd.viewParms.or;
+	oldWorld = tr.world;
+
+	tkDeform.deformationWave.func = GF_SIN;
+	tkDeform.deformationWave.base = 0;
+	tkDeform.deformationWave.amplitude = 2;
+	tkDeform.deformationWave.phase = 0;
+	tkDeform.deformationWave.frequency = 1.5f;
+	tkDeform.deformationSpread = 1.0f / 64;
+	tkDeform.bulgeWidth = 1;
+	tkDeform.bulgeHeight = 2;
+	tkDeform.bulgeSpeed = 1;
+	VectorSet( tkDeform.moveVector, 0, 0, 1 );
+	tkDeformNormal = tkDeform;
+	tkDeformNormal.deformationWave.frequency = 0;
+
+	tkTexMod.wave = tkDeform.deformationWave;
+	tkTexMod.wave.amplitude = 0.25f;
+	tkTexMod.scale[0] = 2;
+	tkTexMod.scale[1] = 0.5f;
+	tkTexMod.scroll[0] = 0.3f;
+	tkTexMod.scroll[1] = -0.2f;
+	tkTexMod.rotateSpeed = 30;
+
+	VectorSet( tkEntity.ambientLight, 48, 40, 32 );
+	VectorSet( tkEntity.directedLight, 200, 190, 180 );
+	VectorSet( tkEntity.lightDir, 0.48f, 0.6f, 0.64f );
+	((byte *)&tkEntity.ambientLightInt)[0] = 48;
+	((byte *)&tkEntity.ambientLightInt)[1] = 40;
+	((byte *)&tkEntity.ambientLightInt)[2] = 32;
+	((byte *)&tkEntity.ambientLightInt)[3] = 0xff;
+	backEnd.currentEntity = &tkEntity;
+
+	// identity orientation with the eye outside a fog volume
+	// that has a surface, the longest fog path
+	Com_Memset( &backEnd.or, 0, sizeof( backEnd.or ) );
+	backEnd.or.axis[0][0] = backEnd.or.axis[1][1] = backEnd.or.axis[2][2] = 1;
+	backEnd.or.modelMatrix[0] = backEnd.or.modelMatrix[5] = backEnd.or.modelMatrix[10] = backEnd.or.modelMatrix[15] = 1;
+	VectorSet( backEnd.or.viewOrigin, 64, 32, 96 );
+	backEnd.viewParms.or = backEnd.or;
+
+	Com_Memset( &fog, 0, sizeof( fog ) );
+	fog.tcScale = 1.0f / 512;
+	fog.hasSurface = qtrue;
+	fog.surface[2] = 1;
+	fog.surface[3] = 128;
+	Com_Memset( &world, 0, sizeof( world ) );
+	world.fogs = &fog;
+	world.numfogs = 1;
+	tr.world = &world;
+	tess.fogNum = 0;
+	tess.shaderTime = 1.25f;
+
+	checkXyz = ri.Hunk_AllocateTempMemory( SHADER_MAX_VERTEXES * ( 4 + 2 + 1 ) * sizeof( float ) );
+	checkSt = checkXyz + SHADER_MAX_VERTEXES * 4;
+	checkColors = (byte *)( checkSt + SHADER_MAX_VERTEXES * 2 );
+
+	ri.Printf( PRINT_ALL, "%i batches, %i vertexes, %i iterations\n", numBatches, numVertexes, iterations );
+	ri.Printf( PRINT_ALL, "                    kernel  scalar msec    simd msec  max error\n" );
+
+	for ( k = tessKernels ; k < tessKernels + sizeof( tessKernels ) / sizeof( tessKernels[0] ) ; k++ ) {
+		// correctness, one fresh run of each
+		maxErr = 0;
+		in = batches;
+		for ( b = 0 ; b < numBatches ; b++ ) {
+			ri.Cvar_Set( "r_simdTess", "0" );
+			R_LoadTessBatch( in );
+			k->run();
+			Com_Memcpy( checkXyz, tess.xyz, tess.numVertexes * sizeof( vec4_t ) );
+			Com_Memcpy( checkSt, tess.svars.texcoords[0], tess.numVertexes * sizeof( vec2_t ) );
+			Com_Memcpy( checkColors, tess.svars.colors, tess.numVertexes * sizeof( color4ub_t ) );
+
+			ri.Cvar_Set( "r_simdTess", "1" );
+			in = R_LoadTessBatch( in );
+			k->run();
+
+			err = R_TessKernelError( k->output, checkXyz, checkSt, checkColors );
+			if ( err > maxErr ) {
+				maxErr = err;
+			}
+		}
+
+		// timing, the kernels work in place so later iterations
+		// just keep deforming the same batch
+		for ( simd = 0 ; simd < 2 ; simd++ ) {
+			ri.Cvar_Set( "r_simdTess", simd ? "1" : "0" );
+			start = ri.Milliseconds();
+			in = batches;
+			for ( b = 0 ; b < numBatches ; b++ ) {
+				in = R_LoadTessBatch( in );
+				for ( i = 0 ; i < iterations ; i++ ) {
+					k->run();
+				}
+			}
+			msec[simd] = ri.Milliseconds() - start;
+		}
+
+		ri.Printf( PRINT_ALL, "%26s %12.3f %12.3f %10f\n", k->name,
+			msec[0] / (float)iterations, msec[1] / (float)iterations, maxErr );
+	}
+
+	ri.Hunk_FreeTempMemory( checkXyz );
+	ri.FS_FreeFile( header );
+
+	ri.Cvar_Set( "r_simdTess", va( "%i", oldSimd ) );
+	tess.numVertexes = 0;
+	backEnd.currentEntity = oldEntity;
+	backEnd.or = oldOr;
+	backEnd.viewParms.or = oldViewOr;
+	tr.world = oldWorld;
+}
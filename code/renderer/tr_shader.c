@@ -1695,6 +1695,84 @@ done:
 	return;
 }
 
+/*
+===================
+ComputeStaticGeometry
+
+See if world surfaces can draw this shader straight from the world
+buffers, which only works when nothing is computed per vertex
+===================
+*/
+static void ComputeStaticGeometry( void )
+{
+	int				stage, b;
+	shaderStage_t	*pStage;
+
+	shader.staticGeometry = qfalse;
+
+	if ( shader.isSky || shader.numDeforms || shader.sort == SS_PORTAL || !shader.numUnfoggedPasses )
+	{
+		return;
+	}
+
+	for ( stage = 0; stage < MAX_SHADER_STAGES; stage++ )
+	{
+		pStage = &stages[stage];
+
+		if ( !pStage->active )
+		{
+			break;
+		}
+
+		// the color has to be a constant or one of the stored vertex colors
+		switch ( pStage->rgbGen )
+		{
+		case CGEN_IDENTITY:
+		case CGEN_IDENTITY_LIGHTING:
+		case CGEN_CONST:
+			if ( pStage->alphaGen != AGEN_IDENTITY && pStage->alphaGen != AGEN_SKIP && pStage->alphaGen != AGEN_CONST )
+			{
+				return;
+			}
+			break;
+		case CGEN_VERTEX:
+			// ComputeColors keeps the vertex alpha here when nothing is scaled
+			if ( pStage->alphaGen == AGEN_IDENTITY && tr.identityLight == 1 )
+			{
+				break;
+			}
+			// fall through
+		case CGEN_EXACT_VERTEX:
+			if ( pStage->alphaGen != AGEN_SKIP && pStage->alphaGen != AGEN_VERTEX )
+			{
+				return;
+			}
+			break;
+		default:
+			return;
+		}
+
+		// and the texture coordinates the stored ones, untouched
+		for ( b = 0; b < NUM_TEXTURE_BUNDLES; b++ )
+		{
+			if ( b > 0 && !pStage->bundle[b].image[0] )
+			{
+				continue;
+			}
+			if ( pStage->bundle[b].tcGen != TCGEN_TEXTURE && pStage->bundle[b].tcGen != TCGEN_LIGHTMAP )
+			{
+				return;
+			}
+			if ( pStage->bundle[b].numTexMods )
+			{
+				return;
+			}
+		}
+	}
+
+	shader.staticGeometry = qtrue;
+}
+
 typedef struct {
 	int		blendA;
 	int		blendB;
@@ -1898,7 +1976,7 @@ static void FixRenderCommandList( int newShader ) {
                     sortedIndex = (( drawSurf->sort >> QSORT_SHADERNUM_SHIFT ) & (MAX_SHADERS-1));
 					if( sortedIndex >= newShader ) {
 						sortedIndex++;
-						drawSurf->sort = (sortedIndex << QSORT_SHADERNUM_SHIFT) | entityNum | ( fogNum << QSORT_FOGNUM_SHIFT ) | (int)dlightMap;
+						drawSurf->sort = ((sortKey_t)sortedIndex << QSORT_SHADERNUM_SHIFT) | ((sortKey_t)entityNum << QSORT_ENTITYNUM_SHIFT) | ( fogNum << QSORT_FOGNUM_SHIFT ) | (int)dlightMap;
 					}
 				}
 				curCmd = (const void *)(ds_cmd + 1);
@@ -2275,6 +2353,8 @@ static shader_t *FinishShader( void ) {
 	// determine which stage iterator function is appropriate
 	ComputeStageIteratorFunc();
 
+	ComputeStaticGeometry();
+
 	return GeneratePermanentShader();
 }
 
@@ -2284,8 +2364,10 @@ static shader_t *FinishShader( void ) {
 ====================
 FindShaderInShaderText
 
-Scans the combined text description of all the shader files for
-the given shader name.
+Looks up the given shader name in the labels of the combined text
+description of all the shader files.  Every label is in the hash
+table, so a name that isn't there has no definition and the text
+doesn't need to be scanned.
 
 return NULL if not found
 
@@ -2298,6 +2380,10 @@ static char *FindShaderInShaderText( const char *shadername ) {
 
 	int i, hash;
 
+	if ( !s_shaderText ) {
+		return NULL;
+	}
+
 	hash = generateHashValue(shadername, MAX_SHADERTEXT_HASH);
 
 	for (i = 0; shaderTextHashTable[hash][i]; i++) {
@@ -2308,28 +2394,6 @@ static char *FindShaderInShaderText( const char *shadername ) {
 		}
 	}
 
-	p = s_shaderText;
-
-	if ( !p ) {
-		return NULL;
-	}
-
-	// look for label
-	while ( 1 ) {
-		token = COM_ParseExt( &p, qtrue );
-		if ( token[0] == 0 ) {
-			break;
-		}
-
-		if ( !Q_stricmp( token, shadername ) ) {
-			return p;
-		}
-		else {
-			// skip the definition
-			SkipBracedSection( &p );
-		}
-	}
-
 	return NULL;
 }
 
@@ -2833,6 +2897,191 @@ void	R_ShaderList_f (void) {
 }
 
 
+/*
+=============================================================================
+
+SHADER CACHE
+
+The combined shader text and the position of every label in it are kept in
+one file, so starting up with the same shader files reads that instead of
+loading, compressing and scanning every script.  The key is a checksum over
+the script names and the pure checksums of the paks they are in.  Scripts
+that aren't in a pak are read and checksummed, so editing one is noticed.
+
+=============================================================================
+*/
+
+#define	SHADERCACHE_IDENT		(('1'<<24)+('B'<<16)+('D'<<8)+'S')	// little-endian "SDB1"
+#define	SHADERCACHE_VERSION		1
+#define	SHADERCACHE_NAME		"shadercache.dat"
+
+typedef struct {
+	int		ident;
+	int		version;
+	int		key;
+	int		textSize;		// including the trailing 0
+	int		numLabels;
+	// followed by textSize bytes of text
+	// and numLabels offsets of labels in the text, in hash table order
+} shaderCacheHeader_t;
+
+/*
+====================
+ShaderFilesKey
+====================
+*/
+static int ShaderFilesKey( char **shaderFiles, int numShaders ) {
+	char	filename[MAX_QPATH];
+	int		*sums;
+	int		i, len, key;
+	void	*buffer;
+
+	sums = ri.Hunk_AllocateTempMemory( numShaders * 2 * sizeof( int ) );
+
+	for ( i = 0 ; i < numShaders ; i++ ) {
+		Com_sprintf( filename, sizeof( filename ), "scripts/%s", shaderFiles[i] );
+		sums[i*2] = LittleLong( Com_BlockChecksum( filename, strlen( filename ) ) );
+		if ( ri.FS_FileIsInPAK( filename, &sums[i*2+1] ) == 1 ) {
+			sums[i*2+1] = LittleLong( sums[i*2+1] );
+			continue;
+		}
+		len = ri.FS_ReadFile( filename, &buffer );
+		if ( !buffer ) {
+			sums[i*2+1] = 0;
+			continue;
+		}
+		sums[i*2+1] = LittleLong( Com_BlockChecksum( buffer, len ) );
+		ri.FS_FreeFile( buffer );
+	}
+
+	key = Com_BlockChecksum( sums, numShaders * 2 * sizeof( int ) );
+
+	ri.Hunk_FreeTempMemory( sums );
+
+	return key;
+}
+
+/*
+====================
+LoadShaderCache
+
+Returns qfalse without touching the hunk if the cache is missing,
+damaged or for other shader files
+====================
+*/
+static qboolean LoadShaderCache( int key ) {
+	shaderCacheHeader_t	*header;
+	int					*offsets;
+	int					len, textSize, numLabels;
+	int					i, hash, size;
+	int					shaderTextHashTableSizes[MAX_SHADERTEXT_HASH];
+	char				*p, *token, *hashMem;
+
+	len = ri.FS_ReadFile( SHADERCACHE_NAME, (void **)&header );
+	if ( !header ) {
+		return qfalse;
+	}
+
+	if ( len < sizeof( *header )
+		|| LittleLong( header->ident ) != SHADERCACHE_IDENT
+		|| LittleLong( header->version ) != SHADERCACHE_VERSION
+		|| LittleLong( header->key ) != key ) {
+		ri.FS_FreeFile( header );
+		return qfalse;
+	}
+
+	textSize = LittleLong( header->textSize );
+	numLabels = LittleLong( header->numLabels );
+	p = (char *)( header + 1 );
+	offsets = (int *)( p + textSize );
+	if ( textSize <= 0 || numLabels < 0
+		|| len != sizeof( *header ) + textSize + numLabels * sizeof( int )
+		|| p[textSize-1] ) {
+		ri.FS_FreeFile( header );
+		return qfalse;
+	}
+	for ( i = 0 ; i < numLabels ; i++ ) {
+		offsets[i] = LittleLong( offsets[i] );
+		if ( offsets[i] < 0 || offsets[i] >= textSize ) {
+			ri.FS_FreeFile( header );
+			return qfalse;
+		}
+	}
+
+	s_shaderText = ri.Hunk_Alloc( textSize, h_low );
+	Com_Memcpy( s_shaderText, p, textSize );
+
+	Com_Memset(shaderTextHashTableSizes, 0, sizeof(shaderTextHashTableSizes));
+	for ( i = 0 ; i < numLabels ; i++ ) {
+		p = s_shaderText + offsets[i];
+		token = COM_ParseExt( &p, qtrue );
+		shaderTextHashTableSizes[ generateHashValue( token, MAX_SHADERTEXT_HASH ) ]++;
+	}
+
+	size = numLabels + MAX_SHADERTEXT_HASH;
+
+	hashMem = ri.Hunk_Alloc( size * sizeof(char *), h_low );
+
+	for (i = 0; i < MAX_SHADERTEXT_HASH; i++) {
+		shaderTextHashTable[i] = (char **) hashMem;
+		hashMem = ((char *) hashMem) + ((shaderTextHashTableSizes[i] + 1) * sizeof(char *));
+	}
+
+	Com_Memset(shaderTextHashTableSizes, 0, sizeof(shaderTextHashTableSizes));
+	for ( i = 0 ; i < numLabels ; i++ ) {
+		p = s_shaderText + offsets[i];
+		token = COM_ParseExt( &p, qtrue );
+		hash = generateHashValue( token, MAX_SHADERTEXT_HASH );
+		shaderTextHashTable[hash][shaderTextHashTableSizes[hash]++] = s_shaderText + offsets[i];
+	}
+
+	ri.FS_FreeFile( header );
+
+	return qtrue;
+}
+
+/*
+====================
+WriteShaderCache
+====================
+*/
+static void WriteShaderCache( int key ) {
+	shaderCacheHeader_t	*header;
+	int					*offsets;
+	int					textSize, numLabels, size;
+	int					i, j;
+
+	textSize = strlen( s_shaderText ) + 1;
+	numLabels = 0;
+	for ( i = 0 ; i < MAX_SHADERTEXT_HASH ; i++ ) {
+		for ( j = 0 ; shaderTextHashTable[i][j] ; j++ ) {
+			numLabels++;
+		}
+	}
+
+	size = sizeof( *header ) + textSize + numLabels * sizeof( int );
+	header = ri.Hunk_AllocateTempMemory( size );
+
+	header->ident = LittleLong( SHADERCACHE_IDENT );
+	header->version = LittleLong( SHADERCACHE_VERSION );
+	header->key = LittleLong( key );
+	header->textSize = LittleLong( textSize );
+	header->numLabels = LittleLong( numLabels );
+	Com_Memcpy( header + 1, s_shaderText, textSize );
+
+	// bucket by bucket, so the order within each bucket comes back the same
+	offsets = (int *)( (byte *)( header + 1 ) + textSize );
+	for ( i = 0 ; i < MAX_SHADERTEXT_HASH ; i++ ) {
+		for ( j = 0 ; shaderTextHashTable[i][j] ; j++ ) {
+			*offsets++ = LittleLong( shaderTextHashTable[i][j] - s_shaderText );
+		}
+	}
+
+	ri.FS_WriteFile( SHADERCACHE_NAME, header, size );
+
+	ri.Hunk_FreeTempMemory( header );
+}
+
 /*
 ====================
 ScanAndLoadShaderFiles
@@ -2851,8 +3100,15 @@ static void ScanAndLoadShaderFiles( void )
 	int i;
 	char *oldp, *token, *hashMem;
 	int shaderTextHashTableSizes[MAX_SHADERTEXT_HASH], hash, size;
+	int key, start;
 
 	long sum = 0;
+
+	s_shaderText = NULL;
+	Com_Memset( shaderTextHashTable, 0, sizeof( shaderTextHashTable ) );
+
+	start = ri.Milliseconds();
+
 	// scan for shader files
 	shaderFiles = ri.FS_ListFiles( "scripts", ".shader", &numShaders );
 
@@ -2866,6 +3122,17 @@ static void ScanAndLoadShaderFiles( void )
 		numShaders = MAX_SHADER_FILES;
 	}
 
+	key = 0;
+	if ( r_shaderCache->integer ) {
+		key = ShaderFilesKey( shaderFiles, numShaders );
+		if ( LoadShaderCache( key ) ) {
+			ri.FS_FreeFileList( shaderFiles );
+			ri.Printf( PRINT_ALL, "...%i shader files from %s in %i msec\n",
+				numShaders, SHADERCACHE_NAME, ri.Milliseconds() - start );
+			return;
+		}
+	}
+
 	// load and parse shader files
 	for ( i = 0; i < numShaders; i++ )
 	{
@@ -2956,8 +3223,11 @@ static void ScanAndLoadShaderFiles( void )
 		}
 	}
 
-	return;
+	ri.Printf( PRINT_ALL, "...%i shader files in %i msec\n", numShaders, ri.Milliseconds() - start );
 
+	if ( r_shaderCache->integer ) {
+		WriteShaderCache( key );
+	}
 }
 
 
@@ -21,6 +21,12 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 */
 // tr_surf.c
 #include "tr_local.h"
+#if idsse2
+#include <emmintrin.h>
+#if idavx2
+#include <immintrin.h>
+#endif
+#endif
 
 /*
 
@@ -215,6 +221,44 @@ void RB_SurfacePolychain( srfPoly_t *p ) {
 }
 
 
+/*
+=============
+RB_AddBufferRange
+
+Static world surfaces already sit in the world buffers, so unless
+something has to be computed for this batch on the CPU they only
+queue their index range
+=============
+*/
+static qboolean RB_AddBufferRange( int firstIndex, int numIndexes, int dlightBits ) {
+	int		last;
+
+	if ( !numIndexes || dlightBits || tess.fogNum || !tess.shader->staticGeometry ) {
+		return qfalse;
+	}
+	if ( r_lightmap->integer || r_showtris->integer || r_shownormals->integer ) {
+		return qfalse;
+	}
+
+	// grow the last range when the surfaces are neighbours in the buffer
+	last = tess.numBufferRanges - 1;
+	if ( last >= 0 && tess.bufferFirstIndex[last] + tess.bufferNumIndexes[last] == firstIndex ) {
+		tess.bufferNumIndexes[last] += numIndexes;
+		return qtrue;
+	}
+
+	if ( tess.numBufferRanges == MAX_BUFFER_RANGES ) {
+		RB_EndSurface();
+		RB_BeginSurface( tess.shader, tess.fogNum );
+	}
+
+	tess.bufferFirstIndex[tess.numBufferRanges] = firstIndex;
+	tess.bufferNumIndexes[tess.numBufferRanges] = numIndexes;
+	tess.numBufferRanges++;
+
+	return qtrue;
+}
+
 /*
 =============
 RB_SurfaceTriangles
@@ -229,6 +273,9 @@ void RB_SurfaceTriangles( srfTriangles_t *srf ) {
 	qboolean	needsNormal;
 
 	dlightBits = srf->dlightBits[backEnd.smpFrame];
+	if ( RB_AddBufferRange( srf->firstBufferIndex, srf->numBufferIndexes, dlightBits ) ) {
+		return;
+	}
 	tess.dlightBits |= dlightBits;
 
 	RB_CHECKOVERFLOW( srf->numVerts, srf->numIndexes );
@@ -607,7 +654,7 @@ static void VectorArrayNormalize(vec4_t *normals, unsigned int count)
 /*
 ** LerpMeshVertexes
 */
-static void LerpMeshVertexes (md3Surface_t *surf, float backlerp) 
+static void LerpMeshVertexes (md3Surface_t *surf, int frame, int oldframe, float backlerp) 
 {
 	short	*oldXyz, *newXyz, *oldNormals, *newNormals;
 	float	*outXyz, *outNormal;
@@ -621,7 +668,7 @@ static void LerpMeshVertexes (md3Surface_t *surf, float backlerp)
 	outNormal = tess.normal[tess.numVertexes];
 
 	newXyz = (short *)((byte *)surf + surf->ofsXyzNormals)
-		+ (backEnd.currentEntity->e.frame * surf->numVerts * 4);
+		+ (frame * surf->numVerts * 4);
 	newNormals = newXyz + 3;
 
 	newXyzScale = MD3_XYZ_SCALE * (1.0 - backlerp);
@@ -717,7 +764,7 @@ static void LerpMeshVertexes (md3Surface_t *surf, float backlerp)
 		// interpolate and copy the vertex and normal
 		//
 		oldXyz = (short *)((byte *)surf + surf->ofsXyzNormals)
-			+ (backEnd.currentEntity->e.oldframe * surf->numVerts * 4);
+			+ (oldframe * surf->numVerts * 4);
 		oldNormals = oldXyz + 3;
 
 		oldXyzScale = MD3_XYZ_SCALE * backlerp;
@@ -762,6 +809,271 @@ static void LerpMeshVertexes (md3Surface_t *surf, float backlerp)
    	}
 }
 
+#if idsse2
+/*
+** StoreVertexes4
+*
+* Writes four vertexes held as x, y and z lanes out as vec4_t
+*/
+static void StoreVertexes4( float *out, __m128 x, __m128 y, __m128 z ) {
+	__m128	w;
+
+	w = _mm_setzero_ps();
+	_MM_TRANSPOSE4_PS( x, y, z, w );
+	_mm_storeu_ps( out, x );
+	_mm_storeu_ps( out + 4, y );
+	_mm_storeu_ps( out + 8, z );
+	_mm_storeu_ps( out + 12, w );
+}
+
+/*
+** RecipLength4
+*
+* rsqrt estimate with one Newton-Raphson step, close enough to
+* VectorNormalizeFast for the near unit normals coming out of a lerp
+*/
+static __m128 RecipLength4( __m128 x, __m128 y, __m128 z ) {
+	__m128	len, r;
+
+	len = _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, x ), _mm_mul_ps( y, y ) ), _mm_mul_ps( z, z ) );
+	r = _mm_rsqrt_ps( len );
+	return _mm_mul_ps( r, _mm_sub_ps( _mm_set1_ps( 1.5f ),
+		_mm_mul_ps( _mm_mul_ps( _mm_set1_ps( 0.5f ), len ), _mm_mul_ps( r, r ) ) ) );
+}
+#endif
+
+/*
+** LerpDecodedVertexes
+*
+* Same results as LerpMeshVertexes, from the float frames that
+* R_DecodeMD3Frames built at load time.  Each frame is six arrays of
+* MD3_DECODED_STRIDE floats: x, y, z, then normal x, y, z.
+*/
+static void LerpDecodedVertexes( md3Surface_t *surf, int frame, int oldframe, float backlerp ) {
+	float	*newFrame, *oldFrame;
+	float	*outXyz, *outNormal;
+	float	newScale;
+	int		stride;
+	int		numVerts;
+	int		j, k;
+
+	numVerts = surf->numVerts;
+	stride = MD3_DECODED_STRIDE( numVerts );
+	newFrame = (float *)( (byte *)surf + surf->flags ) + frame * stride * 6;
+	oldFrame = (float *)( (byte *)surf + surf->flags ) + oldframe * stride * 6;
+
+	outXyz = tess.xyz[tess.numVertexes];
+	outNormal = tess.normal[tess.numVertexes];
+	j = 0;
+
+	if ( backlerp == 0 ) {
+		//
+		// just copy the vertexes
+		//
+#if idsse2
+		for ( ; j + 4 <= numVerts ; j += 4 ) {
+			StoreVertexes4( outXyz + j*4, _mm_loadu_ps( newFrame + j ),
+				_mm_loadu_ps( newFrame + stride + j ), _mm_loadu_ps( newFrame + stride*2 + j ) );
+			StoreVertexes4( outNormal + j*4, _mm_loadu_ps( newFrame + stride*3 + j ),
+				_mm_loadu_ps( newFrame + stride*4 + j ), _mm_loadu_ps( newFrame + stride*5 + j ) );
+		}
+#endif
+		for ( ; j < numVerts ; j++ ) {
+			for ( k = 0 ; k < 3 ; k++ ) {
+				outXyz[j*4+k] = newFrame[stride*k + j];
+				outNormal[j*4+k] = newFrame[stride*(3+k) + j];
+			}
+		}
+		return;
+	}
+
+	//
+	// interpolate and copy the vertex and normal
+	//
+	newScale = 1.0f - backlerp;
+
+#if idavx2
+	{
+		__m256	o8, n8, v8[6], len8, r8;
+
+		o8 = _mm256_set1_ps( backlerp );
+		n8 = _mm256_set1_ps( newScale );
+		for ( ; j + 8 <= numVerts ; j += 8 ) {
+			for ( k = 0 ; k < 6 ; k++ ) {
+				v8[k] = _mm256_add_ps( _mm256_mul_ps( _mm256_loadu_ps( oldFrame + stride*k + j ), o8 ),
+					_mm256_mul_ps( _mm256_loadu_ps( newFrame + stride*k + j ), n8 ) );
+			}
+
+			len8 = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( v8[3], v8[3] ), _mm256_mul_ps( v8[4], v8[4] ) ),
+				_mm256_mul_ps( v8[5], v8[5] ) );
+			r8 = _mm256_rsqrt_ps( len8 );
+			r8 = _mm256_mul_ps( r8, _mm256_sub_ps( _mm256_set1_ps( 1.5f ),
+				_mm256_mul_ps( _mm256_mul_ps( _mm256_set1_ps( 0.5f ), len8 ), _mm256_mul_ps( r8, r8 ) ) ) );
+			for ( k = 3 ; k < 6 ; k++ ) {
+				v8[k] = _mm256_mul_ps( v8[k], r8 );
+			}
+
+			// the transposed stores are four vertexes wide
+			StoreVertexes4( outXyz + j*4, _mm256_castps256_ps128( v8[0] ),
+				_mm256_castps256_ps128( v8[1] ), _mm256_castps256_ps128( v8[2] ) );
+			StoreVertexes4( outXyz + j*4 + 16, _mm256_extractf128_ps( v8[0], 1 ),
+				_mm256_extractf128_ps( v8[1], 1 ), _mm256_extractf128_ps( v8[2], 1 ) );
+			StoreVertexes4( outNormal + j*4, _mm256_castps256_ps128( v8[3] ),
+				_mm256_castps256_ps128( v8[4] ), _mm256_castps256_ps128( v8[5] ) );
+			StoreVertexes4( outNormal + j*4 + 16, _mm256_extractf128_ps( v8[3], 1 ),
+				_mm256_extractf128_ps( v8[4], 1 ), _mm256_extractf128_ps( v8[5], 1 ) );
+		}
+	}
+#endif
+
+#if idsse2
+	{
+		__m128	o4, n4, v4[6], r4;
+
+		o4 = _mm_set1_ps( backlerp );
+		n4 = _mm_set1_ps( newScale );
+		for ( ; j + 4 <= numVerts ; j += 4 ) {
+			for ( k = 0 ; k < 6 ; k++ ) {
+				v4[k] = _mm_add_ps( _mm_mul_ps( _mm_loadu_ps( oldFrame + stride*k + j ), o4 ),
+					_mm_mul_ps( _mm_loadu_ps( newFrame + stride*k + j ), n4 ) );
+			}
+
+			r4 = RecipLength4( v4[3], v4[4], v4[5] );
+			StoreVertexes4( outXyz + j*4, v4[0], v4[1], v4[2] );
+			StoreVertexes4( outNormal + j*4, _mm_mul_ps( v4[3], r4 ), _mm_mul_ps( v4[4], r4 ), _mm_mul_ps( v4[5], r4 ) );
+		}
+	}
+#endif
+
+	for ( ; j < numVerts ; j++ ) {
+		for ( k = 0 ; k < 3 ; k++ ) {
+			outXyz[j*4+k] = oldFrame[stride*k + j] * backlerp + newFrame[stride*k + j] * newScale;
+			outNormal[j*4+k] = oldFrame[stride*(3+k) + j] * backlerp + newFrame[stride*(3+k) + j] * newScale;
+		}
+		VectorNormalizeFast( outNormal + j*4 );
+	}
+}
+
+/*
+=============
+R_MD3Bench_f
+
+md3bench [iterations] [model...]
+
+Times LerpMeshVertexes against LerpDecodedVertexes over every lod 0
+surface of the given models, the stock player models by default
+=============
+*/
+static const char *md3BenchModels[] = {
+	"models/players/sarge/lower.md3",
+	"models/players/sarge/upper.md3",
+	"models/players/sarge/head.md3",
+	"models/players/major/lower.md3",
+	"models/players/major/upper.md3",
+	"models/players/major/head.md3",
+	"models/players/visor/lower.md3",
+	"models/players/visor/upper.md3",
+	"models/players/visor/head.md3"
+};
+
+void R_MD3Bench_f( void ) {
+	const char		*name;
+	model_t			*mod;
+	md3Header_t		*md3;
+	md3Surface_t	*surf;
+	vec4_t			*check;
+	int				iterations;
+	int				numModels, firstModel;
+	int				m, i, s, j, k;
+	int				numFrames, frame, oldframe;
+	int				start, packedMsec, decodedMsec;
+	float			err, maxErr;
+
+	iterations = 1000;
+	firstModel = 1;
+	if ( ri.Cmd_Argc() > 1 && atoi( ri.Cmd_Argv( 1 ) ) > 0 ) {
+		iterations = atoi( ri.Cmd_Argv( 1 ) );
+		firstModel = 2;
+	}
+	numModels = ri.Cmd_Argc() - firstModel;
+	if ( numModels <= 0 ) {
+		numModels = sizeof( md3BenchModels ) / sizeof( md3BenchModels[0] );
+	}
+
+	// the lerps write into tess
+	R_SyncRenderThread();
+
+	check = ri.Hunk_AllocateTempMemory( SHADER_MAX_VERTEXES * 2 * sizeof( vec4_t ) );
+
+	for ( m = 0 ; m < numModels ; m++ ) {
+		if ( ri.Cmd_Argc() > firstModel ) {
+			name = ri.Cmd_Argv( firstModel + m );
+		} else {
+			name = md3BenchModels[m];
+		}
+
+		mod = R_GetModelByHandle( RE_RegisterModel( name ) );
+		md3 = mod->md3[0];
+		if ( mod->type != MOD_MESH || !md3 ) {
+			ri.Printf( PRINT_ALL, "%s: not an md3\n", name );
+			continue;
+		}
+		numFrames = md3->numFrames;
+
+		packedMsec = 0;
+		decodedMsec = 0;
+		maxErr = 0;
+		surf = (md3Surface_t *)( (byte *)md3 + md3->ofsSurfaces );
+		for ( s = 0 ; s < md3->numSurfaces ; s++ ) {
+			tess.numVertexes = 0;
+
+			start = ri.Milliseconds();
+			for ( i = 0 ; i < iterations ; i++ ) {
+				LerpMeshVertexes( surf, i % numFrames, ( i + 1 ) % numFrames, 0.5f );
+			}
+			packedMsec += ri.Milliseconds() - start;
+			Com_Memcpy( check, tess.xyz, surf->numVerts * sizeof( vec4_t ) );
+			Com_Memcpy( check + SHADER_MAX_VERTEXES, tess.normal, surf->numVerts * sizeof( vec4_t ) );
+
+			if ( !surf->flags ) {
+				surf = (md3Surface_t *)( (byte *)surf + surf->ofsEnd );
+				continue;
+			}
+
+			start = ri.Milliseconds();
+			for ( i = 0 ; i < iterations ; i++ ) {
+				LerpDecodedVertexes( surf, i % numFrames, ( i + 1 ) % numFrames, 0.5f );
+			}
+			decodedMsec += ri.Milliseconds() - start;
+
+			for ( j = 0 ; j < surf->numVerts ; j++ ) {
+				for ( k = 0 ; k < 3 ; k++ ) {
+					err = fabs( tess.xyz[j][k] - check[j][k] );
+					if ( err > maxErr ) {
+						maxErr = err;
+					}
+					err = fabs( tess.normal[j][k] - check[SHADER_MAX_VERTEXES + j][k] );
+					if ( err > maxErr ) {
+						maxErr = err;
+					}
+				}
+			}
+
+			surf = (md3Surface_t *)( (byte *)surf + surf->ofsEnd );
+		}
+
+		if ( !r_md3Cache->integer ) {
+			ri.Printf( PRINT_ALL, "%s: packed %.4f msec (r_md3Cache 0, no decoded frames)\n",
+				name, packedMsec / (float)iterations );
+			continue;
+		}
+		ri.Printf( PRINT_ALL, "%s: %i surfaces, packed %.4f msec, decoded %.4f msec, max error %f\n",
+			name, md3->numSurfaces, packedMsec / (float)iterations, decodedMsec / (float)iterations, maxErr );
+	}
+
+	ri.Hunk_FreeTempMemory( check );
+}
+
 /*
 =============
 RB_SurfaceMesh
@@ -784,7 +1096,11 @@ void RB_SurfaceMesh(md3Surface_t *surface) {
 
 	RB_CHECKOVERFLOW( surface->numVerts, surface->numTriangles*3 );
 
-	LerpMeshVertexes (surface, backlerp);
+	if ( surface->flags ) {
+		LerpDecodedVertexes( surface, backEnd.currentEntity->e.frame, backEnd.currentEntity->e.oldframe, backlerp );
+	} else {
+		LerpMeshVertexes( surface, backEnd.currentEntity->e.frame, backEnd.currentEntity->e.oldframe, backlerp );
+	}
 
 	triangles = (int *) ((byte *)surface + surface->ofsTriangles);
 	indexes = surface->numTriangles * 3;
@@ -824,9 +1140,13 @@ void RB_SurfaceFace( srfSurfaceFace_t *surf ) {
 	int			numPoints;
 	int			dlightBits;
 
+	dlightBits = surf->dlightBits[backEnd.smpFrame];
+	if ( RB_AddBufferRange( surf->firstBufferIndex, surf->numBufferIndexes, dlightBits ) ) {
+		return;
+	}
+
 	RB_CHECKOVERFLOW( surf->numPoints, surf->numIndices );
 
-	dlightBits = surf->dlightBits[backEnd.smpFrame];
 	tess.dlightBits |= dlightBits;
 
 	indices = ( unsigned * ) ( ( ( char  * ) surf ) + surf->ofsIndices );
@@ -923,10 +1243,19 @@ void RB_SurfaceGrid( srfGridMesh_t *cv ) {
 	qboolean	needsNormal;
 
 	dlightBits = cv->dlightBits[backEnd.smpFrame];
+	if ( RB_AddBufferRange( cv->firstBufferIndex, cv->numBufferIndexes, dlightBits ) ) {
+		return;
+	}
 	tess.dlightBits |= dlightBits;
 
 	// determine the allowable discrepance
-	lodError = LodErrorForVolume( cv->lodOrigin, cv->lodRadius );
+	if ( tr.world && tr.world->vertexBuffer ) {
+		// the world buffers hold every patch at full detail, the
+		// ones drawn from here must match or their seams crack
+		lodError = 1e30f;
+	} else {
+		lodError = LodErrorForVolume( cv->lodOrigin, cv->lodRadius );
+	}
 
 	// determine which rows and columns of the subdivision
 	// we are actually going to use
@@ -58,7 +58,7 @@ static qboolean	R_CullGrid( srfGridMesh_t *cv ) {
 		return qtrue;
 	}
 
-	if ( tr.currentEntityNum != ENTITYNUM_WORLD ) {
+	if ( frontEnd->currentEntityNum != ENTITYNUM_WORLD ) {
 		sphereCull = R_CullLocalPointAndRadius( cv->localOrigin, cv->meshRadius );
 	} else {
 		sphereCull = R_CullPointAndRadius( cv->localOrigin, cv->meshRadius );
@@ -68,33 +68,33 @@ static qboolean	R_CullGrid( srfGridMesh_t *cv ) {
 	// check for trivial reject
 	if ( sphereCull == CULL_OUT )
 	{
-		tr.pc.c_sphere_cull_patch_out++;
+		frontEnd->pc->c_sphere_cull_patch_out++;
 		return qtrue;
 	}
 	// check bounding box if necessary
 	else if ( sphereCull == CULL_CLIP )
 	{
-		tr.pc.c_sphere_cull_patch_clip++;
+		frontEnd->pc->c_sphere_cull_patch_clip++;
 
 		boxCull = R_CullLocalBox( cv->meshBounds );
 
 		if ( boxCull == CULL_OUT ) 
 		{
-			tr.pc.c_box_cull_patch_out++;
+			frontEnd->pc->c_box_cull_patch_out++;
 			return qtrue;
 		}
 		else if ( boxCull == CULL_IN )
 		{
-			tr.pc.c_box_cull_patch_in++;
+			frontEnd->pc->c_box_cull_patch_in++;
 		}
 		else
 		{
-			tr.pc.c_box_cull_patch_clip++;
+			frontEnd->pc->c_box_cull_patch_clip++;
 		}
 	}
 	else
 	{
-		tr.pc.c_sphere_cull_patch_in++;
+		frontEnd->pc->c_sphere_cull_patch_in++;
 	}
 
 	return qfalse;
@@ -141,7 +141,7 @@ static qboolean	R_CullSurface( surfaceType_t *surface, shader_t *shader ) {
 	}
 
 	sface = ( srfSurfaceFace_t * ) surface;
-	d = DotProduct (tr.or.viewOrigin, sface->plane.normal);
+	d = DotProduct (frontEnd->or.viewOrigin, sface->plane.normal);
 
 	// don't cull exactly on the plane, because there are levels of rounding
 	// through the BSP, ICD, and hardware that may cause pixel gaps if an
@@ -178,7 +178,7 @@ static int R_DlightFace( srfSurfaceFace_t *face, int dlightBits ) {
 	}
 
 	if ( !dlightBits ) {
-		tr.pc.c_dlightSurfacesCulled++;
+		frontEnd->pc->c_dlightSurfacesCulled++;
 	}
 
 	face->dlightBits[ tr.smpFrame ] = dlightBits;
@@ -206,7 +206,7 @@ static int R_DlightGrid( srfGridMesh_t *grid, int dlightBits ) {
 	}
 
 	if ( !dlightBits ) {
-		tr.pc.c_dlightSurfacesCulled++;
+		frontEnd->pc->c_dlightSurfacesCulled++;
 	}
 
 	grid->dlightBits[ tr.smpFrame ] = dlightBits;
@@ -239,7 +239,7 @@ static int R_DlightTrisurf( srfTriangles_t *surf, int dlightBits ) {
 	}
 
 	if ( !dlightBits ) {
-		tr.pc.c_dlightSurfacesCulled++;
+		frontEnd->pc->c_dlightSurfacesCulled++;
 	}
 
 	grid->dlightBits[ tr.smpFrame ] = dlightBits;
@@ -268,7 +268,7 @@ static int R_DlightSurface( msurface_t *surf, int dlightBits ) {
 	}
 
 	if ( dlightBits ) {
-		tr.pc.c_dlightSurfaces++;
+		frontEnd->pc->c_dlightSurfaces++;
 	}
 
 	return dlightBits;
@@ -282,10 +282,23 @@ R_AddWorldSurface
 ======================
 */
 static void R_AddWorldSurface( msurface_t *surf, int dlightBits ) {
+	deferredSurf_t	*deferred;
+
 	if ( surf->viewCount == tr.viewCount ) {
 		return;		// already in this view
 	}
 
+	// another world job may reach this surface at the same time,
+	// so leave it for the main thread once the jobs are done
+	if ( surf->worldJob == WORLDJOB_SHARED && frontEnd->deferShared ) {
+		if ( frontEnd->numDeferred < frontEnd->maxDeferred ) {
+			deferred = &frontEnd->deferred[ frontEnd->numDeferred++ ];
+			deferred->surf = surf;
+			deferred->dlightBits = dlightBits;
+		}
+		return;
+	}
+
 	surf->viewCount = tr.viewCount;
 	// FIXME: bmodel fog?
 
@@ -334,7 +347,7 @@ void R_AddBrushModelSurfaces ( trRefEntity_t *ent ) {
 	R_DlightBmodel( bmodel );
 
 	for ( i = 0 ; i < bmodel->numSurfaces ; i++ ) {
-		R_AddWorldSurface( bmodel->firstSurface + i, tr.currentEntity->needDlights );
+		R_AddWorldSurface( bmodel->firstSurface + i, frontEnd->currentEntity->needDlights );
 	}
 }
 
@@ -348,6 +361,61 @@ void R_AddBrushModelSurfaces ( trRefEntity_t *ent ) {
 */
 
 
+// subtrees found by the main thread for R_AddWorldJobs
+typedef struct {
+	mnode_t		*node;
+	int			planeBits;
+	int			dlightBits;
+} worldJob_t;
+
+static worldJob_t	worldJobs[MAX_WORLD_JOBS];
+static int			numWorldJobs;
+static qboolean		collectWorldJobs;
+
+/*
+================
+R_AddWorldLeaf
+================
+*/
+static void R_AddWorldLeaf( mnode_t *node, int dlightBits ) {
+	int			c;
+	msurface_t	*surf, **mark;
+
+	frontEnd->pc->c_leafs++;
+
+	// add to z buffer bounds
+	if ( node->mins[0] < frontEnd->visBounds[0][0] ) {
+		frontEnd->visBounds[0][0] = node->mins[0];
+	}
+	if ( node->mins[1] < frontEnd->visBounds[0][1] ) {
+		frontEnd->visBounds[0][1] = node->mins[1];
+	}
+	if ( node->mins[2] < frontEnd->visBounds[0][2] ) {
+		frontEnd->visBounds[0][2] = node->mins[2];
+	}
+
+	if ( node->maxs[0] > frontEnd->visBounds[1][0] ) {
+		frontEnd->visBounds[1][0] = node->maxs[0];
+	}
+	if ( node->maxs[1] > frontEnd->visBounds[1][1] ) {
+		frontEnd->visBounds[1][1] = node->maxs[1];
+	}
+	if ( node->maxs[2] > frontEnd->visBounds[1][2] ) {
+		frontEnd->visBounds[1][2] = node->maxs[2];
+	}
+
+	// add the individual surfaces
+	mark = node->firstmarksurface;
+	c = node->nummarksurfaces;
+	while (c--) {
+		// the surface may have already been added if it
+		// spans multiple leafs
+		surf = *mark;
+		R_AddWorldSurface( surf, dlightBits );
+		mark++;
+	}
+}
+
 /*
 ================
 R_RecursiveWorldNode
@@ -411,6 +479,15 @@ static void R_RecursiveWorldNode( mnode_t *node, int planeBits, int dlightBits )
 
 		}
 
+		// the main thread stops at the roots of the world jobs
+		if ( collectWorldJobs && node->worldJob >= 0 ) {
+			worldJobs[ numWorldJobs ].node = node;
+			worldJobs[ numWorldJobs ].planeBits = planeBits;
+			worldJobs[ numWorldJobs ].dlightBits = dlightBits;
+			numWorldJobs++;
+			return;
+		}
+
 		if ( node->contents != -1 ) {
 			break;
 		}
@@ -450,46 +527,90 @@ static void R_RecursiveWorldNode( mnode_t *node, int planeBits, int dlightBits )
 		dlightBits = newDlights[1];
 	} while ( 1 );
 
-	{
-		// leaf node, so add mark surfaces
-		int			c;
-		msurface_t	*surf, **mark;
+	// leaf node, so add mark surfaces
+	R_AddWorldLeaf( node, dlightBits );
+}
 
-		tr.pc.c_leafs++;
 
-		// add to z buffer bounds
-		if ( node->mins[0] < tr.viewParms.visBounds[0][0] ) {
-			tr.viewParms.visBounds[0][0] = node->mins[0];
-		}
-		if ( node->mins[1] < tr.viewParms.visBounds[0][1] ) {
-			tr.viewParms.visBounds[0][1] = node->mins[1];
-		}
-		if ( node->mins[2] < tr.viewParms.visBounds[0][2] ) {
-			tr.viewParms.visBounds[0][2] = node->mins[2];
-		}
+/*
+================
+R_AddWorldJob
+================
+*/
+static void R_AddWorldJob( int index ) {
+	worldJob_t	*job;
 
-		if ( node->maxs[0] > tr.viewParms.visBounds[1][0] ) {
-			tr.viewParms.visBounds[1][0] = node->maxs[0];
-		}
-		if ( node->maxs[1] > tr.viewParms.visBounds[1][1] ) {
-			tr.viewParms.visBounds[1][1] = node->maxs[1];
-		}
-		if ( node->maxs[2] > tr.viewParms.visBounds[1][2] ) {
-			tr.viewParms.visBounds[1][2] = node->maxs[2];
+	job = &worldJobs[index];
+	R_RecursiveWorldNode( job->node, job->planeBits, job->dlightBits );
+}
+
+/*
+================
+R_BeginSharedSurfaces
+
+Surfaces marked from leafs of more than one world job are held back
+while the jobs run
+================
+*/
+static void R_BeginSharedSurfaces( void ) {
+	frontEndThread_t	*thread;
+	int					i;
+
+	for ( i = 0 ; i < numFrontEndThreads ; i++ ) {
+		thread = &frontEndThreads[i];
+		if ( thread->maxDeferred < tr.world->numSharedMarks ) {
+			if ( thread->deferred ) {
+				ri.Free( thread->deferred );
+			}
+			thread->maxDeferred = tr.world->numSharedMarks;
+			thread->deferred = ri.Malloc( thread->maxDeferred * sizeof( *thread->deferred ) );
 		}
+		thread->numDeferred = 0;
+		thread->deferShared = qtrue;
+	}
+}
+
+/*
+================
+R_EndSharedSurfaces
+
+Adds the surfaces held back by R_BeginSharedSurfaces once the jobs are done
+================
+*/
+static void R_EndSharedSurfaces( void ) {
+	frontEndThread_t	*thread;
+	deferredSurf_t		*deferred;
+	int					i, j;
 
-		// add the individual surfaces
-		mark = node->firstmarksurface;
-		c = node->nummarksurfaces;
-		while (c--) {
-			// the surface may have already been added if it
-			// spans multiple leafs
-			surf = *mark;
-			R_AddWorldSurface( surf, dlightBits );
-			mark++;
+	for ( i = 0 ; i < numFrontEndThreads ; i++ ) {
+		frontEndThreads[i].deferShared = qfalse;
+	}
+	for ( i = 0 ; i < numFrontEndThreads ; i++ ) {
+		thread = &frontEndThreads[i];
+		for ( j = 0, deferred = thread->deferred ; j < thread->numDeferred ; j++, deferred++ ) {
+			R_AddWorldSurface( deferred->surf, deferred->dlightBits );
 		}
 	}
+}
 
+/*
+================
+R_AddWorldJobs
+
+Walks the tree down to the world job roots marked at load time, then
+lets the front end jobs walk the subtrees below them.  Surfaces marked
+from leafs of more than one job are added here once the jobs are done.
+================
+*/
+static void R_AddWorldJobs( int dlightBits ) {
+	numWorldJobs = 0;
+	collectWorldJobs = qtrue;
+	R_RecursiveWorldNode( tr.world->nodes, 15, dlightBits );
+	collectWorldJobs = qfalse;
+
+	R_BeginSharedSurfaces();
+	R_RunFrontEndJobs( R_AddWorldJob, numWorldJobs );
+	R_EndSharedSurfaces();
 }
 
 
@@ -556,6 +677,15 @@ qboolean R_inPVS( const vec3_t p1, const vec3_t p2 ) {
 	return qtrue;
 }
 
+/*
+=================
+R_PointCluster
+=================
+*/
+int R_PointCluster( const vec3_t p ) {
+	return R_PointInLeaf( p )->cluster;
+}
+
 /*
 ===============
 R_MarkLeaves
@@ -637,12 +767,321 @@ static void R_MarkLeaves (void) {
 }
 
 
+/*
+=============================================================
+
+	VISIBLE LEAF LISTS
+
+Instead of marking the PVS up the tree and walking the tree again, the
+leafs visible from the view cluster are gathered from the load time
+cluster lists into a flat depth first list.  That list is cached for
+the last few clusters and areamasks, and culled a chunk of neighbouring
+leafs at a time, so the cost follows what is visible.
+
+=============================================================
+*/
+
+static visList_t	*jobVisList;		// for R_AddVisJob
+static int			jobDlightBits;
+
+/*
+================
+R_CullVisBox
+
+Returns the frustum planes the box still crosses, or -1 if it is outside
+================
+*/
+static int R_CullVisBox( vec3_t mins, vec3_t maxs, int planeBits ) {
+	int		i, r;
+
+	for ( i = 0 ; i < 4 ; i++ ) {
+		if ( planeBits & ( 1 << i ) ) {
+			r = BoxOnPlaneSide( mins, maxs, &tr.viewParms.frustum[i] );
+			if ( r == 2 ) {
+				return -1;					// culled
+			}
+			if ( r == 1 ) {
+				planeBits &= ~( 1 << i );	// everything inside is in front too
+			}
+		}
+	}
+	return planeBits;
+}
+
+/*
+================
+R_DlightVisBox
+
+Drops the dlights whose sphere doesn't reach the box
+================
+*/
+static int R_DlightVisBox( const vec3_t mins, const vec3_t maxs, int dlightBits ) {
+	dlight_t	*dl;
+	float		d, dist;
+	int			i, j;
+
+	for ( i = 0 ; i < tr.refdef.num_dlights ; i++ ) {
+		if ( !( dlightBits & ( 1 << i ) ) ) {
+			continue;
+		}
+		dl = &tr.refdef.dlights[i];
+
+		dist = 0;
+		for ( j = 0 ; j < 3 ; j++ ) {
+			if ( dl->origin[j] < mins[j] ) {
+				d = mins[j] - dl->origin[j];
+			} else if ( dl->origin[j] > maxs[j] ) {
+				d = dl->origin[j] - maxs[j];
+			} else {
+				continue;
+			}
+			dist += d * d;
+		}
+		if ( dist >= dl->radius * dl->radius ) {
+			dlightBits &= ~( 1 << i );
+		}
+	}
+	return dlightBits;
+}
+
+static int R_CompareLeafNums( const void *a, const void *b ) {
+	return *(const int *)a - *(const int *)b;
+}
+
+/*
+================
+R_BuildVisList
+
+Gathers the leafs in the PVS of cluster that the areamask doesn't close
+off, or every leaf for cluster -1, and splits them into chunks
+================
+*/
+static void R_BuildVisList( visList_t *list, int cluster ) {
+	const byte	*vis;
+	mnode_t		*leaf;
+	visChunk_t	*chunk;
+	int			*first;
+	int			numLeafs;
+	int			c, i, job, chunkJob;
+
+	list->cluster = cluster;
+	Com_Memcpy( list->areamask, tr.refdef.areamask, sizeof( list->areamask ) );
+
+	numLeafs = 0;
+	if ( cluster == -1 ) {
+		for ( i = 0 ; i < tr.world->numLeafs ; i++ ) {
+			list->leafs[ numLeafs++ ] = i;
+		}
+	} else {
+		vis = R_ClusterPVS( cluster );
+		first = tr.world->clusterFirstLeaf;
+		for ( c = 0 ; c < tr.world->numClusters ; c++ ) {
+			if ( !vis[c>>3] ) {
+				c |= 7;		// skip the whole byte
+				continue;
+			}
+			if ( !( vis[c>>3] & ( 1 << ( c & 7 ) ) ) ) {
+				continue;
+			}
+			for ( i = first[c] ; i < first[c+1] ; i++ ) {
+				leaf = tr.world->leafOrder[ tr.world->clusterLeafs[i] ];
+
+				// check for door connection
+				if ( tr.refdef.areamask[leaf->area>>3] & ( 1 << ( leaf->area & 7 ) ) ) {
+					continue;		// not visible
+				}
+				list->leafs[ numLeafs++ ] = tr.world->clusterLeafs[i];
+			}
+		}
+
+		// back to depth first order
+		qsort( list->leafs, numLeafs, sizeof( int ), R_CompareLeafNums );
+	}
+	list->numLeafs = numLeafs;
+
+	// chunks of neighbouring leafs, never spanning two world jobs
+	list->numChunks = 0;
+	list->numJobs = 0;
+	chunk = NULL;
+	chunkJob = -1;
+	job = 0;
+	for ( i = 0 ; i < numLeafs ; i++ ) {
+		leaf = tr.world->leafOrder[ list->leafs[i] ];
+		while ( list->leafs[i] >= tr.world->jobFirstLeaf[ job + 1 ] ) {
+			job++;
+		}
+
+		if ( chunk && chunk->numLeafs < VISCHUNK_LEAFS && job == chunkJob ) {
+			AddPointToBounds( leaf->mins, chunk->mins, chunk->maxs );
+			AddPointToBounds( leaf->maxs, chunk->mins, chunk->maxs );
+			chunk->numLeafs++;
+			continue;
+		}
+
+		if ( job != chunkJob ) {
+			list->jobs[ list->numJobs ].firstChunk = list->numChunks;
+			list->jobs[ list->numJobs ].numChunks = 0;
+			list->numJobs++;
+			chunkJob = job;
+		}
+		list->jobs[ list->numJobs - 1 ].numChunks++;
+
+		chunk = &list->chunks[ list->numChunks++ ];
+		chunk->firstLeaf = i;
+		chunk->numLeafs = 1;
+		VectorCopy( leaf->mins, chunk->mins );
+		VectorCopy( leaf->maxs, chunk->maxs );
+	}
+}
+
+/*
+================
+R_FindVisList
+
+Returns the list for the current view cluster and areamask, building
+it over the least recently used one if it isn't cached
+================
+*/
+static visList_t *R_FindVisList( void ) {
+	visList_t	*list, *oldest;
+	mnode_t		*leaf;
+	int			cluster;
+	int			i;
+
+	// lockpvs lets designers walk around to determine the
+	// extent of the current pvs
+	if ( r_lockpvs->integer && tr.world->visList ) {
+		return tr.world->visList;
+	}
+
+	// current viewcluster
+	leaf = R_PointInLeaf( tr.viewParms.pvsOrigin );
+	cluster = leaf->cluster;
+
+	// if r_showcluster was just turned on, print it again
+	if ( r_showcluster->modified || ( r_showcluster->integer && cluster != tr.viewCluster ) ) {
+		r_showcluster->modified = qfalse;
+		if ( r_showcluster->integer ) {
+			ri.Printf( PRINT_ALL, "cluster:%i  area:%i\n", cluster, leaf->area );
+		}
+	}
+	tr.viewCluster = cluster;
+
+	if ( r_novis->integer || cluster < 0 ) {
+		cluster = -1;
+	}
+
+	tr.world->visListFrame++;
+	oldest = tr.world->visLists;
+	for ( i = 0, list = tr.world->visLists ; i < MAX_VISLISTS ; i++, list++ ) {
+		if ( list->lastUsed && list->cluster == cluster
+			&& ( cluster == -1 || !memcmp( list->areamask, tr.refdef.areamask, sizeof( list->areamask ) ) ) ) {
+			break;
+		}
+		if ( list->lastUsed < oldest->lastUsed ) {
+			oldest = list;
+		}
+	}
+	if ( i == MAX_VISLISTS ) {
+		list = oldest;
+		R_BuildVisList( list, cluster );
+	}
+
+	list->lastUsed = tr.world->visListFrame;
+	tr.world->visList = list;
+	return list;
+}
+
+/*
+================
+R_AddVisChunks
+================
+*/
+static void R_AddVisChunks( visList_t *list, int firstChunk, int numChunks, int dlightBits ) {
+	visChunk_t	*chunk;
+	mnode_t		*leaf;
+	int			*leafNum;
+	int			planeBits, chunkDlightBits;
+	int			i, j;
+
+	for ( i = 0, chunk = list->chunks + firstChunk ; i < numChunks ; i++, chunk++ ) {
+		planeBits = 0;
+		if ( !r_nocull->integer ) {
+			planeBits = R_CullVisBox( chunk->mins, chunk->maxs, 15 );
+			if ( planeBits < 0 ) {
+				continue;
+			}
+		}
+
+		chunkDlightBits = 0;
+		if ( dlightBits ) {
+			chunkDlightBits = R_DlightVisBox( chunk->mins, chunk->maxs, dlightBits );
+		}
+
+		leafNum = list->leafs + chunk->firstLeaf;
+		for ( j = 0 ; j < chunk->numLeafs ; j++, leafNum++ ) {
+			leaf = tr.world->leafOrder[ *leafNum ];
+
+			// only the planes that cut the chunk are left to test
+			if ( planeBits && R_CullVisBox( leaf->mins, leaf->maxs, planeBits ) < 0 ) {
+				continue;
+			}
+
+			if ( chunkDlightBits ) {
+				R_AddWorldLeaf( leaf, R_DlightVisBox( leaf->mins, leaf->maxs, chunkDlightBits ) );
+			} else {
+				R_AddWorldLeaf( leaf, 0 );
+			}
+		}
+	}
+}
+
+/*
+================
+R_AddVisJob
+================
+*/
+static void R_AddVisJob( int index ) {
+	visJob_t	*job;
+
+	job = &jobVisList->jobs[index];
+	R_AddVisChunks( jobVisList, job->firstChunk, job->numChunks, jobDlightBits );
+}
+
+/*
+================
+R_AddVisList
+
+The chunks of each world job are run as one front end job, with the
+same shared surface handling as R_AddWorldJobs
+================
+*/
+static void R_AddVisList( int dlightBits ) {
+	visList_t	*list;
+
+	list = R_FindVisList();
+
+	if ( numFrontEndThreads > 1 && list->numJobs > 1 ) {
+		jobVisList = list;
+		jobDlightBits = dlightBits;
+		R_BeginSharedSurfaces();
+		R_RunFrontEndJobs( R_AddVisJob, list->numJobs );
+		R_EndSharedSurfaces();
+	} else {
+		R_AddVisChunks( list, 0, list->numChunks, dlightBits );
+	}
+}
+
+
 /*
 =============
 R_AddWorldSurfaces
 =============
 */
 void R_AddWorldSurfaces (void) {
+	frontEndThread_t	*thread;
+	int					i;
+
 	if ( !r_drawworld->integer ) {
 		return;
 	}
@@ -651,18 +1090,37 @@ void R_AddWorldSurfaces (void) {
 		return;
 	}
 
-	tr.currentEntityNum = ENTITYNUM_WORLD;
-	tr.shiftedEntityNum = tr.currentEntityNum << QSORT_ENTITYNUM_SHIFT;
-
-	// determine which leaves are in the PVS / areamask
-	R_MarkLeaves ();
+	frontEnd->currentEntityNum = ENTITYNUM_WORLD;
+	frontEnd->shiftedEntityNum = (sortKey_t)frontEnd->currentEntityNum << QSORT_ENTITYNUM_SHIFT;
 
 	// clear out the visible min/max
 	ClearBounds( tr.viewParms.visBounds[0], tr.viewParms.visBounds[1] );
+	for ( i = 0 ; i < numFrontEndThreads ; i++ ) {
+		ClearBounds( frontEndThreads[i].visBounds[0], frontEndThreads[i].visBounds[1] );
+	}
 
 	// perform frustum culling and add all the potentially visible surfaces
 	if ( tr.refdef.num_dlights > 32 ) {
 		tr.refdef.num_dlights = 32 ;
 	}
-	R_RecursiveWorldNode( tr.world->nodes, 15, ( 1 << tr.refdef.num_dlights ) - 1 );
+	if ( r_visLists->integer ) {
+		R_AddVisList( ( 1 << tr.refdef.num_dlights ) - 1 );
+	} else {
+		// determine which leaves are in the PVS / areamask
+		R_MarkLeaves ();
+
+		if ( numFrontEndThreads > 1 && tr.world->numWorldJobs > 1 ) {
+			R_AddWorldJobs( ( 1 << tr.refdef.num_dlights ) - 1 );
+		} else {
+			R_RecursiveWorldNode( tr.world->nodes, 15, ( 1 << tr.refdef.num_dlights ) - 1 );
+		}
+	}
+
+	for ( i = 0 ; i < numFrontEndThreads ; i++ ) {
+		thread = &frontEndThreads[i];
+		if ( thread->visBounds[0][0] <= thread->visBounds[1][0] ) {
+			AddPointToBounds( thread->visBounds[0], tr.viewParms.visBounds[0], tr.viewParms.visBounds[1] );
+			AddPointToBounds( thread->visBounds[1], tr.viewParms.visBounds[0], tr.viewParms.visBounds[1] );
+		}
+	}
 }
@@ -94,6 +94,8 @@ typedef struct {
 										// order, otherwise the delta compression will fail
 	int				messageSent;		// time the message was transmitted
 	int				messageAcked;		// time the message was acked
+	int				realSent;			// Sys_Milliseconds when it was transmitted
+	int				realAcked;			// arrival time of the packet that acked it
 	int				messageSize;		// used to rate drop packets
 } clientSnapshot_t;
 
@@ -148,6 +150,7 @@ typedef struct client_s {
 	int				deltaMessage;		// frame last client usercmd message
 	int				nextReliableTime;	// svs.time when another reliable command will be allowed
 	int				lastPacketTime;		// svs.time when packet was last received
+	int				lastPacketArrival;	// Sys_Milliseconds when it arrived, from the event
 	int				lastConnectTime;	// svs.time when connection started
 	int				nextSnapshotTime;	// send another snapshot when svs.time >= nextSnapshotTime
 	qboolean		rateDelayed;		// true if nextSnapshotTime was set based on rate instead of snapshotMsec
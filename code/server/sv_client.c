@@ -1371,6 +1371,7 @@ static void SV_UserMove( client_t *cl, msg_t *msg, qboolean delta ) {
 
 	// save time for ping calculation
 	cl->frames[ cl->messageAcknowledge & PACKET_MASK ].messageAcked = svs.time;
+	cl->frames[ cl->messageAcknowledge & PACKET_MASK ].realAcked = cl->lastPacketArrival;
 
 	// TTimo
 	// catch the no-cp-yet situation before SV_ClientEnterWorld
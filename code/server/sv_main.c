@@ -545,7 +545,7 @@ void SV_ConnectionlessPacket( netadr_t from, msg_t *msg ) {
 SV_ReadPackets
 =================
 */
-void SV_PacketEvent( netadr_t from, msg_t *msg ) {
+void SV_PacketEvent( netadr_t from, msg_t *msg, int time ) {
 	int			i;
 	client_t	*cl;
 	int			qport;
@@ -591,6 +591,7 @@ void SV_PacketEvent( netadr_t from, msg_t *msg ) {
 			// reliable message, but they don't do any other processing
 			if (cl->state != CS_ZOMBIE) {
 				cl->lastPacketTime = svs.time;	// don't timeout
+				cl->lastPacketArrival = time;
 				SV_ExecuteClientMessage( cl, msg );
 			}
 		}
@@ -638,7 +639,9 @@ void SV_CalcPings( void ) {
 			if ( cl->frames[j].messageAcked <= 0 ) {
 				continue;
 			}
-			delta = cl->frames[j].messageAcked - cl->frames[j].messageSent;
+			// real times rather than svs.time, so packets are not
+			// rounded to the server frame they were read in
+			delta = cl->frames[j].realAcked - cl->frames[j].realSent;
 			count++;
 			total += delta;
 		}
@@ -1286,6 +1286,83 @@ static void GLW_InitExtensions( void )
     ri.Printf( PRINT_ALL, "...GL_EXT_compiled_vertex_array not found\n" );
   }
 
+  // GL_ARB_vertex_buffer_object
+  qglBindBufferARB = NULL;
+  qglDeleteBuffersARB = NULL;
+  qglGenBuffersARB = NULL;
+  qglBufferDataARB = NULL;
+  qglMultiDrawElementsEXT = NULL;
+  if ( Q_stristr( glConfig.extensions_string, "GL_ARB_vertex_buffer_object" ) )
+  {
+    if ( r_ext_vertex_buffer_object->value )
+    {
+      qglBindBufferARB = ( void ( APIENTRY * )( GLenum, GLuint ) ) dlsym( glw_state.OpenGLLib, "glBindBufferARB" );
+      qglDeleteBuffersARB = ( void ( APIENTRY * )( GLsizei, const GLuint * ) ) dlsym( glw_state.OpenGLLib, "glDeleteBuffersARB" );
+      qglGenBuffersARB = ( void ( APIENTRY * )( GLsizei, GLuint * ) ) dlsym( glw_state.OpenGLLib, "glGenBuffersARB" );
+      qglBufferDataARB = ( void ( APIENTRY * )( GLenum, ptrdiff_t, const GLvoid *, GLenum ) ) dlsym( glw_state.OpenGLLib, "glBufferDataARB" );
+
+      if ( qglBindBufferARB && qglDeleteBuffersARB && qglGenBuffersARB && qglBufferDataARB )
+      {
+        ri.Printf( PRINT_ALL, "...using GL_ARB_vertex_buffer_object\n" );
+
+        if ( Q_stristr( glConfig.extensions_string, "GL_EXT_multi_draw_arrays" ) )
+        {
+          qglMultiDrawElementsEXT = ( void ( APIENTRY * )( GLenum, const GLsizei *, GLenum, const GLvoid **, GLsizei ) ) dlsym( glw_state.OpenGLLib, "glMultiDrawElementsEXT" );
+        }
+      } else
+      {
+        qglBindBufferARB = NULL;
+        qglDeleteBuffersARB = NULL;
+        qglGenBuffersARB = NULL;
+        qglBufferDataARB = NULL;
+        ri.Printf( PRINT_ALL, "...not using GL_ARB_vertex_buffer_object, missing entry points\n" );
+      }
+    } else
+    {
+      ri.Printf( PRINT_ALL, "...ignoring GL_ARB_vertex_buffer_object\n" );
+    }
+  } else
+  {
+    ri.Printf( PRINT_ALL, "...GL_ARB_vertex_buffer_object not found\n" );
+  }
+
+  // GL_ARB_occlusion_query
+  qglGenQueriesARB = NULL;
+  qglDeleteQueriesARB = NULL;
+  qglBeginQueryARB = NULL;
+  qglEndQueryARB = NULL;
+  qglGetQueryObjectivARB = NULL;
+  if ( Q_stristr( glConfig.extensions_string, "GL_ARB_occlusion_query" ) )
+  {
+    if ( r_ext_occlusion_query->value )
+    {
+      qglGenQueriesARB = ( void ( APIENTRY * )( GLsizei, GLuint * ) ) dlsym( glw_state.OpenGLLib, "glGenQueriesARB" );
+      qglDeleteQueriesARB = ( void ( APIENTRY * )( GLsizei, const GLuint * ) ) dlsym( glw_state.OpenGLLib, "glDeleteQueriesARB" );
+      qglBeginQueryARB = ( void ( APIENTRY * )( GLenum, GLuint ) ) dlsym( glw_state.OpenGLLib, "glBeginQueryARB" );
+      qglEndQueryARB = ( void ( APIENTRY * )( GLenum ) ) dlsym( glw_state.OpenGLLib, "glEndQueryARB" );
+      qglGetQueryObjectivARB = ( void ( APIENTRY * )( GLuint, GLenum, GLint * ) ) dlsym( glw_state.OpenGLLib, "glGetQueryObjectivARB" );
+
+      if ( qglGenQueriesARB && qglDeleteQueriesARB && qglBeginQueryARB && qglEndQueryARB && qglGetQueryObjectivARB )
+      {
+        ri.Printf( PRINT_ALL, "...using GL_ARB_occlusion_query\n" );
+      } else
+      {
+        qglGenQueriesARB = NULL;
+        qglDeleteQueriesARB = NULL;
+        qglBeginQueryARB = NULL;
+        qglEndQueryARB = NULL;
+        qglGetQueryObjectivARB = NULL;
+        ri.Printf( PRINT_ALL, "...not using GL_ARB_occlusion_query, missing entry points\n" );
+      }
+    } else
+    {
+      ri.Printf( PRINT_ALL, "...ignoring GL_ARB_occlusion_query\n" );
+    }
+  } else
+  {
+    ri.Printf( PRINT_ALL, "...GL_ARB_occlusion_query not found\n" );
+  }
+
 }
 
 static void GLW_InitGamma()
@@ -23,6 +23,9 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 void Sys_QueEvent( int time, sysEventType_t type, int value, int value2, int ptrLength, void *ptr );
 qboolean Sys_GetPacket ( netadr_t *net_from, msg_t *net_message );
+
+#define	SYS_PACKET_BATCH	32		// packets received per Sys_GetPackets call
+int Sys_GetPackets( netPacket_t **packets, int *lengths, int *times, int max );
 void Sys_SendKeyEvents (void);
 
 // Input subsystem
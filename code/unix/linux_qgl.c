@@ -3410,6 +3410,16 @@ qboolean QGL_Init( const char *dllname )
 
 	qglLockArraysEXT = 0;
 	qglUnlockArraysEXT = 0;
+	qglBindBufferARB = 0;
+	qglDeleteBuffersARB = 0;
+	qglGenBuffersARB = 0;
+	qglBufferDataARB = 0;
+	qglMultiDrawElementsEXT = 0;
+	qglGenQueriesARB = 0;
+	qglDeleteQueriesARB = 0;
+	qglBeginQueryARB = 0;
+	qglEndQueryARB = 0;
+	qglGetQueryObjectivARB = 0;
 	qglPointParameterfEXT = 0;
 	qglPointParameterfvEXT = 0;
 	qglColorTableEXT = 0;
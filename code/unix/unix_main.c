@@ -37,6 +37,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include <sys/wait.h>
 #include <sys/mman.h>
 #include <errno.h>
+#include <pthread.h>
 #ifdef __linux__ // rb010123
   #include <mntent.h>
 #endif
@@ -338,6 +339,7 @@ void Sys_Exit( int ex ) {
 
 void Sys_Quit (void) {
   CL_Shutdown ();
+  Sys_ShutdownStreamThread ();
   fcntl (0, F_SETFL, fcntl (0, F_GETFL, 0) & ~FNDELAY);
   Sys_Exit(0);
 }
@@ -806,76 +808,241 @@ void *Sys_LoadDll( const char *name, char *fqpath ,
 
 BACKGROUND FILE STREAMING
 
+Each streamed file gets two read ahead buffers.  The stream thread fills
+whichever is empty while the main thread copies out of the other, so a
+main thread read only waits when it gets through a whole buffer before
+the thread has filled the next one.  Those waits are counted as stalls,
+streaminfo prints them.
+
+The thread can only read handles that don't share anything with the
+main thread's file system calls, see FS_ThreadSafeRead.  Other files,
+files that were never begun, and everything with sys_streamThread 0 are
+read straight through FS_Read.
+
 ========================================================================
 */
 
-#if 1
+#define MAX_STREAMS         8
+#define MIN_STREAM_BUFFER   0x4000
 
-void Sys_InitStreamThread( void ) {
-}
+typedef struct
+{
+  fileHandle_t  file;           // 0 when the slot is free
+  FILE          *plain;         // for read ahead hints, NULL in a pak
+  int           bufferSize;
+  byte          *buffers[2];
+  int           length[2];      // bytes in each filled buffer
+
+  // changed with streamLock held
+  int           filled;         // buffers filled by the thread, ever
+  int           consumed;       // buffers emptied by the main thread, ever
+  qboolean      eof;
+  qboolean      reading;        // the thread is filling a buffer
+
+  // main thread only
+  qboolean      holding;        // buffers[consumed & 1] is known to be filled
+  int           offset;         // next byte in it
+
+  // streaminfo
+  int           reads;
+  int           bytes;
+  int           stalls;
+  int           stallMsec;
+} streamState_t;
 
-void Sys_ShutdownStreamThread( void ) {
-}
+static streamState_t    streams[MAX_STREAMS];
 
-void Sys_BeginStreamedFile( fileHandle_t f, int readAhead ) {
-}
+static pthread_mutex_t  streamLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t   streamWork = PTHREAD_COND_INITIALIZER;    // a buffer was emptied
+static pthread_cond_t   streamDone = PTHREAD_COND_INITIALIZER;    // a buffer was filled
+static void             *streamThread;
+static qboolean         streamQuit;
+
+static cvar_t           *sys_streamThread;
+
+// totals for streaminfo, including closed streams
+static int  streamTotalReads;
+static int  streamTotalStalls;
+static int  streamTotalStallMsec;
+static int  streamMaxStallMsec;
+static int  streamUnstreamedReads;
+
+/*
+===============
+Sys_FindStream
+================
+*/
+static streamState_t *Sys_FindStream( fileHandle_t f )
+{
+  int   i;
+
+  if ( !f )
+    return NULL;
 
-void Sys_EndStreamedFile( fileHandle_t f ) {
+  for ( i = 0 ; i < MAX_STREAMS ; i++ )
+  {
+    if ( streams[i].file == f )
+      return &streams[i];
+  }
+  return NULL;
 }
 
-int Sys_StreamedRead( void *buffer, int size, int count, fileHandle_t f ) {
-  return FS_Read( buffer, size * count, f );
+/*
+===============
+Sys_FillStream
+
+Reads the next buffer of a stream.  The caller has set s->reading, so
+nothing else touches the file or the buffer being filled.
+================
+*/
+static int Sys_FillStream( streamState_t *s )
+{
+  long  pos;
+  int   r;
+
+  r = FS_Read( s->buffers[s->filled & 1], s->bufferSize, s->file );
+  s->length[s->filled & 1] = r;
+
+  // have the kernel start on the buffer after this one
+  if ( s->plain && r == s->bufferSize )
+  {
+    pos = ftell( s->plain );
+    if ( pos >= 0 )
+      posix_fadvise( fileno( s->plain ), pos, s->bufferSize * 2, POSIX_FADV_WILLNEED );
+  }
+  return r;
 }
 
-void Sys_StreamSeek( fileHandle_t f, int offset, int origin ) {
-  FS_Seek( f, offset, origin );
+/*
+===============
+Sys_FinishFill
+
+Called with streamLock held after Sys_FillStream
+================
+*/
+static void Sys_FinishFill( streamState_t *s, int r )
+{
+  if ( r > 0 )
+    s->filled++;
+  if ( r < s->bufferSize )
+    s->eof = qtrue;
+  s->reading = qfalse;
 }
 
-#else
+/*
+===============
+Sys_StreamThread
 
-typedef struct
+Fills empty buffers for as long as the stream system is up
+================
+*/
+static void Sys_StreamThread( void *arg )
 {
-  fileHandle_t file;
-  byte  *buffer;
-  qboolean  eof;
-  int   bufferSize;
-  int   streamPosition; // next byte to be returned by Sys_StreamRead
-  int   threadPosition; // next byte to be read from file
-} streamState_t;
+  streamState_t *s;
+  int           i, next, r;
+
+  next = 0;
+  pthread_mutex_lock( &streamLock );
+  while ( !streamQuit )
+  {
+    // take the streams in turn so one fast reader can't starve the rest
+    s = NULL;
+    for ( i = 0 ; i < MAX_STREAMS ; i++ )
+    {
+      s = &streams[( next + i ) % MAX_STREAMS];
+      if ( s->file && !s->eof && !s->reading && s->filled - s->consumed < 2 )
+        break;
+      s = NULL;
+    }
+    if ( !s )
+    {
+      pthread_cond_wait( &streamWork, &streamLock );
+      continue;
+    }
+    next = ( s - streams ) + 1;
 
-streamState_t stream;
+    s->reading = qtrue;
+    pthread_mutex_unlock( &streamLock );
+
+    r = Sys_FillStream( s );
+
+    pthread_mutex_lock( &streamLock );
+    Sys_FinishFill( s, r );
+    pthread_cond_broadcast( &streamDone );
+  }
+  pthread_mutex_unlock( &streamLock );
+}
 
 /*
 ===============
-Sys_StreamThread
+Sys_WaitForStream
+
+Waits for the thread to finish with a stream's file, called with
+streamLock held
+================
+*/
+static void Sys_WaitForStream( streamState_t *s )
+{
+  while ( s->reading )
+    pthread_cond_wait( &streamDone, &streamLock );
+}
+
+/*
+===============
+Sys_PrimeStream
 
-A thread will be sitting in this loop forever
+Fills the first buffer on the calling thread.  Opening or seeking the
+file has just blocked anyway, and this way the first read doesn't.
 ================
 */
-void Sys_StreamThread( void ) 
+static void Sys_PrimeStream( streamState_t *s )
 {
-  int   buffer;
-  int   count;
-  int   readCount;
-  int   bufferPoint;
   int   r;
 
-  // if there is any space left in the buffer, fill it up
-  if ( !stream.eof )
+  s->filled = s->consumed = 0;
+  s->holding = qfalse;
+  s->offset = 0;
+  s->eof = qfalse;
+
+  s->reading = qtrue;
+  pthread_mutex_unlock( &streamLock );
+  r = Sys_FillStream( s );
+  pthread_mutex_lock( &streamLock );
+  Sys_FinishFill( s, r );
+
+  pthread_cond_signal( &streamWork );
+}
+
+/*
+===============
+Sys_StreamInfo_f
+================
+*/
+static void Sys_StreamInfo_f( void )
+{
+  streamState_t *s;
+  int           i;
+
+  if ( !streamThread )
+  {
+    Com_Printf( "no stream thread, streamed files are read directly\n" );
+  }
+  else
   {
-    count = stream.bufferSize - (stream.threadPosition - stream.streamPosition);
-    if ( count )
+    for ( i = 0 ; i < MAX_STREAMS ; i++ )
     {
-      bufferPoint = stream.threadPosition % stream.bufferSize;
-      buffer = stream.bufferSize - bufferPoint;
-      readCount = buffer < count ? buffer : count;
-      r = FS_Read ( stream.buffer + bufferPoint, readCount, stream.file );
-      stream.threadPosition += r;
-
-      if ( r != readCount )
-        stream.eof = qtrue;
+      s = &streams[i];
+      if ( !s->file )
+        continue;
+      Com_Printf( "handle %2i: %i x %i byte buffers, %i reads, %i bytes, %i stalls (%i msec)%s\n",
+        s->file, 2, s->bufferSize, s->reads, s->bytes, s->stalls, s->stallMsec,
+        s->plain ? "" : " in a pak" );
     }
   }
+
+  Com_Printf( "%i streamed reads, %i stalls, %i msec stalled, longest %i msec\n",
+    streamTotalReads, streamTotalStalls, streamTotalStallMsec, streamMaxStallMsec );
+  Com_Printf( "%i reads of files that weren't streamed\n", streamUnstreamedReads );
 }
 
 /*
@@ -884,8 +1051,18 @@ Sys_InitStreamThread
 
 ================
 */
-void Sys_InitStreamThread( void ) 
+void Sys_InitStreamThread( void )
 {
+  sys_streamThread = Cvar_Get( "sys_streamThread", "1", CVAR_ARCHIVE | CVAR_LATCH );
+  Cmd_AddCommand( "streaminfo", Sys_StreamInfo_f );
+
+  if ( !sys_streamThread->integer )
+    return;
+
+  streamQuit = qfalse;
+  streamThread = Sys_CreateThread( Sys_StreamThread, NULL );
+  if ( !streamThread )
+    Com_Printf( "couldn't start the stream thread, streamed files are read directly\n" );
 }
 
 /*
@@ -894,8 +1071,26 @@ Sys_ShutdownStreamThread
 
 ================
 */
-void Sys_ShutdownStreamThread( void ) 
+void Sys_ShutdownStreamThread( void )
 {
+  int   i;
+
+  if ( !streamThread )
+    return;
+
+  pthread_mutex_lock( &streamLock );
+  streamQuit = qtrue;
+  pthread_cond_signal( &streamWork );
+  pthread_mutex_unlock( &streamLock );
+
+  Sys_JoinThread( streamThread );
+  streamThread = NULL;
+
+  for ( i = 0 ; i < MAX_STREAMS ; i++ )
+  {
+    if ( streams[i].file )
+      Sys_EndStreamedFile( streams[i].file );
+  }
 }
 
 
@@ -907,17 +1102,45 @@ Sys_BeginStreamedFile
 */
 void Sys_BeginStreamedFile( fileHandle_t f, int readAhead ) 
 {
-  if ( stream.file )
+  streamState_t *s;
+  FILE          *plain;
+  int           i;
+
+  if ( !streamThread || !f )
+    return;
+
+  Sys_EndStreamedFile( f );
+  if ( !FS_ThreadSafeRead( f, &plain ) )
+    return;
+
+  s = NULL;
+  for ( i = 0 ; i < MAX_STREAMS ; i++ )
   {
-    Com_Error( ERR_FATAL, "Sys_BeginStreamedFile: unclosed stream");
+    if ( !streams[i].file )
+    {
+      s = &streams[i];
+      break;
+    }
   }
+  if ( !s )
+    return;     // read directly
+
+  if ( readAhead < MIN_STREAM_BUFFER )
+    readAhead = MIN_STREAM_BUFFER;
+
+  Com_Memset( s, 0, sizeof( *s ) );
+  s->plain = plain;
+  s->bufferSize = readAhead;
+  s->buffers[0] = Z_Malloc( readAhead );
+  s->buffers[1] = Z_Malloc( readAhead );
+
+  if ( plain )
+    posix_fadvise( fileno( plain ), 0, 0, POSIX_FADV_SEQUENTIAL );
 
-  stream.file = f;
-  stream.buffer = Z_Malloc( readAhead );
-  stream.bufferSize = readAhead;
-  stream.streamPosition = 0;
-  stream.threadPosition = 0;
-  stream.eof = qfalse;
+  pthread_mutex_lock( &streamLock );
+  s->file = f;
+  Sys_PrimeStream( s );
+  pthread_mutex_unlock( &streamLock );
 }
 
 /*
@@ -928,13 +1151,20 @@ Sys_EndStreamedFile
 */
 void Sys_EndStreamedFile( fileHandle_t f ) 
 {
-  if ( f != stream.file )
-  {
-    Com_Error( ERR_FATAL, "Sys_EndStreamedFile: wrong file");
-  }
+  streamState_t *s;
+
+  s = Sys_FindStream( f );
+  if ( !s )
+    return;
+
+  pthread_mutex_lock( &streamLock );
+  Sys_WaitForStream( s );
+  s->file = 0;
+  pthread_mutex_unlock( &streamLock );
 
-  stream.file = 0;
-  Z_Free( stream.buffer );
+  Z_Free( s->buffers[0] );
+  Z_Free( s->buffers[1] );
+  s->buffers[0] = s->buffers[1] = NULL;
 }
 
 
@@ -942,18 +1172,25 @@ void Sys_EndStreamedFile( fileHandle_t f )
 ===============
 Sys_StreamedRead
 
+Returns the number of bytes read, like FS_Read
 ================
 */
 int Sys_StreamedRead( void *buffer, int size, int count, fileHandle_t f ) 
 {
-  int   available;
+  streamState_t *s;
   int   remaining;
-  int   sleepCount;
   int   copy;
-  int   bufferCount;
-  int   bufferPoint;
+  int   start, msec;
+  int   b;
   byte  *dest;
 
+  s = Sys_FindStream( f );
+  if ( !s )
+  {
+    streamUnstreamedReads++;
+    return FS_Read( buffer, size * count, f );
+  }
+
   dest = (byte *)buffer;
   remaining = size * count;
 
@@ -962,33 +1199,58 @@ int Sys_StreamedRead( void *buffer, int size, int count, fileHandle_t f )
     Com_Error( ERR_FATAL, "Streamed read with non-positive size" );
   }
 
-  sleepCount = 0;
+  s->reads++;
+  streamTotalReads++;
+
   while ( remaining > 0 )
   {
-    available = stream.threadPosition - stream.streamPosition;
-    if ( !available )
+    if ( !s->holding )
     {
-      if (stream.eof)
-        break;
-      Sys_StreamThread();
-      continue;
-    }
+      pthread_mutex_lock( &streamLock );
+      if ( s->consumed == s->filled && !s->eof )
+      {
+        // the thread is behind, this is what should never happen
+        s->stalls++;
+        streamTotalStalls++;
+        start = Sys_Milliseconds();
+        while ( s->consumed == s->filled && !s->eof )
+          pthread_cond_wait( &streamDone, &streamLock );
+        msec = Sys_Milliseconds() - start;
+        s->stallMsec += msec;
+        streamTotalStallMsec += msec;
+        if ( msec > streamMaxStallMsec )
+          streamMaxStallMsec = msec;
+      }
+      s->holding = ( s->consumed != s->filled );
+      pthread_mutex_unlock( &streamLock );
 
-    bufferPoint = stream.streamPosition % stream.bufferSize;
-    bufferCount = stream.bufferSize - bufferPoint;
+      if ( !s->holding )
+        break;    // end of file
+    }
 
-    copy = available < bufferCount ? available : bufferCount;
+    b = s->consumed & 1;
+    copy = s->length[b] - s->offset;
     if ( copy > remaining )
-    {
       copy = remaining;
-    }
-    memcpy( dest, stream.buffer + bufferPoint, copy );
-    stream.streamPosition += copy;
+    memcpy( dest, s->buffers[b] + s->offset, copy );
+    s->offset += copy;
     dest += copy;
     remaining -= copy;
+
+    if ( s->offset == s->length[b] )
+    {
+      // hand the buffer back to the thread
+      pthread_mutex_lock( &streamLock );
+      s->consumed++;
+      s->holding = qfalse;
+      s->offset = 0;
+      pthread_cond_signal( &streamWork );
+      pthread_mutex_unlock( &streamLock );
+    }
   }
 
-  return(count * size - remaining) / size;
+  s->bytes += size * count - remaining;
+  return size * count - remaining;
 }
 
 /*
@@ -998,14 +1260,32 @@ Sys_StreamSeek
 ================
 */
 void Sys_StreamSeek( fileHandle_t f, int offset, int origin ) {
-  // clear to that point
+  streamState_t *s;
+  int   i;
+
+  s = Sys_FindStream( f );
+  if ( !s )
+  {
+    FS_Seek( f, offset, origin );
+    return;
+  }
+
+  pthread_mutex_lock( &streamLock );
+  Sys_WaitForStream( s );
+
+  // the file is ahead of the reader by whatever is buffered
+  if ( origin == FS_SEEK_CUR )
+  {
+    for ( i = s->consumed ; i != s->filled ; i++ )
+      offset -= s->length[i & 1];
+    if ( s->holding )
+      offset += s->offset;
+  }
   FS_Seek( f, offset, origin );
-  stream.streamPosition = 0;
-  stream.threadPosition = 0;
-  stream.eof = qfalse;
-}
 
-#endif
+  Sys_PrimeStream( s );
+  pthread_mutex_unlock( &streamLock );
+}
 
 /*
 ========================================================================
@@ -1031,7 +1311,7 @@ Sys_QueEvent
 
 A time of 0 will get the current time
 Ptr should either be null, or point to a block of data that can
-be freed by the game later.
+be released with Com_EventFree later.
 ================
 */
 void Sys_QueEvent( int time, sysEventType_t type, int value, int value2, int ptrLength, void *ptr ) {
@@ -1046,7 +1326,7 @@ void Sys_QueEvent( int time, sysEventType_t type, int value, int value2, int ptr
     // we are discarding an event, but don't leak memory
     if ( ev->evPtr )
     {
-      Z_Free( ev->evPtr );
+      Com_EventFree( ev->evPtr );
     }
     eventTail++;
   }
@@ -1077,6 +1357,10 @@ sysEvent_t Sys_GetEvent( void ) {
   char    *s;
   msg_t   netmsg;
   netadr_t  adr;
+  netPacket_t *packets[SYS_PACKET_BATCH];
+  int     lengths[SYS_PACKET_BATCH];
+  int     times[SYS_PACKET_BATCH];
+  int     count, i;
 
   // return if we have data
   if ( eventHead > eventTail )
@@ -1097,7 +1381,7 @@ sysEvent_t Sys_GetEvent( void ) {
     int   len;
 
     len = strlen( s ) + 1;
-    b = Z_Malloc( len );
+    b = Com_EventAlloc( len );
     strcpy( b, s );
     Sys_QueEvent( 0, SE_CONSOLE, 0, 0, len, b );
   }
@@ -1105,16 +1389,23 @@ sysEvent_t Sys_GetEvent( void ) {
   // check for other input devices
   IN_Frame();
 
-  // check for network packets
+  // check for network packets, a batch at a time straight into packet
+  // buffers, or one copied out if the buffers are all queued already
+  count = Sys_GetPackets( packets, lengths, times, MAX_QUED_EVENTS - ( eventHead - eventTail ) );
+  for ( i = 0 ; i < count ; i++ )
+  {
+    Sys_QueEvent( times[i], SE_PACKET, 0, 0, sizeof( netadr_t ) + lengths[i], packets[i] );
+  }
+
   MSG_Init( &netmsg, sys_packetReceived, sizeof( sys_packetReceived ) );
-  if ( Sys_GetPacket ( &adr, &netmsg ) )
+  if ( count == -1 && Sys_GetPacket ( &adr, &netmsg ) )
   {
     netadr_t    *buf;
     int       len;
 
     // copy out to a seperate buffer for qeueing
     len = sizeof( netadr_t ) + netmsg.cursize;
-    buf = Z_Malloc( len );
+    buf = Com_EventAlloc( len );
     *buf = adr;
     memcpy( buf+1, netmsg.data, netmsg.cursize );
     Sys_QueEvent( 0, SE_PACKET, 0, 0, len, buf );
@@ -1253,6 +1544,7 @@ int main ( int argc, char* argv[] )
 
   Com_Init(cmdline);
   NET_Init();
+  Sys_InitStreamThread();
 
   Sys_ConsoleInputInit();
 
@@ -21,6 +21,10 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 */
 // unix_net.c
 
+#ifdef __linux__
+#define _GNU_SOURCE		// recvmmsg
+#endif
+
 #include "../game/q_shared.h"
 #include "../qcommon/qcommon.h"
 
@@ -34,8 +38,13 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include <sys/param.h>
 #include <sys/ioctl.h>
 #include <sys/uio.h>
+#include <sys/resource.h>
+#include <poll.h>
+#include <fcntl.h>
 #include <errno.h>
 
+#include "linux_local.h"
+
 #ifdef MACOS_X
 #import <sys/sockio.h>
 #import <net/if.h>
@@ -206,6 +215,703 @@ qboolean	Sys_GetPacket (netadr_t *net_from, msg_t *net_message)
 	return qfalse;
 }
 
+static volatile int	netReceiveErrors;		// written by whichever thread receives
+static volatile int	netReceiveErrno;		// the last one
+static int			netReceiveErrorsReported;
+
+/*
+==================
+NET_CountReceiveError
+==================
+*/
+static void NET_CountReceiveError (void)
+{
+	netReceiveErrno = errno;
+	Sys_MemoryBarrier ();
+	netReceiveErrors++;
+}
+
+/*
+==================
+NET_ReceiveBatch
+
+Receives up to max waiting packets on net_socket straight into packet
+buffers, with a single recvmmsg call on Linux.  Returns how many were
+received, or -1 if there wasn't a free packet buffer to receive into.
+If stamps isn't NULL it gets the arrival time of each packet, from the
+kernel when the socket has SO_TIMESTAMP set.
+
+This runs on the network thread, so it doesn't print.  Oversize packets
+are passed back with a length of MAX_MSGLEN, and receive errors are
+counted, for Sys_GetPackets to report on the main thread.
+==================
+*/
+static int NET_ReceiveBatch( int net_socket, netPacket_t **packets, int *lengths, struct timeval *stamps, int max )
+{
+	struct sockaddr_in	from[SYS_PACKET_BATCH];
+	struct timeval	now;
+	int		i, count, ret;
+#ifdef __linux__
+	struct mmsghdr	msgs[SYS_PACKET_BATCH];
+	struct iovec	iovs[SYS_PACKET_BATCH];
+	byte			control[SYS_PACKET_BATCH][CMSG_SPACE(sizeof(struct timeval))];
+	struct cmsghdr	*cmsg;
+#else
+	socklen_t	fromlen;
+#endif
+
+	if (max > SYS_PACKET_BATCH)
+		max = SYS_PACKET_BATCH;
+
+	for (count = 0 ; count < max ; count++)
+	{
+		packets[count] = Com_AllocPacket();
+		if (!packets[count])
+			break;
+	}
+	if (!count)
+		return -1;
+
+#ifdef __linux__
+	memset (msgs, 0, count * sizeof(msgs[0]));
+	for (i = 0 ; i < count ; i++)
+	{
+		iovs[i].iov_base = packets[i]->data;
+		iovs[i].iov_len = MAX_MSGLEN;
+		msgs[i].msg_hdr.msg_name = &from[i];
+		msgs[i].msg_hdr.msg_namelen = sizeof(from[i]);
+		msgs[i].msg_hdr.msg_iov = &iovs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+		if (stamps)
+		{
+			msgs[i].msg_hdr.msg_control = control[i];
+			msgs[i].msg_hdr.msg_controllen = sizeof(control[i]);
+		}
+	}
+
+	ret = recvmmsg (net_socket, msgs, count, MSG_DONTWAIT, NULL);
+	if (ret == -1)
+	{
+		if (errno != EWOULDBLOCK && errno != ECONNREFUSED)
+			NET_CountReceiveError ();
+		ret = 0;
+	}
+
+	gettimeofday (&now, NULL);
+	for (i = 0 ; i < ret ; i++)
+	{
+		lengths[i] = msgs[i].msg_len;
+		if (!stamps)
+			continue;
+
+		stamps[i] = now;
+		for (cmsg = CMSG_FIRSTHDR(&msgs[i].msg_hdr) ; cmsg ; cmsg = CMSG_NXTHDR(&msgs[i].msg_hdr, cmsg))
+		{
+			if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMP)
+			{
+				memcpy (&stamps[i], CMSG_DATA(cmsg), sizeof(stamps[i]));
+				break;
+			}
+		}
+	}
+#else
+	for (ret = 0 ; ret < count ; ret++)
+	{
+		fromlen = sizeof(from[ret]);
+		lengths[ret] = recvfrom (net_socket, packets[ret]->data, MAX_MSGLEN
+			, 0, (struct sockaddr *)&from[ret], &fromlen);
+		if (lengths[ret] == -1)
+		{
+			if (errno != EWOULDBLOCK && errno != ECONNREFUSED)
+				NET_CountReceiveError ();
+			break;
+		}
+	}
+
+	gettimeofday (&now, NULL);
+	for (i = 0 ; stamps && i < ret ; i++)
+		stamps[i] = now;
+#endif
+
+	// hand back the buffers nothing arrived in
+	for (i = 0 ; i < count ; i++)
+	{
+		if (i >= ret)
+			Com_FreePacket (packets[i]);
+		else
+			SockadrToNetadr (&from[i], &packets[i]->adr);
+	}
+
+	return ret;
+}
+
+/*
+=============================================================================
+
+NETWORK THREAD
+
+With net_thread set, a dedicated server receives on a thread that waits
+in poll on the IP socket, so packets are taken off the socket as soon
+as they arrive, even in the middle of a long server frame.  Each one
+keeps its kernel arrival stamp and goes through a single producer,
+single consumer ring that Sys_GetEvent drains at the start of the next
+frame.  A byte down a pipe wakes NET_Sleep when there is something in
+the ring.
+
+The arrival stamps feed two histograms for net_jitter: the jitter in
+the spacing of packets from each address, and how long packets waited
+between arriving and being handed to the event loop.
+
+=============================================================================
+*/
+
+#define	NET_QUEUE_SIZE		256			// power of two
+#define	NET_QUEUE_MASK		( NET_QUEUE_SIZE - 1 )
+#define	NET_POLL_MSEC		10
+
+#define	NET_HISTOGRAM_BUCKETS	10		// 250 usec doubling, the last is open
+#define	NET_SOURCES			256			// power of two
+
+typedef struct {
+	netPacket_t		*packet;
+	int				length;
+	struct timeval	stamp;
+} netQueued_t;
+
+typedef struct {
+	void			*thread;
+	volatile qboolean	quit;
+
+	netQueued_t		queue[NET_QUEUE_SIZE];
+	volatile int	head;				// only written by the network thread
+	volatile int	tail;				// only written by the main thread
+	int				full;				// times the ring was full
+
+	int				wake[2];			// pipe NET_Sleep waits on
+} netThread_t;
+
+typedef struct {
+	netadr_t		adr;
+	struct timeval	last;
+	int				interval;			// usec, -1 until there is one
+} netSource_t;
+
+static netThread_t	netThread;
+static netSource_t	netSources[NET_SOURCES];
+static int			netJitter[NET_HISTOGRAM_BUCKETS];
+static int			netWait[NET_HISTOGRAM_BUCKETS];
+
+static cvar_t		*net_thread;
+
+extern unsigned long sys_timeBase;
+
+/*
+==================
+NET_StampDelta
+
+a - b in usec
+==================
+*/
+static int NET_StampDelta (const struct timeval *a, const struct timeval *b)
+{
+	long	sec;
+
+	sec = a->tv_sec - b->tv_sec;
+	if (sec > 1000)
+		return 1000 * 1000000;
+	if (sec < -1000)
+		return -1000 * 1000000;
+	return sec * 1000000 + ( a->tv_usec - b->tv_usec );
+}
+
+/*
+==================
+NET_StampMilliseconds
+
+An arrival stamp on the Sys_Milliseconds clock
+==================
+*/
+static int NET_StampMilliseconds (const struct timeval *stamp)
+{
+	return (stamp->tv_sec - sys_timeBase) * 1000 + stamp->tv_usec / 1000;
+}
+
+/*
+==================
+NET_HistogramBucket
+==================
+*/
+static int NET_HistogramBucket (int usec)
+{
+	int		bucket, limit;
+
+	if (usec < 0)
+		usec = -usec;
+	for (bucket = 0, limit = 250 ; bucket < NET_HISTOGRAM_BUCKETS - 1 ; bucket++, limit <<= 1)
+	{
+		if (usec < limit)
+			break;
+	}
+	return bucket;
+}
+
+/*
+==================
+NET_RecordArrival
+
+Only called by whichever thread is receiving on ip_socket
+==================
+*/
+static void NET_RecordArrival (const netadr_t *adr, const struct timeval *stamp)
+{
+	netSource_t	*source;
+	int			hash, interval;
+
+	hash = ( adr->ip[0] ^ adr->ip[1] ^ adr->ip[2] ^ adr->ip[3] ^ adr->port ^ ( adr->port >> 8 ) ) & ( NET_SOURCES - 1 );
+	source = &netSources[hash];
+
+	if (source->adr.type != adr->type || !NET_CompareAdr (source->adr, *adr))
+	{
+		source->adr = *adr;
+		source->last = *stamp;
+		source->interval = -1;
+		return;
+	}
+
+	interval = NET_StampDelta (stamp, &source->last);
+	if (source->interval >= 0)
+		netJitter[NET_HistogramBucket (interval - source->interval)]++;
+	source->interval = interval;
+	source->last = *stamp;
+}
+
+/*
+==================
+NET_ThreadMain
+==================
+*/
+static void NET_ThreadMain (void *arg)
+{
+	netPacket_t		*packets[SYS_PACKET_BATCH];
+	int				lengths[SYS_PACKET_BATCH];
+	struct timeval	stamps[SYS_PACKET_BATCH];
+	struct pollfd	pfd;
+	netQueued_t		*queued;
+	int				head, space, count, i;
+
+	while (!netThread.quit)
+	{
+		pfd.fd = ip_socket;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+		if (poll (&pfd, 1, NET_POLL_MSEC) <= 0)
+			continue;
+
+		head = netThread.head;
+		space = NET_QUEUE_SIZE - ( head - netThread.tail );
+		if (!space)
+		{
+			// leave them in the socket until the main thread catches up
+			netThread.full++;
+			Sys_Sleep (1);
+			continue;
+		}
+
+		count = NET_ReceiveBatch (ip_socket, packets, lengths, stamps, space);
+		if (count == -1)
+		{
+			Sys_Sleep (1);
+			continue;
+		}
+
+		for (i = 0 ; i < count ; i++)
+		{
+			NET_RecordArrival (&packets[i]->adr, &stamps[i]);
+
+			queued = &netThread.queue[ ( head + i ) & NET_QUEUE_MASK ];
+			queued->packet = packets[i];
+			queued->length = lengths[i];
+			queued->stamp = stamps[i];
+		}
+
+		// the entries have to be visible before the new head
+		Sys_MemoryBarrier ();
+		netThread.head = head + count;
+
+		if (count)
+			write (netThread.wake[1], "", 1);
+	}
+}
+
+/*
+==================
+NET_StartThread
+==================
+*/
+static void NET_StartThread (void)
+{
+	if (netThread.thread || !ip_socket)
+		return;
+
+	if (pipe (netThread.wake) == -1)
+	{
+		Com_Printf ("Couldn't start the network thread: %s\n", NET_ErrorString());
+		return;
+	}
+	fcntl (netThread.wake[0], F_SETFL, O_NONBLOCK);
+	fcntl (netThread.wake[1], F_SETFL, O_NONBLOCK);
+
+	Com_SharePackets ();
+
+	netThread.quit = qfalse;
+	netThread.head = netThread.tail = 0;
+	netThread.thread = Sys_CreateThread (NET_ThreadMain, NULL);
+	if (!netThread.thread)
+	{
+		Com_Printf ("Couldn't start the network thread\n");
+		close (netThread.wake[0]);
+		close (netThread.wake[1]);
+		return;
+	}
+	Com_Printf ("Receiving packets on a network thread\n");
+}
+
+/*
+==================
+NET_StopThread
+==================
+*/
+static void NET_StopThread (void)
+{
+	if (!netThread.thread)
+		return;
+
+	netThread.quit = qtrue;
+	Sys_MemoryBarrier ();
+	Sys_JoinThread (netThread.thread);
+	netThread.thread = NULL;
+	close (netThread.wake[0]);
+	close (netThread.wake[1]);
+
+	while (netThread.tail != netThread.head)
+	{
+		Com_FreePacket (netThread.queue[netThread.tail & NET_QUEUE_MASK].packet);
+		netThread.tail++;
+	}
+}
+
+/*
+==================
+Sys_GetPackets
+
+Batched Sys_GetPacket for Sys_GetEvent.  The packets are left in packet
+buffers to be queued as they are, with their arrival times on the
+Sys_Milliseconds clock.  Returns -1 if the buffers are all in use.
+==================
+*/
+int Sys_GetPackets (netPacket_t **packets, int *lengths, int *times, int max)
+{
+	struct timeval	stamps[SYS_PACKET_BATCH];
+	struct timeval	now;
+	netQueued_t		*queued;
+	int				count, head, errors, i, j;
+
+	if (!ip_socket || max <= 0)
+		return 0;
+	if (max > SYS_PACKET_BATCH)
+		max = SYS_PACKET_BATCH;
+
+	if (netThread.thread)
+	{
+		head = netThread.head;
+		Sys_MemoryBarrier ();
+
+		for (count = 0 ; count < max && netThread.tail != head ; count++)
+		{
+			queued = &netThread.queue[netThread.tail & NET_QUEUE_MASK];
+			packets[count] = queued->packet;
+			lengths[count] = queued->length;
+			stamps[count] = queued->stamp;
+			netThread.tail++;
+		}
+		Sys_MemoryBarrier ();
+	}
+	else
+	{
+		count = NET_ReceiveBatch (ip_socket, packets, lengths, stamps, max);
+		for (i = 0 ; i < count ; i++)
+			NET_RecordArrival (&packets[i]->adr, &stamps[i]);
+	}
+
+	errors = netReceiveErrors;
+	if (errors != netReceiveErrorsReported)
+	{
+		Sys_MemoryBarrier ();
+		Com_Printf ("NET_ReceiveBatch: %s", strerror (netReceiveErrno));
+		if (errors - netReceiveErrorsReported > 1)
+			Com_Printf (" (%i errors)", errors - netReceiveErrorsReported);
+		Com_Printf ("\n");
+		netReceiveErrorsReported = errors;
+	}
+	if (count <= 0)
+		return count;
+
+	// drop oversize packets
+	gettimeofday (&now, NULL);
+	for (i = j = 0 ; i < count ; i++)
+	{
+		if (lengths[i] == MAX_MSGLEN)
+		{
+			Com_Printf ("Oversize packet from %s\n", NET_AdrToString (packets[i]->adr));
+			Com_FreePacket (packets[i]);
+			continue;
+		}
+
+		netWait[NET_HistogramBucket (NET_StampDelta (&now, &stamps[i]))]++;
+		packets[j] = packets[i];
+		lengths[j] = lengths[i];
+		times[j] = NET_StampMilliseconds (&stamps[i]);
+		j++;
+	}
+
+	return j;
+}
+
+/*
+==================
+NET_PrintHistogram
+==================
+*/
+static void NET_PrintHistogram (const char *title, const int *counts)
+{
+	int		i, total, limit;
+
+	total = 0;
+	for (i = 0 ; i < NET_HISTOGRAM_BUCKETS ; i++)
+		total += counts[i];
+
+	Com_Printf ("%s, %i samples:\n", title, total);
+	if (!total)
+		return;
+
+	for (i = 0, limit = 250 ; i < NET_HISTOGRAM_BUCKETS ; i++, limit <<= 1)
+	{
+		if (i < NET_HISTOGRAM_BUCKETS - 1)
+			Com_Printf ("  < %6i usec %8i %5.1f%%\n", limit, counts[i], 100.0f * counts[i] / total);
+		else
+			Com_Printf (" >= %6i usec %8i %5.1f%%\n", limit >> 1, counts[i], 100.0f * counts[i] / total);
+	}
+}
+
+/*
+==================
+NET_Jitter_f
+
+net_jitter [reset]
+==================
+*/
+static void NET_Jitter_f (void)
+{
+	if (Cmd_Argc() > 1 && !Q_stricmp (Cmd_Argv (1), "reset"))
+	{
+		memset (netJitter, 0, sizeof(netJitter));
+		memset (netWait, 0, sizeof(netWait));
+		netThread.full = 0;
+		return;
+	}
+
+	Com_Printf ("packets received %s\n", netThread.thread ? "on the network thread" : "in the event loop");
+	NET_PrintHistogram ("arrival spacing jitter", netJitter);
+	NET_PrintHistogram ("wait before the event loop", netWait);
+	if (netThread.full)
+		Com_Printf ("network queue was full %i times\n", netThread.full);
+}
+
+//=============================================================================
+
+/*
+====================
+NET_LoadTestMain
+
+A local traffic source for the network thread: a socket per fake client,
+each sending to our own port at a fixed rate with the clients spread
+evenly over the period.  The packets are connectionless "disconnect"
+messages, which the server reads and ignores.
+====================
+*/
+#define	MAX_LOADTEST_CLIENTS	64
+
+typedef struct {
+	void			*thread;
+	volatile qboolean	quit;
+	volatile qboolean	done;
+
+	int				clients;
+	int				hz;
+	int				seconds;
+	int				sockets[MAX_LOADTEST_CLIENTS];
+	struct sockaddr_in	to;
+
+	volatile int	sent;
+	volatile int	late;				// sent more than a msec behind schedule
+} netLoadTest_t;
+
+static netLoadTest_t	netLoadTest;
+
+static void NET_LoadTestMain (void *arg)
+{
+	static const char	packet[] = "\xff\xff\xff\xff" "disconnect";
+	int				next[MAX_LOADTEST_CLIENTS];		// usec from the start
+	struct timeval	start, now;
+	int				period, end, elapsed, first, i;
+
+	period = 1000000 / netLoadTest.hz;
+	end = netLoadTest.seconds * 1000000;
+	for (i = 0 ; i < netLoadTest.clients ; i++)
+		next[i] = i * ( period / netLoadTest.clients );
+
+	gettimeofday (&start, NULL);
+	while (!netLoadTest.quit)
+	{
+		first = 0;
+		for (i = 1 ; i < netLoadTest.clients ; i++)
+		{
+			if (next[i] < next[first])
+				first = i;
+		}
+		if (next[first] >= end)
+			break;
+
+		gettimeofday (&now, NULL);
+		elapsed = NET_StampDelta (&now, &start);
+		if (elapsed < next[first])
+		{
+			usleep (next[first] - elapsed);
+			continue;
+		}
+		if (elapsed - next[first] > 1000)
+			netLoadTest.late++;
+
+		sendto (netLoadTest.sockets[first], packet, sizeof(packet) - 1, 0,
+			(struct sockaddr *)&netLoadTest.to, sizeof(netLoadTest.to));
+		netLoadTest.sent++;
+		next[first] += period;
+	}
+
+	netLoadTest.done = qtrue;
+}
+
+/*
+====================
+NET_StopLoadTest
+====================
+*/
+static void NET_StopLoadTest (void)
+{
+	int		i;
+
+	if (!netLoadTest.thread)
+		return;
+
+	netLoadTest.quit = qtrue;
+	Sys_JoinThread (netLoadTest.thread);
+	netLoadTest.thread = NULL;
+
+	for (i = 0 ; i < netLoadTest.clients ; i++)
+		close (netLoadTest.sockets[i]);
+}
+
+/*
+====================
+NET_LoadTest_f
+
+net_loadtest <clients> <hz> <seconds>
+net_loadtest stop
+net_loadtest
+
+Watch the results with net_jitter
+====================
+*/
+static void NET_LoadTest_f (void)
+{
+	socklen_t	len;
+	int			i;
+
+	if (Cmd_Argc() == 1)
+	{
+		if (!netLoadTest.clients)
+		{
+			Com_Printf ("usage: net_loadtest <clients> <hz> <seconds>, or stop\n");
+			return;
+		}
+		Com_Printf ("load test %s: %i clients at %i Hz for %i sec, %i packets sent, %i late\n",
+			netLoadTest.thread && !netLoadTest.done ? "running" : "finished",
+			netLoadTest.clients, netLoadTest.hz, netLoadTest.seconds,
+			netLoadTest.sent, netLoadTest.late);
+		return;
+	}
+
+	NET_StopLoadTest ();
+	if (!Q_stricmp (Cmd_Argv (1), "stop"))
+		return;
+
+	if (Cmd_Argc() != 4)
+	{
+		Com_Printf ("usage: net_loadtest <clients> <hz> <seconds>, or stop\n");
+		return;
+	}
+	if (!ip_socket)
+	{
+		Com_Printf ("net_loadtest: no IP socket\n");
+		return;
+	}
+
+	memset (&netLoadTest, 0, sizeof(netLoadTest));
+	netLoadTest.clients = atoi (Cmd_Argv (1));
+	netLoadTest.hz = atoi (Cmd_Argv (2));
+	netLoadTest.seconds = atoi (Cmd_Argv (3));
+	if (netLoadTest.clients < 1)
+		netLoadTest.clients = 1;
+	if (netLoadTest.clients > MAX_LOADTEST_CLIENTS)
+		netLoadTest.clients = MAX_LOADTEST_CLIENTS;
+	if (netLoadTest.hz < 1)
+		netLoadTest.hz = 1;
+	if (netLoadTest.hz > 1000)
+		netLoadTest.hz = 1000;
+	if (netLoadTest.seconds < 1)
+		netLoadTest.seconds = 1;
+	if (netLoadTest.seconds > 600)
+		netLoadTest.seconds = 600;
+
+	len = sizeof(netLoadTest.to);
+	getsockname (ip_socket, (struct sockaddr *)&netLoadTest.to, &len);
+	netLoadTest.to.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+
+	for (i = 0 ; i < netLoadTest.clients ; i++)
+	{
+		netLoadTest.sockets[i] = socket (PF_INET, SOCK_DGRAM, IPPROTO_UDP);
+		if (netLoadTest.sockets[i] == -1)
+		{
+			Com_Printf ("net_loadtest: socket: %s\n", NET_ErrorString());
+			while (--i >= 0)
+				close (netLoadTest.sockets[i]);
+			netLoadTest.clients = 0;
+			return;
+		}
+	}
+
+	netLoadTest.thread = Sys_CreateThread (NET_LoadTestMain, NULL);
+	if (!netLoadTest.thread)
+	{
+		Com_Printf ("net_loadtest: couldn't start a thread\n");
+		for (i = 0 ; i < netLoadTest.clients ; i++)
+			close (netLoadTest.sockets[i]);
+		netLoadTest.clients = 0;
+	}
+}
+
+//=============================================================================
+
 //=============================================================================
 
 void	Sys_SendPacket( int length, const void *data, netadr_t to )
@@ -493,6 +1199,8 @@ void NET_OpenIP (void)
 }
 
 
+static void NET_Bench_f (void);
+
 /*
 ====================
 NET_Init
@@ -501,10 +1209,19 @@ NET_Init
 void NET_Init (void)
 {
 	noudp = Cvar_Get ("net_noudp", "0", 0);
+	net_thread = Cvar_Get ("net_thread", "1", CVAR_ARCHIVE | CVAR_LATCH);
+	Cmd_AddCommand ("net_bench", NET_Bench_f);
+	Cmd_AddCommand ("net_jitter", NET_Jitter_f);
+	Cmd_AddCommand ("net_loadtest", NET_LoadTest_f);
 	// open sockets
 	if (! noudp->value) {
 		NET_OpenIP ();
 	}
+
+	// only a dedicated server sleeps between frames
+	if (com_dedicated->integer && net_thread->integer) {
+		NET_StartThread ();
+	}
 }
 
 
@@ -546,6 +1263,10 @@ int NET_IPSocket (char *net_interface, int port)
 		return 0;
 	}
 
+	// kernel arrival stamps for NET_ReceiveBatch, it falls back to
+	// the time it read the packet
+	setsockopt(newsocket, SOL_SOCKET, SO_TIMESTAMP, (char *)&i, sizeof(i));
+
 	if (!net_interface || !net_interface[0] || !Q_stricmp(net_interface, "localhost"))
 		address.sin_addr.s_addr = INADDR_ANY;
 	else
@@ -575,6 +1296,9 @@ NET_Shutdown
 */
 void	NET_Shutdown (void)
 {
+	NET_StopLoadTest ();
+	NET_StopThread ();
+
 	if (ip_socket) {
 		close(ip_socket);
 		ip_socket = 0;
@@ -600,17 +1324,177 @@ void NET_Sleep(int msec)
 {
     struct timeval timeout;
 	fd_set	fdset;
+	int		net_fd;
+	char	drain[64];
 	extern qboolean stdin_active;
 
 	if (!ip_socket || !com_dedicated->integer)
 		return; // we're not a server, just run full speed
 
+	// the network thread owns the socket and says when it has queued
+	// something
+	net_fd = netThread.thread ? netThread.wake[0] : ip_socket;
+
 	FD_ZERO(&fdset);
 	if (stdin_active)
 		FD_SET(0, &fdset); // stdin is processed too
-	FD_SET(ip_socket, &fdset); // network socket
+	FD_SET(net_fd, &fdset); // network socket
 	timeout.tv_sec = msec/1000;
 	timeout.tv_usec = (msec%1000)*1000;
-	select(ip_socket+1, &fdset, NULL, NULL, &timeout);
+	select(net_fd+1, &fdset, NULL, NULL, &timeout);
+
+	if (netThread.thread)
+	{
+		while (read (netThread.wake[0], drain, sizeof(drain)) > 0)
+			;
+	}
+}
+
+/*
+====================
+NET_Microseconds
+====================
+*/
+static int NET_Microseconds (void)
+{
+	struct timeval	tp;
+	static int		secbase;
+
+	gettimeofday (&tp, NULL);
+	if (!secbase)
+		secbase = tp.tv_sec;
+	return (tp.tv_sec - secbase) * 1000000 + tp.tv_usec;
+}
+
+/*
+====================
+NET_CpuMicroseconds
+====================
+*/
+static int NET_CpuMicroseconds (void)
+{
+	struct rusage	usage;
+
+	getrusage (RUSAGE_SELF, &usage);
+	return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000
+		+ usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
 }
 
+/*
+====================
+NET_Bench_f
+
+net_bench [packets] [size]
+
+Sends packets to a private loopback socket in bursts and receives them
+the way Sys_GetEvent used to, one recvfrom and a zone copy at a time,
+and then with NET_ReceiveBatch into packet buffers
+====================
+*/
+static void NET_Bench_f (void)
+{
+	static byte		payload[MAX_MSGLEN];
+	static byte		received[MAX_MSGLEN];
+	static byte		bufData[MAX_MSGLEN];
+	netPacket_t		*packets[SYS_PACKET_BATCH];
+	int				lengths[SYS_PACKET_BATCH];
+	struct sockaddr_in	to, from;
+	socklen_t		tolen, fromlen;
+	int				recvSock, sendSock;
+	int				total, size, mode;
+	int				sent, burst, got, calls, ret, i;
+	int				recvTime, cpuTime, start;
+	netadr_t		*copy;
+	msg_t			msg;
+
+	total = 100000;
+	size = 64;
+	if (Cmd_Argc() > 1)
+		total = atoi (Cmd_Argv (1));
+	if (Cmd_Argc() > 2)
+		size = atoi (Cmd_Argv (2));
+	if (total <= 0 || size <= 0 || size >= MAX_MSGLEN)
+	{
+		Com_Printf ("usage: net_bench [packets] [size]\n");
+		return;
+	}
+
+	recvSock = NET_IPSocket ("127.0.0.1", PORT_ANY);
+	if (!recvSock)
+		return;
+	tolen = sizeof(to);
+	getsockname (recvSock, (struct sockaddr *)&to, &tolen);
+
+	sendSock = socket (PF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (sendSock == -1)
+	{
+		Com_Printf ("net_bench: socket: %s\n", NET_ErrorString());
+		close (recvSock);
+		return;
+	}
+
+	for (i = 0 ; i < size ; i++)
+		payload[i] = i;
+
+	for (mode = 0 ; mode < 2 ; mode++)
+	{
+		recvTime = 0;
+		calls = 0;
+		got = 0;
+		cpuTime = NET_CpuMicroseconds();
+
+		for (sent = 0 ; sent < total ; sent += burst)
+		{
+			burst = total - sent;
+			if (burst > SYS_PACKET_BATCH)
+				burst = SYS_PACKET_BATCH;
+			for (i = 0 ; i < burst ; i++)
+				sendto (sendSock, payload, size, 0, (struct sockaddr *)&to, sizeof(to));
+
+			// loopback delivers during sendto, so the burst is waiting
+			start = NET_Microseconds();
+			if (mode == 0)
+			{
+				while (1)
+				{
+					calls++;
+					fromlen = sizeof(from);
+					ret = recvfrom (recvSock, received, sizeof(received), 0, (struct sockaddr *)&from, &fromlen);
+					if (ret <= 0)
+						break;
+					copy = Z_Malloc (sizeof(netadr_t) + ret);
+					SockadrToNetadr (&from, copy);
+					memcpy (copy + 1, received, ret);
+					MSG_Init (&msg, bufData, sizeof(bufData));
+					memcpy (msg.data, copy + 1, ret);
+					Z_Free (copy);
+					got++;
+				}
+			}
+			else
+			{
+				while (1)
+				{
+					calls++;
+					ret = NET_ReceiveBatch (recvSock, packets, lengths, NULL, SYS_PACKET_BATCH);
+					if (ret <= 0)
+						break;
+					for (i = 0 ; i < ret ; i++)
+						Com_FreePacket (packets[i]);
+					got += ret;
+				}
+			}
+			recvTime += NET_Microseconds() - start;
+		}
+
+		cpuTime = NET_CpuMicroseconds() - cpuTime;
+		if (recvTime <= 0)
+			recvTime = 1;
+		Com_Printf ("%s: %i of %i packets, %i receive calls, %i usec receiving, %.0f packets/sec, %i usec cpu\n",
+			mode ? "recvmmsg batch" : "recvfrom copy", got, total, calls, recvTime,
+			got * 1000000.0 / recvTime, cpuTime);
+	}
+
+	close (sendSock);
+	close (recvSock);
+}
@@ -28,6 +28,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include <sys/mman.h>
 #include <sys/time.h>
 #include <pwd.h>
+#include <pthread.h>
 
 #include "../game/q_shared.h"
 #include "../qcommon/qcommon.h"
@@ -433,3 +434,108 @@ unsigned int Sys_ProcessorCount()
   return sysconf(_SC_NPROCESSORS_ONLN);
 }
 #endif
+
+/*
+========================================================================
+
+THREADS
+
+========================================================================
+*/
+
+typedef struct {
+	pthread_t	handle;
+	void		(*function)( void *arg );
+	void		*arg;
+} sysThread_t;
+
+static void *Sys_ThreadMain( void *parm ) {
+	sysThread_t	*thread = (sysThread_t *)parm;
+
+	thread->function( thread->arg );
+	return NULL;
+}
+
+/*
+================
+Sys_CreateThread
+================
+*/
+void *Sys_CreateThread( void (*function)( void *arg ), void *arg ) {
+	sysThread_t	*thread;
+
+	thread = Z_Malloc( sizeof( *thread ) );
+	thread->function = function;
+	thread->arg = arg;
+	if ( pthread_create( &thread->handle, NULL, Sys_ThreadMain, thread ) ) {
+		Z_Free( thread );
+		return NULL;
+	}
+	return thread;
+}
+
+/*
+================
+Sys_JoinThread
+================
+*/
+void Sys_JoinThread( void *thread ) {
+	sysThread_t	*t = (sysThread_t *)thread;
+
+	pthread_join( t->handle, NULL );
+	Z_Free( t );
+}
+
+void *Sys_CreateMutex( void ) {
+	pthread_mutex_t		*mutex;
+	pthread_mutexattr_t	attr;
+
+	mutex = Z_Malloc( sizeof( *mutex ) );
+	pthread_mutexattr_init( &attr );
+	pthread_mutexattr_settype( &attr, PTHREAD_MUTEX_RECURSIVE );
+	pthread_mutex_init( mutex, &attr );
+	pthread_mutexattr_destroy( &attr );
+	return mutex;
+}
+
+void Sys_DestroyMutex( void *mutex ) {
+	pthread_mutex_destroy( (pthread_mutex_t *)mutex );
+	Z_Free( mutex );
+}
+
+void Sys_LockMutex( void *mutex ) {
+	pthread_mutex_lock( (pthread_mutex_t *)mutex );
+}
+
+void Sys_UnlockMutex( void *mutex ) {
+	pthread_mutex_unlock( (pthread_mutex_t *)mutex );
+}
+
+void *Sys_CreateCondition( void ) {
+	pthread_cond_t	*cond;
+
+	cond = Z_Malloc( sizeof( *cond ) );
+	pthread_cond_init( cond, NULL );
+	return cond;
+}
+
+void Sys_DestroyCondition( void *cond ) {
+	pthread_cond_destroy( (pthread_cond_t *)cond );
+	Z_Free( cond );
+}
+
+void Sys_WaitCondition( void *cond, void *mutex ) {
+	pthread_cond_wait( (pthread_cond_t *)cond, (pthread_mutex_t *)mutex );
+}
+
+void Sys_WakeCondition( void *cond ) {
+	pthread_cond_broadcast( (pthread_cond_t *)cond );
+}
+
+void Sys_Sleep( int msec ) {
+	usleep( msec * 1000 );
+}
+
+void Sys_MemoryBarrier( void ) {
+	__sync_synchronize();
+}
@@ -1083,6 +1083,89 @@ static void GLW_InitExtensions( void )
 		ri.Printf( PRINT_ALL, "...GL_EXT_compiled_vertex_array not found\n" );
 	}
 
+	// GL_ARB_vertex_buffer_object
+	qglBindBufferARB = NULL;
+	qglDeleteBuffersARB = NULL;
+	qglGenBuffersARB = NULL;
+	qglBufferDataARB = NULL;
+	qglMultiDrawElementsEXT = NULL;
+	if ( strstr( glConfig.extensions_string, "GL_ARB_vertex_buffer_object" ) )
+	{
+		if ( r_ext_vertex_buffer_object->integer )
+		{
+			qglBindBufferARB = ( void ( APIENTRY * )( GLenum, GLuint ) ) qwglGetProcAddress( "glBindBufferARB" );
+			qglDeleteBuffersARB = ( void ( APIENTRY * )( GLsizei, const GLuint * ) ) qwglGetProcAddress( "glDeleteBuffersARB" );
+			qglGenBuffersARB = ( void ( APIENTRY * )( GLsizei, GLuint * ) ) qwglGetProcAddress( "glGenBuffersARB" );
+			qglBufferDataARB = ( void ( APIENTRY * )( GLenum, ptrdiff_t, const GLvoid *, GLenum ) ) qwglGetProcAddress( "glBufferDataARB" );
+
+			if ( qglBindBufferARB && qglDeleteBuffersARB && qglGenBuffersARB && qglBufferDataARB )
+			{
+				ri.Printf( PRINT_ALL, "...using GL_ARB_vertex_buffer_object\n" );
+
+				if ( strstr( glConfig.extensions_string, "GL_EXT_multi_draw_arrays" ) )
+				{
+					qglMultiDrawElementsEXT = ( void ( APIENTRY * )( GLenum, const GLsizei *, GLenum, const GLvoid **, GLsizei ) ) qwglGetProcAddress( "glMultiDrawElementsEXT" );
+				}
+			}
+			else
+			{
+				qglBindBufferARB = NULL;
+				qglDeleteBuffersARB = NULL;
+				qglGenBuffersARB = NULL;
+				qglBufferDataARB = NULL;
+				ri.Printf( PRINT_ALL, "...not using GL_ARB_vertex_buffer_object, missing entry points\n" );
+			}
+		}
+		else
+		{
+			ri.Printf( PRINT_ALL, "...ignoring GL_ARB_vertex_buffer_object\n" );
+		}
+	}
+	else
+	{
+		ri.Printf( PRINT_ALL, "...GL_ARB_vertex_buffer_object not found\n" );
+	}
+
+	// GL_ARB_occlusion_query
+	qglGenQueriesARB = NULL;
+	qglDeleteQueriesARB = NULL;
+	qglBeginQueryARB = NULL;
+	qglEndQueryARB = NULL;
+	qglGetQueryObjectivARB = NULL;
+	if ( strstr( glConfig.extensions_string, "GL_ARB_occlusion_query" ) )
+	{
+		if ( r_ext_occlusion_query->integer )
+		{
+			qglGenQueriesARB = ( void ( APIENTRY * )( GLsizei, GLuint * ) ) qwglGetProcAddress( "glGenQueriesARB" );
+			qglDeleteQueriesARB = ( void ( APIENTRY * )( GLsizei, const GLuint * ) ) qwglGetProcAddress( "glDeleteQueriesARB" );
+			qglBeginQueryARB = ( void ( APIENTRY * )( GLenum, GLuint ) ) qwglGetProcAddress( "glBeginQueryARB" );
+			qglEndQueryARB = ( void ( APIENTRY * )( GLenum ) ) qwglGetProcAddress( "glEndQueryARB" );
+			qglGetQueryObjectivARB = ( void ( APIENTRY * )( GLuint, GLenum, GLint * ) ) qwglGetProcAddress( "glGetQueryObjectivARB" );
+
+			if ( qglGenQueriesARB && qglDeleteQueriesARB && qglBeginQueryARB && qglEndQueryARB && qglGetQueryObjectivARB )
+			{
+				ri.Printf( PRINT_ALL, "...using GL_ARB_occlusion_query\n" );
+			}
+			else
+			{
+				qglGenQueriesARB = NULL;
+				qglDeleteQueriesARB = NULL;
+				qglBeginQueryARB = NULL;
+				qglEndQueryARB = NULL;
+				qglGetQueryObjectivARB = NULL;
+				ri.Printf( PRINT_ALL, "...not using GL_ARB_occlusion_query, missing entry points\n" );
+			}
+		}
+		else
+		{
+			ri.Printf( PRINT_ALL, "...ignoring GL_ARB_occlusion_query\n" );
+		}
+	}
+	else
+	{
+		ri.Printf( PRINT_ALL, "...GL_ARB_occlusion_query not found\n" );
+	}
+
 	// WGL_3DFX_gamma_control
 	qwglGetDeviceGammaRamp3DFX = NULL;
 	qwglSetDeviceGammaRamp3DFX = NULL;
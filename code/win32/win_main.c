@@ -903,7 +903,7 @@ Sys_QueEvent
 
 A time of 0 will get the current time
 Ptr should either be null, or point to a block of data that can
-be freed by the game later.
+be released with Com_EventFree later.
 ================
 */
 void Sys_QueEvent( int time, sysEventType_t type, int value, int value2, int ptrLength, void *ptr ) {
@@ -919,7 +919,7 @@ void Sys_QueEvent4( int time, sysEventType_t type, int value, int value2, int va
 		Com_Printf("Sys_QueEvent: overflow\n");
 		// we are discarding an event, but don't leak memory
 		if ( ev->evPtr ) {
-			Z_Free( ev->evPtr );
+			Com_EventFree( ev->evPtr );
 		}
 		eventTail++;
 	}
@@ -979,7 +979,7 @@ sysEvent_t Sys_GetEvent( void ) {
 		int		len;
 
 		len = strlen( s ) + 1;
-		b = Z_Malloc( len );
+		b = Com_EventAlloc( len );
 		Q_strncpyz( b, s, len-1 );
 		Sys_QueEvent( 0, SE_CONSOLE, 0, 0, len, b );
 	}
@@ -993,7 +993,7 @@ sysEvent_t Sys_GetEvent( void ) {
 		// copy out to a seperate buffer for qeueing
 		// the readcount stepahead is for SOCKS support
 		len = sizeof( netadr_t ) + netmsg.cursize - netmsg.readcount;
-		buf = Z_Malloc( len );
+		buf = Com_EventAlloc( len );
 		*buf = adr;
 		memcpy( buf+1, &netmsg.data[netmsg.readcount], netmsg.cursize - netmsg.readcount );
 		Sys_QueEvent( 0, SE_PACKET, 0, 0, len, buf );
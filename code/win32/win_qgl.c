@@ -3635,6 +3635,16 @@ qboolean QGL_Init( const char *dllname )
 	qglMultiTexCoord2fARB = 0;
 	qglLockArraysEXT = 0;
 	qglUnlockArraysEXT = 0;
+	qglBindBufferARB = 0;
+	qglDeleteBuffersARB = 0;
+	qglGenBuffersARB = 0;
+	qglBufferDataARB = 0;
+	qglMultiDrawElementsEXT = 0;
+	qglGenQueriesARB = 0;
+	qglDeleteQueriesARB = 0;
+	qglBeginQueryARB = 0;
+	qglEndQueryARB = 0;
+	qglGetQueryObjectivARB = 0;
 	qwglGetDeviceGammaRamp3DFX = NULL;
 	qwglSetDeviceGammaRamp3DFX = NULL;
 
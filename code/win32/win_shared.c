@@ -304,3 +304,118 @@ char *Sys_DefaultInstallPath(void)
 	return Sys_Cwd();
 }
 
+
+/*
+================
+Sys_ProcessorCount
+================
+*/
+unsigned int Sys_ProcessorCount( void ) {
+	SYSTEM_INFO	info;
+
+	GetSystemInfo( &info );
+	return info.dwNumberOfProcessors;
+}
+
+/*
+========================================================================
+
+THREADS
+
+========================================================================
+*/
+
+typedef struct {
+	HANDLE	handle;
+	void	(*function)( void *arg );
+	void	*arg;
+} sysThread_t;
+
+static DWORD WINAPI Sys_ThreadMain( LPVOID parm ) {
+	sysThread_t	*thread = (sysThread_t *)parm;
+
+	thread->function( thread->arg );
+	return 0;
+}
+
+/*
+================
+Sys_CreateThread
+================
+*/
+void *Sys_CreateThread( void (*function)( void *arg ), void *arg ) {
+	sysThread_t	*thread;
+	DWORD		threadId;
+
+	thread = Z_Malloc( sizeof( *thread ) );
+	thread->function = function;
+	thread->arg = arg;
+	thread->handle = CreateThread( NULL, 0, Sys_ThreadMain, thread, 0, &threadId );
+	if ( !thread->handle ) {
+		Z_Free( thread );
+		return NULL;
+	}
+	return thread;
+}
+
+/*
+================
+Sys_JoinThread
+================
+*/
+void Sys_JoinThread( void *thread ) {
+	sysThread_t	*t = (sysThread_t *)thread;
+
+	WaitForSingleObject( t->handle, INFINITE );
+	CloseHandle( t->handle );
+	Z_Free( t );
+}
+
+void *Sys_CreateMutex( void ) {
+	CRITICAL_SECTION	*crit;
+
+	crit = Z_Malloc( sizeof( *crit ) );
+	InitializeCriticalSection( crit );
+	return crit;
+}
+
+void Sys_DestroyMutex( void *mutex ) {
+	DeleteCriticalSection( (CRITICAL_SECTION *)mutex );
+	Z_Free( mutex );
+}
+
+void Sys_LockMutex( void *mutex ) {
+	EnterCriticalSection( (CRITICAL_SECTION *)mutex );
+}
+
+void Sys_UnlockMutex( void *mutex ) {
+	LeaveCriticalSection( (CRITICAL_SECTION *)mutex );
+}
+
+void *Sys_CreateCondition( void ) {
+	CONDITION_VARIABLE	*cond;
+
+	cond = Z_Malloc( sizeof( *cond ) );
+	InitializeConditionVariable( cond );
+	return cond;
+}
+
+void Sys_DestroyCondition( void *cond ) {
+	Z_Free( cond );
+}
+
+void Sys_WaitCondition( void *cond, void *mutex ) {
+	SleepConditionVariableCS( (CONDITION_VARIABLE *)cond, (CRITICAL_SECTION *)mutex, INFINITE );
+}
+
+void Sys_WakeCondition( void *cond ) {
+	WakeAllConditionVariable( (CONDITION_VARIABLE *)cond );
+}
+
+void Sys_Sleep( int msec ) {
+	Sleep( msec );
+}
+
+void Sys_MemoryBarrier( void ) {
+	MemoryBarrier();
+}